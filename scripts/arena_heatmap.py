@@ -0,0 +1,143 @@
+# Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Renders the JSON trace of a MicroArenaTracer as an SVG memory heatmap.
+
+The trace is printed by MicroArenaTracer::LogJson(), e.g. by
+scripts/trace_arena.cpp. It holds the size of the traced part of the arena
+(arena_bytes), the size of the memory plan at its start (planned_bytes) and
+one entry per node:
+
+  {"subgraph": 0, "node": 3, "op": "CONV_2D", "invocations": 1,
+   "high_water_bytes": 9216, "stray_bytes": 0, "temp_bytes": 0,
+   "buffers": [{"kind": "tensor", "index": 7, "offset": 0, "bytes": 4096},
+               {"kind": "scratch", "index": 2, "offset": 4096,
+                "bytes": 1024, "used_bytes": 512}]}
+
+Every node is a column and arena offsets grow downwards. Live tensors are
+blue, the written part of scratch buffers orange and the part their kernels
+never wrote hatched. The red mark is the high-water mark of the node, nodes
+that wrote outside their buffers are labelled in red.
+
+Usage:
+  python3 arena_heatmap.py trace.json heatmap.svg
+"""
+
+import argparse
+import json
+import sys
+
+COLUMN_WIDTH = 14
+HEIGHT = 600
+MARGIN_LEFT = 70
+MARGIN_TOP = 30
+MARGIN_BOTTOM = 120
+
+
+def load_trace(path):
+  """Reads a trace, skipping any log lines around the JSON object."""
+  with open(path) as trace_file:
+    text = trace_file.read()
+  start = text.find('{')
+  end = text.rfind('}')
+  if start < 0 or end < start:
+    raise ValueError('%s holds no trace' % path)
+  return json.loads(text[start:end + 1])
+
+
+def render(trace):
+  """Returns the SVG document for a trace."""
+  nodes = trace['nodes']
+  scale_bytes = max([trace['planned_bytes'], 1] +
+                    [node['high_water_bytes'] for node in nodes] +
+                    [b['offset'] + b['bytes'] for node in nodes
+                     for b in node['buffers']])
+
+  def y(offset):
+    return MARGIN_TOP + HEIGHT * offset / scale_bytes
+
+  width = MARGIN_LEFT + COLUMN_WIDTH * len(nodes) + 20
+  out = []
+  out.append('<svg xmlns="http://www.w3.org/2000/svg" width="%d" height="%d" '
+             'font-family="monospace" font-size="10">' %
+             (width, MARGIN_TOP + HEIGHT + MARGIN_BOTTOM))
+  out.append('<defs><pattern id="unused" width="4" height="4" '
+             'patternUnits="userSpaceOnUse"><path d="M0,4 L4,0" '
+             'stroke="#e08020" stroke-width="1"/></pattern></defs>')
+  out.append('<text x="%d" y="15">%d bytes traced, %d bytes planned</text>' %
+             (MARGIN_LEFT, trace['arena_bytes'], trace['planned_bytes']))
+
+  # Axis with a tick every tenth of the scale.
+  for i in range(11):
+    offset = scale_bytes * i // 10
+    out.append('<text x="%d" y="%.1f" text-anchor="end">%d</text>' %
+               (MARGIN_LEFT - 4, y(offset) + 3, offset))
+  out.append('<line x1="%d" y1="%.1f" x2="%d" y2="%.1f" stroke="black" '
+             'stroke-dasharray="4,2"/>' %
+             (MARGIN_LEFT, y(trace['planned_bytes']), width - 20,
+              y(trace['planned_bytes'])))
+
+  for column, node in enumerate(nodes):
+    x = MARGIN_LEFT + column * COLUMN_WIDTH
+    for b in node['buffers']:
+      top = y(b['offset'])
+      height = max(y(b['offset'] + b['bytes']) - top, 0.5)
+      if b['kind'] == 'tensor':
+        out.append('<rect x="%d" y="%.1f" width="%d" height="%.1f" '
+                   'fill="#4070c0"><title>tensor %d: %d bytes at %d'
+                   '</title></rect>' % (x, top, COLUMN_WIDTH - 2, height,
+                                        b['index'], b['bytes'], b['offset']))
+        continue
+      used = min(b['used_bytes'], b['bytes'])
+      used_height = y(b['offset'] + used) - top
+      out.append('<rect x="%d" y="%.1f" width="%d" height="%.1f" '
+                 'fill="url(#unused)"><title>scratch %d: %d of %d bytes '
+                 'written</title></rect>' %
+                 (x, top, COLUMN_WIDTH - 2, height, b['index'], used,
+                  b['bytes']))
+      if used_height > 0:
+        out.append('<rect x="%d" y="%.1f" width="%d" height="%.1f" '
+                   'fill="#e08020"/>' % (x, top, COLUMN_WIDTH - 2,
+                                         used_height))
+    high_water = y(node['high_water_bytes'])
+    out.append('<line x1="%d" y1="%.1f" x2="%d" y2="%.1f" stroke="red" '
+               'stroke-width="2"/>' %
+               (x, high_water, x + COLUMN_WIDTH - 2, high_water))
+    label_y = MARGIN_TOP + HEIGHT + 6
+    color = 'red' if node['stray_bytes'] > 0 else 'black'
+    out.append('<text x="%d" y="%d" fill="%s" transform="rotate(90 %d %d)">'
+               '%d:%d %s</text>' %
+               (x + 3, label_y, color, x + 3, label_y, node['subgraph'],
+                node['node'], node['op']))
+  out.append('</svg>')
+  return '\n'.join(out) + '\n'
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+  parser.add_argument('trace', help='JSON printed by MicroArenaTracer')
+  parser.add_argument('output', help='SVG file to write')
+  args = parser.parse_args()
+  try:
+    trace = load_trace(args.trace)
+  except ValueError as error:
+    print(error, file=sys.stderr)
+    return 1
+  with open(args.output, 'w') as output_file:
+    output_file.write(render(trace))
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -0,0 +1,240 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host tool that checks the int8 and int16 BATCH_MATMUL kernel against
+// reference_ops::BatchMatMul and times both on the matrix products of small
+// attention heads: the scores Q x K^T, the weighted values A x V and a
+// projection with a constant weight matrix that is broadcast over the heads.
+// For every shape the number of outputs that differ and the speedup are
+// printed. The tool exits with 1 if any output differs. The reference is given
+// operands that are already transposed to its layout, so its time leaves out
+// the transposes.
+//
+// Build from the repository root with:
+//   scripts/build_host_tool.sh scripts/benchmark_batch_matmul.cpp
+//
+// Usage:
+//   benchmark_batch_matmul [--iterations=100] [--seed=1]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <type_traits>
+#include <vector>
+
+#include "kernel_benchmark.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/reference/batch_matmul.h"
+#include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/test_helpers.h"
+
+namespace {
+
+using kernel_benchmark::Checker;
+using kernel_benchmark::KernelBenchmark;
+using kernel_benchmark::TimeMicros;
+
+enum class Product {
+  // [heads, seq, dim] x [heads, seq, dim]^T with adj_y.
+  kScores,
+  // [heads, seq, seq] x [heads, seq, dim].
+  kValues,
+  // [heads, seq, dim] x constant [dim, dim], broadcast over the heads.
+  kProjection,
+};
+
+struct Case {
+  Product product;
+  int heads;
+  int seq;
+  int dim;
+};
+
+constexpr Case kCases[] = {
+    {Product::kScores, 2, 8, 8},      {Product::kScores, 4, 16, 8},
+    {Product::kScores, 4, 16, 16},    {Product::kScores, 2, 32, 16},
+    {Product::kValues, 2, 8, 8},      {Product::kValues, 4, 16, 8},
+    {Product::kValues, 4, 16, 16},    {Product::kValues, 2, 32, 16},
+    {Product::kProjection, 2, 8, 8},  {Product::kProjection, 4, 16, 16},
+    {Product::kProjection, 2, 32, 16}, {Product::kProjection, 1, 49, 32},
+};
+
+// Transposes count matrices of rows x cols.
+template <typename T>
+std::vector<T> Transpose(const std::vector<T>& input, int rows, int cols) {
+  std::vector<T> output(input.size());
+  const int size = rows * cols;
+  for (size_t m = 0; m < input.size() / size; ++m) {
+    for (int r = 0; r < rows; ++r) {
+      for (int c = 0; c < cols; ++c) {
+        output[m * size + c * rows + r] = input[m * size + r * cols + c];
+      }
+    }
+  }
+  return output;
+}
+
+template <typename T>
+void Benchmark(const Case& test_case, int iterations, Checker* checker) {
+  constexpr bool kIsInt8 = sizeof(T) == 1;
+  using AccumT = typename std::conditional<kIsInt8, int32_t, int64_t>::type;
+  const int heads = test_case.heads;
+  const int seq = test_case.seq;
+  const int dim = test_case.dim;
+  // Dimensions of the product: [heads, rows, depth] x [depth, cols].
+  const int rows = seq;
+  int depth;
+  int cols;
+  const char* name;
+  // The RHS is stored as [rhs_heads, rhs_rows, rhs_cols].
+  int rhs_heads = heads;
+  int rhs_rows;
+  int rhs_cols;
+  bool adj_y = false;
+  bool constant_rhs = false;
+  switch (test_case.product) {
+    case Product::kScores:
+      name = "Q x K^T";
+      depth = dim;
+      cols = seq;
+      rhs_rows = seq;
+      rhs_cols = dim;
+      adj_y = true;
+      break;
+    case Product::kValues:
+      name = "A x V";
+      depth = seq;
+      cols = dim;
+      rhs_rows = seq;
+      rhs_cols = dim;
+      break;
+    case Product::kProjection:
+    default:
+      name = "X x W";
+      depth = dim;
+      cols = dim;
+      rhs_heads = 1;
+      rhs_rows = dim;
+      rhs_cols = dim;
+      constant_rhs = true;
+      break;
+  }
+
+  std::vector<T> lhs(heads * rows * depth);
+  std::vector<T> rhs(rhs_heads * rhs_rows * rhs_cols);
+  const int min = kIsInt8 ? -128 : -32768;
+  const int max = kIsInt8 ? 127 : 32767;
+  for (T& value : lhs) value = static_cast<T>(min + rand() % (max - min + 1));
+  for (T& value : rhs) value = static_cast<T>(min + rand() % (max - min + 1));
+  std::vector<T> expected(heads * rows * cols);
+  std::vector<T> actual(expected.size());
+
+  // Symmetric RHS, as the CMSIS-NN path requires, and an asymmetric LHS for
+  // int8. int16 has no zero points.
+  const float lhs_scale = 0.02f;
+  const float rhs_scale = 0.01f;
+  const float output_scale =
+      lhs_scale * rhs_scale * depth * (kIsInt8 ? 8 : 64);
+  const int lhs_zero_point = kIsInt8 ? 5 : 0;
+  const int output_zero_point = kIsInt8 ? -3 : 0;
+
+  int lhs_dims[] = {3, heads, rows, depth};
+  int rhs_dims_3d[] = {3, rhs_heads, rhs_rows, rhs_cols};
+  int rhs_dims_2d[] = {2, rhs_rows, rhs_cols};
+  int output_dims[] = {3, heads, rows, cols};
+  TfLiteTensor tensors[3] = {
+      tflite::testing::CreateQuantizedTensor(
+          lhs.data(), tflite::testing::IntArrayFromInts(lhs_dims), lhs_scale,
+          lhs_zero_point),
+      tflite::testing::CreateQuantizedTensor(
+          rhs.data(),
+          tflite::testing::IntArrayFromInts(constant_rhs ? rhs_dims_2d
+                                                         : rhs_dims_3d),
+          rhs_scale, 0),
+      tflite::testing::CreateQuantizedTensor(
+          actual.data(), tflite::testing::IntArrayFromInts(output_dims),
+          output_scale, output_zero_point),
+  };
+  if (constant_rhs) {
+    tensors[1].allocation_type = kTfLiteMmapRo;
+  }
+  int inputs_array[] = {2, 0, 1};
+  int outputs_array[] = {1, 2};
+  TfLiteBatchMatMulParams params = {false, adj_y, false};
+  const TfLiteRegistration registration = tflite::Register_BATCH_MATMUL();
+  KernelBenchmark kernel(registration, tensors,
+                         tflite::testing::IntArrayFromInts(inputs_array),
+                         tflite::testing::IntArrayFromInts(outputs_array),
+                         &params);
+
+  char dims[32];
+  snprintf(dims, sizeof(dims), "%dx%dx%d x %dx%d", heads, rows, depth, depth,
+           cols);
+  printf("%-5s %-8s %-24s ", kIsInt8 ? "int8" : "int16", name, dims);
+  // The reference multiplies [cols, depth] by [rows, depth]^T, with the
+  // weights offset applied to its first operand. As in the TFLite kernel, the
+  // shape of the second operand has its last two dimensions swapped.
+  const std::vector<T> rhs_by_cols = adj_y ? rhs : Transpose(rhs, depth, cols);
+  tflite::FullyConnectedParams op_params = {};
+  op_params.input_offset = -lhs_zero_point;
+  op_params.weights_offset = 0;
+  op_params.output_offset = output_zero_point;
+  tflite::QuantizeMultiplier(
+      static_cast<double>(lhs_scale) * rhs_scale / output_scale,
+      &op_params.output_multiplier, &op_params.output_shift);
+  op_params.quantized_activation_min = min;
+  op_params.quantized_activation_max = max;
+  const int32_t rhs_by_cols_dims[] = {rhs_heads, cols, depth};
+  const int32_t lhs_shape_dims[] = {heads, depth, rows};
+  const int32_t output_shape_dims[] = {heads, rows, cols};
+  const tflite::RuntimeShape rhs_by_cols_shape(3, rhs_by_cols_dims);
+  const tflite::RuntimeShape lhs_shape(3, lhs_shape_dims);
+  const tflite::RuntimeShape output_shape(3, output_shape_dims);
+  const double reference_micros = TimeMicros(iterations, [&] {
+    tflite::reference_ops::BatchMatMul<T, AccumT>(
+        op_params, rhs_by_cols_shape, rhs_by_cols.data(), lhs_shape,
+        lhs.data(), output_shape, expected.data());
+  });
+  double kernel_micros;
+  if (kernel.TimeInvoke(iterations, &kernel_micros) != kTfLiteOk) {
+    checker->Fail("Invoke");
+    return;
+  }
+  const int mismatches = checker->CountMismatches(
+      expected.data(), actual.data(), expected.size());
+  printf("mismatches %-5d %9.1f us %9.1f us %7.2fx\n", mismatches,
+         reference_micros, kernel_micros, reference_micros / kernel_micros);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  kernel_benchmark::Options options = {100};
+  if (!kernel_benchmark::ParseOptions(argc, argv, &options)) {
+    return 1;
+  }
+  Checker checker;
+  printf("%-5s %-8s %-24s %-16s %12s %12s %8s\n", "type", "product", "shape",
+         "accuracy", "reference", "kernel", "speedup");
+  for (const Case& test_case : kCases) {
+    Benchmark<int8_t>(test_case, options.iterations, &checker);
+  }
+  for (const Case& test_case : kCases) {
+    Benchmark<int16_t>(test_case, options.iterations, &checker);
+  }
+  return checker.ExitStatus();
+}
@@ -0,0 +1,227 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host tool that checks the int8 CMSIS-NN FULLY_CONNECTED kernel against
+// reference_integer_ops::FullyConnected across batch sizes, and times it
+// against the reference and against the loop of arm_fully_connected_s8 over
+// the batches that the kernel ran before it used the matrix-matrix kernels.
+// For every shape the number of outputs that differ, the kernel the
+// FULLY_CONNECTED Prepare picks and the speedup over the per-row loop are
+// printed, and the tool exits with 1 if any output differs. The last two
+// columns are the weight bytes the per-row loop and the kernel load in their
+// pure C and DSP builds, which bound the run time on a microcontroller with
+// the weights in flash and which the host timings do not reflect.
+//
+// Build from the repository root with:
+//   scripts/build_host_tool.sh scripts/benchmark_batched_fully_connected.cpp
+//
+// Usage:
+//   benchmark_batched_fully_connected [--iterations=200] [--seed=1]
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "kernel_benchmark.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
+#include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/test_helpers.h"
+#include "third_party/cmsis_nn/Include/arm_nnfunctions.h"
+
+namespace {
+
+using kernel_benchmark::Checker;
+using kernel_benchmark::KernelBenchmark;
+using kernel_benchmark::TimeMicros;
+
+struct Layer {
+  int accum_depth;
+  int output_depth;
+};
+
+// A square layer, one whose depth is not a multiple of 4 and so takes
+// arm_nn_mat_mult_nt_t_s8 instead of arm_convolve_1x1_s8_fast, and an LSTM
+// projection.
+constexpr Layer kLayers[] = {{256, 256}, {250, 256}, {512, 128}};
+constexpr int kBatches[] = {1, 2, 4, 8, 16};
+
+// The kernel FULLY_CONNECTED picks in Prepare for a 2D dense int8 layer.
+const char* KernelName(int batches, int accum_depth) {
+  if (batches == 1) {
+    return "vec_mat";
+  }
+  return accum_depth % 4 == 0 ? "conv_1x1" : "mat_mult";
+}
+
+void Benchmark(const Layer& layer, int batches, int iterations,
+               Checker* checker) {
+  const int accum_depth = layer.accum_depth;
+  const int output_depth = layer.output_depth;
+  std::vector<int8_t> input(batches * accum_depth);
+  std::vector<int8_t> filter(output_depth * accum_depth);
+  std::vector<int32_t> bias(output_depth);
+  for (int8_t& value : input) value = static_cast<int8_t>(rand());
+  for (int8_t& value : filter) value = static_cast<int8_t>(rand());
+  for (int32_t& value : bias) value = rand() % 8192 - 4096;
+  std::vector<int8_t> expected(batches * output_depth);
+  std::vector<int8_t> per_row(expected.size());
+  std::vector<int8_t> actual(expected.size());
+
+  const float input_scale = 0.05f;
+  const float filter_scale = 0.01f;
+  const float output_scale =
+      input_scale * filter_scale * 128 * std::sqrt(accum_depth);
+  const int input_zero_point = -4;
+  const int output_zero_point = 6;
+
+  int input_dims[] = {2, batches, accum_depth};
+  int filter_dims[] = {2, output_depth, accum_depth};
+  int bias_dims[] = {1, output_depth};
+  int output_dims[] = {2, batches, output_depth};
+  TfLiteTensor tensors[4] = {
+      tflite::testing::CreateQuantizedTensor(
+          input.data(), tflite::testing::IntArrayFromInts(input_dims),
+          input_scale, input_zero_point),
+      tflite::testing::CreateQuantizedTensor(
+          filter.data(), tflite::testing::IntArrayFromInts(filter_dims),
+          filter_scale, 0),
+      tflite::testing::CreateQuantizedTensor(
+          bias.data(), tflite::testing::IntArrayFromInts(bias_dims),
+          input_scale * filter_scale, 0),
+      tflite::testing::CreateQuantizedTensor(
+          actual.data(), tflite::testing::IntArrayFromInts(output_dims),
+          output_scale, output_zero_point),
+  };
+  tensors[1].allocation_type = kTfLiteMmapRo;
+  tensors[2].allocation_type = kTfLiteMmapRo;
+  int inputs_array[] = {3, 0, 1, 2};
+  int outputs_array[] = {1, 3};
+  TfLiteFullyConnectedParams params = {};
+  params.activation = kTfLiteActNone;
+  params.weights_format = kTfLiteFullyConnectedWeightsFormatDefault;
+  const TfLiteRegistration registration =
+      tflite::Register_FULLY_CONNECTED();
+  KernelBenchmark kernel(registration, tensors,
+                         tflite::testing::IntArrayFromInts(inputs_array),
+                         tflite::testing::IntArrayFromInts(outputs_array),
+                         &params);
+
+  char dims[32];
+  snprintf(dims, sizeof(dims), "%d x %dx%d", batches, accum_depth,
+           output_depth);
+  printf("%-16s %-9s ", dims, KernelName(batches, accum_depth));
+
+  // As in GetQuantizedConvolutionMultipler, the product of the scales is
+  // rounded to float first.
+  int32_t output_multiplier;
+  int output_shift;
+  tflite::QuantizeMultiplier(
+      static_cast<double>(input_scale * filter_scale) / output_scale,
+      &output_multiplier, &output_shift);
+
+  tflite::FullyConnectedParams op_params = {};
+  op_params.input_offset = -input_zero_point;
+  op_params.weights_offset = 0;
+  op_params.output_offset = output_zero_point;
+  op_params.output_multiplier = output_multiplier;
+  op_params.output_shift = output_shift;
+  op_params.quantized_activation_min = -128;
+  op_params.quantized_activation_max = 127;
+  const int32_t input_shape_dims[] = {batches, accum_depth};
+  const int32_t filter_shape_dims[] = {output_depth, accum_depth};
+  const int32_t output_shape_dims[] = {batches, output_depth};
+  const tflite::RuntimeShape input_shape(2, input_shape_dims);
+  const tflite::RuntimeShape filter_shape(2, filter_shape_dims);
+  const tflite::RuntimeShape bias_shape(1, &output_depth);
+  const tflite::RuntimeShape output_shape(2, output_shape_dims);
+  const double reference_micros = TimeMicros(iterations, [&] {
+    tflite::reference_integer_ops::FullyConnected(
+        op_params, input_shape, input.data(), filter_shape, filter.data(),
+        bias_shape, bias.data(), output_shape, expected.data());
+  });
+
+  // The per-row loop, as EvalQuantizedInt8 called it for every batch.
+  cmsis_nn_fc_params fc_params;
+  fc_params.input_offset = -input_zero_point;
+  fc_params.filter_offset = 0;
+  fc_params.output_offset = output_zero_point;
+  fc_params.activation.min = -128;
+  fc_params.activation.max = 127;
+  cmsis_nn_per_tensor_quant_params quant_params;
+  quant_params.multiplier = output_multiplier;
+  quant_params.shift = output_shift;
+  const cmsis_nn_dims row_input_dims = {1, 1, 1, accum_depth};
+  const cmsis_nn_dims fc_filter_dims = {accum_depth, 1, 1, output_depth};
+  const cmsis_nn_dims fc_bias_dims = {1, 1, 1, output_depth};
+  const cmsis_nn_dims row_output_dims = {1, 1, 1, output_depth};
+  std::vector<int8_t> buffer(
+      arm_fully_connected_s8_get_buffer_size(&fc_filter_dims) + 1);
+  cmsis_nn_context ctx;
+  ctx.buf = buffer.data();
+  ctx.size = static_cast<int32_t>(buffer.size());
+  const double per_row_micros = TimeMicros(iterations, [&] {
+    for (int b = 0; b < batches; ++b) {
+      arm_fully_connected_s8(&ctx, &fc_params, &quant_params, &row_input_dims,
+                             input.data() + b * accum_depth, &fc_filter_dims,
+                             filter.data(), &fc_bias_dims, bias.data(),
+                             &row_output_dims,
+                             per_row.data() + b * output_depth);
+    }
+  });
+
+  double kernel_micros;
+  if (kernel.TimeInvoke(iterations, &kernel_micros) != kTfLiteOk) {
+    checker->Fail("Invoke");
+    return;
+  }
+  const int mismatches = checker->CountMismatches(
+      expected.data(), actual.data(), expected.size());
+  const int per_row_mismatches = checker->CountMismatches(
+      expected.data(), per_row.data(), expected.size());
+  // The matrix-matrix kernels load every weight once per group of input rows
+  // they process together: 2 rows in the pure C and DSP loops of
+  // arm_nn_mat_mult_nt_t_s8, 4 in the MVE loop of arm_convolve_1x1_s8_fast.
+  const int filter_bytes = output_depth * accum_depth;
+  printf("%5d %5d %9.1f us %9.1f us %9.1f us %6.2fx %8d %8d\n", mismatches,
+         per_row_mismatches, reference_micros, per_row_micros, kernel_micros,
+         per_row_micros / kernel_micros, batches * filter_bytes,
+         (batches + 1) / 2 * filter_bytes);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  kernel_benchmark::Options options = {200};
+  if (!kernel_benchmark::ParseOptions(argc, argv, &options)) {
+    return 1;
+  }
+  Checker checker;
+  printf("%-16s %-9s %5s %5s %12s %12s %12s %7s %8s %8s\n", "shape", "kernel",
+         "diff", "diff", "reference", "per-row", "kernel", "speedup",
+         "weights", "weights");
+  printf("%-16s %-9s %5s %5s %12s %12s %12s %7s %8s %8s\n", "", "",
+         "kernel", "rows", "", "", "", "per-row", "per-row", "kernel");
+  for (const Layer& layer : kLayers) {
+    for (int batches : kBatches) {
+      Benchmark(layer, batches, options.iterations, &checker);
+    }
+  }
+  return checker.ExitStatus();
+}
@@ -0,0 +1,296 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host tool that checks BlockSparseMatVec, the int8 block-sparse path of the
+// FULLY_CONNECTED and 1x1 CONV_2D kernels, against
+// reference_integer_ops::FullyConnected on the same weights stored densely,
+// and times it against the dense CMSIS-NN kernels those layers take
+// otherwise: arm_fully_connected_s8 and arm_convolve_1x1_s8_fast. The sweep
+// covers 0%, 50%, 70%, 80% and 90% of the blocks pruned, for 1x4, 4x1 and
+// 1x16 blocks. For every case the number of outputs that differ, which must
+// be 0, the speedup over the dense kernel and the bytes of the dense weights
+// and of the sparse values and index are printed. The tool exits with 1 if
+// any output differs.
+//
+// The weights are pruned at random and encoded here the way the converter
+// and BlockSparseWeightsInit lay them out, so decoding the flatbuffer
+// sparsity parameters is not part of the timings.
+//
+// Build from the repository root with:
+//   scripts/build_host_tool.sh scripts/benchmark_block_sparse.cpp
+// Set CFLAGS and CXXFLAGS to -fno-tree-vectorize for the build to approximate
+// a core without SIMD, where the dense kernels do not get the auto-vectorized
+// loops of the host.
+//
+// Usage:
+//   benchmark_block_sparse [--iterations=200] [--seed=1]
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "kernel_benchmark.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
+#include "tensorflow/lite/micro/kernels/block_sparse.h"
+#include "third_party/cmsis_nn/Include/arm_nnfunctions.h"
+
+namespace {
+
+using kernel_benchmark::Checker;
+using kernel_benchmark::TimeMicros;
+
+// A FULLY_CONNECTED layer has one pixel, a 1x1 CONV_2D one input vector per
+// pixel of its feature map.
+struct Layer {
+  const char* name;
+  int pixels;
+  int accum_depth;
+  int output_depth;
+};
+
+constexpr Layer kLayers[] = {
+    {"fc", 1, 512, 256},
+    {"conv 1x1", 64, 128, 128},
+};
+
+struct BlockShape {
+  int rows;
+  int cols;
+};
+
+constexpr BlockShape kBlockShapes[] = {{1, 4}, {4, 1}, {1, 16}};
+constexpr int kSparsities[] = {0, 50, 70, 80, 90};
+
+// The block-sparse encoding of a rows x cols filter.
+struct SparseFilter {
+  std::vector<int8_t> values;
+  std::vector<int32_t> block_row_starts;
+  std::vector<uint16_t> block_columns;
+  std::vector<int32_t> input_offset_terms;
+  tflite::BlockSparseWeights weights;
+};
+
+// Zeroes sparsity percent of the blocks of the dense filter at random and
+// encodes the remaining ones: block by block, row of blocks by row of blocks,
+// each block row-major.
+void Prune(const BlockShape& block, int rows, int cols, int sparsity,
+           int32_t input_offset, std::vector<int8_t>* dense,
+           SparseFilter* sparse) {
+  const int num_block_rows = rows / block.rows;
+  const int num_block_cols = cols / block.cols;
+  const int num_blocks = num_block_rows * num_block_cols;
+  std::vector<char> kept(num_blocks, 0);
+  const int num_kept = num_blocks - num_blocks * sparsity / 100;
+  std::fill(kept.begin(), kept.begin() + num_kept, 1);
+  for (int i = num_blocks - 1; i > 0; --i) {
+    std::swap(kept[i], kept[rand() % (i + 1)]);
+  }
+
+  sparse->values.clear();
+  sparse->block_row_starts.assign(1, 0);
+  sparse->block_columns.clear();
+  sparse->input_offset_terms.assign(rows, 0);
+  for (int block_row = 0; block_row < num_block_rows; ++block_row) {
+    for (int block_col = 0; block_col < num_block_cols; ++block_col) {
+      const bool is_kept = kept[block_row * num_block_cols + block_col];
+      if (is_kept) {
+        sparse->block_columns.push_back(static_cast<uint16_t>(block_col));
+      }
+      for (int r = 0; r < block.rows; ++r) {
+        const int row = block_row * block.rows + r;
+        for (int c = 0; c < block.cols; ++c) {
+          int8_t& value = (*dense)[row * cols + block_col * block.cols + c];
+          if (!is_kept) {
+            value = 0;
+            continue;
+          }
+          sparse->values.push_back(value);
+          sparse->input_offset_terms[row] += value * input_offset;
+        }
+      }
+    }
+    sparse->block_row_starts.push_back(
+        static_cast<int32_t>(sparse->block_columns.size()));
+  }
+
+  sparse->weights.block_rows = block.rows;
+  sparse->weights.block_cols = block.cols;
+  sparse->weights.num_block_rows = num_block_rows;
+  sparse->weights.block_row_starts = sparse->block_row_starts.data();
+  sparse->weights.block_columns = sparse->block_columns.data();
+  sparse->weights.input_offset_terms = sparse->input_offset_terms.data();
+}
+
+void Benchmark(const Layer& layer, const BlockShape& block, int sparsity,
+               int iterations, Checker* checker) {
+  const int pixels = layer.pixels;
+  const int accum_depth = layer.accum_depth;
+  const int output_depth = layer.output_depth;
+  std::vector<int8_t> input(pixels * accum_depth);
+  std::vector<int8_t> filter(output_depth * accum_depth);
+  std::vector<int32_t> bias(output_depth);
+  for (int8_t& value : input) value = static_cast<int8_t>(rand());
+  for (int8_t& value : filter) value = static_cast<int8_t>(rand());
+  for (int32_t& value : bias) value = rand() % 8192 - 4096;
+  const int output_size = pixels * output_depth;
+  std::vector<int8_t> expected(output_size);
+  std::vector<int8_t> dense(output_size);
+  std::vector<int8_t> actual(output_size);
+
+  const int input_zero_point = -4;
+  const int output_zero_point = 6;
+  SparseFilter sparse;
+  Prune(block, output_depth, accum_depth, sparsity, -input_zero_point,
+        &filter, &sparse);
+
+  // One multiplier for all rows keeps the reference and the dense CMSIS-NN
+  // kernels comparable. BlockSparseMatVec takes it per row, as both kernels
+  // pass it.
+  int32_t output_multiplier;
+  int output_shift;
+  tflite::QuantizeMultiplier(0.05 * 0.01 / 2.0, &output_multiplier,
+                             &output_shift);
+  std::vector<int32_t> row_multipliers(output_depth, output_multiplier);
+  std::vector<int32_t> row_shifts(output_depth, output_shift);
+
+  char dims[40];
+  snprintf(dims, sizeof(dims), "%s %dx%d->%d", layer.name, pixels,
+           accum_depth, output_depth);
+  char shape[8];
+  snprintf(shape, sizeof(shape), "%dx%d", block.rows, block.cols);
+  printf("%-22s %-5s %3d%% ", dims, shape, sparsity);
+
+  tflite::FullyConnectedParams op_params = {};
+  op_params.input_offset = -input_zero_point;
+  op_params.weights_offset = 0;
+  op_params.output_offset = output_zero_point;
+  op_params.output_multiplier = output_multiplier;
+  op_params.output_shift = output_shift;
+  op_params.quantized_activation_min = -128;
+  op_params.quantized_activation_max = 127;
+  const int32_t input_shape_dims[] = {pixels, accum_depth};
+  const int32_t filter_shape_dims[] = {output_depth, accum_depth};
+  const int32_t output_shape_dims[] = {pixels, output_depth};
+  const tflite::RuntimeShape input_shape(2, input_shape_dims);
+  const tflite::RuntimeShape filter_shape(2, filter_shape_dims);
+  const tflite::RuntimeShape bias_shape(1, &output_depth);
+  const tflite::RuntimeShape output_shape(2, output_shape_dims);
+  const double reference_micros = TimeMicros(iterations, [&] {
+    tflite::reference_integer_ops::FullyConnected(
+        op_params, input_shape, input.data(), filter_shape, filter.data(),
+        bias_shape, bias.data(), output_shape, expected.data());
+  });
+
+  // The dense kernel the layer takes without sparse weights.
+  cmsis_nn_activation activation = {-128, 127};
+  const cmsis_nn_dims bias_dims = {1, 1, 1, output_depth};
+  cmsis_nn_context ctx;
+  std::vector<int8_t> buffer;
+  double dense_micros;
+  if (pixels == 1) {
+    cmsis_nn_fc_params fc_params;
+    fc_params.input_offset = -input_zero_point;
+    fc_params.filter_offset = 0;
+    fc_params.output_offset = output_zero_point;
+    fc_params.activation = activation;
+    cmsis_nn_per_tensor_quant_params quant_params;
+    quant_params.multiplier = output_multiplier;
+    quant_params.shift = output_shift;
+    const cmsis_nn_dims input_dims = {1, 1, 1, accum_depth};
+    const cmsis_nn_dims filter_dims = {accum_depth, 1, 1, output_depth};
+    const cmsis_nn_dims output_dims = {1, 1, 1, output_depth};
+    buffer.resize(arm_fully_connected_s8_get_buffer_size(&filter_dims) + 1);
+    ctx.buf = buffer.data();
+    ctx.size = static_cast<int32_t>(buffer.size());
+    dense_micros = TimeMicros(iterations, [&] {
+      arm_fully_connected_s8(&ctx, &fc_params, &quant_params, &input_dims,
+                             input.data(), &filter_dims, filter.data(),
+                             &bias_dims, bias.data(), &output_dims,
+                             dense.data());
+    });
+  } else {
+    cmsis_nn_conv_params conv_params;
+    conv_params.input_offset = -input_zero_point;
+    conv_params.output_offset = output_zero_point;
+    conv_params.stride = {1, 1};
+    conv_params.padding = {0, 0};
+    conv_params.dilation = {1, 1};
+    conv_params.activation = activation;
+    cmsis_nn_per_channel_quant_params quant_params;
+    quant_params.multiplier = row_multipliers.data();
+    quant_params.shift = row_shifts.data();
+    const cmsis_nn_dims input_dims = {1, 1, pixels, accum_depth};
+    const cmsis_nn_dims filter_dims = {output_depth, 1, 1, accum_depth};
+    const cmsis_nn_dims output_dims = {1, 1, pixels, output_depth};
+    buffer.resize(arm_convolve_1x1_s8_fast_get_buffer_size(&input_dims) + 1);
+    ctx.buf = buffer.data();
+    ctx.size = static_cast<int32_t>(buffer.size());
+    dense_micros = TimeMicros(iterations, [&] {
+      arm_convolve_1x1_s8_fast(&ctx, &conv_params, &quant_params,
+                               &input_dims, input.data(), &filter_dims,
+                               filter.data(), &bias_dims, bias.data(),
+                               &output_dims, dense.data());
+    });
+  }
+
+  // As the FULLY_CONNECTED and CONV_2D kernels call it, once per pixel.
+  const double sparse_micros = TimeMicros(iterations, [&] {
+    for (int p = 0; p < pixels; ++p) {
+      tflite::BlockSparseMatVec(
+          sparse.weights, sparse.values.data(),
+          input.data() + p * accum_depth, bias.data(), row_multipliers.data(),
+          row_shifts.data(), output_zero_point, -128, 127,
+          actual.data() + p * output_depth);
+    }
+  });
+
+  const int mismatches =
+      checker->CountMismatches(expected.data(), actual.data(), output_size);
+  const int dense_mismatches =
+      checker->CountMismatches(expected.data(), dense.data(), output_size);
+  const size_t sparse_bytes =
+      sparse.values.size() +
+      sparse.block_columns.size() * sizeof(uint16_t) +
+      sparse.block_row_starts.size() * sizeof(int32_t);
+  printf("%6d %6d %9.1f us %9.1f us %9.1f us %6.2fx %7zu %7zu\n", mismatches,
+         dense_mismatches, reference_micros, dense_micros, sparse_micros,
+         dense_micros / sparse_micros, filter.size(), sparse_bytes);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  kernel_benchmark::Options options = {200};
+  if (!kernel_benchmark::ParseOptions(argc, argv, &options)) {
+    return 1;
+  }
+  Checker checker;
+  printf("%-22s %-5s %4s %6s %6s %12s %12s %12s %7s %7s %7s\n", "layer",
+         "block", "zero", "diff", "diff", "reference", "dense", "sparse",
+         "speedup", "weights", "weights");
+  printf("%-22s %-5s %4s %6s %6s %12s %12s %12s %7s %7s %7s\n", "", "", "",
+         "sparse", "dense", "", "", "", "dense", "dense", "sparse");
+  for (const Layer& layer : kLayers) {
+    for (const BlockShape& block : kBlockShapes) {
+      for (int sparsity : kSparsities) {
+        Benchmark(layer, block, sparsity, options.iterations, &checker);
+      }
+    }
+  }
+  return checker.ExitStatus();
+}
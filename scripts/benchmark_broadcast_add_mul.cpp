@@ -0,0 +1,234 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host tool that checks the broadcast paths of the int8 and int16 CMSIS-NN
+// ADD and MUL kernels against the BroadcastAdd4DSlow and BroadcastMul4DSlow
+// reference functions they replace, and times both. The shapes cover
+// per-channel vectors, scalars, repeats over an outer dimension and per-pixel
+// values, with either input broadcasting, plus a generic broadcast that both
+// kernels still hand to the slow path. For every shape the number of outputs
+// that differ and the speedup are printed. The tool exits with 1 if any output
+// differs.
+//
+// Build from the repository root with:
+//   scripts/build_host_tool.sh scripts/benchmark_broadcast_add_mul.cpp
+//
+// Usage:
+//   benchmark_broadcast_add_mul [--iterations=1000] [--seed=1]
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "kernel_benchmark.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/reference/add.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/add.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/mul.h"
+#include "tensorflow/lite/micro/kernels/add.h"
+#include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/test_helpers.h"
+
+namespace {
+
+using kernel_benchmark::Checker;
+using kernel_benchmark::KernelBenchmark;
+using kernel_benchmark::TimeMicros;
+
+struct Case {
+  const char* name;
+  int input1_dims[4];
+  int input2_dims[4];
+};
+
+constexpr Case kCases[] = {
+    {"per-channel", {1, 16, 16, 32}, {1, 1, 1, 32}},
+    {"per-channel", {1, 4, 4, 256}, {1, 1, 1, 256}},
+    {"per-channel 1st", {1, 1, 1, 32}, {1, 16, 16, 32}},
+    {"scalar", {1, 16, 16, 32}, {1, 1, 1, 1}},
+    {"scalar 1st", {1, 1, 1, 1}, {1, 16, 16, 32}},
+    {"outer repeat", {1, 16, 16, 32}, {1, 1, 16, 32}},
+    {"batch repeat", {4, 8, 8, 16}, {1, 8, 8, 16}},
+    {"per-pixel", {1, 16, 16, 32}, {1, 16, 16, 1}},
+    {"generic", {2, 16, 1, 32}, {1, 1, 16, 1}},
+};
+
+enum class Op { kAdd, kMul };
+
+template <typename T>
+void Benchmark(Op op, const Case& test_case, int iterations,
+               Checker* checker) {
+  constexpr bool kIsInt8 = sizeof(T) == 1;
+  int input1_dims[5] = {4};
+  int input2_dims[5] = {4};
+  int output_dims[5] = {4};
+  int input1_size = 1;
+  int input2_size = 1;
+  int output_size = 1;
+  for (int i = 0; i < 4; ++i) {
+    input1_dims[i + 1] = test_case.input1_dims[i];
+    input2_dims[i + 1] = test_case.input2_dims[i];
+    output_dims[i + 1] =
+        std::max(test_case.input1_dims[i], test_case.input2_dims[i]);
+    input1_size *= input1_dims[i + 1];
+    input2_size *= input2_dims[i + 1];
+    output_size *= output_dims[i + 1];
+  }
+
+  const int min = kIsInt8 ? -128 : -32768;
+  const int max = kIsInt8 ? 127 : 32767;
+  std::vector<T> input1(input1_size);
+  std::vector<T> input2(input2_size);
+  for (T& value : input1) {
+    value = static_cast<T>(min + rand() % (max - min + 1));
+  }
+  for (T& value : input2) {
+    value = static_cast<T>(min + rand() % (max - min + 1));
+  }
+  std::vector<T> expected(output_size);
+  std::vector<T> actual(output_size);
+
+  // int16 ADD and MUL take symmetric tensors only.
+  const float input1_scale = kIsInt8 ? 0.05f : 1.0f / 1024;
+  const float input2_scale = kIsInt8 ? 0.02f : 1.0f / 2048;
+  const float output_scale = op == Op::kAdd
+                                 ? (kIsInt8 ? 0.06f : 1.0f / 512)
+                                 : input1_scale * input2_scale * max / 8;
+  const int input1_zero_point = kIsInt8 ? 3 : 0;
+  const int input2_zero_point = kIsInt8 ? -7 : 0;
+  const int output_zero_point = kIsInt8 ? 2 : 0;
+
+  TfLiteTensor tensors[3] = {
+      tflite::testing::CreateQuantizedTensor(
+          input1.data(), tflite::testing::IntArrayFromInts(input1_dims),
+          input1_scale, input1_zero_point),
+      tflite::testing::CreateQuantizedTensor(
+          input2.data(), tflite::testing::IntArrayFromInts(input2_dims),
+          input2_scale, input2_zero_point),
+      tflite::testing::CreateQuantizedTensor(
+          actual.data(), tflite::testing::IntArrayFromInts(output_dims),
+          output_scale, output_zero_point),
+  };
+  int inputs_array[] = {2, 0, 1};
+  int outputs_array[] = {1, 2};
+  TfLiteAddParams add_params = {};
+  add_params.activation = kTfLiteActNone;
+  TfLiteMulParams mul_params = {};
+  mul_params.activation = kTfLiteActNone;
+  const TfLiteRegistration registration =
+      op == Op::kAdd ? tflite::Register_ADD() : tflite::Register_MUL();
+  KernelBenchmark kernel(
+      registration, tensors, tflite::testing::IntArrayFromInts(inputs_array),
+      tflite::testing::IntArrayFromInts(outputs_array),
+      op == Op::kAdd ? static_cast<void*>(&add_params)
+                     : static_cast<void*>(&mul_params));
+
+  char dims[48];
+  snprintf(dims, sizeof(dims), "%dx%dx%dx%d %c %dx%dx%dx%d",
+           input1_dims[1], input1_dims[2], input1_dims[3], input1_dims[4],
+           op == Op::kAdd ? '+' : '*', input2_dims[1], input2_dims[2],
+           input2_dims[3], input2_dims[4]);
+  printf("%-5s %-16s %-28s ", kIsInt8 ? "int8" : "int16", test_case.name,
+         dims);
+
+  // The parameters the kernels computed for the slow path before.
+  tflite::ArithmeticParams op_params = {};
+  if (op == Op::kAdd) {
+    TfLiteContext context = {};
+    tflite::OpDataAdd data;
+    if (tflite::CalculateOpDataAdd(&context, &add_params, &tensors[0],
+                                   &tensors[1], &tensors[2],
+                                   &data) != kTfLiteOk) {
+      checker->Fail("Prepare");
+      return;
+    }
+    op_params.left_shift = data.left_shift;
+    op_params.input1_offset = data.input1_offset;
+    op_params.input1_multiplier = data.input1_multiplier;
+    op_params.input1_shift = data.input1_shift;
+    op_params.input2_offset = data.input2_offset;
+    op_params.input2_multiplier = data.input2_multiplier;
+    op_params.input2_shift = data.input2_shift;
+    op_params.output_offset = data.output_offset;
+    op_params.output_multiplier = data.output_multiplier;
+    op_params.output_shift = data.output_shift;
+  } else {
+    op_params.input1_offset = -input1_zero_point;
+    op_params.input2_offset = -input2_zero_point;
+    op_params.output_offset = output_zero_point;
+    tflite::QuantizeMultiplier(static_cast<double>(input1_scale) *
+                                   input2_scale / output_scale,
+                               &op_params.output_multiplier,
+                               &op_params.output_shift);
+  }
+  op_params.quantized_activation_min = min;
+  op_params.quantized_activation_max = max;
+
+  const tflite::RuntimeShape input1_shape(4, input1_dims + 1);
+  const tflite::RuntimeShape input2_shape(4, input2_dims + 1);
+  const tflite::RuntimeShape output_shape(4, output_dims + 1);
+  const double reference_micros = TimeMicros(iterations, [&] {
+    if (op == Op::kMul) {
+      tflite::reference_integer_ops::BroadcastMul4DSlow(
+          op_params, input1_shape, input1.data(), input2_shape, input2.data(),
+          output_shape, expected.data());
+    } else if (kIsInt8) {
+      tflite::reference_integer_ops::BroadcastAdd4DSlow(
+          op_params, input1_shape,
+          reinterpret_cast<const int8_t*>(input1.data()), input2_shape,
+          reinterpret_cast<const int8_t*>(input2.data()), output_shape,
+          reinterpret_cast<int8_t*>(expected.data()));
+    } else {
+      tflite::reference_ops::BroadcastAdd4DSlow(
+          op_params, input1_shape, input1.data(), input2_shape, input2.data(),
+          output_shape, expected.data());
+    }
+  });
+  double kernel_micros;
+  if (kernel.TimeInvoke(iterations, &kernel_micros) != kTfLiteOk) {
+    checker->Fail("Invoke");
+    return;
+  }
+  const int mismatches =
+      checker->CountMismatches(expected.data(), actual.data(), output_size);
+  printf("mismatches %-5d %9.1f us %9.1f us %7.2fx\n", mismatches,
+         reference_micros, kernel_micros, reference_micros / kernel_micros);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  kernel_benchmark::Options options = {1000};
+  if (!kernel_benchmark::ParseOptions(argc, argv, &options)) {
+    return 1;
+  }
+  Checker checker;
+  for (Op op : {Op::kAdd, Op::kMul}) {
+    printf("%s\n", op == Op::kAdd ? "ADD" : "MUL");
+    printf("%-5s %-16s %-28s %-16s %12s %12s %8s\n", "type", "pattern",
+           "shape", "accuracy", "slow path", "kernel", "speedup");
+    for (const Case& test_case : kCases) {
+      Benchmark<int8_t>(op, test_case, options.iterations, &checker);
+    }
+    for (const Case& test_case : kCases) {
+      Benchmark<int16_t>(op, test_case, options.iterations, &checker);
+    }
+  }
+  return checker.ExitStatus();
+}
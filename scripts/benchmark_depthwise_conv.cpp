@@ -0,0 +1,252 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host tool that sweeps the int8 CMSIS-NN DEPTHWISE_CONV_2D kernel over
+// filter sizes, channel multipliers, strides and dilations, checks it against
+// reference_integer_ops::DepthwiseConvPerChannel and times it against the
+// reference and against the generic arm_depthwise_conv_s8 that handled the
+// channel multipliers above 1 and the dilated layers before. Besides a 2D
+// feature map, the sweep covers the 1D dilated filters of audio models. For
+// every shape the number of outputs that differ and the speedup over the
+// generic kernel are printed. The tool exits with 1 if any output differs.
+//
+// Build from the repository root with:
+//   scripts/build_host_tool.sh scripts/benchmark_depthwise_conv.cpp
+// This times the pure C loops of CMSIS-NN. To time their ARM_MATH_DSP loops,
+// set CFLAGS and CXXFLAGS to -DTF_LITE_MICRO_CMSIS_NN_EMULATE_DSP for the
+// build, see check_cmsis_nn_dsp.cpp. The MVE loops cannot run on the host.
+//
+// Usage:
+//   benchmark_depthwise_conv [--iterations=100] [--seed=1]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "kernel_benchmark.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/depthwise_conv.h"
+#include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/test_helpers.h"
+#include "third_party/cmsis_nn/Include/arm_nnfunctions.h"
+
+namespace {
+
+using kernel_benchmark::Checker;
+using kernel_benchmark::KernelBenchmark;
+using kernel_benchmark::TimeMicros;
+
+struct Shape {
+  int height;
+  int width;
+  int input_depth;
+  int filter_height;
+  int filter_width;
+  int depth_multiplier;
+  int stride;
+  int dilation;
+};
+
+void Benchmark(const Shape& shape, int iterations, Checker* checker) {
+  const int input_depth = shape.input_depth;
+  const int output_depth = input_depth * shape.depth_multiplier;
+  int output_height;
+  int output_width;
+  const TfLitePaddingValues padding = tflite::ComputePaddingHeightWidth(
+      shape.stride, shape.stride, shape.dilation, shape.dilation, shape.height,
+      shape.width, shape.filter_height, shape.filter_width, kTfLitePaddingSame,
+      &output_height, &output_width);
+
+  std::vector<int8_t> input(shape.height * shape.width * input_depth);
+  std::vector<int8_t> filter(shape.filter_height * shape.filter_width *
+                             output_depth);
+  std::vector<int32_t> bias(output_depth);
+  for (int8_t& value : input) value = static_cast<int8_t>(rand());
+  for (int8_t& value : filter) value = static_cast<int8_t>(rand());
+  for (int32_t& value : bias) value = rand() % 8192 - 4096;
+  const int output_size = output_height * output_width * output_depth;
+  std::vector<int8_t> expected(output_size);
+  std::vector<int8_t> generic(output_size);
+  std::vector<int8_t> actual(output_size);
+
+  const float input_scale = 0.05f;
+  const float output_scale = 0.5f;
+  const int input_zero_point = -3;
+  const int output_zero_point = 5;
+  std::vector<float> filter_scales(output_depth + 1);
+  std::vector<int> filter_zero_points(output_depth + 1, 0);
+  filter_scales[0] = output_depth;
+  filter_zero_points[0] = output_depth;
+  std::vector<int32_t> output_multiplier(output_depth);
+  std::vector<int32_t> output_shift(output_depth);
+  for (int c = 0; c < output_depth; ++c) {
+    filter_scales[c + 1] = 0.002f + 0.0005f * (c % 7);
+    // As in PopulateConvolutionQuantizationParams.
+    int shift;
+    tflite::QuantizeMultiplier(static_cast<double>(input_scale) *
+                                   filter_scales[c + 1] / output_scale,
+                               &output_multiplier[c], &shift);
+    output_shift[c] = shift;
+  }
+
+  int input_dims[] = {4, 1, shape.height, shape.width, input_depth};
+  int filter_dims[] = {4, 1, shape.filter_height, shape.filter_width,
+                       output_depth};
+  int bias_dims[] = {1, output_depth};
+  int output_dims[] = {4, 1, output_height, output_width, output_depth};
+  TfLiteAffineQuantization filter_quantization = {
+      tflite::testing::FloatArrayFromFloats(filter_scales.data()),
+      tflite::testing::IntArrayFromInts(filter_zero_points.data()), 3};
+  TfLiteTensor tensors[4] = {
+      tflite::testing::CreateQuantizedTensor(
+          input.data(), tflite::testing::IntArrayFromInts(input_dims),
+          input_scale, input_zero_point),
+      tflite::testing::CreateTensor(
+          filter.data(), tflite::testing::IntArrayFromInts(filter_dims)),
+      tflite::testing::CreateQuantizedTensor(
+          bias.data(), tflite::testing::IntArrayFromInts(bias_dims),
+          input_scale * filter_scales[1], 0),
+      tflite::testing::CreateQuantizedTensor(
+          actual.data(), tflite::testing::IntArrayFromInts(output_dims),
+          output_scale, output_zero_point),
+  };
+  tensors[1].quantization = {kTfLiteAffineQuantization, &filter_quantization};
+  tensors[1].allocation_type = kTfLiteMmapRo;
+  tensors[2].allocation_type = kTfLiteMmapRo;
+  int inputs_array[] = {3, 0, 1, 2};
+  int outputs_array[] = {1, 3};
+  TfLiteDepthwiseConvParams params = {};
+  params.padding = kTfLitePaddingSame;
+  params.stride_width = shape.stride;
+  params.stride_height = shape.stride;
+  params.depth_multiplier = shape.depth_multiplier;
+  params.activation = kTfLiteActNone;
+  params.dilation_width_factor = shape.dilation;
+  params.dilation_height_factor = shape.dilation;
+  const TfLiteRegistration registration = tflite::Register_DEPTHWISE_CONV_2D();
+  KernelBenchmark kernel(registration, tensors,
+                         tflite::testing::IntArrayFromInts(inputs_array),
+                         tflite::testing::IntArrayFromInts(outputs_array),
+                         &params);
+
+  char dims[48];
+  snprintf(dims, sizeof(dims), "%dx%dx%d %dx%d m%d s%d d%d", shape.height,
+           shape.width, input_depth, shape.filter_height, shape.filter_width,
+           shape.depth_multiplier, shape.stride, shape.dilation);
+  printf("%-28s ", dims);
+
+  tflite::DepthwiseParams op_params = {};
+  op_params.padding_values.width = padding.width;
+  op_params.padding_values.height = padding.height;
+  op_params.stride_width = shape.stride;
+  op_params.stride_height = shape.stride;
+  op_params.dilation_width_factor = shape.dilation;
+  op_params.dilation_height_factor = shape.dilation;
+  op_params.depth_multiplier = shape.depth_multiplier;
+  op_params.input_offset = -input_zero_point;
+  op_params.weights_offset = 0;
+  op_params.output_offset = output_zero_point;
+  op_params.quantized_activation_min = -128;
+  op_params.quantized_activation_max = 127;
+  const tflite::RuntimeShape input_shape(4, input_dims + 1);
+  const tflite::RuntimeShape filter_shape(4, filter_dims + 1);
+  const tflite::RuntimeShape bias_shape(1, &output_depth);
+  const tflite::RuntimeShape output_shape(4, output_dims + 1);
+  const double reference_micros = TimeMicros(iterations, [&] {
+    tflite::reference_integer_ops::DepthwiseConvPerChannel(
+        op_params, output_multiplier.data(), output_shift.data(), input_shape,
+        input.data(), filter_shape, filter.data(), bias_shape, bias.data(),
+        output_shape, expected.data());
+  });
+
+  cmsis_nn_dw_conv_params dw_conv_params;
+  dw_conv_params.input_offset = -input_zero_point;
+  dw_conv_params.output_offset = output_zero_point;
+  dw_conv_params.ch_mult = shape.depth_multiplier;
+  dw_conv_params.stride.h = shape.stride;
+  dw_conv_params.stride.w = shape.stride;
+  dw_conv_params.padding.h = padding.height;
+  dw_conv_params.padding.w = padding.width;
+  dw_conv_params.dilation.h = shape.dilation;
+  dw_conv_params.dilation.w = shape.dilation;
+  dw_conv_params.activation.min = -128;
+  dw_conv_params.activation.max = 127;
+  cmsis_nn_per_channel_quant_params quant_params;
+  quant_params.multiplier = output_multiplier.data();
+  quant_params.shift = output_shift.data();
+  const cmsis_nn_dims cmsis_input_dims = {1, shape.height, shape.width,
+                                          input_depth};
+  const cmsis_nn_dims cmsis_filter_dims = {1, shape.filter_height,
+                                           shape.filter_width, output_depth};
+  const cmsis_nn_dims cmsis_bias_dims = {1, 1, 1, output_depth};
+  const cmsis_nn_dims cmsis_output_dims = {1, output_height, output_width,
+                                           output_depth};
+  cmsis_nn_context ctx = {nullptr, 0};
+  const double generic_micros = TimeMicros(iterations, [&] {
+    arm_depthwise_conv_s8(&ctx, &dw_conv_params, &quant_params,
+                          &cmsis_input_dims, input.data(), &cmsis_filter_dims,
+                          filter.data(), &cmsis_bias_dims, bias.data(),
+                          &cmsis_output_dims, generic.data());
+  });
+
+  double kernel_micros;
+  if (kernel.TimeInvoke(iterations, &kernel_micros) != kTfLiteOk) {
+    checker->Fail("Invoke");
+    return;
+  }
+  const int mismatches =
+      checker->CountMismatches(expected.data(), actual.data(), output_size);
+  const int generic_mismatches =
+      checker->CountMismatches(expected.data(), generic.data(), output_size);
+  printf("%6d %7d %9.1f us %9.1f us %9.1f us %7.2fx\n", mismatches,
+         generic_mismatches, reference_micros, generic_micros, kernel_micros,
+         generic_micros / kernel_micros);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  kernel_benchmark::Options options = {100};
+  if (!kernel_benchmark::ParseOptions(argc, argv, &options)) {
+    return 1;
+  }
+  Checker checker;
+  printf("%-28s %6s %7s %12s %12s %12s %8s\n", "shape", "diff", "diff",
+         "reference", "generic", "kernel", "speedup");
+  printf("%-28s %6s %7s %12s %12s %12s %8s\n", "", "kernel", "generic", "",
+         "", "", "generic");
+  for (int filter_size : {3, 5}) {
+    for (int depth_multiplier : {1, 2, 4, 8}) {
+      for (int stride : {1, 2}) {
+        for (int dilation : {1, 2}) {
+          Benchmark({16, 16, 8, filter_size, filter_size, depth_multiplier,
+                     stride, dilation},
+                    options.iterations, &checker);
+        }
+      }
+    }
+  }
+  for (int filter_size : {3, 5}) {
+    for (int dilation : {1, 2, 4, 8}) {
+      Benchmark({1, 64, 32, 1, filter_size, 1, 1, dilation},
+                options.iterations, &checker);
+    }
+  }
+  return checker.ExitStatus();
+}
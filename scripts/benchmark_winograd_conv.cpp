@@ -0,0 +1,312 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host tool that checks the float and int16 CONV_2D kernel, which runs the
+// Winograd kernels of src/tensorflow/lite/micro/kernels/winograd_conv.h for
+// the layers that winograd::PrepareConv admits, against reference_ops::Conv
+// and reference_integer_ops::ConvPerChannel on random data and times both for
+// a range of 3x3 convolutions. For every shape the number of outputs that
+// differ, by more than 1e-4 for float, and the speedup are printed. Shapes
+// that PrepareConv leaves on the direct convolution show the speedup of that.
+// Every shape is prepared on an arena of its own, so the budget of
+// TF_LITE_MICRO_WINOGRAD_CONV_MAX_BYTES applies to each shape alone. The tool
+// exits with 1 if any output differs.
+//
+// Build from the repository root with:
+//   export CXXFLAGS=-DTF_LITE_MICRO_WINOGRAD_CONV_MAX_BYTES=1048576
+//   scripts/build_host_tool.sh scripts/benchmark_winograd_conv.cpp
+//
+// Usage:
+//   benchmark_winograd_conv [--iterations=20] [--seed=1]
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "kernel_benchmark.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/reference/conv.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
+#include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/kernels/conv.h"
+#include "tensorflow/lite/micro/kernels/winograd_conv.h"
+#include "tensorflow/lite/micro/test_helpers.h"
+
+#if TF_LITE_MICRO_WINOGRAD_CONV_MAX_BYTES == 0
+#error "Build with -DTF_LITE_MICRO_WINOGRAD_CONV_MAX_BYTES set, see above."
+#endif
+
+namespace {
+
+using kernel_benchmark::Checker;
+using kernel_benchmark::KernelBenchmark;
+using kernel_benchmark::TimeMicros;
+
+struct Shape {
+  int batches;
+  int height;
+  int width;
+  int input_depth;
+  int output_depth;
+  TfLitePadding padding;
+};
+
+constexpr Shape kShapes[] = {
+    {1, 8, 8, 3, 8, kTfLitePaddingSame},
+    {1, 16, 16, 8, 8, kTfLitePaddingSame},
+    {1, 16, 16, 16, 16, kTfLitePaddingValid},
+    {1, 16, 16, 32, 64, kTfLitePaddingSame},
+    {1, 32, 32, 16, 16, kTfLitePaddingSame},
+    {1, 32, 32, 32, 32, kTfLitePaddingValid},
+    {2, 24, 24, 16, 32, kTfLitePaddingSame},
+    {1, 49, 10, 8, 16, kTfLitePaddingSame},
+};
+
+// The dimensions of one convolution, with the size in front as
+// IntArrayFromInts expects it.
+struct Dims {
+  explicit Dims(const Shape& shape) {
+    int output_height;
+    int output_width;
+    padding = tflite::ComputePaddingHeightWidth(
+        1, 1, 1, 1, shape.height, shape.width, 3, 3, shape.padding,
+        &output_height, &output_width);
+    const int input[] = {4, shape.batches, shape.height, shape.width,
+                         shape.input_depth};
+    const int filter[] = {4, shape.output_depth, 3, 3, shape.input_depth};
+    const int output[] = {4, shape.batches, output_height, output_width,
+                          shape.output_depth};
+    for (int i = 0; i < 5; ++i) {
+      input_dims[i] = input[i];
+      filter_dims[i] = filter[i];
+      output_dims[i] = output[i];
+    }
+    bias_dims[0] = 1;
+    bias_dims[1] = shape.output_depth;
+  }
+
+  tflite::RuntimeShape input_shape() const {
+    return tflite::RuntimeShape(4, input_dims + 1);
+  }
+  tflite::RuntimeShape filter_shape() const {
+    return tflite::RuntimeShape(4, filter_dims + 1);
+  }
+  tflite::RuntimeShape bias_shape() const {
+    return tflite::RuntimeShape(1, bias_dims + 1);
+  }
+  tflite::RuntimeShape output_shape() const {
+    return tflite::RuntimeShape(4, output_dims + 1);
+  }
+
+  // The op params of the reference kernels, without the activation range.
+  tflite::ConvParams ConvParams() const {
+    tflite::ConvParams params = {};
+    params.padding_values.width = padding.width;
+    params.padding_values.height = padding.height;
+    params.stride_width = 1;
+    params.stride_height = 1;
+    params.dilation_width_factor = 1;
+    params.dilation_height_factor = 1;
+    return params;
+  }
+
+  TfLitePaddingValues padding;
+  int input_dims[5];
+  int filter_dims[5];
+  int bias_dims[2];
+  int output_dims[5];
+};
+
+TfLiteConvParams BuiltinParams(const Shape& shape) {
+  TfLiteConvParams params = {};
+  params.padding = shape.padding;
+  params.stride_width = 1;
+  params.stride_height = 1;
+  params.dilation_width_factor = 1;
+  params.dilation_height_factor = 1;
+  params.activation = kTfLiteActNone;
+  return params;
+}
+
+float RandomFloat() { return 2.0f * rand() / RAND_MAX - 1.0f; }
+
+void PrintShape(const Shape& shape, const char* type) {
+  char dims[32];
+  snprintf(dims, sizeof(dims), "%dx%dx%dx%d -> %d", shape.batches,
+           shape.height, shape.width, shape.input_depth, shape.output_depth);
+  printf("%-6s %-18s %-5s ", type, dims,
+         shape.padding == kTfLitePaddingSame ? "SAME" : "VALID");
+}
+
+void PrintResult(int mismatches, double reference_micros,
+                 double kernel_micros) {
+  printf("%6d %10.1f us %10.1f us %7.2fx\n", mismatches, reference_micros,
+         kernel_micros, reference_micros / kernel_micros);
+}
+
+void BenchmarkFloat(const Shape& shape, int iterations, Checker* checker) {
+  Dims dims(shape);
+  const tflite::RuntimeShape output_shape = dims.output_shape();
+  std::vector<float> input(dims.input_shape().FlatSize());
+  std::vector<float> filter(dims.filter_shape().FlatSize());
+  std::vector<float> bias(shape.output_depth);
+  for (float& value : input) value = RandomFloat();
+  for (float& value : filter) value = RandomFloat();
+  for (float& value : bias) value = RandomFloat();
+  std::vector<float> expected(output_shape.FlatSize());
+  std::vector<float> actual(expected.size());
+
+  TfLiteTensor tensors[4] = {
+      tflite::testing::CreateTensor(
+          input.data(), tflite::testing::IntArrayFromInts(dims.input_dims)),
+      tflite::testing::CreateTensor(
+          filter.data(), tflite::testing::IntArrayFromInts(dims.filter_dims)),
+      tflite::testing::CreateTensor(
+          bias.data(), tflite::testing::IntArrayFromInts(dims.bias_dims)),
+      tflite::testing::CreateTensor(
+          actual.data(), tflite::testing::IntArrayFromInts(dims.output_dims)),
+  };
+  tensors[1].allocation_type = kTfLiteMmapRo;
+  tensors[2].allocation_type = kTfLiteMmapRo;
+  int inputs_array[] = {3, 0, 1, 2};
+  int outputs_array[] = {1, 3};
+  TfLiteConvParams params = BuiltinParams(shape);
+  const TfLiteRegistration registration = tflite::Register_CONV_2D();
+  KernelBenchmark kernel(registration, tensors,
+                         tflite::testing::IntArrayFromInts(inputs_array),
+                         tflite::testing::IntArrayFromInts(outputs_array),
+                         &params);
+
+  PrintShape(shape, "float");
+  tflite::ConvParams op_params = dims.ConvParams();
+  op_params.float_activation_min = -INFINITY;
+  op_params.float_activation_max = INFINITY;
+  const double reference_micros = TimeMicros(iterations, [&] {
+    tflite::reference_ops::Conv(
+        op_params, dims.input_shape(), input.data(), dims.filter_shape(),
+        filter.data(), dims.bias_shape(), bias.data(), output_shape,
+        expected.data(), tflite::RuntimeShape(), nullptr);
+  });
+  double kernel_micros;
+  if (kernel.TimeInvoke(iterations, &kernel_micros) != kTfLiteOk) {
+    checker->Fail("Invoke");
+    return;
+  }
+  PrintResult(checker->CountMismatches(expected.data(), actual.data(),
+                                       expected.size(), 1e-4f),
+              reference_micros, kernel_micros);
+}
+
+void BenchmarkInt16(const Shape& shape, int iterations, Checker* checker) {
+  Dims dims(shape);
+  const tflite::RuntimeShape output_shape = dims.output_shape();
+  std::vector<int16_t> input(dims.input_shape().FlatSize());
+  std::vector<int8_t> filter(dims.filter_shape().FlatSize());
+  std::vector<int64_t> bias(shape.output_depth);
+  for (int16_t& value : input) value = static_cast<int16_t>(rand());
+  for (int8_t& value : filter) value = static_cast<int8_t>(rand());
+  for (int64_t& value : bias) value = (rand() % (1 << 20)) - (1 << 19);
+  std::vector<int16_t> expected(output_shape.FlatSize());
+  std::vector<int16_t> actual(expected.size());
+
+  // The output scale brings the sums of the products into the int16 range.
+  const float input_scale = 0.5f;
+  const float output_scale = input_scale * 9 * 128 * shape.input_depth;
+  std::vector<float> filter_scales(shape.output_depth + 1);
+  std::vector<int> filter_zero_points(shape.output_depth + 1, 0);
+  filter_scales[0] = shape.output_depth;
+  filter_zero_points[0] = shape.output_depth;
+  std::vector<int32_t> output_multiplier(shape.output_depth);
+  std::vector<int32_t> output_shift(shape.output_depth);
+  for (int c = 0; c < shape.output_depth; ++c) {
+    filter_scales[c + 1] = 0.5f + 0.5f * rand() / RAND_MAX;
+    // As in PopulateConvolutionQuantizationParams.
+    int shift;
+    tflite::QuantizeMultiplier(static_cast<double>(input_scale) *
+                                   filter_scales[c + 1] / output_scale,
+                               &output_multiplier[c], &shift);
+    output_shift[c] = shift;
+  }
+
+  TfLiteAffineQuantization filter_quantization = {
+      tflite::testing::FloatArrayFromFloats(filter_scales.data()),
+      tflite::testing::IntArrayFromInts(filter_zero_points.data()), 0};
+  TfLiteTensor tensors[4] = {
+      tflite::testing::CreateQuantizedTensor(
+          input.data(), tflite::testing::IntArrayFromInts(dims.input_dims),
+          input_scale, 0),
+      tflite::testing::CreateTensor(
+          filter.data(), tflite::testing::IntArrayFromInts(dims.filter_dims)),
+      tflite::testing::CreateQuantizedTensor(
+          bias.data(), tflite::testing::IntArrayFromInts(dims.bias_dims),
+          input_scale * filter_scales[1], 0),
+      tflite::testing::CreateQuantizedTensor(
+          actual.data(), tflite::testing::IntArrayFromInts(dims.output_dims),
+          output_scale, 0),
+  };
+  tensors[1].quantization = {kTfLiteAffineQuantization, &filter_quantization};
+  tensors[1].allocation_type = kTfLiteMmapRo;
+  tensors[2].allocation_type = kTfLiteMmapRo;
+  int inputs_array[] = {3, 0, 1, 2};
+  int outputs_array[] = {1, 3};
+  TfLiteConvParams params = BuiltinParams(shape);
+  const TfLiteRegistration registration = tflite::Register_CONV_2D();
+  KernelBenchmark kernel(registration, tensors,
+                         tflite::testing::IntArrayFromInts(inputs_array),
+                         tflite::testing::IntArrayFromInts(outputs_array),
+                         &params);
+
+  PrintShape(shape, "int16");
+  tflite::ConvParams op_params = dims.ConvParams();
+  op_params.quantized_activation_min = INT16_MIN;
+  op_params.quantized_activation_max = INT16_MAX;
+  const double reference_micros = TimeMicros(iterations, [&] {
+    tflite::reference_integer_ops::ConvPerChannel(
+        op_params, output_multiplier.data(), output_shift.data(),
+        dims.input_shape(), input.data(), dims.filter_shape(), filter.data(),
+        dims.bias_shape(), bias.data(), output_shape, expected.data());
+  });
+  double kernel_micros;
+  if (kernel.TimeInvoke(iterations, &kernel_micros) != kTfLiteOk) {
+    checker->Fail("Invoke");
+    return;
+  }
+  PrintResult(
+      checker->CountMismatches(expected.data(), actual.data(), expected.size()),
+      reference_micros, kernel_micros);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  kernel_benchmark::Options options = {20};
+  if (!kernel_benchmark::ParseOptions(argc, argv, &options)) {
+    return 1;
+  }
+  Checker checker;
+  printf("%-6s %-24s %6s %13s %13s %8s\n", "type", "shape", "diff",
+         "reference", "kernel", "speedup");
+  for (const Shape& shape : kShapes) {
+    BenchmarkFloat(shape, options.iterations, &checker);
+  }
+  for (const Shape& shape : kShapes) {
+    BenchmarkInt16(shape, options.iterations, &checker);
+  }
+  return checker.ExitStatus();
+}
@@ -0,0 +1,92 @@
+#!/usr/bin/env bash
+# Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+#
+# Builds one of the host tools in this directory that link against the
+# library, e.g. the kernel benchmarks, for the host. The library sources under
+# src/tensorflow and src/third_party are compiled with -DARDUINO, as the
+# Arduino IDE compiles them, so that the tools run the CMSIS-NN kernels of the
+# library. The tools provide DebugLog themselves.
+#
+# Extra flags in CFLAGS and CXXFLAGS apply to the library and the tool alike,
+# e.g. -fno-tree-vectorize or -DTF_LITE_MICRO_CMSIS_NN_EMULATE_DSP. The
+# library objects are kept per set of flags in ${BUILD_DIR}, which defaults to
+# /tmp/tflm_host_tools, and are only rebuilt when their source or one of the
+# headers it includes changes.
+#
+# Usage:
+#   scripts/build_host_tool.sh scripts/<tool>.cpp [output]
+
+set -e
+
+if [ $# -lt 1 ] || [ $# -gt 2 ]; then
+  echo "Usage: $0 scripts/<tool>.cpp [output]" >&2
+  exit 1
+fi
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+SRC_DIR="${SCRIPT_DIR}/../src"
+TOOL="$(cd "$(dirname "${1}")" && pwd)/$(basename "${1}")"
+OUTPUT="${2:-$(basename "${1}" .cpp)}"
+case "${OUTPUT}" in
+  /*) ;;
+  *) OUTPUT="${PWD}/${OUTPUT}" ;;
+esac
+
+COMMON_FLAGS="-O2 -DARDUINO -DTF_LITE_USE_CTIME -I${SRC_DIR} \
+  -I${SRC_DIR}/third_party/flatbuffers/include \
+  -I${SRC_DIR}/third_party/gemmlowp -I${SRC_DIR}/third_party/ruy \
+  -I${SRC_DIR}/third_party/kissfft -I${SRC_DIR}/third_party/cmsis_nn \
+  -I${SRC_DIR}/third_party/cmsis_nn/Include"
+ALL_CFLAGS="-std=c11 ${COMMON_FLAGS} ${CFLAGS}"
+ALL_CXXFLAGS="-std=c++17 -fno-exceptions ${COMMON_FLAGS} ${CXXFLAGS}"
+
+BUILD_DIR="${BUILD_DIR:-/tmp/tflm_host_tools}"
+OBJ_DIR="${BUILD_DIR}/$(echo "${ALL_CFLAGS} ${ALL_CXXFLAGS}" | cksum | cut -d' ' -f1)"
+mkdir -p "${OBJ_DIR}"
+
+# Compiles the source ${1}, relative to src, into ${OBJ_DIR} unless its
+# object is newer than the source and the headers listed in its dependency
+# file.
+function compile {
+  local object="${OBJ_DIR}/$(echo "${1}" | tr / _).o"
+  local deps="${object%.o}.d"
+  if [ -f "${object}" ] && [ -f "${deps}" ]; then
+    local stale=0
+    for dep in $(sed -e 's/^[^:]*://' -e 's/\\$//' "${deps}"); do
+      if [ "${dep}" -nt "${object}" ]; then
+        stale=1
+        break
+      fi
+    done
+    if [ "${stale}" -eq 0 ]; then
+      return
+    fi
+  fi
+  case "${1}" in
+    *.c) gcc ${ALL_CFLAGS} -MMD -MF "${deps}" -c "${SRC_DIR}/${1}" \
+           -o "${object}" ;;
+    *) g++ ${ALL_CXXFLAGS} -MMD -MF "${deps}" -c "${SRC_DIR}/${1}" \
+         -o "${object}" ;;
+  esac
+}
+export -f compile
+export SRC_DIR OBJ_DIR ALL_CFLAGS ALL_CXXFLAGS
+
+cd "${SRC_DIR}"
+find tensorflow third_party -name '*.c' -o -name '*.cpp' | sort |
+  xargs -P "$(nproc)" -I{} bash -c 'compile {}'
+
+g++ ${ALL_CXXFLAGS} "${TOOL}" "${OBJ_DIR}"/*.o -o "${OUTPUT}"
@@ -0,0 +1,250 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host tool that finds the smallest tensor arena a .tflite model needs, see
+// src/tensorflow/lite/micro/arena_size_calculator.h. The arena is grown until
+// the model fits, then the minimum is searched for and reported with its
+// breakdown into head and tail. Optionally, a header that defines the arena
+// size constant is written, so that CI can regenerate it for every model.
+//
+// The model is allocated with the kernels of AllOpsResolver, which need the
+// same arena as any other resolver that registers the same kernels.
+//
+// Build from the repository root with:
+//   scripts/build_host_tool.sh scripts/calculate_arena_size.cpp
+//
+// Usage:
+//   calculate_arena_size [--planner=greedy|linear|multi_region]
+//     [--region=65536:1]... [--max_arena_size=67108864]
+//     [--header=arena_size.h] [--name=kTensorArenaSize] [--verbose]
+//     model.tflite
+//
+// --region adds a fast memory region of the given size and latency weight to
+// the multi_region planner, whose arena latency weight is 3. --verbose shows
+// the log of the failed allocations of the search.
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/arena_size_calculator.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/micro/memory_planner/linear_memory_planner.h"
+#include "tensorflow/lite/micro/memory_planner/multi_region_memory_planner.h"
+#include "tensorflow/lite/micro/micro_arena_constants.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace {
+
+// Failed allocations are expected while searching, so only show the log when
+// asked to.
+bool log_enabled = false;
+
+struct RegionOption {
+  size_t size;
+  int latency_weight;
+};
+
+struct Options {
+  std::string planner = "greedy";
+  std::vector<RegionOption> regions;
+  size_t max_arena_size = 64 * 1024 * 1024;
+  std::string header;
+  std::string name = "kTensorArenaSize";
+  bool verbose = false;
+  std::string model;
+};
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    if (strncmp(arg, "--planner=", 10) == 0) {
+      options->planner = arg + 10;
+    } else if (strncmp(arg, "--region=", 9) == 0) {
+      char* end = nullptr;
+      RegionOption region;
+      region.size = strtoul(arg + 9, &end, 10);
+      if (*end != ':') {
+        return false;
+      }
+      region.latency_weight = atoi(end + 1);
+      options->regions.push_back(region);
+    } else if (strncmp(arg, "--max_arena_size=", 17) == 0) {
+      options->max_arena_size = strtoul(arg + 17, nullptr, 10);
+    } else if (strncmp(arg, "--header=", 9) == 0) {
+      options->header = arg + 9;
+    } else if (strncmp(arg, "--name=", 7) == 0) {
+      options->name = arg + 7;
+    } else if (strcmp(arg, "--verbose") == 0) {
+      options->verbose = true;
+    } else if (arg[0] == '-') {
+      return false;
+    } else if (options->model.empty()) {
+      options->model = arg;
+    } else {
+      return false;
+    }
+  }
+  if (options->planner != "greedy" && options->planner != "linear" &&
+      options->planner != "multi_region") {
+    return false;
+  }
+  if (!options->regions.empty() && options->planner != "multi_region") {
+    return false;
+  }
+  return !options->model.empty() &&
+         options->regions.size() <
+             static_cast<size_t>(tflite::MultiRegionMemoryPlanner::kMaxRegions);
+}
+
+// Returns the include guard for the header, e.g. PERSON_ARENA_SIZE_H_ for
+// out/person_arena_size.h.
+std::string IncludeGuard(const std::string& header) {
+  std::string guard;
+  const size_t slash = header.find_last_of('/');
+  for (char c : header.substr(slash == std::string::npos ? 0 : slash + 1)) {
+    guard += isalnum(static_cast<unsigned char>(c))
+                 ? static_cast<char>(toupper(static_cast<unsigned char>(c)))
+                 : '_';
+  }
+  return guard + "_";
+}
+
+bool WriteHeader(const Options& options,
+                 const tflite::ArenaSizeReport& report) {
+  FILE* file = fopen(options.header.c_str(), "w");
+  if (file == nullptr) {
+    fprintf(stderr, "Failed to open %s\n", options.header.c_str());
+    return false;
+  }
+  const std::string guard = IncludeGuard(options.header);
+  fprintf(file,
+          "// Generated by scripts/calculate_arena_size.cpp from %s with the "
+          "%s\n"
+          "// memory planner. Do not edit.\n\n",
+          options.model.c_str(), options.planner.c_str());
+  fprintf(file, "#ifndef %s\n#define %s\n\n", guard.c_str(), guard.c_str());
+  fprintf(file,
+          "// Minimum tensor arena size for an arena aligned to %d bytes: %zu "
+          "bytes of\n"
+          "// head, %zu bytes of tail and %zu bytes only needed for "
+          "planning.\n",
+          tflite::MicroArenaBufferAlignment(), report.non_persistent_bytes,
+          report.tail_bytes, report.planning_bytes);
+  fprintf(file, "constexpr int %s = %zu;\n\n", options.name.c_str(),
+          report.arena_size);
+  fprintf(file, "#endif  // %s\n", guard.c_str());
+  fclose(file);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    fprintf(stderr,
+            "Usage: %s [--planner=greedy|linear|multi_region] "
+            "[--region=65536:1]... [--max_arena_size=67108864] "
+            "[--header=arena_size.h] [--name=kTensorArenaSize] [--verbose] "
+            "model.tflite\n",
+            argv[0]);
+    return 1;
+  }
+  log_enabled = options.verbose;
+
+  std::ifstream file(options.model, std::ios::binary);
+  std::vector<char> buffer((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+  if (buffer.empty()) {
+    fprintf(stderr, "Failed to read %s\n", options.model.c_str());
+    return 1;
+  }
+  const tflite::Model* model = tflite::GetModel(buffer.data());
+  tflite::AllOpsResolver op_resolver;
+
+  tflite::LinearMemoryPlanner linear_planner;
+  tflite::MultiRegionMemoryPlanner multi_region_planner;
+  std::vector<std::vector<uint8_t>> region_buffers;
+  tflite::MicroMemoryPlanner* memory_planner = nullptr;
+  if (options.planner == "linear") {
+    memory_planner = &linear_planner;
+  } else if (options.planner == "multi_region") {
+    multi_region_planner.set_arena_latency_weight(3);
+    for (const RegionOption& region : options.regions) {
+      region_buffers.emplace_back(region.size +
+                                  tflite::MicroArenaBufferAlignment());
+      multi_region_planner.AddRegion(
+          tflite::AlignPointerUp(region_buffers.back().data(),
+                                 tflite::MicroArenaBufferAlignment()),
+          region.size, region.latency_weight);
+    }
+    memory_planner = &multi_region_planner;
+  }
+
+  // Grow the arena until the model fits.
+  tflite::ArenaSizeReport report;
+  TfLiteStatus status = kTfLiteError;
+  for (size_t arena_size = 64 * 1024;
+       status != kTfLiteOk && arena_size <= options.max_arena_size;
+       arena_size *= 2) {
+    std::unique_ptr<uint8_t[]> arena(
+        new uint8_t[arena_size + tflite::MicroArenaBufferAlignment()]);
+    status = tflite::CalculateArenaSize(
+        model, op_resolver, arena.get(),
+        arena_size + tflite::MicroArenaBufferAlignment(), memory_planner,
+        &report);
+  }
+  if (status != kTfLiteOk) {
+    fprintf(stderr, "%s does not fit in an arena of %zu bytes\n",
+            options.model.c_str(), options.max_arena_size);
+    return 1;
+  }
+
+  printf("%s with the %s memory planner:\n", options.model.c_str(),
+         options.planner.c_str());
+  printf("  arena size            %8zu bytes\n", report.arena_size);
+  printf("  used after allocation %8zu bytes\n", report.used_bytes);
+  printf("    head (non-persistent) %8zu bytes\n",
+         report.non_persistent_bytes);
+  printf("      scratch buffers     %8zu bytes in %zu buffers\n",
+         report.scratch_bytes, report.scratch_buffer_count);
+  printf("    tail                  %8zu bytes\n", report.tail_bytes);
+  printf("      persistent buffers  %8zu bytes\n",
+         report.persistent_buffer_bytes);
+  printf("  only for planning     %8zu bytes\n", report.planning_bytes);
+  printf("Add %d bytes if the arena is not aligned to %d bytes.\n",
+         tflite::MicroArenaBufferAlignment() - 1,
+         tflite::MicroArenaBufferAlignment());
+
+  if (!options.header.empty() && !WriteHeader(options, report)) {
+    return 1;
+  }
+  return 0;
+}
+
+extern "C" void DebugLog(const char* s) {
+  if (log_enabled) {
+    fputs(s, stderr);
+  }
+}
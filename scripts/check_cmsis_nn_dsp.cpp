@@ -0,0 +1,519 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host tool that runs the ARM_MATH_DSP paths of the CMSIS-NN convolution,
+// depthwise convolution and fully connected kernels through the emulated
+// intrinsics of src/tensorflow/lite/micro/kernels/cmsis_nn/dsp_emulation.h
+// and compares them with reference_integer_ops on random shapes, parameters
+// and data. The outputs must be bit-exact. The number of cases with
+// differing outputs is printed per kernel, and the first of them in full.
+//
+// Build from the repository root by compiling it together with the CMSIS-NN
+// sources, src/third_party/cmsis_nn/Source/*/*.c, on the host with
+// -DTF_LITE_MICRO_CMSIS_NN_EMULATE_DSP and include paths src and
+// src/third_party/cmsis_nn.
+//
+// Usage:
+//   check_cmsis_nn_dsp [--cases=500] [--seed=1]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/depthwise_conv.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "third_party/cmsis_nn/Include/arm_nnfunctions.h"
+
+#if !defined(ARM_MATH_DSP)
+#error "Build with -DTF_LITE_MICRO_CMSIS_NN_EMULATE_DSP, see above."
+#endif
+
+namespace {
+
+struct Options {
+  int cases = 500;
+  unsigned seed = 1;
+};
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    if (strncmp(arg, "--cases=", 8) == 0) {
+      options->cases = atoi(arg + 8);
+    } else if (strncmp(arg, "--seed=", 7) == 0) {
+      options->seed = static_cast<unsigned>(strtoul(arg + 7, nullptr, 10));
+    } else {
+      return false;
+    }
+  }
+  return options->cases > 0;
+}
+
+tflite::RuntimeShape MakeShape(std::initializer_list<int32_t> dims) {
+  return tflite::RuntimeShape(static_cast<int>(dims.size()), dims.begin());
+}
+
+// Returns a random integer in [min, max].
+int Random(int min, int max) { return min + rand() % (max - min + 1); }
+
+template <typename T>
+void Fill(std::vector<T>* values, int min, int max) {
+  for (T& value : *values) {
+    value = static_cast<T>(Random(min, max));
+  }
+}
+
+// Fills per-channel multipliers in [2^30, 2^31) with shifts that map sums of
+// depth products of full-range values roughly onto the output range, so that
+// both rounding and saturation are exercised.
+void FillMultipliers(int depth, int value_bits,
+                     std::vector<int32_t>* multiplier,
+                     std::vector<int32_t>* shift) {
+  int sum_bits = 14 + value_bits - 8;
+  for (int d = depth; d > 1; d >>= 1) {
+    ++sum_bits;
+  }
+  for (size_t i = 0; i < multiplier->size(); ++i) {
+    (*multiplier)[i] = (1 << 30) + Random(0, (1 << 30) - 1);
+    (*shift)[i] = value_bits - sum_bits + Random(-2, 2);
+  }
+}
+
+// Picks activation limits that clamp some of the outputs in a quarter of the
+// cases.
+void PickActivation(int min, int max, int32_t* activation_min,
+                    int32_t* activation_max) {
+  *activation_min = min;
+  *activation_max = max;
+  if (Random(0, 3) == 0) {
+    *activation_min = Random(min, min / 2);
+    *activation_max = Random(max / 2, max);
+  }
+}
+
+// Result of one kernel over all cases.
+struct Tally {
+  const char* name;
+  int cases = 0;
+  int failed_cases = 0;
+};
+
+// Compares the outputs of a case and prints the first failing one.
+template <typename T>
+void Check(const char* description, const std::vector<T>& expected,
+           const std::vector<T>& actual, Tally* tally) {
+  ++tally->cases;
+  int mismatches = 0;
+  for (size_t i = 0; i < expected.size(); ++i) {
+    mismatches += expected[i] != actual[i];
+  }
+  if (mismatches == 0) {
+    return;
+  }
+  if (tally->failed_cases++ == 0) {
+    printf("%s: %s: %d of %zu outputs differ\n", tally->name, description,
+           mismatches, expected.size());
+  }
+}
+
+struct ConvShape {
+  int batches;
+  int input_height;
+  int input_width;
+  int input_depth;
+  int output_depth;
+  int filter_height;
+  int filter_width;
+  int stride;
+  int dilation;
+  int pad_height;
+  int pad_width;
+  int output_height;
+  int output_width;
+};
+
+// Picks a random convolution shape. Input depths that are multiples of 4,
+// 1x1 filters and rows of height 1 are favoured, since the wrappers select
+// their specialized kernels for them.
+ConvShape RandomConvShape(int input_depth, int output_depth) {
+  ConvShape shape;
+  int padded_height;
+  int padded_width;
+  int effective_height;
+  int effective_width;
+  do {
+    shape.batches = Random(1, 2);
+    shape.input_height = Random(0, 3) == 0 ? 1 : Random(1, 12);
+    shape.input_width = Random(1, 12);
+    shape.input_depth = input_depth;
+    shape.output_depth = output_depth;
+    const int kFilterSizes[] = {1, 1, 2, 3, 3, 5};
+    shape.filter_height =
+        shape.input_height == 1 ? 1 : kFilterSizes[Random(0, 5)];
+    shape.filter_width = kFilterSizes[Random(0, 5)];
+    shape.stride = Random(0, 2) == 0 ? 2 : 1;
+    shape.dilation = Random(0, 4) == 0 ? 2 : 1;
+    shape.pad_height = Random(0, shape.filter_height / 2);
+    shape.pad_width = Random(0, shape.filter_width / 2);
+    padded_height = shape.input_height + 2 * shape.pad_height;
+    padded_width = shape.input_width + 2 * shape.pad_width;
+    effective_height = (shape.filter_height - 1) * shape.dilation + 1;
+    effective_width = (shape.filter_width - 1) * shape.dilation + 1;
+  } while (padded_height < effective_height || padded_width < effective_width);
+  shape.output_height = (padded_height - effective_height) / shape.stride + 1;
+  shape.output_width = (padded_width - effective_width) / shape.stride + 1;
+  return shape;
+}
+
+int RandomDepth() {
+  return Random(0, 1) == 0 ? 4 * Random(1, 4) : Random(1, 12);
+}
+
+void Describe(const ConvShape& shape, char* description, size_t size) {
+  snprintf(description, size,
+           "%dx%dx%dx%d, filter %dx%d -> %d, stride %d, dilation %d, "
+           "pad %dx%d",
+           shape.batches, shape.input_height, shape.input_width,
+           shape.input_depth, shape.filter_height, shape.filter_width,
+           shape.output_depth, shape.stride, shape.dilation, shape.pad_height,
+           shape.pad_width);
+}
+
+void SetConvParams(const ConvShape& shape, cmsis_nn_conv_params* conv_params,
+                   tflite::ConvParams* params) {
+  conv_params->stride.h = shape.stride;
+  conv_params->stride.w = shape.stride;
+  conv_params->dilation.h = shape.dilation;
+  conv_params->dilation.w = shape.dilation;
+  conv_params->padding.h = shape.pad_height;
+  conv_params->padding.w = shape.pad_width;
+  *params = {};
+  params->stride_height = shape.stride;
+  params->stride_width = shape.stride;
+  params->dilation_height_factor = shape.dilation;
+  params->dilation_width_factor = shape.dilation;
+  params->padding_values.height = shape.pad_height;
+  params->padding_values.width = shape.pad_width;
+  params->input_offset = conv_params->input_offset;
+  params->output_offset = conv_params->output_offset;
+  params->quantized_activation_min = conv_params->activation.min;
+  params->quantized_activation_max = conv_params->activation.max;
+}
+
+void CheckConvS8(Tally* tally) {
+  const ConvShape shape = RandomConvShape(RandomDepth(), Random(1, 12));
+  const cmsis_nn_dims input_dims = {shape.batches, shape.input_height,
+                                    shape.input_width, shape.input_depth};
+  const cmsis_nn_dims filter_dims = {shape.output_depth, shape.filter_height,
+                                     shape.filter_width, shape.input_depth};
+  const cmsis_nn_dims bias_dims = {1, 1, 1, shape.output_depth};
+  const cmsis_nn_dims output_dims = {shape.batches, shape.output_height,
+                                     shape.output_width, shape.output_depth};
+  std::vector<int8_t> input(shape.batches * shape.input_height *
+                            shape.input_width * shape.input_depth);
+  std::vector<int8_t> filter(shape.output_depth * shape.filter_height *
+                             shape.filter_width * shape.input_depth);
+  std::vector<int32_t> bias(shape.output_depth);
+  std::vector<int32_t> multiplier(shape.output_depth);
+  std::vector<int32_t> shift(shape.output_depth);
+  Fill(&input, -128, 127);
+  Fill(&filter, -127, 127);
+  Fill(&bias, -(1 << 14), 1 << 14);
+  FillMultipliers(shape.filter_height * shape.filter_width * shape.input_depth,
+                  8, &multiplier, &shift);
+
+  cmsis_nn_conv_params conv_params;
+  conv_params.input_offset = Random(-127, 128);
+  conv_params.output_offset = Random(-128, 127);
+  PickActivation(-128, 127, &conv_params.activation.min,
+                 &conv_params.activation.max);
+  tflite::ConvParams params;
+  SetConvParams(shape, &conv_params, &params);
+
+  std::vector<int8_t> expected(shape.batches * shape.output_height *
+                               shape.output_width * shape.output_depth);
+  tflite::reference_integer_ops::ConvPerChannel(
+      params, multiplier.data(), shift.data(),
+      MakeShape({shape.batches, shape.input_height,
+                            shape.input_width, shape.input_depth}),
+      input.data(),
+      MakeShape({shape.output_depth, shape.filter_height,
+                            shape.filter_width, shape.input_depth}),
+      filter.data(), MakeShape({shape.output_depth}), bias.data(),
+      MakeShape({shape.batches, shape.output_height,
+                            shape.output_width, shape.output_depth}),
+      expected.data());
+
+  std::vector<int8_t> actual(expected.size());
+  const cmsis_nn_per_channel_quant_params quant_params = {multiplier.data(),
+                                                          shift.data()};
+  std::vector<int8_t> buffer(arm_convolve_wrapper_s8_get_buffer_size(
+      &conv_params, &input_dims, &filter_dims, &output_dims));
+  const cmsis_nn_context ctx = {buffer.data(),
+                                static_cast<int32_t>(buffer.size())};
+  char description[128];
+  Describe(shape, description, sizeof(description));
+  if (arm_convolve_wrapper_s8(&ctx, &conv_params, &quant_params, &input_dims,
+                              input.data(), &filter_dims, filter.data(),
+                              &bias_dims, bias.data(), &output_dims,
+                              actual.data()) != ARM_CMSIS_NN_SUCCESS) {
+    // The wrapper only rejects shapes it has no kernel for.
+    return;
+  }
+  Check(description, expected, actual, tally);
+}
+
+void CheckConvS16(Tally* tally) {
+  const ConvShape shape = RandomConvShape(RandomDepth(), Random(1, 12));
+  const cmsis_nn_dims input_dims = {shape.batches, shape.input_height,
+                                    shape.input_width, shape.input_depth};
+  const cmsis_nn_dims filter_dims = {shape.output_depth, shape.filter_height,
+                                     shape.filter_width, shape.input_depth};
+  const cmsis_nn_dims bias_dims = {1, 1, 1, shape.output_depth};
+  const cmsis_nn_dims output_dims = {shape.batches, shape.output_height,
+                                     shape.output_width, shape.output_depth};
+  std::vector<int16_t> input(shape.batches * shape.input_height *
+                             shape.input_width * shape.input_depth);
+  std::vector<int8_t> filter(shape.output_depth * shape.filter_height *
+                             shape.filter_width * shape.input_depth);
+  std::vector<int64_t> bias(shape.output_depth);
+  std::vector<int32_t> multiplier(shape.output_depth);
+  std::vector<int32_t> shift(shape.output_depth);
+  Fill(&input, -32768, 32767);
+  Fill(&filter, -127, 127);
+  Fill(&bias, -(1 << 22), 1 << 22);
+  FillMultipliers(shape.filter_height * shape.filter_width * shape.input_depth,
+                  16, &multiplier, &shift);
+
+  // int16 convolutions have no zero points.
+  cmsis_nn_conv_params conv_params;
+  conv_params.input_offset = 0;
+  conv_params.output_offset = 0;
+  PickActivation(-32768, 32767, &conv_params.activation.min,
+                 &conv_params.activation.max);
+  tflite::ConvParams params;
+  SetConvParams(shape, &conv_params, &params);
+
+  std::vector<int16_t> expected(shape.batches * shape.output_height *
+                                shape.output_width * shape.output_depth);
+  tflite::reference_integer_ops::ConvPerChannel(
+      params, multiplier.data(), shift.data(),
+      MakeShape({shape.batches, shape.input_height,
+                            shape.input_width, shape.input_depth}),
+      input.data(),
+      MakeShape({shape.output_depth, shape.filter_height,
+                            shape.filter_width, shape.input_depth}),
+      filter.data(), MakeShape({shape.output_depth}), bias.data(),
+      MakeShape({shape.batches, shape.output_height,
+                            shape.output_width, shape.output_depth}),
+      expected.data());
+
+  std::vector<int16_t> actual(expected.size());
+  const cmsis_nn_per_channel_quant_params quant_params = {multiplier.data(),
+                                                          shift.data()};
+  std::vector<int8_t> buffer(arm_convolve_wrapper_s16_get_buffer_size(
+      &conv_params, &input_dims, &filter_dims, &output_dims));
+  const cmsis_nn_context ctx = {buffer.data(),
+                                static_cast<int32_t>(buffer.size())};
+  char description[128];
+  Describe(shape, description, sizeof(description));
+  if (arm_convolve_wrapper_s16(&ctx, &conv_params, &quant_params, &input_dims,
+                               input.data(), &filter_dims, filter.data(),
+                               &bias_dims, bias.data(), &output_dims,
+                               actual.data()) != ARM_CMSIS_NN_SUCCESS) {
+    return;
+  }
+  Check(description, expected, actual, tally);
+}
+
+void CheckDepthwiseConvS8(Tally* tally) {
+  const int input_depth = RandomDepth();
+  const int depth_multiplier = Random(0, 1) == 0 ? 1 : Random(1, 3);
+  ConvShape shape =
+      RandomConvShape(input_depth, input_depth * depth_multiplier);
+  // The depthwise kernels take a single batch.
+  shape.batches = 1;
+  const cmsis_nn_dims input_dims = {1, shape.input_height, shape.input_width,
+                                    shape.input_depth};
+  const cmsis_nn_dims filter_dims = {1, shape.filter_height,
+                                     shape.filter_width, shape.output_depth};
+  const cmsis_nn_dims bias_dims = {1, 1, 1, shape.output_depth};
+  const cmsis_nn_dims output_dims = {1, shape.output_height,
+                                     shape.output_width, shape.output_depth};
+  std::vector<int8_t> input(shape.input_height * shape.input_width *
+                            shape.input_depth);
+  std::vector<int8_t> filter(shape.filter_height * shape.filter_width *
+                             shape.output_depth);
+  std::vector<int32_t> bias(shape.output_depth);
+  std::vector<int32_t> multiplier(shape.output_depth);
+  std::vector<int32_t> shift(shape.output_depth);
+  Fill(&input, -128, 127);
+  Fill(&filter, -127, 127);
+  Fill(&bias, -(1 << 14), 1 << 14);
+  FillMultipliers(shape.filter_height * shape.filter_width, 8, &multiplier,
+                  &shift);
+
+  cmsis_nn_dw_conv_params dw_conv_params;
+  dw_conv_params.input_offset = Random(-127, 128);
+  dw_conv_params.output_offset = Random(-128, 127);
+  dw_conv_params.ch_mult = depth_multiplier;
+  dw_conv_params.stride.h = shape.stride;
+  dw_conv_params.stride.w = shape.stride;
+  dw_conv_params.dilation.h = shape.dilation;
+  dw_conv_params.dilation.w = shape.dilation;
+  dw_conv_params.padding.h = shape.pad_height;
+  dw_conv_params.padding.w = shape.pad_width;
+  PickActivation(-128, 127, &dw_conv_params.activation.min,
+                 &dw_conv_params.activation.max);
+
+  tflite::DepthwiseParams params = {};
+  params.stride_height = shape.stride;
+  params.stride_width = shape.stride;
+  params.dilation_height_factor = shape.dilation;
+  params.dilation_width_factor = shape.dilation;
+  params.padding_values.height = shape.pad_height;
+  params.padding_values.width = shape.pad_width;
+  params.depth_multiplier = depth_multiplier;
+  params.input_offset = dw_conv_params.input_offset;
+  params.output_offset = dw_conv_params.output_offset;
+  params.quantized_activation_min = dw_conv_params.activation.min;
+  params.quantized_activation_max = dw_conv_params.activation.max;
+
+  std::vector<int8_t> expected(shape.output_height * shape.output_width *
+                               shape.output_depth);
+  tflite::reference_integer_ops::DepthwiseConvPerChannel(
+      params, multiplier.data(), shift.data(),
+      MakeShape({1, shape.input_height, shape.input_width,
+                            shape.input_depth}),
+      input.data(),
+      MakeShape({1, shape.filter_height, shape.filter_width,
+                            shape.output_depth}),
+      filter.data(), MakeShape({shape.output_depth}), bias.data(),
+      MakeShape({1, shape.output_height, shape.output_width,
+                            shape.output_depth}),
+      expected.data());
+
+  std::vector<int8_t> actual(expected.size());
+  const cmsis_nn_per_channel_quant_params quant_params = {multiplier.data(),
+                                                          shift.data()};
+  std::vector<int8_t> buffer(arm_depthwise_conv_wrapper_s8_get_buffer_size(
+      &dw_conv_params, &input_dims, &filter_dims, &output_dims));
+  const cmsis_nn_context ctx = {buffer.data(),
+                                static_cast<int32_t>(buffer.size())};
+  char description[160];
+  Describe(shape, description, sizeof(description));
+  const size_t length = strlen(description);
+  snprintf(description + length, sizeof(description) - length,
+           ", multiplier %d", depth_multiplier);
+  if (arm_depthwise_conv_wrapper_s8(
+          &ctx, &dw_conv_params, &quant_params, &input_dims, input.data(),
+          &filter_dims, filter.data(), &bias_dims, bias.data(), &output_dims,
+          actual.data()) != ARM_CMSIS_NN_SUCCESS) {
+    return;
+  }
+  Check(description, expected, actual, tally);
+}
+
+void CheckFullyConnectedS8(Tally* tally) {
+  const int batches = Random(1, 4);
+  const int accum_depth = Random(0, 1) == 0 ? 4 * Random(1, 16) : Random(1, 64);
+  const int output_depth = Random(1, 32);
+  const cmsis_nn_dims input_dims = {batches, 1, 1, accum_depth};
+  const cmsis_nn_dims filter_dims = {accum_depth, 1, 1, output_depth};
+  const cmsis_nn_dims bias_dims = {1, 1, 1, output_depth};
+  const cmsis_nn_dims output_dims = {batches, 1, 1, output_depth};
+  std::vector<int8_t> input(batches * accum_depth);
+  std::vector<int8_t> filter(output_depth * accum_depth);
+  std::vector<int32_t> bias(output_depth);
+  std::vector<int32_t> multiplier(1);
+  std::vector<int32_t> shift(1);
+  Fill(&input, -128, 127);
+  Fill(&filter, -127, 127);
+  Fill(&bias, -(1 << 14), 1 << 14);
+  FillMultipliers(accum_depth, 8, &multiplier, &shift);
+
+  cmsis_nn_fc_params fc_params;
+  fc_params.input_offset = Random(-127, 128);
+  fc_params.filter_offset = 0;
+  fc_params.output_offset = Random(-128, 127);
+  PickActivation(-128, 127, &fc_params.activation.min,
+                 &fc_params.activation.max);
+
+  tflite::FullyConnectedParams params = {};
+  params.input_offset = fc_params.input_offset;
+  params.output_offset = fc_params.output_offset;
+  params.output_multiplier = multiplier[0];
+  params.output_shift = shift[0];
+  params.quantized_activation_min = fc_params.activation.min;
+  params.quantized_activation_max = fc_params.activation.max;
+
+  std::vector<int8_t> expected(batches * output_depth);
+  tflite::reference_integer_ops::FullyConnected(
+      params, MakeShape({batches, accum_depth}), input.data(),
+      MakeShape({output_depth, accum_depth}), filter.data(),
+      MakeShape({output_depth}), bias.data(),
+      MakeShape({batches, output_depth}), expected.data());
+
+  std::vector<int8_t> actual(expected.size());
+  const cmsis_nn_per_tensor_quant_params quant_params = {multiplier[0],
+                                                         shift[0]};
+  std::vector<int8_t> buffer(
+      arm_fully_connected_s8_get_buffer_size(&filter_dims));
+  const cmsis_nn_context ctx = {buffer.data(),
+                                static_cast<int32_t>(buffer.size())};
+  char description[64];
+  snprintf(description, sizeof(description), "%dx%d -> %d", batches,
+           accum_depth, output_depth);
+  if (arm_fully_connected_s8(&ctx, &fc_params, &quant_params, &input_dims,
+                             input.data(), &filter_dims, filter.data(),
+                             &bias_dims, bias.data(), &output_dims,
+                             actual.data()) != ARM_CMSIS_NN_SUCCESS) {
+    return;
+  }
+  Check(description, expected, actual, tally);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    fprintf(stderr, "Usage: %s [--cases=500] [--seed=1]\n", argv[0]);
+    return 1;
+  }
+  srand(options.seed);
+  Tally tallies[] = {{"arm_convolve_wrapper_s8"},
+                     {"arm_convolve_wrapper_s16"},
+                     {"arm_depthwise_conv_wrapper_s8"},
+                     {"arm_fully_connected_s8"}};
+  for (int i = 0; i < options.cases; ++i) {
+    CheckConvS8(&tallies[0]);
+    CheckConvS16(&tallies[1]);
+    CheckDepthwiseConvS8(&tallies[2]);
+    CheckFullyConnectedS8(&tallies[3]);
+  }
+  int failed_cases = 0;
+  for (const Tally& tally : tallies) {
+    printf("%-30s %5d cases, %5d differ\n", tally.name, tally.cases,
+           tally.failed_cases);
+    failed_cases += tally.failed_cases;
+  }
+  return failed_cases == 0 ? 0 : 1;
+}
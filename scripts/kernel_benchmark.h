@@ -0,0 +1,253 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Helpers shared by the host kernel benchmarks in this directory: the command
+// line options, timing, a runner for the kernels and the accuracy checks that
+// decide the exit status. Each benchmark is a single source file that includes
+// this header once, see build_host_tool.sh for how to build it.
+
+#ifndef SCRIPTS_KERNEL_BENCHMARK_H_
+#define SCRIPTS_KERNEL_BENCHMARK_H_
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/arena_allocator/single_arena_buffer_allocator.h"
+#include "tensorflow/lite/micro/fake_micro_context.h"
+#include "tensorflow/lite/micro/micro_context.h"
+#include "tensorflow/lite/micro/mock_micro_graph.h"
+
+namespace kernel_benchmark {
+
+// --iterations is the number of timed calls of every kernel, --seed seeds the
+// random data.
+struct Options {
+  int iterations;
+  unsigned seed = 1;
+};
+
+// Parses the command line into options, whose iterations hold the default of
+// the benchmark, and seeds rand. Prints the usage and returns false on
+// arguments it does not know.
+inline bool ParseOptions(int argc, char** argv, Options* options) {
+  const int default_iterations = options->iterations;
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    if (strncmp(arg, "--iterations=", 13) == 0) {
+      options->iterations = atoi(arg + 13);
+    } else if (strncmp(arg, "--seed=", 7) == 0) {
+      options->seed = static_cast<unsigned>(strtoul(arg + 7, nullptr, 10));
+    } else {
+      options->iterations = 0;
+      break;
+    }
+  }
+  if (options->iterations <= 0) {
+    fprintf(stderr, "Usage: %s [--iterations=%d] [--seed=1]\n", argv[0],
+            default_iterations);
+    return false;
+  }
+  srand(options->seed);
+  return true;
+}
+
+// Counts the outputs that differ from the reference and the kernels that
+// failed over all shapes of a benchmark, so that it can serve as an accuracy
+// check.
+class Checker {
+ public:
+  // Returns how many of the size outputs differ and adds them to the total.
+  template <typename T>
+  int CountMismatches(const T* expected, const T* actual, size_t size) {
+    int mismatches = 0;
+    for (size_t i = 0; i < size; ++i) {
+      mismatches += expected[i] != actual[i];
+    }
+    mismatches_ += mismatches;
+    return mismatches;
+  }
+
+  // Same for float outputs, which differ if they are further apart than
+  // tolerance.
+  int CountMismatches(const float* expected, const float* actual, size_t size,
+                      float tolerance) {
+    int mismatches = 0;
+    for (size_t i = 0; i < size; ++i) {
+      mismatches += std::fabs(expected[i] - actual[i]) > tolerance;
+    }
+    mismatches_ += mismatches;
+    return mismatches;
+  }
+
+  // Records a kernel that failed, what names the failed step.
+  void Fail(const char* what) {
+    printf("%s failed\n", what);
+    ++failures_;
+  }
+
+  // Returns the exit status of the benchmark, 1 if any output differed or any
+  // kernel failed, after printing a summary of those.
+  int ExitStatus() const {
+    if (mismatches_ == 0 && failures_ == 0) {
+      return 0;
+    }
+    fprintf(stderr, "FAILED: %d mismatches, %d failed kernels\n",
+            mismatches_, failures_);
+    return 1;
+  }
+
+ private:
+  int mismatches_ = 0;
+  int failures_ = 0;
+};
+
+// Returns the average microseconds of a call of fn.
+template <typename Fn>
+double TimeMicros(int iterations, Fn fn) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    fn();
+  }
+  const std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / iterations;
+}
+
+// Runs the init, prepare and invoke of a kernel like
+// tflite::micro::KernelRunner, but on an arena of its own that is large
+// enough for the scratch buffers of big shapes. FakeMicroContext takes a new
+// temp allocation for every TfLiteEvalTensor a kernel asks for and never
+// releases it, so an arena fills up after enough invocations. TimeInvoke
+// therefore prepares the kernel again on a fresh arena for every
+// kInvokesPerPrepare invocations, and only the invocations are timed.
+class KernelBenchmark {
+ public:
+  static constexpr size_t kArenaSize = 4 * 1024 * 1024;
+  static constexpr int kInvokesPerPrepare = 1000;
+
+  KernelBenchmark(const TfLiteRegistration& registration,
+                  TfLiteTensor* tensors, TfLiteIntArray* inputs,
+                  TfLiteIntArray* outputs, void* builtin_data)
+      : registration_(registration),
+        tensors_(tensors),
+        arena_(new uint8_t[kArenaSize]) {
+    node_.inputs = inputs;
+    node_.outputs = outputs;
+    node_.builtin_data = builtin_data;
+  }
+
+  // Prepares the kernel and invokes it once, which leaves its outputs in the
+  // output tensors.
+  TfLiteStatus Invoke() {
+    Session session(this);
+    TF_LITE_ENSURE_STATUS(session.Prepare());
+    return session.Invoke();
+  }
+
+  // Sets *micros to the average microseconds of an invocation.
+  TfLiteStatus TimeInvoke(int iterations, double* micros) {
+    double total = 0;
+    for (int done = 0; done < iterations; done += kInvokesPerPrepare) {
+      const int count = iterations - done < kInvokesPerPrepare
+                            ? iterations - done
+                            : kInvokesPerPrepare;
+      Session session(this);
+      TF_LITE_ENSURE_STATUS(session.Prepare());
+      TfLiteStatus status = kTfLiteOk;
+      total += count * TimeMicros(count, [&] {
+                 if (session.Invoke() != kTfLiteOk) {
+                   status = kTfLiteError;
+                 }
+               });
+      TF_LITE_ENSURE_STATUS(status);
+    }
+    *micros = total / iterations;
+    return kTfLiteOk;
+  }
+
+ private:
+  // The kernel state from one init and prepare on a fresh arena.
+  class Session {
+   public:
+    explicit Session(KernelBenchmark* benchmark)
+        : benchmark_(benchmark),
+          allocator_(tflite::SingleArenaBufferAllocator::Create(
+              benchmark->arena_.get(), kArenaSize)),
+          graph_(allocator_),
+          micro_context_(benchmark->tensors_, allocator_, &graph_) {
+      context_.impl_ = &micro_context_;
+      context_.ReportError = tflite::MicroContextReportOpError;
+      context_.GetTensor = tflite::MicroContextGetTensor;
+      context_.GetEvalTensor = tflite::MicroContextGetEvalTensor;
+      context_.AllocatePersistentBuffer =
+          tflite::MicroContextAllocatePersistentBuffer;
+      context_.RequestScratchBufferInArena =
+          tflite::MicroContextRequestScratchBufferInArena;
+      context_.GetScratchBuffer = tflite::MicroContextGetScratchBuffer;
+      context_.GetExternalContext = tflite::MicroContextGetExternalContext;
+      node_ = benchmark->node_;
+    }
+
+    ~Session() {
+      if (prepared_ && benchmark_->registration_.free != nullptr) {
+        benchmark_->registration_.free(&context_, node_.user_data);
+      }
+    }
+
+    TfLiteStatus Prepare() {
+      const TfLiteRegistration& registration = benchmark_->registration_;
+      if (registration.init != nullptr) {
+        node_.user_data = registration.init(&context_, nullptr, 0);
+      }
+      prepared_ = true;
+      if (registration.prepare != nullptr) {
+        TF_LITE_ENSURE_STATUS(registration.prepare(&context_, &node_));
+      }
+      return kTfLiteOk;
+    }
+
+    TfLiteStatus Invoke() {
+      return benchmark_->registration_.invoke(&context_, &node_);
+    }
+
+   private:
+    KernelBenchmark* benchmark_;
+    tflite::SingleArenaBufferAllocator* allocator_;
+    tflite::MockMicroGraph graph_;
+    tflite::FakeMicroContext micro_context_;
+    TfLiteContext context_ = {};
+    TfLiteNode node_ = {};
+    bool prepared_ = false;
+  };
+
+  const TfLiteRegistration registration_;
+  TfLiteTensor* tensors_;
+  std::unique_ptr<uint8_t[]> arena_;
+  TfLiteNode node_ = {};
+};
+
+}  // namespace kernel_benchmark
+
+// The library log goes to stderr, apart from the tables the benchmarks print.
+extern "C" void DebugLog(const char* s) { fputs(s, stderr); }
+
+#endif  // SCRIPTS_KERNEL_BENCHMARK_H_
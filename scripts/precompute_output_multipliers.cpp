@@ -0,0 +1,230 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host tool that precomputes the per-channel output multipliers and shifts of
+// the quantized CONV_2D and DEPTHWISE_CONV_2D operators in a .tflite model and
+// stores them in the model, see
+// src/tensorflow/lite/micro/micro_output_multipliers.h for the format. The
+// kernels then read them from flash instead of computing them into the arena
+// in Prepare.
+//
+// Every precomputed operator saves 8 bytes of arena per channel and costs an
+// entry of about 20 bytes, so operators with fewer than --min_channels
+// channels are skipped. FULLY_CONNECTED operators are only included with
+// --fully_connected, since only its batched and sparse kernels use per-channel
+// parameters.
+//
+// Build from the repository root with:
+//   g++ -std=c++17 -O2 -Isrc -Isrc/third_party/flatbuffers/include
+//     scripts/precompute_output_multipliers.cpp
+//     src/tensorflow/lite/kernels/internal/quantization_util.cpp
+//     src/tensorflow/lite/schema/schema_utils.cpp
+//     -o precompute_output_multipliers
+//
+// Usage:
+//   precompute_output_multipliers [--min_channels=8] [--fully_connected]
+//     input.tflite output.tflite
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/micro/micro_output_multipliers.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/schema/schema_utils.h"
+
+namespace {
+
+struct Options {
+  int min_channels = 8;
+  bool fully_connected = false;
+  std::string input;
+  std::string output;
+};
+
+bool HasScales(const tflite::TensorT* tensor) {
+  return tensor->quantization != nullptr &&
+         !tensor->quantization->scale.empty();
+}
+
+// Precomputes the output multipliers of an operator the same way
+// PopulateConvolutionQuantizationParams() does. Returns false if the kernel
+// does not take per-channel parameters for it.
+bool Precompute(const Options& options, tflite::ModelT* model,
+                int subgraph_index, const tflite::OperatorT& op,
+                tflite::BuiltinOperator code, std::vector<uint32_t>* metadata,
+                int* num_channels) {
+  const tflite::SubGraphT* subgraph = model->subgraphs[subgraph_index].get();
+  if (op.inputs.size() < 2 || op.inputs[0] < 0 || op.inputs[1] < 0 ||
+      op.outputs.empty()) {
+    return false;
+  }
+  const tflite::TensorT* input = subgraph->tensors[op.inputs[0]].get();
+  const tflite::TensorT* filter = subgraph->tensors[op.inputs[1]].get();
+  const tflite::TensorT* output = subgraph->tensors[op.outputs[0]].get();
+  if ((input->type != tflite::TensorType_INT8 &&
+       input->type != tflite::TensorType_INT16) ||
+      (filter->type != tflite::TensorType_INT8 &&
+       filter->type != tflite::TensorType_INT4) ||
+      !HasScales(input) || !HasScales(filter) || !HasScales(output)) {
+    return false;
+  }
+
+  // The quantized dimension of the filter, see the kernels.
+  const size_t channel_dimension =
+      code == tflite::BuiltinOperator_DEPTHWISE_CONV_2D ? 3 : 0;
+  if (filter->shape.size() <= channel_dimension) {
+    return false;
+  }
+  *num_channels = filter->shape[channel_dimension];
+  const std::vector<float>& filter_scales = filter->quantization->scale;
+  // Fully connected kernels only use the per-tensor scale.
+  const bool is_per_channel = code != tflite::BuiltinOperator_FULLY_CONNECTED &&
+                              filter_scales.size() > 1;
+  if ((is_per_channel &&
+       static_cast<int>(filter_scales.size()) != *num_channels) ||
+      *num_channels < options.min_channels) {
+    return false;
+  }
+
+  std::vector<int32_t> values(2 * *num_channels);
+  const float input_scale = input->quantization->scale[0];
+  const float output_scale = output->quantization->scale[0];
+  for (int i = 0; i < *num_channels; ++i) {
+    const float scale = is_per_channel ? filter_scales[i] : filter_scales[0];
+    const double effective_output_scale = static_cast<double>(input_scale) *
+                                          static_cast<double>(scale) /
+                                          static_cast<double>(output_scale);
+    int shift;
+    tflite::QuantizeMultiplier(effective_output_scale, &values[i], &shift);
+    values[*num_channels + i] = shift;
+  }
+
+  auto values_buffer = std::make_unique<tflite::BufferT>();
+  values_buffer->data.resize(values.size() * sizeof(int32_t));
+  memcpy(values_buffer->data.data(), values.data(),
+         values_buffer->data.size());
+  metadata->push_back(subgraph_index);
+  metadata->push_back(op.outputs[0]);
+  metadata->push_back(*num_channels);
+  metadata->push_back(model->buffers.size());
+  model->buffers.push_back(std::move(values_buffer));
+  return true;
+}
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg.rfind("--min_channels=", 0) == 0) {
+      options->min_channels = atoi(arg.c_str() + strlen("--min_channels="));
+    } else if (arg == "--fully_connected") {
+      options->fully_connected = true;
+    } else {
+      paths.push_back(arg);
+    }
+  }
+  if (paths.size() != 2) {
+    return false;
+  }
+  options->input = paths[0];
+  options->output = paths[1];
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    fprintf(stderr,
+            "Usage: %s [--min_channels=8] [--fully_connected] input.tflite "
+            "output.tflite\n",
+            argv[0]);
+    return 1;
+  }
+
+  std::ifstream input_file(options.input, std::ios::binary);
+  const std::vector<uint8_t> input((std::istreambuf_iterator<char>(input_file)),
+                                   std::istreambuf_iterator<char>());
+  flatbuffers::Verifier verifier(input.data(), input.size());
+  if (input.empty() || !tflite::VerifyModelBuffer(verifier)) {
+    fprintf(stderr, "%s is not a valid model.\n", options.input.c_str());
+    return 1;
+  }
+  std::unique_ptr<tflite::ModelT> model(tflite::GetModel(input.data())->UnPack());
+
+  for (const auto& metadata : model->metadata) {
+    if (metadata->name == tflite::kOutputMultiplierMetadataName) {
+      fprintf(stderr, "%s already has precomputed output multipliers.\n",
+              options.input.c_str());
+      return 1;
+    }
+  }
+
+  std::vector<uint32_t> metadata = {tflite::kOutputMultiplierMetadataVersion,
+                                    0};
+  int total_channels = 0;
+  for (size_t s = 0; s < model->subgraphs.size(); ++s) {
+    for (const auto& op : model->subgraphs[s]->operators) {
+      const tflite::BuiltinOperator code = tflite::GetBuiltinCode(
+          model->operator_codes[op->opcode_index].get());
+      if (code != tflite::BuiltinOperator_CONV_2D &&
+          code != tflite::BuiltinOperator_DEPTHWISE_CONV_2D &&
+          (code != tflite::BuiltinOperator_FULLY_CONNECTED ||
+           !options.fully_connected)) {
+        continue;
+      }
+      int num_channels = 0;
+      if (Precompute(options, model.get(), s, *op, code, &metadata,
+                     &num_channels)) {
+        metadata[1]++;
+        total_channels += num_channels;
+      }
+    }
+  }
+
+  auto metadata_buffer = std::make_unique<tflite::BufferT>();
+  metadata_buffer->data.resize(metadata.size() * sizeof(uint32_t));
+  memcpy(metadata_buffer->data.data(), metadata.data(),
+         metadata_buffer->data.size());
+  auto metadata_entry = std::make_unique<tflite::MetadataT>();
+  metadata_entry->name = tflite::kOutputMultiplierMetadataName;
+  metadata_entry->buffer = model->buffers.size();
+  model->buffers.push_back(std::move(metadata_buffer));
+  model->metadata.push_back(std::move(metadata_entry));
+
+  // The flatbuffers library vendored for TFLM has no implicit allocator.
+  flatbuffers::DefaultAllocator allocator;
+  flatbuffers::FlatBufferBuilder builder(input.size(), &allocator);
+  builder.Finish(tflite::Model::Pack(builder, model.get()),
+                 tflite::ModelIdentifier());
+  std::ofstream output_file(options.output, std::ios::binary);
+  output_file.write(reinterpret_cast<const char*>(builder.GetBufferPointer()),
+                    builder.GetSize());
+  printf(
+      "Precomputed the output multipliers of %u operators with %d channels: "
+      "%d bytes moved from the arena to flash.\n",
+      metadata[1], total_channels,
+      total_channels * 2 * static_cast<int>(sizeof(int32_t)));
+  return output_file ? 0 : 1;
+}
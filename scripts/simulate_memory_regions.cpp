@@ -0,0 +1,215 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host tool that evaluates how MultiRegionMemoryPlanner places the buffers of
+// a .tflite model in fast memory regions, see
+// src/tensorflow/lite/micro/memory_planner/multi_region_memory_planner.h.
+//
+// Every region, including the arena, has a latency weight, the relative cost
+// of one access. The tool plans the model once with the arena only and once
+// with the given regions, which are simulated with host buffers, and reports
+// the usage of every region and the weighted access cost of both plans. It
+// then invokes both interpreters on the same random input and checks that the
+// outputs are identical.
+//
+// Build from the repository root with:
+//   scripts/build_host_tool.sh scripts/simulate_memory_regions.cpp
+//
+// Usage:
+//   simulate_memory_regions [--arena_size=1048576] [--arena_latency=3]
+//     [--region=65536:1]... model.tflite
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/memory_planner/multi_region_memory_planner.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace {
+
+struct RegionOption {
+  size_t size;
+  int latency_weight;
+};
+
+struct Options {
+  size_t arena_size = 1024 * 1024;
+  int arena_latency = 3;
+  std::vector<RegionOption> regions;
+  std::string model;
+};
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    if (strncmp(arg, "--arena_size=", 13) == 0) {
+      options->arena_size = strtoul(arg + 13, nullptr, 10);
+    } else if (strncmp(arg, "--arena_latency=", 16) == 0) {
+      options->arena_latency = atoi(arg + 16);
+    } else if (strncmp(arg, "--region=", 9) == 0) {
+      char* end = nullptr;
+      RegionOption region;
+      region.size = strtoul(arg + 9, &end, 10);
+      if (*end != ':') {
+        return false;
+      }
+      region.latency_weight = atoi(end + 1);
+      options->regions.push_back(region);
+    } else if (arg[0] == '-') {
+      return false;
+    } else if (options->model.empty()) {
+      options->model = arg;
+    } else {
+      return false;
+    }
+  }
+  return !options->model.empty() &&
+         options->regions.size() <
+             static_cast<size_t>(tflite::MultiRegionMemoryPlanner::kMaxRegions);
+}
+
+// Owns an interpreter that plans the model with a MultiRegionMemoryPlanner.
+class Simulation {
+ public:
+  Simulation(const tflite::Model* model, const Options& options,
+             bool use_regions)
+      : arena_(new uint8_t[options.arena_size + 16]) {
+    planner_.set_arena_latency_weight(options.arena_latency);
+    if (use_regions) {
+      for (const RegionOption& region : options.regions) {
+        region_buffers_.emplace_back(region.size + 16);
+        planner_.AddRegion(region_buffers_.back().data(),
+                           region_buffers_.back().size(),
+                           region.latency_weight);
+      }
+    }
+    tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(
+        arena_.get(), options.arena_size + 16, &planner_);
+    interpreter_.reset(
+        new tflite::MicroInterpreter(model, resolver_, allocator));
+  }
+
+  bool AllocateTensors() {
+    if (interpreter_->AllocateTensors() != kTfLiteOk) {
+      fprintf(stderr, "AllocateTensors failed\n");
+      return false;
+    }
+    return true;
+  }
+
+  bool Invoke(const std::vector<uint8_t>& input) {
+    TfLiteTensor* tensor = interpreter_->input(0);
+    memcpy(tensor->data.raw, input.data(),
+           std::min(input.size(), tensor->bytes));
+    if (interpreter_->Invoke() != kTfLiteOk) {
+      fprintf(stderr, "Invoke failed\n");
+      return false;
+    }
+    return true;
+  }
+
+  void Report(const char* name, int num_regions) {
+    printf("%s:\n", name);
+    printf("  arena used %zu bytes, planned head %zu bytes\n",
+           interpreter_->arena_used_bytes(), planner_.GetRegionUsage(0));
+    for (int r = 1; r <= num_regions; ++r) {
+      printf("  region %d used %zu bytes\n", r, planner_.GetRegionUsage(r));
+    }
+    printf("  weighted access cost %llu\n",
+           static_cast<unsigned long long>(planner_.GetWeightedAccessCost()));
+  }
+
+  uint64_t cost() { return planner_.GetWeightedAccessCost(); }
+
+  std::vector<uint8_t> Output() {
+    const TfLiteTensor* tensor = interpreter_->output(0);
+    return std::vector<uint8_t>(tensor->data.uint8,
+                                tensor->data.uint8 + tensor->bytes);
+  }
+
+  size_t input_bytes() { return interpreter_->input(0)->bytes; }
+
+ private:
+  std::unique_ptr<uint8_t[]> arena_;
+  std::vector<std::vector<uint8_t>> region_buffers_;
+  tflite::MultiRegionMemoryPlanner planner_;
+  tflite::AllOpsResolver resolver_;
+  std::unique_ptr<tflite::MicroInterpreter> interpreter_;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    fprintf(stderr,
+            "Usage: %s [--arena_size=1048576] [--arena_latency=3] "
+            "[--region=65536:1]... model.tflite\n",
+            argv[0]);
+    return 1;
+  }
+
+  std::ifstream file(options.model, std::ios::binary);
+  std::vector<char> buffer((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+  if (buffer.empty()) {
+    fprintf(stderr, "Failed to read %s\n", options.model.c_str());
+    return 1;
+  }
+  const tflite::Model* model = tflite::GetModel(buffer.data());
+
+  Simulation baseline(model, options, /*use_regions=*/false);
+  Simulation simulation(model, options, /*use_regions=*/true);
+
+  if (!baseline.AllocateTensors() || !simulation.AllocateTensors()) {
+    return 1;
+  }
+  std::vector<uint8_t> input(baseline.input_bytes());
+  srand(1);
+  for (uint8_t& value : input) {
+    value = static_cast<uint8_t>(rand());
+  }
+  if (!baseline.Invoke(input) || !simulation.Invoke(input)) {
+    return 1;
+  }
+
+  const int num_regions = static_cast<int>(options.regions.size());
+  baseline.Report("Arena only", 0);
+  simulation.Report("With regions", num_regions);
+  if (baseline.cost() > 0) {
+    printf("Weighted access cost: %.1f%% of arena only\n",
+           100.0 * simulation.cost() / baseline.cost());
+  }
+
+  if (baseline.Output() != simulation.Output()) {
+    printf("Outputs differ\n");
+    return 1;
+  }
+  printf("Outputs match\n");
+  return 0;
+}
+
+extern "C" void DebugLog(const char* s) { fputs(s, stderr); }
@@ -0,0 +1,256 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host tool that invokes a .tflite model with its constant tensors streamed
+// from the model file, see
+// src/tensorflow/lite/micro/micro_weight_streamer.h, as if the file were an
+// external flash device with a fixed latency per block. The outputs are
+// compared with an invocation that reads the weights in place, and the
+// storage latency and the part of it that prefetching did not hide are
+// printed.
+//
+// Build from the repository root with:
+//   scripts/build_host_tool.sh scripts/stream_weights.cpp
+//
+// Usage:
+//   stream_weights [--arena_size=1048576] [--invocations=3]
+//     [--block_size=256] [--block_latency_us=5] [--min_tensor_bytes=1024]
+//     [--max_staging_bytes=65536] model.tflite
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_time.h"
+#include "tensorflow/lite/micro/micro_weight_provider.h"
+#include "tensorflow/lite/micro/micro_weight_streamer.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace {
+
+struct Options {
+  size_t arena_size = 1024 * 1024;
+  int invocations = 3;
+  size_t block_size = 256;
+  uint32_t block_latency_us = 5;
+  size_t min_tensor_bytes = 1024;
+  size_t max_staging_bytes = 64 * 1024;
+  std::string model;
+};
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    if (strncmp(arg, "--arena_size=", 13) == 0) {
+      options->arena_size = strtoul(arg + 13, nullptr, 10);
+    } else if (strncmp(arg, "--invocations=", 14) == 0) {
+      options->invocations = atoi(arg + 14);
+    } else if (strncmp(arg, "--block_size=", 13) == 0) {
+      options->block_size = strtoul(arg + 13, nullptr, 10);
+    } else if (strncmp(arg, "--block_latency_us=", 19) == 0) {
+      options->block_latency_us = strtoul(arg + 19, nullptr, 10);
+    } else if (strncmp(arg, "--min_tensor_bytes=", 19) == 0) {
+      options->min_tensor_bytes = strtoul(arg + 19, nullptr, 10);
+    } else if (strncmp(arg, "--max_staging_bytes=", 20) == 0) {
+      options->max_staging_bytes = strtoul(arg + 20, nullptr, 10);
+    } else if (arg[0] == '-') {
+      return false;
+    } else if (options->model.empty()) {
+      options->model = arg;
+    } else {
+      return false;
+    }
+  }
+  return !options->model.empty() && options->invocations > 0 &&
+         options->block_size > 0;
+}
+
+// Stand-in for an external flash block device. The file holds a copy of the
+// model flatbuffer whose in-memory image starts at model_data, so a source
+// address maps to the same offset in the file.
+//
+// Every block of block_size bytes touched by a read costs block_latency_us
+// microseconds. The data is copied in StartRead, but WaitForRead busy-waits
+// until the latency of the read has elapsed since it was started, the way a
+// DMA transfer would complete in the background while the CPU computes.
+class FileWeightProvider : public tflite::MicroWeightProvider {
+ public:
+  FileWeightProvider(const char* path, const void* model_data,
+                     size_t block_size, uint32_t block_latency_us)
+      : file_(fopen(path, "rb")),
+        model_data_(static_cast<const uint8_t*>(model_data)),
+        block_size_(block_size),
+        block_latency_us_(block_latency_us) {}
+
+  ~FileWeightProvider() override {
+    if (file_ != nullptr) {
+      fclose(file_);
+    }
+  }
+
+  bool is_open() const { return file_ != nullptr; }
+
+  TfLiteStatus StartRead(const void* source, size_t bytes,
+                         void* destination) override {
+    if (source < model_data_) {
+      return kTfLiteError;
+    }
+    const size_t offset = static_cast<const uint8_t*>(source) - model_data_;
+    if (fseek(file_, static_cast<long>(offset), SEEK_SET) != 0 ||
+        fread(destination, 1, bytes, file_) != bytes) {
+      fprintf(stderr, "Failed to read %zu weight bytes at offset %zu\n", bytes,
+              offset);
+      return kTfLiteError;
+    }
+
+    const size_t first_block = offset / block_size_;
+    const size_t last_block = (offset + bytes + block_size_ - 1) / block_size_;
+    const uint32_t blocks = static_cast<uint32_t>(last_block - first_block);
+    blocks_read_ += blocks;
+    read_start_ticks_ = tflite::GetCurrentTimeTicks();
+    read_ticks_ = static_cast<uint32_t>(static_cast<uint64_t>(blocks) *
+                                        block_latency_us_ *
+                                        tflite::ticks_per_second() / 1000000);
+    return kTfLiteOk;
+  }
+
+  TfLiteStatus WaitForRead() override {
+    while (tflite::GetCurrentTimeTicks() - read_start_ticks_ < read_ticks_) {
+    }
+    read_ticks_ = 0;
+    return kTfLiteOk;
+  }
+
+  // Number of blocks read so far.
+  uint32_t blocks_read() const { return blocks_read_; }
+
+ private:
+  FILE* file_;
+  const uint8_t* model_data_;
+  size_t block_size_;
+  uint32_t block_latency_us_;
+
+  uint32_t read_start_ticks_ = 0;
+  uint32_t read_ticks_ = 0;
+  uint32_t blocks_read_ = 0;
+};
+
+// Invokes the model on the same random inputs for every interpreter and
+// appends the bytes of all outputs to outputs.
+bool Run(tflite::MicroInterpreter* interpreter, int invocations,
+         std::vector<uint8_t>* outputs) {
+  if (interpreter->AllocateTensors() != kTfLiteOk) {
+    fprintf(stderr, "AllocateTensors failed\n");
+    return false;
+  }
+  srand(1);
+  for (int invocation = 0; invocation < invocations; ++invocation) {
+    for (size_t i = 0; i < interpreter->inputs_size(); ++i) {
+      TfLiteTensor* tensor = interpreter->input(i);
+      for (size_t n = 0; n < tensor->bytes; ++n) {
+        tensor->data.uint8[n] = static_cast<uint8_t>(rand());
+      }
+    }
+    if (interpreter->Invoke() != kTfLiteOk) {
+      fprintf(stderr, "Invoke failed\n");
+      return false;
+    }
+    for (size_t i = 0; i < interpreter->outputs_size(); ++i) {
+      const TfLiteTensor* tensor = interpreter->output(i);
+      outputs->insert(outputs->end(), tensor->data.uint8,
+                      tensor->data.uint8 + tensor->bytes);
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    fprintf(stderr,
+            "Usage: %s [--arena_size=1048576] [--invocations=3] "
+            "[--block_size=256] [--block_latency_us=5] "
+            "[--min_tensor_bytes=1024] [--max_staging_bytes=65536] "
+            "model.tflite\n",
+            argv[0]);
+    return 1;
+  }
+
+  std::ifstream file(options.model, std::ios::binary);
+  std::vector<char> buffer((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+  if (buffer.empty()) {
+    fprintf(stderr, "Failed to read %s\n", options.model.c_str());
+    return 1;
+  }
+  const tflite::Model* model = tflite::GetModel(buffer.data());
+  tflite::AllOpsResolver resolver;
+
+  std::vector<uint8_t> expected;
+  {
+    std::unique_ptr<uint8_t[]> arena(new uint8_t[options.arena_size]);
+    tflite::MicroInterpreter interpreter(model, resolver, arena.get(),
+                                         options.arena_size);
+    if (!Run(&interpreter, options.invocations, &expected)) {
+      return 1;
+    }
+  }
+
+  FileWeightProvider provider(options.model.c_str(), buffer.data(),
+                              options.block_size, options.block_latency_us);
+  if (!provider.is_open()) {
+    fprintf(stderr, "Failed to open %s\n", options.model.c_str());
+    return 1;
+  }
+  std::unique_ptr<uint8_t[]> arena(new uint8_t[options.arena_size]);
+  tflite::MicroInterpreter interpreter(model, resolver, arena.get(),
+                                       options.arena_size);
+  std::vector<uint8_t> actual;
+  if (interpreter.SetWeightStreaming(&provider, options.min_tensor_bytes,
+                                     options.max_staging_bytes) != kTfLiteOk ||
+      !Run(&interpreter, options.invocations, &actual)) {
+    return 1;
+  }
+
+  const tflite::MicroWeightStreamer* streamer = interpreter.weight_streamer();
+  if (streamer == nullptr) {
+    printf("No tensor is streamed.\n");
+    return 0;
+  }
+  const uint64_t latency_us =
+      static_cast<uint64_t>(provider.blocks_read()) * options.block_latency_us;
+  const uint64_t stall_us = static_cast<uint64_t>(streamer->stall_ticks()) *
+                            1000000 / tflite::ticks_per_second();
+  printf("outputs: %s\n", actual == expected ? "bit-exact" : "DIFFERENT");
+  printf("staging bytes: %zu\n", streamer->staging_bytes());
+  printf("reads: %u, blocks: %u\n", streamer->reads(),
+         provider.blocks_read());
+  printf("storage latency per invocation: %llu us, stalled: %llu us\n",
+         static_cast<unsigned long long>(latency_us / options.invocations),
+         static_cast<unsigned long long>(stall_us / options.invocations));
+  return actual == expected ? 0 : 1;
+}
+
+extern "C" void DebugLog(const char* s) { fputs(s, stderr); }
@@ -0,0 +1,217 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host tool that invokes a .tflite model on random input with a
+// MicroArenaTracer, see src/tensorflow/lite/micro/micro_arena_tracer.h, and
+// writes the trace of the arena as JSON. Render it with
+// scripts/arena_heatmap.py.
+//
+// A summary of every node is printed: the high-water mark of the arena, the
+// bytes written outside its buffers, which point at kernels that overrun,
+// and the requested, planned and written bytes of its scratch buffers. With
+// --overrides, a header with the ScratchBufferOverride table that shrinks the
+// scratch buffers to what was written is generated, see
+// MicroInterpreter::SetScratchBufferOverrides(). Calibrate with at least two
+// invocations on representative inputs.
+//
+// Build from the repository root with:
+//   scripts/build_host_tool.sh scripts/trace_arena.cpp
+//
+// Usage:
+//   trace_arena [--arena_size=1048576] [--invocations=2]
+//     [--output=trace.json] [--overrides=scratch_overrides.h] model.tflite
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_arena_tracer.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace {
+
+// Where DebugLog() writes to, the JSON goes to the output file.
+FILE* log_file = stderr;
+
+struct Options {
+  size_t arena_size = 1024 * 1024;
+  int invocations = 2;
+  std::string output;
+  std::string overrides;
+  std::string model;
+};
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    if (strncmp(arg, "--arena_size=", 13) == 0) {
+      options->arena_size = strtoul(arg + 13, nullptr, 10);
+    } else if (strncmp(arg, "--invocations=", 14) == 0) {
+      options->invocations = atoi(arg + 14);
+    } else if (strncmp(arg, "--output=", 9) == 0) {
+      options->output = arg + 9;
+    } else if (strncmp(arg, "--overrides=", 12) == 0) {
+      options->overrides = arg + 12;
+    } else if (arg[0] == '-') {
+      return false;
+    } else if (options->model.empty()) {
+      options->model = arg;
+    } else {
+      return false;
+    }
+  }
+  return !options->model.empty() && options->invocations > 0;
+}
+
+void PrintSummary(const tflite::MicroArenaTracer& tracer) {
+  printf("%8s %6s %12s %8s %8s\n", "subgraph", "node", "high water", "stray",
+         "temp");
+  for (int i = 0; i < tracer.num_records(); ++i) {
+    const tflite::MicroArenaTracer::NodeRecord& record = tracer.record(i);
+    printf("%8d %6d %12zu %8zu %8zu\n", record.subgraph_idx, record.node_idx,
+           record.high_water_bytes, record.stray_bytes, record.temp_bytes);
+  }
+  printf("\n");
+  log_file = stdout;
+  tracer.LogScratchBufferUsage();
+  log_file = stderr;
+}
+
+bool WriteJson(const std::string& path,
+               const tflite::MicroArenaTracer& tracer) {
+  log_file = fopen(path.c_str(), "w");
+  if (log_file == nullptr) {
+    log_file = stderr;
+    fprintf(stderr, "Failed to open %s\n", path.c_str());
+    return false;
+  }
+  tracer.LogJson();
+  fclose(log_file);
+  log_file = stderr;
+  return true;
+}
+
+// Returns the include guard for the header, e.g. SCRATCH_OVERRIDES_H_ for
+// out/scratch_overrides.h.
+std::string IncludeGuard(const std::string& header) {
+  std::string guard;
+  const size_t slash = header.find_last_of('/');
+  for (char c : header.substr(slash == std::string::npos ? 0 : slash + 1)) {
+    guard += isalnum(static_cast<unsigned char>(c))
+                 ? static_cast<char>(toupper(static_cast<unsigned char>(c)))
+                 : '_';
+  }
+  return guard + "_";
+}
+
+bool WriteOverridesHeader(const Options& options,
+                          const tflite::MicroArenaTracer& tracer) {
+  log_file = fopen(options.overrides.c_str(), "w");
+  if (log_file == nullptr) {
+    log_file = stderr;
+    fprintf(stderr, "Failed to open %s\n", options.overrides.c_str());
+    return false;
+  }
+  fprintf(log_file,
+          "// Generated by scripts/trace_arena.cpp from %s. Do not edit.\n\n",
+          options.model.c_str());
+  const std::string guard = IncludeGuard(options.overrides);
+  fprintf(log_file, "#ifndef %s\n#define %s\n\n", guard.c_str(),
+          guard.c_str());
+  fprintf(log_file,
+          "#include \"tensorflow/lite/micro/micro_allocator.h\"\n\n");
+  tracer.LogScratchBufferOverrides();
+  fprintf(log_file, "\n#endif  // %s\n", guard.c_str());
+  fclose(log_file);
+  log_file = stderr;
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    fprintf(stderr,
+            "Usage: %s [--arena_size=1048576] [--invocations=2] "
+            "[--output=trace.json] [--overrides=scratch_overrides.h] "
+            "model.tflite\n",
+            argv[0]);
+    return 1;
+  }
+
+  std::ifstream file(options.model, std::ios::binary);
+  std::vector<char> buffer((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+  if (buffer.empty()) {
+    fprintf(stderr, "Failed to read %s\n", options.model.c_str());
+    return 1;
+  }
+  const tflite::Model* model = tflite::GetModel(buffer.data());
+
+  std::unique_ptr<uint8_t[]> arena(new uint8_t[options.arena_size]);
+  tflite::MicroAllocator* allocator =
+      tflite::MicroAllocator::Create(arena.get(), options.arena_size);
+  tflite::AllOpsResolver resolver;
+  tflite::MicroInterpreter interpreter(model, resolver, allocator);
+  // The tracer holds its records in fixed arrays. It is static since the
+  // library is built without its operator delete.
+  static tflite::MicroArenaTracer tracer;
+  if (interpreter.SetArenaTracer(&tracer) != kTfLiteOk ||
+      interpreter.AllocateTensors() != kTfLiteOk) {
+    fprintf(stderr, "AllocateTensors failed\n");
+    return 1;
+  }
+
+  srand(1);
+  for (int invocation = 0; invocation < options.invocations; ++invocation) {
+    for (size_t i = 0; i < interpreter.inputs_size(); ++i) {
+      TfLiteTensor* tensor = interpreter.input(i);
+      for (size_t n = 0; n < tensor->bytes; ++n) {
+        tensor->data.uint8[n] = static_cast<uint8_t>(rand());
+      }
+    }
+    if (interpreter.Invoke() != kTfLiteOk) {
+      fprintf(stderr, "Invoke failed\n");
+      return 1;
+    }
+  }
+
+  if (!options.overrides.empty() && !WriteOverridesHeader(options, tracer)) {
+    return 1;
+  }
+  if (options.output.empty()) {
+    log_file = stdout;
+    tracer.LogJson();
+    return 0;
+  }
+  if (!WriteJson(options.output, tracer)) {
+    return 1;
+  }
+  PrintSummary(tracer);
+  return 0;
+}
+
+extern "C" void DebugLog(const char* s) { fputs(s, log_file); }
@@ -557,6 +557,11 @@ constexpr int LUTSize() {
 
 // int16_t -> int16_t table lookup with interpolation
 // LUT must have 513 values
+// The table interpolates the float function, so for LOGISTIC and TANH it is up
+// to a few LSB less accurate than their fixed-point reference kernels, which
+// are within 1 LSB of the exact function. TFLM kernels thus only build int16
+// tables when TF_LITE_MICRO_INT16_ACTIVATION_LUT is defined. Their int8 tables
+// tabulate the reference kernels and are bit-exact.
 inline int16_t LUTLookup(int16_t value, const int16_t* lut) {
   // 512 base values, lut[513] is only used to calculate the slope
   const uint16_t index = static_cast<uint16_t>(256 + (value >> 7));
@@ -229,6 +229,8 @@ inline bool IsHybridOp(const TfLiteTensor* input, const TfLiteTensor* weight) {
 }
 
 // Check dimensionality match and populate OpData for Conv and DepthwiseConv.
+// per_channel_multiplier and per_channel_shift may both be nullptr to run the
+// checks and populate the other outputs only.
 TfLiteStatus PopulateConvolutionQuantizationParams(
     TfLiteContext* context, const TfLiteTensor* input,
     const TfLiteTensor* filter, const TfLiteTensor* bias, TfLiteTensor* output,
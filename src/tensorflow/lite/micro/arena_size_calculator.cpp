@@ -0,0 +1,139 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/arena_size_calculator.h"
+
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/micro/arena_allocator/recording_single_arena_buffer_allocator.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_arena_constants.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/recording_micro_allocator.h"
+
+namespace tflite {
+
+namespace {
+
+// Allocates the tensors of the model in an arena of arena_size bytes at
+// buffer. Returns the used bytes, or 0 if the arena is too small.
+size_t TryAllocateTensors(const Model* model,
+                          const MicroOpResolver& op_resolver, uint8_t* buffer,
+                          size_t arena_size,
+                          MicroMemoryPlanner* memory_planner) {
+  MicroAllocator* allocator =
+      memory_planner == nullptr
+          ? MicroAllocator::Create(buffer, arena_size)
+          : MicroAllocator::Create(buffer, arena_size, memory_planner);
+  MicroInterpreter interpreter(model, op_resolver, allocator);
+  if (interpreter.AllocateTensors() != kTfLiteOk) {
+    return 0;
+  }
+  return interpreter.arena_used_bytes();
+}
+
+}  // namespace
+
+TfLiteStatus CalculateArenaSize(const Model* model,
+                                const MicroOpResolver& op_resolver,
+                                uint8_t* buffer, size_t buffer_size,
+                                MicroMemoryPlanner* memory_planner,
+                                ArenaSizeReport* report) {
+  TFLITE_DCHECK(report != nullptr);
+  *report = {};
+
+  uint8_t* aligned_buffer = AlignPointerUp(buffer, MicroArenaBufferAlignment());
+  if (static_cast<size_t>(aligned_buffer - buffer) >= buffer_size) {
+    return kTfLiteError;
+  }
+  buffer_size -= aligned_buffer - buffer;
+
+  // Measure the head and the tail with a recording allocator first.
+  {
+    RecordingMicroAllocator* allocator =
+        memory_planner == nullptr
+            ? RecordingMicroAllocator::Create(aligned_buffer, buffer_size)
+            : RecordingMicroAllocator::Create(aligned_buffer, buffer_size,
+                                              memory_planner);
+    MicroInterpreter interpreter(model, op_resolver, allocator);
+    if (interpreter.AllocateTensors() != kTfLiteOk) {
+      MicroPrintf("Model does not fit in an arena of %d bytes",
+                  static_cast<int>(buffer_size));
+      return kTfLiteError;
+    }
+    report->non_persistent_bytes =
+        allocator->GetSimpleMemoryAllocator()->GetNonPersistentUsedBytes();
+    const RecordedAllocation scratch = allocator->GetRecordedAllocation(
+        RecordedAllocationType::kScratchBufferData);
+    report->scratch_bytes = scratch.used_bytes;
+    report->scratch_buffer_count = scratch.count;
+    report->persistent_buffer_bytes =
+        allocator
+            ->GetRecordedAllocation(
+                RecordedAllocationType::kPersistentBufferData)
+            .used_bytes;
+  }
+
+  // The recording allocator uses a little more tail than MicroAllocator, so
+  // the plain allocator must fit in buffer_size too.
+  size_t used_bytes = TryAllocateTensors(model, op_resolver, aligned_buffer,
+                                         buffer_size, memory_planner);
+  if (used_bytes == 0) {
+    MicroPrintf("Model does not fit in an arena of %d bytes",
+                static_cast<int>(buffer_size));
+    return kTfLiteError;
+  }
+
+  // Tail allocations are aligned down from the end of the arena, so the used
+  // bytes depend slightly on the arena size and an arena somewhat smaller
+  // than the used bytes may still work. Step down until an arena fails, then
+  // search between it and the largest size known to work.
+  size_t large_enough = buffer_size;
+  size_t too_small = used_bytes;
+  do {
+    if (too_small <= MicroArenaBufferAlignment()) {
+      too_small = 0;
+      break;
+    }
+    too_small -= MicroArenaBufferAlignment();
+    const size_t trial_used_bytes = TryAllocateTensors(
+        model, op_resolver, aligned_buffer, too_small, memory_planner);
+    if (trial_used_bytes == 0) {
+      break;
+    }
+    large_enough = too_small;
+    used_bytes = trial_used_bytes;
+  } while (true);
+  while (large_enough - too_small > 1) {
+    const size_t arena_size = too_small + (large_enough - too_small) / 2;
+    const size_t trial_used_bytes = TryAllocateTensors(
+        model, op_resolver, aligned_buffer, arena_size, memory_planner);
+    if (trial_used_bytes == 0) {
+      too_small = arena_size;
+    } else {
+      large_enough = arena_size;
+      used_bytes = trial_used_bytes;
+    }
+  }
+
+  report->arena_size = large_enough;
+  report->used_bytes = used_bytes;
+  report->tail_bytes = used_bytes - report->non_persistent_bytes;
+  report->planning_bytes = large_enough - used_bytes;
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
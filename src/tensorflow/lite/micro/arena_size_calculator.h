@@ -0,0 +1,75 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_ARENA_SIZE_CALCULATOR_H_
+#define TENSORFLOW_LITE_MICRO_ARENA_SIZE_CALCULATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/memory_planner/micro_memory_planner.h"
+#include "tensorflow/lite/micro/micro_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+// Breakdown of the tensor arena a model needs, see CalculateArenaSize().
+struct ArenaSizeReport {
+  // Smallest arena for which AllocateTensors() succeeds, for an arena that
+  // starts at a MicroArenaBufferAlignment() aligned address. An arena with
+  // unknown alignment needs MicroArenaBufferAlignment() - 1 more bytes.
+  size_t arena_size;
+  // Bytes in use after AllocateTensors(), i.e. the head plus the tail.
+  size_t used_bytes;
+  // Head: the non-persistent memory plan of activations and scratch buffers.
+  size_t non_persistent_bytes;
+  // Part of the head that kernels requested as scratch buffers.
+  size_t scratch_bytes;
+  size_t scratch_buffer_count;
+  // Tail: allocations that live as long as the interpreter.
+  size_t tail_bytes;
+  // Part of the tail that kernels allocated with AllocatePersistentBuffer(),
+  // e.g. their OpData.
+  size_t persistent_buffer_bytes;
+  // Part of arena_size that is only needed while AllocateTensors() runs, e.g.
+  // by the memory planner to compute the plan.
+  size_t planning_bytes;
+};
+
+// Finds the smallest tensor arena with which a MicroInterpreter for model and
+// op_resolver can allocate its tensors.
+//
+// The model is first allocated with a RecordingMicroAllocator in buffer, which
+// must be large enough for it, to measure the head and the tail. Since the
+// memory planner and the kernels' Prepare temporarily need more memory than
+// the plan, the minimum is then found by a binary search over arena sizes up
+// to buffer_size. The allocations of the failing attempts are logged.
+//
+// If memory_planner is nullptr, the arena is sized for the default
+// GreedyMemoryPlanner that MicroAllocator::Create(arena, size) places in the
+// arena, otherwise for MicroAllocator::Create(arena, size, memory_planner).
+//
+// Every attempt constructs a MicroInterpreter, so this is intended for host
+// tools, see scripts/calculate_arena_size.cpp.
+TfLiteStatus CalculateArenaSize(const Model* model,
+                                const MicroOpResolver& op_resolver,
+                                uint8_t* buffer, size_t buffer_size,
+                                MicroMemoryPlanner* memory_planner,
+                                ArenaSizeReport* report);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_ARENA_SIZE_CALCULATOR_H_
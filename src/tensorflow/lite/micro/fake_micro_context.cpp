@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/micro/arena_allocator/single_arena_buffer_allocator.h"
+#include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
 #include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_arena_constants.h"
 #include "tensorflow/lite/micro/micro_log.h"
@@ -24,8 +25,13 @@ limitations under the License.
 namespace tflite {
 namespace {
 // Dummy static variables to allow creation of dummy MicroAllocator.
-// All tests are guarateed to run serially.
-static constexpr int KDummyTensorArenaSize = 256;
+// All tests are guarateed to run serially. The arena holds the
+// SingleArenaBufferAllocator, GreedyMemoryPlanner and MicroAllocator that
+// MicroAllocator::Create() places in it, each aligned to at most
+// MicroArenaBufferAlignment(), and the arena itself may be unaligned.
+static constexpr int KDummyTensorArenaSize =
+    sizeof(SingleArenaBufferAllocator) + sizeof(GreedyMemoryPlanner) +
+    sizeof(MicroAllocator) + 4 * MicroArenaBufferAlignment();
 static uint8_t dummy_tensor_arena[KDummyTensorArenaSize];
 }  // namespace
 
@@ -95,6 +101,18 @@ TfLiteStatus FakeMicroContext::RequestScratchBufferInArena(size_t bytes,
   return kTfLiteOk;
 }
 
+// All buffers of the fake are aligned to MicroArenaBufferAlignment(), which
+// is the largest alignment kernels may ask for.
+void* FakeMicroContext::AllocateAlignedPersistentBuffer(size_t bytes,
+                                                        size_t alignment) {
+  return AllocatePersistentBuffer(bytes);
+}
+
+TfLiteStatus FakeMicroContext::RequestAlignedScratchBufferInArena(
+    size_t bytes, size_t alignment, int* buffer_index) {
+  return RequestScratchBufferInArena(bytes, buffer_index);
+}
+
 void* FakeMicroContext::GetScratchBuffer(int buffer_index) {
   TFLITE_DCHECK(scratch_buffer_count_ <= kNumScratchBuffers_);
   if (buffer_index >= scratch_buffer_count_) {
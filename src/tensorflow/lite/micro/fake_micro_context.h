@@ -29,6 +29,11 @@ class FakeMicroContext : public MicroContext {
   void* AllocatePersistentBuffer(size_t bytes) override;
   TfLiteStatus RequestScratchBufferInArena(size_t bytes,
                                            int* buffer_index) override;
+  void* AllocateAlignedPersistentBuffer(size_t bytes,
+                                        size_t alignment) override;
+  TfLiteStatus RequestAlignedScratchBufferInArena(size_t bytes,
+                                                  size_t alignment,
+                                                  int* buffer_index) override;
   void* GetScratchBuffer(int buffer_index) override;
 
   TfLiteTensor* AllocateTempTfLiteTensor(int tensor_index) override;
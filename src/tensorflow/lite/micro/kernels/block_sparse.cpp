@@ -0,0 +1,265 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/block_sparse.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/micro_context.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+namespace {
+
+// Accumulators of one block row are kept on the stack.
+constexpr int kMaxBlockRows = 16;
+
+// Returns the number of elements of a SparseIndexVector, or -1 if it is not
+// set.
+int SparseIndexVectorSize(SparseIndexVector type, const void* vector) {
+  if (vector == nullptr) {
+    return -1;
+  }
+  switch (type) {
+    case SparseIndexVector_Int32Vector:
+      return static_cast<const Int32Vector*>(vector)->values()->size();
+    case SparseIndexVector_Uint16Vector:
+      return static_cast<const Uint16Vector*>(vector)->values()->size();
+    case SparseIndexVector_Uint8Vector:
+      return static_cast<const Uint8Vector*>(vector)->values()->size();
+    default:
+      return -1;
+  }
+}
+
+int32_t SparseIndexVectorGet(SparseIndexVector type, const void* vector,
+                             int i) {
+  switch (type) {
+    case SparseIndexVector_Int32Vector:
+      return static_cast<const Int32Vector*>(vector)->values()->Get(i);
+    case SparseIndexVector_Uint16Vector:
+      return static_cast<const Uint16Vector*>(vector)->values()->Get(i);
+    default:
+      return static_cast<const Uint8Vector*>(vector)->values()->Get(i);
+  }
+}
+
+}  // namespace
+
+TfLiteStatus BlockSparseWeightsInit(TfLiteContext* context,
+                                    const TfLiteNode* node, int filter_index,
+                                    const TfLiteTensor* filter, int rows,
+                                    int cols, int32_t input_offset,
+                                    BlockSparseWeights* weights) {
+  weights->block_rows = 1;
+  weights->block_cols = 1;
+  weights->num_block_rows = 0;
+  weights->block_row_starts = nullptr;
+  weights->block_columns = nullptr;
+  weights->input_offset_terms = nullptr;
+
+  const SparsityParameters* sparsity =
+      GetMicroContext(context)->GetInputSparsity(node, filter_index);
+  if (sparsity == nullptr) {
+    return kTfLiteOk;
+  }
+
+  TF_LITE_ENSURE_MSG(context,
+                     filter->type == kTfLiteInt8 && IsConstantTensor(filter),
+                     "Sparse weights must be constant int8 tensors.");
+  const auto* traversal_order = sparsity->traversal_order();
+  const auto* block_map = sparsity->block_map();
+  const auto* dim_metadata = sparsity->dim_metadata();
+  const int num_dims = filter->dims->size;
+  const int num_block_dims = block_map != nullptr ? block_map->size() : 0;
+  TF_LITE_ENSURE(context, traversal_order != nullptr && dim_metadata != nullptr);
+  TF_LITE_ENSURE_EQ(context, static_cast<int>(traversal_order->size()),
+                    num_dims + num_block_dims);
+  TF_LITE_ENSURE_EQ(context, static_cast<int>(dim_metadata->size()),
+                    num_dims + num_block_dims);
+  for (int i = 0; i < num_dims + num_block_dims; ++i) {
+    TF_LITE_ENSURE_MSG(context, traversal_order->Get(i) == i,
+                       "Only row-major sparse traversal order is supported.");
+  }
+
+  // Block sizes come from the dense dimensions after the original ones.
+  for (int i = 0; i < num_block_dims; ++i) {
+    const DimensionMetadata* metadata = dim_metadata->Get(num_dims + i);
+    TF_LITE_ENSURE_EQ(context, metadata->format(), DimensionType_DENSE);
+    if (block_map->Get(i) == 0) {
+      weights->block_rows = metadata->dense_size();
+    } else if (block_map->Get(i) == num_dims - 1) {
+      weights->block_cols = metadata->dense_size();
+    } else {
+      MicroPrintf("Sparse blocks along dimension %d are not supported.",
+                  block_map->Get(i));
+      return kTfLiteError;
+    }
+  }
+  TF_LITE_ENSURE(context, weights->block_rows > 0 &&
+                              weights->block_rows <= kMaxBlockRows &&
+                              rows % weights->block_rows == 0);
+  TF_LITE_ENSURE(context,
+                 weights->block_cols > 0 && cols % weights->block_cols == 0);
+  const int num_block_cols = cols / weights->block_cols;
+  TF_LITE_ENSURE(context,
+                 num_block_cols <= std::numeric_limits<uint16_t>::max());
+
+  // All but the last dimension are dense, the last one is the CSR index.
+  for (int i = 0; i < num_dims - 1; ++i) {
+    const DimensionMetadata* metadata = dim_metadata->Get(i);
+    TF_LITE_ENSURE_EQ(context, metadata->format(), DimensionType_DENSE);
+    const int block_size = i == 0 ? weights->block_rows : 1;
+    TF_LITE_ENSURE_EQ(context, metadata->dense_size(),
+                      filter->dims->data[i] / block_size);
+  }
+  const DimensionMetadata* csr = dim_metadata->Get(num_dims - 1);
+  TF_LITE_ENSURE_EQ(context, csr->format(), DimensionType_SPARSE_CSR);
+
+  weights->num_block_rows = rows / weights->block_rows;
+  const int num_segments =
+      SparseIndexVectorSize(csr->array_segments_type(), csr->array_segments());
+  TF_LITE_ENSURE_EQ(context, num_segments, weights->num_block_rows + 1);
+  const int num_blocks =
+      SparseIndexVectorSize(csr->array_indices_type(), csr->array_indices());
+  TF_LITE_ENSURE(context, num_blocks >= 0);
+
+  weights->block_row_starts =
+      static_cast<int32_t*>(context->AllocatePersistentBuffer(
+          context, num_segments * sizeof(int32_t)));
+  weights->block_columns =
+      static_cast<uint16_t*>(context->AllocatePersistentBuffer(
+          context, std::max(num_blocks, 1) * sizeof(uint16_t)));
+  weights->input_offset_terms = static_cast<int32_t*>(
+      context->AllocatePersistentBuffer(context, rows * sizeof(int32_t)));
+  TF_LITE_ENSURE(context, weights->block_row_starts != nullptr &&
+                              weights->block_columns != nullptr &&
+                              weights->input_offset_terms != nullptr);
+
+  int32_t previous_start = 0;
+  for (int i = 0; i < num_segments; ++i) {
+    const int32_t start = SparseIndexVectorGet(csr->array_segments_type(),
+                                               csr->array_segments(), i);
+    TF_LITE_ENSURE(context, start >= previous_start && start <= num_blocks);
+    TF_LITE_ENSURE(context, i > 0 || start == 0);
+    weights->block_row_starts[i] = start;
+    previous_start = start;
+  }
+  TF_LITE_ENSURE_EQ(context, previous_start, num_blocks);
+  for (int k = 0; k < num_blocks; ++k) {
+    const int32_t column = SparseIndexVectorGet(csr->array_indices_type(),
+                                                csr->array_indices(), k);
+    TF_LITE_ENSURE(context, column >= 0 && column < num_block_cols);
+    weights->block_columns[k] = static_cast<uint16_t>(column);
+  }
+
+  // Fold the input zero point into per row terms.
+  const int8_t* values = GetTensorData<int8_t>(filter);
+  const int block_size = weights->block_rows * weights->block_cols;
+  for (int block_row = 0; block_row < weights->num_block_rows; ++block_row) {
+    for (int r = 0; r < weights->block_rows; ++r) {
+      int32_t row_sum = 0;
+      for (int k = weights->block_row_starts[block_row];
+           k < weights->block_row_starts[block_row + 1]; ++k) {
+        const int8_t* block_values =
+            values + k * block_size + r * weights->block_cols;
+        for (int c = 0; c < weights->block_cols; ++c) {
+          row_sum += block_values[c];
+        }
+      }
+      weights->input_offset_terms[block_row * weights->block_rows + r] =
+          row_sum * input_offset;
+    }
+  }
+  return kTfLiteOk;
+}
+
+namespace {
+
+// Accumulates the non-zero blocks of one block row into acc. The common block
+// shapes are instantiated with constant sizes so that the compiler can unroll
+// the inner loops.
+template <int kBlockRows, int kBlockCols>
+inline void AccumulateBlockRow(const BlockSparseWeights& weights,
+                               const int8_t* values, const int8_t* input,
+                               int block_row, int32_t* acc) {
+  const int block_rows = kBlockRows > 0 ? kBlockRows : weights.block_rows;
+  const int block_cols = kBlockCols > 0 ? kBlockCols : weights.block_cols;
+  const int block_size = block_rows * block_cols;
+  const int end = weights.block_row_starts[block_row + 1];
+  for (int k = weights.block_row_starts[block_row]; k < end; ++k) {
+    const int8_t* block_input = input + weights.block_columns[k] * block_cols;
+    const int8_t* block_values = values + k * block_size;
+    for (int r = 0; r < block_rows; ++r) {
+      int32_t sum = 0;
+      for (int c = 0; c < block_cols; ++c) {
+        sum += block_values[c] * block_input[c];
+      }
+      acc[r] += sum;
+      block_values += block_cols;
+    }
+  }
+}
+
+}  // namespace
+
+void BlockSparseMatVec(const BlockSparseWeights& weights, const int8_t* values,
+                       const int8_t* input, const int32_t* bias,
+                       const int32_t* output_multiplier,
+                       const int32_t* output_shift, int32_t output_offset,
+                       int32_t output_activation_min,
+                       int32_t output_activation_max, int8_t* output) {
+  const int block_rows = weights.block_rows;
+  const int block_cols = weights.block_cols;
+
+  for (int block_row = 0; block_row < weights.num_block_rows; ++block_row) {
+    const int first_row = block_row * block_rows;
+    int32_t acc[kMaxBlockRows];
+    for (int r = 0; r < block_rows; ++r) {
+      acc[r] = weights.input_offset_terms[first_row + r];
+      if (bias != nullptr) {
+        acc[r] += bias[first_row + r];
+      }
+    }
+
+    if (block_rows == 1 && block_cols == 4) {
+      AccumulateBlockRow<1, 4>(weights, values, input, block_row, acc);
+    } else if (block_rows == 1 && block_cols == 16) {
+      AccumulateBlockRow<1, 16>(weights, values, input, block_row, acc);
+    } else if (block_rows == 4 && block_cols == 1) {
+      AccumulateBlockRow<4, 1>(weights, values, input, block_row, acc);
+    } else {
+      AccumulateBlockRow<0, 0>(weights, values, input, block_row, acc);
+    }
+
+    for (int r = 0; r < block_rows; ++r) {
+      const int row = first_row + r;
+      int32_t result = MultiplyByQuantizedMultiplier(
+          acc[r], output_multiplier[row], output_shift[row]);
+      result += output_offset;
+      result = std::max(result, output_activation_min);
+      result = std::min(result, output_activation_max);
+      output[row] = static_cast<int8_t>(result);
+    }
+  }
+}
+
+}  // namespace tflite
@@ -0,0 +1,74 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_BLOCK_SPARSE_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_BLOCK_SPARSE_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+
+// Int8 weights stored in the TFLite sparse format, as produced by the
+// converter for pruned models: the filter is split into block_rows x
+// block_cols blocks (e.g. 1x4, 4x1 or 1x16) and only the non-zero blocks are
+// kept, row of blocks by row of blocks, with a CSR index over the block
+// columns. The tensor data then holds just the values of those blocks.
+//
+// Supported are filters whose last dimension is the input depth, i.e. fully
+// connected weights and 1x1 convolution filters, with the sparse CSR
+// dimension last and, if blocked, blocks along the first and/or last
+// dimension.
+
+namespace tflite {
+
+// Block index decoded from the sparsity parameters in Prepare.
+struct BlockSparseWeights {
+  int block_rows;
+  int block_cols;
+  int num_block_rows;
+
+  // The non-zero blocks of block row i are block_row_starts[i], ...,
+  // block_row_starts[i + 1] - 1, and block_columns[k] is the block column of
+  // block k. nullptr for dense weights.
+  int32_t* block_row_starts;
+  uint16_t* block_columns;
+
+  // input_offset * sum(filter[row][:]) for every row, so that the kernel can
+  // accumulate input values without their zero point.
+  int32_t* input_offset_terms;
+};
+
+// Decodes the sparsity parameters of the given input of node, which must be
+// the int8 filter tensor with rows x cols weights, into weights. Leaves
+// weights->block_row_starts set to nullptr if the filter is dense, and returns
+// an error for sparse encodings that are not supported.
+TfLiteStatus BlockSparseWeightsInit(TfLiteContext* context,
+                                    const TfLiteNode* node, int filter_index,
+                                    const TfLiteTensor* filter, int rows,
+                                    int cols, int32_t input_offset,
+                                    BlockSparseWeights* weights);
+
+// Computes one output vector of rows elements from one input vector, touching
+// only the non-zero blocks. bias may be nullptr. output_multiplier and
+// output_shift hold one value per row.
+void BlockSparseMatVec(const BlockSparseWeights& weights, const int8_t* values,
+                       const int8_t* input, const int32_t* bias,
+                       const int32_t* output_multiplier,
+                       const int32_t* output_shift, int32_t output_offset,
+                       int32_t output_activation_min,
+                       int32_t output_activation_max, int8_t* output);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_BLOCK_SPARSE_H_
@@ -23,7 +23,9 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/op_macros.h"
+#include "tensorflow/lite/micro/kernels/cmsis_nn/broadcast_fivefold.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/x86_int8.h"
 #include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
@@ -37,6 +39,10 @@ constexpr int kOutputTensor = 0;
 struct OpData {
   bool requires_broadcast;
 
+  // Broadcast pattern of the quantized inputs, classified in Prepare.
+  BroadcastableOpCategory broadcast_category;
+  int broadcast_shape[5];
+
   // These fields are used in both the general 8-bit -> 8bit quantized path,
   // and the special 16-bit -> 16bit quantized path
   int input1_shift;
@@ -68,6 +74,13 @@ TfLiteStatus CalculateOpData(TfLiteContext* context, TfLiteAddParams* params,
   data->requires_broadcast = !HaveSameShapes(input1, input2);
 
   if (output->type == kTfLiteInt8 || output->type == kTfLiteInt16) {
+    tflite::ArithmeticParams broadcast_params;
+    reference_ops::ProcessBroadcastShapes(GetTensorShape(input1),
+                                          GetTensorShape(input2),
+                                          &broadcast_params);
+    data->broadcast_category = broadcast_params.broadcast_category;
+    std::copy_n(broadcast_params.broadcast_shape, 5, data->broadcast_shape);
+
     // 8bit -> 8bit general quantized path, with general rescalings
     data->input1_offset = -input1->params.zero_point;
     data->input2_offset = -input2->params.zero_point;
@@ -119,6 +132,44 @@ void UpdateOpParams(tflite::ArithmeticParams* const op_params,
   op_params->output_shift = data->output_shift;
   SetActivationParams(data->output_activation_min, data->output_activation_max,
                       op_params);
+  op_params->broadcast_category = data->broadcast_category;
+  std::copy_n(data->broadcast_shape, 5, op_params->broadcast_shape);
+}
+
+// Swaps the per-input parameters so that input1 is the input that broadcasts
+// fast, as expected by BroadcastFivefold.
+void SwapInputParams(tflite::ArithmeticParams* op_params) {
+  std::swap(op_params->input1_offset, op_params->input2_offset);
+  std::swap(op_params->input1_multiplier, op_params->input2_multiplier);
+  std::swap(op_params->input1_shift, op_params->input2_shift);
+}
+
+template <typename T, typename ElementwiseAddF>
+void EvalAddBroadcast(tflite::ArithmeticParams op_params,
+                      const TfLiteEvalTensor* input1,
+                      const TfLiteEvalTensor* input2, TfLiteEvalTensor* output,
+                      ElementwiseAddF elementwise_add) {
+  const T* input1_data = tflite::micro::GetTensorData<T>(input1);
+  const T* input2_data = tflite::micro::GetTensorData<T>(input2);
+  if (op_params.broadcast_category ==
+      BroadcastableOpCategory::kSecondInputBroadcastsFast) {
+    SwapInputParams(&op_params);
+    std::swap(input1_data, input2_data);
+  }
+  cmsis_nn_broadcast::BroadcastFivefold(
+      op_params.broadcast_shape, input1_data, input2_data,
+      tflite::micro::GetTensorData<T>(output),
+      [&op_params, elementwise_add](const T* in1, const T* in2, T* out,
+                                    int size) {
+        elementwise_add(
+            in1, in2, op_params.input1_offset, op_params.input1_multiplier,
+            op_params.input1_shift, op_params.input2_offset,
+            op_params.input2_multiplier, op_params.input2_shift,
+            op_params.left_shift, out, op_params.output_offset,
+            op_params.output_multiplier, op_params.output_shift,
+            op_params.quantized_activation_min,
+            op_params.quantized_activation_max, size);
+      });
 }
 
 TfLiteStatus EvalAddQuantizedInt8(TfLiteContext* context, TfLiteNode* node,
@@ -129,11 +180,11 @@ TfLiteStatus EvalAddQuantizedInt8(TfLiteContext* context, TfLiteNode* node,
   tflite::ArithmeticParams op_params;
   UpdateOpParams(&op_params, data);
 
-  bool need_broadcast = reference_ops::ProcessBroadcastShapes(
-      tflite::micro::GetTensorShape(input1),
-      tflite::micro::GetTensorShape(input2), &op_params);
-
-  if (need_broadcast) {
+  if (cmsis_nn_broadcast::IsFivefold(op_params.broadcast_category)) {
+    EvalAddBroadcast<int8_t>(op_params, input1, input2, output,
+                             arm_elementwise_add_s8);
+  } else if (op_params.broadcast_category ==
+             BroadcastableOpCategory::kGenericBroadcast) {
     reference_integer_ops::BroadcastAdd4DSlow(
         op_params, tflite::micro::GetTensorShape(input1),
         tflite::micro::GetTensorData<int8_t>(input1),
@@ -142,6 +193,17 @@ TfLiteStatus EvalAddQuantizedInt8(TfLiteContext* context, TfLiteNode* node,
         tflite::micro::GetTensorShape(output),
         tflite::micro::GetTensorData<int8_t>(output));
   } else {
+#if defined(TF_LITE_MICRO_X86_INT8_ENABLED)
+    if (x86_int8::AddElementwise(
+            MatchingElementsSize(tflite::micro::GetTensorShape(input1),
+                                 tflite::micro::GetTensorShape(input2),
+                                 tflite::micro::GetTensorShape(output)),
+            op_params, tflite::micro::GetTensorData<int8_t>(input1),
+            tflite::micro::GetTensorData<int8_t>(input2),
+            tflite::micro::GetTensorData<int8_t>(output))) {
+      return kTfLiteOk;
+    }
+#endif
     arm_elementwise_add_s8(
         tflite::micro::GetTensorData<int8_t>(input1),
 
@@ -168,11 +230,11 @@ TfLiteStatus EvalAddQuantizedInt16(TfLiteContext* context, TfLiteNode* node,
   tflite::ArithmeticParams op_params;
   UpdateOpParams(&op_params, data);
 
-  bool need_broadcast = reference_ops::ProcessBroadcastShapes(
-      tflite::micro::GetTensorShape(input1),
-      tflite::micro::GetTensorShape(input2), &op_params);
-
-  if (need_broadcast) {
+  if (cmsis_nn_broadcast::IsFivefold(op_params.broadcast_category)) {
+    EvalAddBroadcast<int16_t>(op_params, input1, input2, output,
+                              arm_elementwise_add_s16);
+  } else if (op_params.broadcast_category ==
+             BroadcastableOpCategory::kGenericBroadcast) {
     reference_ops::BroadcastAdd4DSlow(
         op_params, tflite::micro::GetTensorShape(input1),
         tflite::micro::GetTensorData<int16_t>(input1),
@@ -0,0 +1,439 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cstdint>
+
+#include "third_party/cmsis_nn/Include/arm_nnsupportfunctions.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/micro_log.h"
+
+namespace tflite {
+namespace {
+
+constexpr int kLhsTensor = 0;
+constexpr int kRhsTensor = 1;
+constexpr int kOutputTensor = 0;
+
+// BATCH_MATMUL supports up to three broadcast batch dimensions in front of
+// the two matrix dimensions.
+constexpr int kMaxDims = 5;
+
+struct OpData {
+  // Quantization parameters. Unused for float32.
+  int32_t output_multiplier;
+  int output_shift;
+  int32_t lhs_zero_point;
+  int32_t rhs_zero_point;
+  int32_t output_zero_point;
+  int32_t output_activation_min;
+  int32_t output_activation_max;
+
+  // arm_nn_mat_mult_nt_t_s8 takes per-column requantization parameters. These
+  // arrays hold output_multiplier/output_shift replicated for every output
+  // column and are only allocated when the int8 CMSIS-NN path is usable.
+  int32_t* per_column_multiplier;
+  int32_t* per_column_shift;
+
+  // Matrix dimensions: output is [rows, cols], the reduction is over depth.
+  int32_t rows;
+  int32_t cols;
+  int32_t depth;
+
+  // Batch dimensions of the (5D extended) output, and the per batch dimension
+  // strides of both inputs. A stride of zero means that input is broadcast.
+  int32_t batch_dims[3];
+  int32_t lhs_batch_strides[3];
+  int32_t rhs_batch_strides[3];
+
+  // Persistent [cols, depth] copy of a constant int8 RHS that is stored as
+  // [depth, cols]. nullptr otherwise.
+  void* rhs_transposed;
+
+  // Scratch buffer used to transpose each LHS matrix when adj_x is set.
+  int lhs_scratch_index;
+  // Scratch buffer holding one output row of accumulators for the row-major
+  // RHS kernel, used when a non-constant RHS is stored as [depth, cols].
+  int accumulator_scratch_index;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
+}
+
+// Transposes count consecutive [rows, cols] matrices into [cols, rows].
+template <typename T>
+void TransposeMatrices(const T* input, int count, int rows, int cols,
+                       T* output) {
+  for (int m = 0; m < count; ++m) {
+    for (int r = 0; r < rows; ++r) {
+      for (int c = 0; c < cols; ++c) {
+        output[c * rows + r] = input[r * cols + c];
+      }
+    }
+    input += rows * cols;
+    output += rows * cols;
+  }
+}
+
+template <typename T, typename AccumT>
+inline T Requantize(AccumT acc, const OpData& data) {
+  int32_t result = MultiplyByQuantizedMultiplier(acc, data.output_multiplier,
+                                                 data.output_shift);
+  result += data.output_zero_point;
+  result = std::max(result, data.output_activation_min);
+  result = std::min(result, data.output_activation_max);
+  return static_cast<T>(result);
+}
+
+// Quantized matrix multiply with the RHS stored as [cols, depth]. Both
+// operands are read sequentially along the depth, so no copy is required.
+template <typename T, typename AccumT>
+void MatMulTransposedRhs(const OpData& data, const T* lhs, const T* rhs,
+                         T* output) {
+  const int32_t lhs_offset = -data.lhs_zero_point;
+  const int32_t rhs_offset = -data.rhs_zero_point;
+  for (int r = 0; r < data.rows; ++r) {
+    const T* lhs_row = lhs + r * data.depth;
+    const T* rhs_row = rhs;
+    for (int c = 0; c < data.cols; ++c) {
+      AccumT acc = 0;
+      for (int d = 0; d < data.depth; ++d) {
+        acc += static_cast<AccumT>(lhs_row[d] + lhs_offset) *
+               static_cast<AccumT>(rhs_row[d] + rhs_offset);
+      }
+      *output++ = Requantize<T, AccumT>(acc, data);
+      rhs_row += data.depth;
+    }
+  }
+}
+
+// Quantized matrix multiply with the RHS stored as [depth, cols]. Each output
+// row is accumulated by streaming contiguous RHS rows into a row of
+// accumulators, which avoids materializing a transposed copy of the RHS.
+template <typename T, typename AccumT>
+void MatMulRowMajorRhs(const OpData& data, const T* lhs, const T* rhs,
+                       AccumT* accumulators, T* output) {
+  const int32_t lhs_offset = -data.lhs_zero_point;
+  const int32_t rhs_offset = -data.rhs_zero_point;
+  for (int r = 0; r < data.rows; ++r) {
+    std::fill(accumulators, accumulators + data.cols, 0);
+    const T* rhs_row = rhs;
+    for (int d = 0; d < data.depth; ++d) {
+      const AccumT lhs_val = lhs[r * data.depth + d] + lhs_offset;
+      for (int c = 0; c < data.cols; ++c) {
+        accumulators[c] +=
+            lhs_val * static_cast<AccumT>(rhs_row[c] + rhs_offset);
+      }
+      rhs_row += data.cols;
+    }
+    for (int c = 0; c < data.cols; ++c) {
+      *output++ = Requantize<T, AccumT>(accumulators[c], data);
+    }
+  }
+}
+
+TfLiteStatus MatMul(TfLiteContext* context, const OpData& data,
+                    const float* lhs, const float* rhs, bool rhs_is_transposed,
+                    float* accumulators, float* output) {
+  for (int r = 0; r < data.rows; ++r) {
+    const float* lhs_row = lhs + r * data.depth;
+    if (rhs_is_transposed) {
+      for (int c = 0; c < data.cols; ++c) {
+        const float* rhs_row = rhs + c * data.depth;
+        float acc = 0.0f;
+        for (int d = 0; d < data.depth; ++d) {
+          acc += lhs_row[d] * rhs_row[d];
+        }
+        *output++ = acc;
+      }
+    } else {
+      std::fill(accumulators, accumulators + data.cols, 0.0f);
+      for (int d = 0; d < data.depth; ++d) {
+        const float* rhs_row = rhs + d * data.cols;
+        for (int c = 0; c < data.cols; ++c) {
+          accumulators[c] += lhs_row[d] * rhs_row[c];
+        }
+      }
+      for (int c = 0; c < data.cols; ++c) {
+        *output++ = accumulators[c];
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus MatMul(TfLiteContext* context, const OpData& data,
+                    const int8_t* lhs, const int8_t* rhs,
+                    bool rhs_is_transposed, int32_t* accumulators,
+                    int8_t* output) {
+  if (!rhs_is_transposed) {
+    MatMulRowMajorRhs<int8_t, int32_t>(data, lhs, rhs, accumulators, output);
+  } else if (data.per_column_multiplier != nullptr) {
+    TF_LITE_ENSURE_EQ(
+        context,
+        arm_nn_mat_mult_nt_t_s8(
+            lhs, rhs, nullptr, output, data.per_column_multiplier,
+            data.per_column_shift, data.rows, data.cols, data.depth,
+            -data.lhs_zero_point, data.output_zero_point,
+            data.output_activation_min, data.output_activation_max),
+        ARM_CMSIS_NN_SUCCESS);
+  } else {
+    MatMulTransposedRhs<int8_t, int32_t>(data, lhs, rhs, output);
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus MatMul(TfLiteContext* context, const OpData& data,
+                    const int16_t* lhs, const int16_t* rhs,
+                    bool rhs_is_transposed, int64_t* accumulators,
+                    int16_t* output) {
+  if (rhs_is_transposed) {
+    MatMulTransposedRhs<int16_t, int64_t>(data, lhs, rhs, output);
+  } else {
+    MatMulRowMajorRhs<int16_t, int64_t>(data, lhs, rhs, accumulators, output);
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+  TF_LITE_ENSURE_EQ(context, NumInputs(node), 2);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
+
+  OpData* data = static_cast<OpData*>(node->user_data);
+  const auto* params =
+      static_cast<const TfLiteBatchMatMulParams*>(node->builtin_data);
+
+  MicroContext* micro_context = GetMicroContext(context);
+  TfLiteTensor* lhs = micro_context->AllocateTempInputTensor(node, kLhsTensor);
+  TF_LITE_ENSURE(context, lhs != nullptr);
+  TfLiteTensor* rhs = micro_context->AllocateTempInputTensor(node, kRhsTensor);
+  TF_LITE_ENSURE(context, rhs != nullptr);
+  TfLiteTensor* output =
+      micro_context->AllocateTempOutputTensor(node, kOutputTensor);
+  TF_LITE_ENSURE(context, output != nullptr);
+
+  TF_LITE_ENSURE_TYPES_EQ(context, lhs->type, rhs->type);
+  TF_LITE_ENSURE_TYPES_EQ(context, lhs->type, output->type);
+  TF_LITE_ENSURE_MSG(context,
+                     lhs->type == kTfLiteFloat32 || lhs->type == kTfLiteInt8 ||
+                         lhs->type == kTfLiteInt16,
+                     "BATCH_MATMUL only supports float32, int8 and int16.");
+
+  const int lhs_rank = NumDimensions(lhs);
+  const int rhs_rank = NumDimensions(rhs);
+  TF_LITE_ENSURE(context, lhs_rank >= 2 && lhs_rank <= kMaxDims);
+  TF_LITE_ENSURE(context, rhs_rank >= 2 && rhs_rank <= kMaxDims);
+
+  const RuntimeShape lhs_shape =
+      RuntimeShape::ExtendedShape(kMaxDims, GetTensorShape(lhs));
+  const RuntimeShape rhs_shape =
+      RuntimeShape::ExtendedShape(kMaxDims, GetTensorShape(rhs));
+  const RuntimeShape output_shape =
+      RuntimeShape::ExtendedShape(kMaxDims, GetTensorShape(output));
+
+  data->rows = params->adj_x ? lhs_shape.Dims(4) : lhs_shape.Dims(3);
+  data->depth = params->adj_x ? lhs_shape.Dims(3) : lhs_shape.Dims(4);
+  data->cols = params->adj_y ? rhs_shape.Dims(3) : rhs_shape.Dims(4);
+  const int rhs_depth = params->adj_y ? rhs_shape.Dims(4) : rhs_shape.Dims(3);
+  TF_LITE_ENSURE_EQ(context, data->depth, rhs_depth);
+  TF_LITE_ENSURE_EQ(context, output_shape.Dims(3), data->rows);
+  TF_LITE_ENSURE_EQ(context, output_shape.Dims(4), data->cols);
+
+  const int lhs_matrix_size = data->rows * data->depth;
+  const int rhs_matrix_size = data->depth * data->cols;
+  int lhs_stride = lhs_matrix_size;
+  int rhs_stride = rhs_matrix_size;
+  for (int i = 2; i >= 0; --i) {
+    const int lhs_dim = lhs_shape.Dims(i);
+    const int rhs_dim = rhs_shape.Dims(i);
+    TF_LITE_ENSURE(context,
+                   lhs_dim == rhs_dim || lhs_dim == 1 || rhs_dim == 1);
+    data->batch_dims[i] = std::max(lhs_dim, rhs_dim);
+    TF_LITE_ENSURE_EQ(context, output_shape.Dims(i), data->batch_dims[i]);
+    data->lhs_batch_strides[i] = lhs_dim == 1 ? 0 : lhs_stride;
+    data->rhs_batch_strides[i] = rhs_dim == 1 ? 0 : rhs_stride;
+    lhs_stride *= lhs_dim;
+    rhs_stride *= rhs_dim;
+  }
+
+  data->per_column_multiplier = nullptr;
+  data->per_column_shift = nullptr;
+  data->rhs_transposed = nullptr;
+  data->lhs_scratch_index = -1;
+  data->accumulator_scratch_index = -1;
+
+  if (lhs->type == kTfLiteInt8 || lhs->type == kTfLiteInt16) {
+    if (lhs->type == kTfLiteInt16) {
+      TF_LITE_ENSURE_EQ(context, lhs->params.zero_point, 0);
+      TF_LITE_ENSURE_EQ(context, rhs->params.zero_point, 0);
+      TF_LITE_ENSURE_EQ(context, output->params.zero_point, 0);
+    }
+    const double real_multiplier = static_cast<double>(lhs->params.scale) *
+                                   static_cast<double>(rhs->params.scale) /
+                                   static_cast<double>(output->params.scale);
+    QuantizeMultiplier(real_multiplier, &data->output_multiplier,
+                       &data->output_shift);
+    data->lhs_zero_point = lhs->params.zero_point;
+    data->rhs_zero_point = rhs->params.zero_point;
+    data->output_zero_point = output->params.zero_point;
+    TF_LITE_ENSURE_STATUS(CalculateActivationRangeQuantized(
+        context, kTfLiteActNone, output, &data->output_activation_min,
+        &data->output_activation_max));
+
+    // arm_nn_mat_mult_nt_t_s8 only applies an offset to the LHS.
+    if (lhs->type == kTfLiteInt8 && data->rhs_zero_point == 0) {
+      data->per_column_multiplier =
+          static_cast<int32_t*>(context->AllocatePersistentBuffer(
+              context, data->cols * sizeof(int32_t)));
+      data->per_column_shift =
+          static_cast<int32_t*>(context->AllocatePersistentBuffer(
+              context, data->cols * sizeof(int32_t)));
+      TF_LITE_ENSURE(context, data->per_column_multiplier != nullptr &&
+                                  data->per_column_shift != nullptr);
+      for (int i = 0; i < data->cols; ++i) {
+        data->per_column_multiplier[i] = data->output_multiplier;
+        data->per_column_shift[i] = data->output_shift;
+      }
+    }
+  }
+
+  // A constant RHS that is not stored as [cols, depth] is transposed once here
+  // so that every Eval can use arm_nn_mat_mult_nt_t_s8. The other kernels read
+  // the RHS in its original layout and do not need the extra copy.
+  const size_t element_size = TfLiteTypeGetSize(lhs->type);
+  if (!params->adj_y && IsConstantTensor(rhs) &&
+      data->per_column_multiplier != nullptr) {
+    const int count = NumElements(rhs) / rhs_matrix_size;
+    data->rhs_transposed =
+        context->AllocatePersistentBuffer(context, count * rhs_matrix_size);
+    TF_LITE_ENSURE(context, data->rhs_transposed != nullptr);
+    TransposeMatrices(GetTensorData<int8_t>(rhs), count, data->depth,
+                      data->cols, static_cast<int8_t*>(data->rhs_transposed));
+  } else if (!params->adj_y) {
+    const size_t accumulator_size =
+        lhs->type == kTfLiteInt16 ? sizeof(int64_t) : sizeof(int32_t);
+    TF_LITE_ENSURE_STATUS(micro_context->RequestAlignedScratchBufferInArena(
+        data->cols * accumulator_size, accumulator_size,
+        &data->accumulator_scratch_index));
+  }
+
+  if (params->adj_x) {
+    TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+        context, lhs_matrix_size * element_size, &data->lhs_scratch_index));
+  }
+
+  micro_context->DeallocateTempTfLiteTensor(lhs);
+  micro_context->DeallocateTempTfLiteTensor(rhs);
+  micro_context->DeallocateTempTfLiteTensor(output);
+
+  return kTfLiteOk;
+}
+
+template <typename T, typename AccumT>
+TfLiteStatus EvalBatches(TfLiteContext* context, const OpData& data,
+                         const TfLiteBatchMatMulParams* params,
+                         const TfLiteEvalTensor* lhs,
+                         const TfLiteEvalTensor* rhs,
+                         TfLiteEvalTensor* output) {
+  const T* lhs_data = tflite::micro::GetTensorData<T>(lhs);
+  const bool rhs_is_transposed =
+      params->adj_y || data.rhs_transposed != nullptr;
+  const T* rhs_data = data.rhs_transposed != nullptr
+                          ? static_cast<const T*>(data.rhs_transposed)
+                          : tflite::micro::GetTensorData<T>(rhs);
+  T* output_data = tflite::micro::GetTensorData<T>(output);
+
+  T* lhs_scratch = nullptr;
+  if (params->adj_x) {
+    lhs_scratch = static_cast<T*>(
+        context->GetScratchBuffer(context, data.lhs_scratch_index));
+  }
+  AccumT* accumulators = nullptr;
+  if (!rhs_is_transposed) {
+    accumulators = static_cast<AccumT*>(
+        context->GetScratchBuffer(context, data.accumulator_scratch_index));
+  }
+
+  for (int b0 = 0; b0 < data.batch_dims[0]; ++b0) {
+    for (int b1 = 0; b1 < data.batch_dims[1]; ++b1) {
+      for (int b2 = 0; b2 < data.batch_dims[2]; ++b2) {
+        const T* lhs_matrix = lhs_data + b0 * data.lhs_batch_strides[0] +
+                              b1 * data.lhs_batch_strides[1] +
+                              b2 * data.lhs_batch_strides[2];
+        const T* rhs_matrix = rhs_data + b0 * data.rhs_batch_strides[0] +
+                              b1 * data.rhs_batch_strides[1] +
+                              b2 * data.rhs_batch_strides[2];
+        if (lhs_scratch != nullptr) {
+          TransposeMatrices(lhs_matrix, 1, data.depth, data.rows, lhs_scratch);
+          lhs_matrix = lhs_scratch;
+        }
+
+        TF_LITE_ENSURE_STATUS(MatMul(context, data, lhs_matrix, rhs_matrix,
+                                     rhs_is_transposed, accumulators,
+                                     output_data));
+        output_data += data.rows * data.cols;
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+  const OpData& data = *(static_cast<const OpData*>(node->user_data));
+  const auto* params =
+      static_cast<const TfLiteBatchMatMulParams*>(node->builtin_data);
+
+  const TfLiteEvalTensor* lhs =
+      tflite::micro::GetEvalInput(context, node, kLhsTensor);
+  const TfLiteEvalTensor* rhs =
+      tflite::micro::GetEvalInput(context, node, kRhsTensor);
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensor);
+
+  switch (lhs->type) {
+    case kTfLiteFloat32:
+      return EvalBatches<float, float>(context, data, params, lhs, rhs, output);
+    case kTfLiteInt8:
+      return EvalBatches<int8_t, int32_t>(context, data, params, lhs, rhs,
+                                          output);
+    case kTfLiteInt16:
+      return EvalBatches<int16_t, int64_t>(context, data, params, lhs, rhs,
+                                           output);
+    default:
+      MicroPrintf("Type %s (%d) not supported.", TfLiteTypeGetName(lhs->type),
+                  lhs->type);
+      return kTfLiteError;
+  }
+}
+
+}  // namespace
+
+TfLiteRegistration Register_BATCH_MATMUL() {
+  return tflite::micro::RegisterOp(Init, Prepare, Eval);
+}
+
+}  // namespace tflite
@@ -0,0 +1,104 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_CMSIS_NN_BROADCAST_FIVEFOLD_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_CMSIS_NN_BROADCAST_FIVEFOLD_H_
+
+#include <algorithm>
+
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+
+namespace tflite {
+namespace cmsis_nn_broadcast {
+
+// Longest run handed to the elementwise function when one input is a single
+// value per run and has to be replicated into a stack buffer.
+constexpr int kMaxScalarRun = 64;
+
+// Returns true if the category computed by ProcessBroadcastShapes can be
+// evaluated with BroadcastFivefold.
+inline bool IsFivefold(BroadcastableOpCategory category) {
+  return category == BroadcastableOpCategory::kFirstInputBroadcastsFast ||
+         category == BroadcastableOpCategory::kSecondInputBroadcastsFast;
+}
+
+// Evaluates a binary op over the fivefold broadcast pattern described by
+// broadcast_shape (see ArithmeticParams::broadcast_shape) by calling
+// elementwise(input1, input2, output, size) on contiguous runs. This covers
+// scalars, per-channel vectors and per-batch vectors without going through
+// NdArrayDesc for every element.
+//
+// input1 must be the input that broadcasts fast, i.e. the caller swaps the
+// inputs (and their quantization parameters) for
+// kSecondInputBroadcastsFast.
+template <typename T, typename ElementwiseF>
+void BroadcastFivefold(const int* broadcast_shape, const T* input1_data,
+                       const T* input2_data, T* output_data,
+                       ElementwiseF elementwise) {
+  // input1 has y0 * y1 * y2 * y4 elements and input2 y0 * y2 * y3 * y4.
+  const int y0 = broadcast_shape[0];
+  const int y1 = broadcast_shape[1];
+  const int y2 = broadcast_shape[2];
+  const int y3 = broadcast_shape[3];
+  const int y4 = broadcast_shape[4];
+
+  const T* input1_data_ptr = input1_data;
+  const T* input2_data_reset = input2_data;
+  T* output_data_ptr = output_data;
+
+  if (y4 > 1) {
+    for (int i0 = 0; i0 < y0; ++i0) {
+      const T* input2_data_ptr = nullptr;
+      for (int i1 = 0; i1 < y1; ++i1) {
+        input2_data_ptr = input2_data_reset;
+        for (int i2 = 0; i2 < y2; ++i2) {
+          for (int i3 = 0; i3 < y3; ++i3) {
+            elementwise(input1_data_ptr, input2_data_ptr, output_data_ptr, y4);
+            input2_data_ptr += y4;
+            output_data_ptr += y4;
+          }
+          input1_data_ptr += y4;
+        }
+      }
+      input2_data_reset = input2_data_ptr;
+    }
+  } else {
+    // A single element of input1 is broadcast over y3 elements of input2.
+    T scalar_run[kMaxScalarRun];
+    const int run_length = std::min(y3, kMaxScalarRun);
+    for (int i0 = 0; i0 < y0; ++i0) {
+      const T* input2_data_ptr = nullptr;
+      for (int i1 = 0; i1 < y1; ++i1) {
+        input2_data_ptr = input2_data_reset;
+        for (int i2 = 0; i2 < y2; ++i2) {
+          std::fill_n(scalar_run, run_length, *input1_data_ptr);
+          for (int i3 = 0; i3 < y3; i3 += run_length) {
+            const int size = std::min(run_length, y3 - i3);
+            elementwise(scalar_run, input2_data_ptr, output_data_ptr, size);
+            input2_data_ptr += size;
+            output_data_ptr += size;
+          }
+          ++input1_data_ptr;
+        }
+      }
+      input2_data_reset = input2_data_ptr;
+    }
+  }
+}
+
+}  // namespace cmsis_nn_broadcast
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_CMSIS_NN_BROADCAST_FIVEFOLD_H_
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/lite/micro/kernels/conv.h"
 
+#include <algorithm>
+
 #include "third_party/cmsis_nn/Include/arm_nn_types.h"
 #include "third_party/cmsis_nn/Include/arm_nnfunctions.h"
 #include "tensorflow/lite/c/builtin_op_data.h"
@@ -26,17 +28,47 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/kernels/block_sparse.h"
+#include "tensorflow/lite/micro/kernels/cmsis_nn/palettized_weights.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/simd_float.h"
+#include "tensorflow/lite/micro/kernels/winograd_conv.h"
+#include "tensorflow/lite/micro/kernels/x86_int8.h"
+#include "tensorflow/lite/micro/micro_kernel_tuner.h"
 #include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_time.h"
 
 namespace tflite {
 namespace {
 
+// Implementations the kernel tuner chooses between for int8 convolutions.
+enum ConvKernel {
+  kConvKernel1x1Fast = 0,
+  kConvKernel1xN,
+  kConvKernelGeneric,
+  kConvKernelReference,
+  kNumConvKernels,
+};
+
 struct OpData {
   OpDataConv reference_op_data;
 
   // Index to buffer for optimizations if applicable.
   int buffer_idx;
+
+  // Slot of the node in the kernel tuner, or -1 if arm_convolve_wrapper_s8
+  // picks the implementation. candidates lists the implementations that
+  // support the node, starting with the one the wrapper would pick.
+  int tuning_slot;
+  int num_candidates;
+  ConvKernel candidates[kNumConvKernels];
+
+  // Index of the non-zero blocks of sparse int8 1x1 filters, which are run as
+  // one sparse matrix-vector product per output pixel.
+  BlockSparseWeights sparse_weights;
+
+  // Codebook and tiling of palettized filters.
+  palette::PalettizedWeights palettized_weights;
 };
 
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
@@ -44,6 +76,54 @@ void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   return context->AllocatePersistentBuffer(context, sizeof(OpData));
 }
 
+// Registers an int8 node with tuner if more than one implementation supports
+// it, and returns the scratch buffer size the candidates need.
+int32_t PrepareTuning(MicroKernelTuner* tuner,
+                      const cmsis_nn_conv_params& conv_params,
+                      const cmsis_nn_dims& input_dims,
+                      const cmsis_nn_dims& filter_dims,
+                      const cmsis_nn_dims& output_dims, OpData* data) {
+  // Same conditions as arm_convolve_wrapper_s8.
+  const bool undilated =
+      conv_params.dilation.w == 1 && conv_params.dilation.h == 1;
+  const bool supports_1x1_fast =
+      conv_params.padding.w == 0 && conv_params.padding.h == 0 &&
+      conv_params.stride.w == 1 && conv_params.stride.h == 1 &&
+      filter_dims.w == 1 && filter_dims.h == 1 && undilated;
+  const bool supports_1xn = input_dims.h == 1 && output_dims.w % 4 == 0 &&
+                            conv_params.dilation.w == 1 && filter_dims.h == 1;
+
+  int num_candidates = 0;
+  int32_t buf_size = 0;
+  if (supports_1x1_fast) {
+    data->candidates[num_candidates++] = kConvKernel1x1Fast;
+    buf_size = arm_convolve_1x1_s8_fast_get_buffer_size(&input_dims);
+  }
+  if (supports_1xn) {
+    data->candidates[num_candidates++] = kConvKernel1xN;
+    buf_size = std::max(
+        buf_size, arm_convolve_1_x_n_s8_get_buffer_size(&input_dims,
+                                                        &filter_dims));
+  }
+  data->candidates[num_candidates++] = kConvKernelGeneric;
+  buf_size = std::max(
+      buf_size, arm_convolve_s8_get_buffer_size(&input_dims, &filter_dims));
+  data->candidates[num_candidates++] = kConvKernelReference;
+  data->num_candidates = num_candidates;
+
+  uint32_t signature = MicroKernelTuner::kInitialHash;
+  signature = MicroKernelTuner::Hash(signature, &conv_params,
+                                     sizeof(conv_params));
+  signature = MicroKernelTuner::Hash(signature, &input_dims,
+                                     sizeof(input_dims));
+  signature = MicroKernelTuner::Hash(signature, &filter_dims,
+                                     sizeof(filter_dims));
+  signature = MicroKernelTuner::Hash(signature, &output_dims,
+                                     sizeof(output_dims));
+  data->tuning_slot = tuner->RegisterNode(signature);
+  return data->tuning_slot >= 0 ? buf_size : 0;
+}
+
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TFLITE_DCHECK(node->user_data != nullptr);
   TFLITE_DCHECK(node->builtin_data != nullptr);
@@ -98,14 +178,14 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
         context, filter_size, &data->reference_op_data.filter_buffer_index);
   }
 
+  data->reference_op_data.per_channel_output_precomputed = false;
   if (input->type == kTfLiteInt8 || input->type == kTfLiteInt16) {
     const int num_channels = filter->dims->data[kConvQuantizedDimension];
-    data->reference_op_data.per_channel_output_multiplier =
-        static_cast<int32_t*>(context->AllocatePersistentBuffer(
-            context, num_channels * sizeof(int32_t)));
-    data->reference_op_data.per_channel_output_shift =
-        static_cast<int32_t*>(context->AllocatePersistentBuffer(
-            context, num_channels * sizeof(int32_t)));
+    TF_LITE_ENSURE_STATUS(micro::AllocatePerChannelOutputMultipliers(
+        context, node, num_channels,
+        &data->reference_op_data.per_channel_output_multiplier,
+        &data->reference_op_data.per_channel_output_shift,
+        &data->reference_op_data.per_channel_output_precomputed));
   }
 
   TF_LITE_ENSURE_STATUS(CalculateOpDataConv(
@@ -113,7 +193,52 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       filter_dims.h, output_dims.w, output_dims.h, input->type,
       &data->reference_op_data));
 
-  if (input->type == kTfLiteInt8 || input->type == kTfLiteInt16) {
+  if (input->type == kTfLiteInt16) {
+    TF_LITE_ENSURE_EQ(context, input->params.zero_point, 0);
+    TF_LITE_ENSURE_EQ(context, output->params.zero_point, 0);
+  }
+
+  TF_LITE_ENSURE_STATUS(BlockSparseWeightsInit(
+      context, node, kConvWeightsTensor, filter, output_dims.c, input_dims.c,
+      -input->params.zero_point, &data->sparse_weights));
+  const bool is_sparse = data->sparse_weights.block_row_starts != nullptr;
+  if (is_sparse) {
+    TF_LITE_ENSURE_MSG(context,
+                       input->type == kTfLiteInt8 && filter_dims.w == 1 &&
+                           filter_dims.h == 1 &&
+                           data->reference_op_data.padding.width == 0 &&
+                           data->reference_op_data.padding.height == 0,
+                       "Sparse filters are only supported for unpadded int8 "
+                       "1x1 convolutions.");
+  }
+  TF_LITE_ENSURE_STATUS(palette::PrepareConv(
+      context, node, kConvWeightsTensor, params,
+      data->reference_op_data.padding, filter, &data->palettized_weights));
+  const bool is_palettized = data->palettized_weights.palette != nullptr;
+  if (is_palettized) {
+    TF_LITE_ENSURE_MSG(
+        context, input->type == kTfLiteInt8,
+        "Palettized filters are only supported for int8 inputs.");
+  }
+
+  data->buffer_idx = -1;
+  data->tuning_slot = -1;
+  // With the DSP extension, arm_convolve_wrapper_s16 picks a kernel that
+  // does two 16-bit multiply-adds per instruction for short filters, which
+  // the 64-bit accumulations of the int16 Winograd kernel do not beat.
+  bool use_cmsis_fast_s16 = false;
+#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_MVEI)
+  use_cmsis_fast_s16 = filter_dims.w * filter_dims.h * filter_dims.c < 512;
+#endif
+  if (input->type == kTfLiteFloat32 ||
+      (input->type == kTfLiteInt16 && !use_cmsis_fast_s16)) {
+    TF_LITE_ENSURE_STATUS(winograd::PrepareConv(
+        context, params, input, filter, output, &data->reference_op_data));
+  }
+
+  if ((input->type == kTfLiteInt8 || input->type == kTfLiteInt16) &&
+      data->reference_op_data.winograd_filter == nullptr && !is_sparse &&
+      !is_palettized) {
     // Initialize cmsis_nn convolution parameters
     cmsis_nn_conv_params conv_params;
     conv_params.input_offset = -input->params.zero_point;
@@ -130,9 +255,18 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     if (input->type == kTfLiteInt8) {
       buf_size = arm_convolve_wrapper_s8_get_buffer_size(
           &conv_params, &input_dims, &filter_dims, &output_dims);
+#if defined(TF_LITE_MICRO_X86_INT8_ENABLED)
+      buf_size = std::max<int32_t>(
+          buf_size,
+          x86_int8::ConvPerChannelScratchSize(GetTensorShape(filter)));
+#endif
+      if (micro_context->kernel_tuner() != nullptr) {
+        buf_size = std::max(
+            buf_size,
+            PrepareTuning(micro_context->kernel_tuner(), conv_params,
+                          input_dims, filter_dims, output_dims, data));
+      }
     } else if (input->type == kTfLiteInt16) {
-      TF_LITE_ENSURE_EQ(context, input->params.zero_point, 0);
-      TF_LITE_ENSURE_EQ(context, output->params.zero_point, 0);
       buf_size = arm_convolve_wrapper_s16_get_buffer_size(
           &conv_params, &input_dims, &filter_dims, &output_dims);
     }
@@ -152,6 +286,10 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   return kTfLiteOk;
 }
 
+void Free(TfLiteContext* context, void* buffer) {
+  winograd::FreeConv(context);
+}
+
 TfLiteStatus EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
                                      const TfLiteConvParams& params,
                                      const OpData& data,
@@ -159,6 +297,81 @@ TfLiteStatus EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
                                      const TfLiteEvalTensor* filter,
                                      const TfLiteEvalTensor* bias,
                                      TfLiteEvalTensor* output) {
+  if (data.sparse_weights.block_row_starts != nullptr) {
+    const RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
+    const RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
+    const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+    const int input_height = input_shape.Dims(1);
+    const int input_width = input_shape.Dims(2);
+    const int input_depth = input_shape.Dims(3);
+    const int output_height = output_shape.Dims(1);
+    const int output_width = output_shape.Dims(2);
+    const int output_depth = output_shape.Dims(3);
+    const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+    int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+    for (int b = 0; b < batches; ++b) {
+      for (int y = 0; y < output_height; ++y) {
+        for (int x = 0; x < output_width; ++x) {
+          const int in_y = y * params.stride_height;
+          const int in_x = x * params.stride_width;
+          BlockSparseMatVec(
+              data.sparse_weights, tflite::micro::GetTensorData<int8_t>(filter),
+              input_data +
+                  ((b * input_height + in_y) * input_width + in_x) *
+                      input_depth,
+              tflite::micro::GetOptionalTensorData<int32_t>(bias),
+              data.reference_op_data.per_channel_output_multiplier,
+              data.reference_op_data.per_channel_output_shift,
+              data.reference_op_data.output_zero_point,
+              data.reference_op_data.output_activation_min,
+              data.reference_op_data.output_activation_max,
+              output_data +
+                  ((b * output_height + y) * output_width + x) * output_depth);
+        }
+      }
+    }
+    return kTfLiteOk;
+  }
+
+  if (data.palettized_weights.palette != nullptr) {
+    palette::ConvPerChannel(
+        ConvParamsQuantized(params, data.reference_op_data),
+        data.reference_op_data.per_channel_output_multiplier,
+        data.reference_op_data.per_channel_output_shift,
+        data.palettized_weights, tflite::micro::GetTensorShape(input),
+        tflite::micro::GetTensorData<int8_t>(input),
+        tflite::micro::GetTensorShape(filter),
+        tflite::micro::GetTensorData<uint8_t>(filter),
+        tflite::micro::GetOptionalTensorData<int32_t>(bias),
+        tflite::micro::GetTensorShape(output),
+        tflite::micro::GetTensorData<int8_t>(output),
+        static_cast<int8_t*>(context->GetScratchBuffer(
+            context, data.palettized_weights.scratch_index)));
+    return kTfLiteOk;
+  }
+
+#if defined(TF_LITE_MICRO_X86_INT8_ENABLED)
+  int8_t* scratch =
+      data.buffer_idx > -1
+          ? static_cast<int8_t*>(
+                context->GetScratchBuffer(context, data.buffer_idx))
+          : nullptr;
+  if (x86_int8::ConvPerChannel(
+          ConvParamsQuantized(params, data.reference_op_data),
+          data.reference_op_data.per_channel_output_multiplier,
+          data.reference_op_data.per_channel_output_shift,
+          tflite::micro::GetTensorShape(input),
+          tflite::micro::GetTensorData<int8_t>(input),
+          tflite::micro::GetTensorShape(filter),
+          tflite::micro::GetTensorData<int8_t>(filter),
+          tflite::micro::GetTensorShape(bias),
+          tflite::micro::GetOptionalTensorData<int32_t>(bias),
+          tflite::micro::GetTensorShape(output),
+          tflite::micro::GetTensorData<int8_t>(output), scratch)) {
+    return kTfLiteOk;
+  }
+#endif
+
   cmsis_nn_conv_params conv_params;
   conv_params.dilation.h = params.dilation_height_factor;
   conv_params.dilation.w = params.dilation_width_factor;
@@ -238,6 +451,68 @@ TfLiteStatus EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
     // arm_convolve_wrapper_s8_get_buffer_size
   }
 
+  if (data.tuning_slot >= 0) {
+    auto run = [&](ConvKernel kernel) {
+      const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+      const int8_t* filter_data = tflite::micro::GetTensorData<int8_t>(filter);
+      const int32_t* bias_data =
+          tflite::micro::GetOptionalTensorData<int32_t>(bias);
+      int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+      switch (kernel) {
+        case kConvKernel1x1Fast:
+          return arm_convolve_1x1_s8_fast(
+              &ctx, &conv_params, &quant_params, &input_dims, input_data,
+              &filter_dims, filter_data, &bias_dims, bias_data, &output_dims,
+              output_data);
+        case kConvKernel1xN:
+          return arm_convolve_1_x_n_s8(&ctx, &conv_params, &quant_params,
+                                       &input_dims, input_data, &filter_dims,
+                                       filter_data, &bias_dims, bias_data,
+                                       &output_dims, output_data);
+        case kConvKernelGeneric:
+          return arm_convolve_s8(&ctx, &conv_params, &quant_params,
+                                 &input_dims, input_data, &filter_dims,
+                                 filter_data, &bias_dims, bias_data,
+                                 &output_dims, output_data);
+        default:
+          reference_integer_ops::ConvPerChannel(
+              ConvParamsQuantized(params, data.reference_op_data),
+              data.reference_op_data.per_channel_output_multiplier,
+              data.reference_op_data.per_channel_output_shift, input_shape,
+              input_data, filter_shape, filter_data, bias_shape, bias_data,
+              output_shape, output_data);
+          return ARM_CMSIS_NN_SUCCESS;
+      }
+    };
+
+    MicroKernelTuner* tuner = GetMicroContext(context)->kernel_tuner();
+    const int choice = tuner->GetChoice(data.tuning_slot);
+    for (int i = 0; i < data.num_candidates; ++i) {
+      if (data.candidates[i] == choice) {
+        TFLITE_DCHECK_EQ(run(data.candidates[i]), ARM_CMSIS_NN_SUCCESS);
+        return kTfLiteOk;
+      }
+    }
+
+    // Not tuned yet, or the recorded choice does not support this node: time
+    // every candidate once. They are bit-exact with each other, so the output
+    // of the last run is the result.
+    ConvKernel fastest = data.candidates[0];
+    uint32_t fastest_ticks = 0;
+    for (int i = 0; i < data.num_candidates; ++i) {
+      const uint32_t start_ticks = GetCurrentTimeTicks();
+      TFLITE_DCHECK_EQ(run(data.candidates[i]), ARM_CMSIS_NN_SUCCESS);
+      const uint32_t ticks = GetCurrentTimeTicks() - start_ticks;
+      // Ties keep the earlier candidate, i.e. the wrapper's choice.
+      if (i == 0 || ticks < fastest_ticks) {
+        fastest = data.candidates[i];
+        fastest_ticks = ticks;
+      }
+    }
+    tuner->SetChoice(data.tuning_slot, fastest);
+    return kTfLiteOk;
+  }
+
   // arm_convolve_wrapper_s8 dispatches the optimized kernel accordingly with
   // the parameters passed
   TFLITE_DCHECK_EQ(
@@ -257,6 +532,23 @@ TfLiteStatus EvalQuantizedPerChannel16x8(
     const OpData& data, const TfLiteEvalTensor* input,
     const TfLiteEvalTensor* filter, const TfLiteEvalTensor* bias,
     TfLiteEvalTensor* output) {
+  if (data.reference_op_data.winograd_filter != nullptr) {
+    winograd::ConvPerChannel(
+        ConvParamsQuantized(params, data.reference_op_data),
+        data.reference_op_data.per_channel_output_multiplier,
+        data.reference_op_data.per_channel_output_shift,
+        tflite::micro::GetTensorShape(input),
+        tflite::micro::GetTensorData<int16_t>(input),
+        tflite::micro::GetTensorShape(filter),
+        static_cast<const int16_t*>(data.reference_op_data.winograd_filter),
+        tflite::micro::GetOptionalTensorData<int64_t>(bias),
+        tflite::micro::GetTensorShape(output),
+        tflite::micro::GetTensorData<int16_t>(output),
+        static_cast<int64_t*>(context->GetScratchBuffer(
+            context, data.reference_op_data.winograd_scratch_index)));
+    return kTfLiteOk;
+  }
+
   cmsis_nn_conv_params conv_params;
   conv_params.dilation.h = params.dilation_height_factor;
   conv_params.dilation.w = params.dilation_width_factor;
@@ -425,7 +717,21 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 
   switch (input->type) {  // Already know in/out types are same.
     case kTfLiteFloat32: {
-      tflite::reference_ops::Conv(
+      if (data.reference_op_data.winograd_filter != nullptr) {
+        winograd::Conv(
+            ConvParamsFloat(params, data.reference_op_data),
+            tflite::micro::GetTensorShape(input),
+            tflite::micro::GetTensorData<float>(input),
+            tflite::micro::GetTensorShape(filter),
+            static_cast<const float*>(data.reference_op_data.winograd_filter),
+            tflite::micro::GetOptionalTensorData<float>(bias),
+            tflite::micro::GetTensorShape(output),
+            tflite::micro::GetTensorData<float>(output),
+            static_cast<float*>(context->GetScratchBuffer(
+                context, data.reference_op_data.winograd_scratch_index)));
+        break;
+      }
+      tflite::simd_float::Conv(
           ConvParamsFloat(params, data.reference_op_data),
           tflite::micro::GetTensorShape(input),
           tflite::micro::GetTensorData<float>(input),
@@ -434,8 +740,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           tflite::micro::GetTensorShape(bias),
           tflite::micro::GetOptionalTensorData<float>(bias),
           tflite::micro::GetTensorShape(output),
-          tflite::micro::GetTensorData<float>(output),
-          tflite::micro::GetTensorShape(nullptr), nullptr);
+          tflite::micro::GetTensorData<float>(output));
       break;
     }
     case kTfLiteInt8:
@@ -468,15 +773,15 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 }  // namespace
 
 TfLiteRegistration Register_CONV_2D() {
-  return tflite::micro::RegisterOp(Init, Prepare, Eval);
+  return tflite::micro::RegisterOp(Init, Prepare, Eval, Free);
 }
 
 TfLiteRegistration Register_CONV_2D_INT8() {
-  return tflite::micro::RegisterOp(Init, Prepare, EvalInt8);
+  return tflite::micro::RegisterOp(Init, Prepare, EvalInt8, Free);
 }
 
 TfLiteRegistration Register_CONV_2D_INT16() {
-  return tflite::micro::RegisterOp(Init, Prepare, EvalInt16x8);
+  return tflite::micro::RegisterOp(Init, Prepare, EvalInt16x8, Free);
 }
 
 }  // namespace tflite
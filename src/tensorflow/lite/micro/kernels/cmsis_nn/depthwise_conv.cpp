@@ -25,8 +25,11 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/kernels/cmsis_nn/palettized_weights.h"
 #include "tensorflow/lite/micro/kernels/conv.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/simd_float.h"
+#include "tensorflow/lite/micro/kernels/x86_int8.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
 namespace tflite {
@@ -37,6 +40,9 @@ struct OpData {
 
   // Index to buffer for optimizations if applicable.
   int buffer_idx;
+
+  // Codebook and tiling of palettized filters.
+  palette::PalettizedWeights palettized_weights;
 };
 
 // Always inline for optimal code size.
@@ -83,6 +89,7 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   int output_width = SizeOfDimension(output, 2);
   int output_height = SizeOfDimension(output, 1);
 
+  data->reference_op_data.per_channel_output_precomputed = false;
   if (input->type == kTfLiteInt8 || input->type == kTfLiteInt16) {
     TF_LITE_ENSURE_EQ(context, filter->quantization.type,
                       kTfLiteAffineQuantization);
@@ -106,16 +113,16 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     TF_LITE_ENSURE_EQ(context, affine_quantization->scale->size,
                       affine_quantization->zero_point->size);
 
-    // Allocate memory for per-channel quantization parameters
+    // Allocate memory for per-channel quantization parameters unless they
+    // were precomputed.
     const int num_channels =
         filter->dims->data[kDepthwiseConvQuantizedDimension];
 
-    data->reference_op_data.per_channel_output_multiplier =
-        reinterpret_cast<int32_t*>(context->AllocatePersistentBuffer(
-            context, num_channels * sizeof(int32_t)));
-    data->reference_op_data.per_channel_output_shift =
-        reinterpret_cast<int32_t*>(context->AllocatePersistentBuffer(
-            context, num_channels * sizeof(int32_t)));
+    TF_LITE_ENSURE_STATUS(micro::AllocatePerChannelOutputMultipliers(
+        context, node, num_channels,
+        &data->reference_op_data.per_channel_output_multiplier,
+        &data->reference_op_data.per_channel_output_shift,
+        &data->reference_op_data.per_channel_output_precomputed));
   }
 
   if (filter->type == kTfLiteInt4) {
@@ -132,7 +139,17 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       filter_height, output_width, output_height, data_type,
       &data->reference_op_data));
 
-  if (input->type == kTfLiteInt8) {
+  TF_LITE_ENSURE_STATUS(palette::PrepareDepthwiseConv(
+      context, node, kDepthwiseConvWeightsTensor, filter,
+      &data->palettized_weights));
+  const bool is_palettized = data->palettized_weights.palette != nullptr;
+  if (is_palettized) {
+    TF_LITE_ENSURE_MSG(
+        context, input->type == kTfLiteInt8,
+        "Palettized filters are only supported for int8 inputs.");
+  }
+
+  if (input->type == kTfLiteInt8 && !is_palettized) {
     RuntimeShape input_shape = GetTensorShape(input);
     RuntimeShape output_shape = GetTensorShape(output);
     RuntimeShape filter_shape = GetTensorShape(filter);
@@ -167,6 +184,7 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     dw_conv_params.padding.w = data->reference_op_data.padding.width;
     dw_conv_params.dilation.h = params.dilation_height_factor;
     dw_conv_params.dilation.w = params.dilation_width_factor;
+    dw_conv_params.ch_mult = params.depth_multiplier;
 
     const int32_t buf_size = arm_depthwise_conv_wrapper_s8_get_buffer_size(
         &dw_conv_params, &input_dims, &filter_dims, &output_dims);
@@ -255,6 +273,40 @@ void EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
                              const TfLiteEvalTensor* filter,
                              const TfLiteEvalTensor* bias,
                              TfLiteEvalTensor* output) {
+  if (data.palettized_weights.palette != nullptr) {
+    palette::DepthwiseConvPerChannel(
+        DepthwiseConvParamsQuantized(params, data.reference_op_data),
+        data.reference_op_data.per_channel_output_multiplier,
+        data.reference_op_data.per_channel_output_shift,
+        data.palettized_weights, tflite::micro::GetTensorShape(input),
+        tflite::micro::GetTensorData<int8_t>(input),
+        tflite::micro::GetTensorShape(filter),
+        tflite::micro::GetTensorData<uint8_t>(filter),
+        tflite::micro::GetOptionalTensorData<int32_t>(bias),
+        tflite::micro::GetTensorShape(output),
+        tflite::micro::GetTensorData<int8_t>(output),
+        static_cast<int8_t*>(context->GetScratchBuffer(
+            context, data.palettized_weights.scratch_index)));
+    return;
+  }
+
+#if defined(TF_LITE_MICRO_X86_INT8_ENABLED)
+  if (x86_int8::DepthwiseConvPerChannel(
+          DepthwiseConvParamsQuantized(params, data.reference_op_data),
+          data.reference_op_data.per_channel_output_multiplier,
+          data.reference_op_data.per_channel_output_shift,
+          tflite::micro::GetTensorShape(input),
+          tflite::micro::GetTensorData<int8_t>(input),
+          tflite::micro::GetTensorShape(filter),
+          tflite::micro::GetTensorData<int8_t>(filter),
+          tflite::micro::GetTensorShape(bias),
+          tflite::micro::GetOptionalTensorData<int32_t>(bias),
+          tflite::micro::GetTensorShape(output),
+          tflite::micro::GetTensorData<int8_t>(output))) {
+    return;
+  }
+#endif
+
   cmsis_nn_dw_conv_params dw_conv_params;
   cmsis_nn_per_channel_quant_params quant_params;
   cmsis_nn_dims input_dims;
@@ -342,7 +394,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 
   switch (input->type) {  // Already know in/out types are same.
     case kTfLiteFloat32: {
-      tflite::reference_ops::DepthwiseConv(
+      tflite::simd_float::DepthwiseConv(
           DepthwiseConvParamsFloat(params, data.reference_op_data),
           tflite::micro::GetTensorShape(input),
           tflite::micro::GetTensorData<float>(input),
@@ -0,0 +1,128 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_CMSIS_NN_DSP_EMULATION_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_CMSIS_NN_DSP_EMULATION_H_
+
+// Portable C implementations of the Armv7E-M DSP extension intrinsics used by
+// CMSIS-NN. They let the ARM_MATH_DSP code paths of the CMSIS-NN kernels build
+// and run on a host so that they can be compared against the reference
+// kernels without a board. Every function matches the architectural result of
+// the instruction bit for bit; the Q flag is not modelled since CMSIS-NN never
+// reads it.
+//
+// This header is pulled in by arm_nn_math_types.h when
+// TF_LITE_MICRO_CMSIS_NN_EMULATE_DSP is defined on a target without
+// __ARM_FEATURE_DSP. It is C, as it is also included by the CMSIS-NN sources.
+//
+// The MVE (Helium) paths are not covered: besides the intrinsics they contain
+// inline assembly that cannot be replaced from a header.
+
+#include <stdint.h>
+
+#ifndef ARM_MATH_DSP
+#define ARM_MATH_DSP 1
+#endif
+
+__STATIC_FORCEINLINE int32_t __tflm_dsp_sat(int64_t value, int32_t min,
+                                            int32_t max) {
+  return value < min ? min : (value > max ? max : (int32_t)value);
+}
+
+__STATIC_FORCEINLINE int32_t __tflm_dsp_lo16(uint32_t value) {
+  return (int16_t)(value & 0xFFFFU);
+}
+
+__STATIC_FORCEINLINE int32_t __tflm_dsp_hi16(uint32_t value) {
+  return (int16_t)(value >> 16);
+}
+
+__STATIC_FORCEINLINE uint32_t __tflm_dsp_pack16(int32_t lo, int32_t hi) {
+  return ((uint32_t)lo & 0xFFFFU) | ((uint32_t)hi << 16);
+}
+
+__STATIC_FORCEINLINE int32_t __QADD(int32_t op1, int32_t op2) {
+  return __tflm_dsp_sat((int64_t)op1 + op2, INT32_MIN, INT32_MAX);
+}
+
+__STATIC_FORCEINLINE uint32_t __SADD16(uint32_t op1, uint32_t op2) {
+  return __tflm_dsp_pack16(__tflm_dsp_lo16(op1) + __tflm_dsp_lo16(op2),
+                           __tflm_dsp_hi16(op1) + __tflm_dsp_hi16(op2));
+}
+
+__STATIC_FORCEINLINE uint32_t __QADD16(uint32_t op1, uint32_t op2) {
+  return __tflm_dsp_pack16(
+      __tflm_dsp_sat(__tflm_dsp_lo16(op1) + __tflm_dsp_lo16(op2), INT16_MIN,
+                     INT16_MAX),
+      __tflm_dsp_sat(__tflm_dsp_hi16(op1) + __tflm_dsp_hi16(op2), INT16_MIN,
+                     INT16_MAX));
+}
+
+__STATIC_FORCEINLINE uint32_t __QSUB16(uint32_t op1, uint32_t op2) {
+  return __tflm_dsp_pack16(
+      __tflm_dsp_sat(__tflm_dsp_lo16(op1) - __tflm_dsp_lo16(op2), INT16_MIN,
+                     INT16_MAX),
+      __tflm_dsp_sat(__tflm_dsp_hi16(op1) - __tflm_dsp_hi16(op2), INT16_MIN,
+                     INT16_MAX));
+}
+
+__STATIC_FORCEINLINE uint32_t __QSUB8(uint32_t op1, uint32_t op2) {
+  uint32_t result = 0;
+  for (int shift = 0; shift < 32; shift += 8) {
+    const int32_t diff = (int8_t)(op1 >> shift) - (int8_t)(op2 >> shift);
+    result |= ((uint32_t)__tflm_dsp_sat(diff, INT8_MIN, INT8_MAX) & 0xFFU)
+              << shift;
+  }
+  return result;
+}
+
+__STATIC_FORCEINLINE uint32_t __SMLAD(uint32_t op1, uint32_t op2,
+                                      uint32_t op3) {
+  // The accumulation wraps modulo 2^32 like the instruction does.
+  return op3 +
+         (uint32_t)(__tflm_dsp_lo16(op1) * __tflm_dsp_lo16(op2)) +
+         (uint32_t)(__tflm_dsp_hi16(op1) * __tflm_dsp_hi16(op2));
+}
+
+__STATIC_FORCEINLINE uint32_t __SXTB16(uint32_t op1) {
+  return __tflm_dsp_pack16((int8_t)op1, (int8_t)(op1 >> 16));
+}
+
+__STATIC_FORCEINLINE uint32_t __SXTB16_RORn(uint32_t op1, uint32_t rotate) {
+  return __SXTB16(__ROR(op1, rotate));
+}
+
+__STATIC_FORCEINLINE uint32_t __SXTAB16(uint32_t op1, uint32_t op2) {
+  return __tflm_dsp_pack16(__tflm_dsp_lo16(op1) + (int8_t)op2,
+                           __tflm_dsp_hi16(op1) + (int8_t)(op2 >> 16));
+}
+
+__STATIC_FORCEINLINE uint32_t __SXTAB16_RORn(uint32_t op1, uint32_t op2,
+                                             uint32_t rotate) {
+  return __SXTAB16(op1, __ROR(op2, rotate));
+}
+
+// PKHTB with a zero shift amount is encoded as PKHBT with swapped operands,
+// which takes the bottom half of op2 unshifted.
+#define __PKHBT(ARG1, ARG2, ARG3)                \
+  ((((uint32_t)(ARG1)) & 0x0000FFFFUL) |         \
+   ((((uint32_t)(ARG2)) << (ARG3)) & 0xFFFF0000UL))
+
+#define __PKHTB(ARG1, ARG2, ARG3)                               \
+  ((((uint32_t)(ARG1)) & 0xFFFF0000UL) |                        \
+   (((ARG3) == 0 ? (uint32_t)(ARG2)                             \
+                 : (uint32_t)(((int32_t)(ARG2)) >> (ARG3))) &   \
+    0x0000FFFFUL))
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_CMSIS_NN_DSP_EMULATION_H_
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/lite/micro/kernels/fully_connected.h"
 
 #include "third_party/cmsis_nn/Include/arm_nnfunctions.h"
+#include "third_party/cmsis_nn/Include/arm_nnsupportfunctions.h"
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/common.h"
@@ -25,7 +26,11 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/block_sparse.h"
+#include "tensorflow/lite/micro/kernels/cmsis_nn/palettized_weights.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/simd_float.h"
+#include "tensorflow/lite/micro/kernels/x86_int8.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
 namespace tflite {
@@ -45,8 +50,65 @@ struct OpData {
   int32_t batches;
   int32_t accum_depth;
   int32_t output_depth;
+
+  // Int8 kernel selection made in Prepare. Both matrix-matrix kernels reuse
+  // each weight row across several batches instead of streaming the whole
+  // filter once per batch.
+  bool use_conv_1x1;
+  bool use_mat_mult;
+
+  // Bias with the input zero point folded in, i.e.
+  // bias[o] - input_zero_point * sum(filter[o][:]). Computed in Prepare for
+  // constant int8 filters so that Eval can run with a zero input offset, see
+  // CalculateEffectiveBias(); nullptr if not applicable.
+  int32_t* effective_bias;
+
+  // Index of the non-zero blocks of sparse int8 weights. Eval skips the zero
+  // blocks entirely.
+  BlockSparseWeights sparse_weights;
+
+  // Codebook and tiling of palettized weights.
+  palette::PalettizedWeights palettized_weights;
 };
 
+// Folds the input zero point of an int8 fully connected layer into its bias.
+// Only the MVE loops of arm_nn_vec_mat_mult_t_s8 skip work for a zero input
+// offset, the DSP and pure C loops add it per element anyway, so elsewhere
+// the bias is only folded with TF_LITE_MICRO_FOLD_INPUT_OFFSET and otherwise
+// costs output_depth * 4 bytes of persistent arena for nothing.
+TfLiteStatus CalculateEffectiveBias(TfLiteContext* context,
+                                    const TfLiteTensor* filter,
+                                    const TfLiteTensor* bias, OpData* data) {
+  data->effective_bias = nullptr;
+#if defined(ARM_MATH_MVEI) || defined(TF_LITE_MICRO_FOLD_INPUT_OFFSET)
+  const int32_t input_offset = -data->reference_op_data.input_zero_point;
+  if (input_offset == 0 || filter->type != kTfLiteInt8 ||
+      !IsConstantTensor(filter) ||
+      (bias != nullptr && !IsConstantTensor(bias))) {
+    return kTfLiteOk;
+  }
+
+  data->effective_bias =
+      static_cast<int32_t*>(context->AllocatePersistentBuffer(
+          context, data->output_depth * sizeof(int32_t)));
+  TF_LITE_ENSURE(context, data->effective_bias != nullptr);
+
+  const int8_t* filter_data = GetTensorData<int8_t>(filter);
+  const int32_t* bias_data =
+      bias != nullptr ? GetTensorData<int32_t>(bias) : nullptr;
+  for (int out_c = 0; out_c < data->output_depth; ++out_c) {
+    int32_t filter_sum = 0;
+    for (int d = 0; d < data->accum_depth; ++d) {
+      filter_sum += filter_data[out_c * data->accum_depth + d];
+    }
+    data->effective_bias[out_c] =
+        (bias_data != nullptr ? bias_data[out_c] : 0) +
+        filter_sum * input_offset;
+  }
+#endif
+  return kTfLiteOk;
+}
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
   return context->AllocatePersistentBuffer(context, sizeof(OpData));
@@ -97,6 +159,27 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 
   int32_t buf_size = 0;
 
+  TF_LITE_ENSURE_STATUS(BlockSparseWeightsInit(
+      context, node, kFullyConnectedWeightsTensor, filter, data->output_depth,
+      data->accum_depth, -data->reference_op_data.input_zero_point,
+      &data->sparse_weights));
+  const bool is_sparse = data->sparse_weights.block_row_starts != nullptr;
+  if (is_sparse) {
+    TF_LITE_ENSURE_MSG(context, input->type == kTfLiteInt8,
+                       "Sparse weights are only supported for int8 inputs.");
+  }
+  TF_LITE_ENSURE_STATUS(palette::PrepareFullyConnected(
+      context, node, kFullyConnectedWeightsTensor, filter,
+      &data->palettized_weights));
+  const bool is_palettized = data->palettized_weights.palette != nullptr;
+  if (is_palettized) {
+    TF_LITE_ENSURE_MSG(
+        context, input->type == kTfLiteInt8,
+        "Palettized weights are only supported for int8 inputs.");
+  }
+  // Sparse and palettized weights have kernels of their own.
+  const bool is_dense = !is_sparse && !is_palettized;
+
   if (input->type == kTfLiteInt16) {
     TF_LITE_ENSURE_EQ(context, input->params.zero_point, 0);
     TF_LITE_ENSURE_EQ(context, output->params.zero_point, 0);
@@ -104,17 +187,41 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   } else if (input->type == kTfLiteInt8) {
     const RuntimeShape input_shape = GetTensorShape(input);
 
+    // The sparse and palettized kernels add the input zero point on their
+    // own.
+    if (is_dense) {
+      TF_LITE_ENSURE_STATUS(
+          CalculateEffectiveBias(context, filter, bias, data));
+    } else {
+      data->effective_bias = nullptr;
+    }
+
     TFLITE_DCHECK_GE(output_dim_count, 2);
     TFLITE_DCHECK_LE(output_dim_count, 4);
 
-    if (output_dim_count > 2 && data->accum_depth % 4 == 0) {
-      data->per_channel_output_multiplier =
-          static_cast<int32_t*>(context->AllocatePersistentBuffer(
-              context, data->output_depth * sizeof(int32_t)));
-      data->per_channel_output_shift =
-          static_cast<int32_t*>(context->AllocatePersistentBuffer(
-              context, data->output_depth * sizeof(int32_t)));
+    data->use_conv_1x1 = is_dense &&
+                         (output_dim_count > 2 || data->batches > 1) &&
+                         data->accum_depth % 4 == 0;
+    data->use_mat_mult =
+        is_dense && !data->use_conv_1x1 && data->batches > 1;
+
+    if (data->use_conv_1x1 || data->use_mat_mult || is_sparse) {
+      bool precomputed;
+      TF_LITE_ENSURE_STATUS(micro::AllocatePerChannelOutputMultipliers(
+          context, node, data->output_depth,
+          &data->per_channel_output_multiplier,
+          &data->per_channel_output_shift, &precomputed));
+      if (!precomputed) {
+        for (int i = 0; i < data->output_depth; i++) {
+          data->per_channel_output_multiplier[i] =
+              data->reference_op_data.output_multiplier;
+          data->per_channel_output_shift[i] =
+              data->reference_op_data.output_shift;
+        }
+      }
+    }
 
+    if (data->use_conv_1x1) {
       cmsis_nn_dims input_dims;
       input_dims.n = data->batches;
       input_dims.h = 1;
@@ -122,7 +229,7 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       input_dims.c = data->accum_depth;
 
       buf_size = arm_convolve_1x1_s8_fast_get_buffer_size(&input_dims);
-    } else {
+    } else if (!data->use_mat_mult && is_dense) {
       buf_size = arm_fully_connected_s8_get_buffer_size(&filter_dims);
     }
   }
@@ -199,6 +306,64 @@ TfLiteStatus EvalQuantizedInt8(TfLiteContext* context, TfLiteNode* node,
   TFLITE_DCHECK_GE(output_dim_count, 2);
   TFLITE_DCHECK_LE(output_dim_count, 4);
 
+  if (data.sparse_weights.block_row_starts != nullptr) {
+    const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+    int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+    for (int b = 0; b < data.batches; ++b) {
+      BlockSparseMatVec(data.sparse_weights,
+                        tflite::micro::GetTensorData<int8_t>(filter),
+                        input_data + b * data.accum_depth,
+                        tflite::micro::GetOptionalTensorData<int32_t>(bias),
+                        data.per_channel_output_multiplier,
+                        data.per_channel_output_shift,
+                        data.reference_op_data.output_zero_point,
+                        data.reference_op_data.output_activation_min,
+                        data.reference_op_data.output_activation_max,
+                        output_data + b * data.output_depth);
+    }
+    return kTfLiteOk;
+  }
+
+  if (data.palettized_weights.palette != nullptr) {
+    palette::FullyConnected(
+        FullyConnectedParamsQuantized(data.reference_op_data),
+        data.palettized_weights, tflite::micro::GetTensorShape(input),
+        tflite::micro::GetTensorData<int8_t>(input),
+        tflite::micro::GetTensorShape(filter),
+        tflite::micro::GetTensorData<uint8_t>(filter),
+        tflite::micro::GetOptionalTensorData<int32_t>(bias),
+        tflite::micro::GetTensorShape(output),
+        tflite::micro::GetTensorData<int8_t>(output),
+        static_cast<int8_t*>(context->GetScratchBuffer(
+            context, data.palettized_weights.scratch_index)));
+    return kTfLiteOk;
+  }
+
+  // With the input zero point folded into the bias the kernels can skip the
+  // input offset.
+  const int32_t* bias_data =
+      tflite::micro::GetOptionalTensorData<int32_t>(bias);
+  int32_t input_offset = -data.reference_op_data.input_zero_point;
+  if (data.effective_bias != nullptr) {
+    bias_data = data.effective_bias;
+    input_offset = 0;
+  }
+
+#if defined(TF_LITE_MICRO_X86_INT8_ENABLED)
+  FullyConnectedParams x86_params =
+      FullyConnectedParamsQuantized(data.reference_op_data);
+  x86_params.input_offset = input_offset;
+  if (x86_int8::FullyConnected(
+          x86_params, tflite::micro::GetTensorShape(input),
+          tflite::micro::GetTensorData<int8_t>(input),
+          tflite::micro::GetTensorShape(filter),
+          tflite::micro::GetTensorData<int8_t>(filter),
+          RuntimeShape({data.output_depth}), bias_data, output_shape,
+          tflite::micro::GetTensorData<int8_t>(output))) {
+    return kTfLiteOk;
+  }
+#endif
+
   cmsis_nn_per_tensor_quant_params quant_params;
   cmsis_nn_dims input_dims;
   cmsis_nn_dims filter_dims;
@@ -209,14 +374,11 @@ TfLiteStatus EvalQuantizedInt8(TfLiteContext* context, TfLiteNode* node,
   PopulateCommonParams(context, &quant_params, &input_dims, &filter_dims,
                        &bias_dims, &output_dims, &ctx, data);
 
-  const int32_t* bias_data =
-      tflite::micro::GetOptionalTensorData<int32_t>(bias);
-
-  if (output_dim_count > 2 && data.accum_depth % 4 == 0) {
+  if (data.use_conv_1x1) {
     cmsis_nn_conv_params conv_params;
     conv_params.dilation.h = 1;
     conv_params.dilation.w = 1;
-    conv_params.input_offset = -data.reference_op_data.input_zero_point;
+    conv_params.input_offset = input_offset;
     conv_params.output_offset = data.reference_op_data.output_zero_point;
     conv_params.stride.h = 1;
     conv_params.stride.w = 1;
@@ -231,11 +393,6 @@ TfLiteStatus EvalQuantizedInt8(TfLiteContext* context, TfLiteNode* node,
     per_channel_quant_params.shift =
         const_cast<int32_t*>(data.per_channel_output_shift);
 
-    for (int i = 0; i < data.output_depth; i++) {
-      per_channel_quant_params.multiplier[i] = quant_params.multiplier;
-      per_channel_quant_params.shift[i] = quant_params.shift;
-    }
-
     TF_LITE_ENSURE_EQ(
         context,
         arm_convolve_1x1_s8_fast(
@@ -244,9 +401,22 @@ TfLiteStatus EvalQuantizedInt8(TfLiteContext* context, TfLiteNode* node,
             tflite::micro::GetTensorData<int8_t>(filter), &bias_dims, bias_data,
             &output_dims, tflite::micro::GetTensorData<int8_t>(output)),
         ARM_CMSIS_NN_SUCCESS);
+  } else if (data.use_mat_mult) {
+    TF_LITE_ENSURE_EQ(
+        context,
+        arm_nn_mat_mult_nt_t_s8(
+            tflite::micro::GetTensorData<int8_t>(input),
+            tflite::micro::GetTensorData<int8_t>(filter), bias_data,
+            tflite::micro::GetTensorData<int8_t>(output),
+            data.per_channel_output_multiplier, data.per_channel_output_shift,
+            data.batches, data.output_depth, data.accum_depth, input_offset,
+            data.reference_op_data.output_zero_point,
+            data.reference_op_data.output_activation_min,
+            data.reference_op_data.output_activation_max),
+        ARM_CMSIS_NN_SUCCESS);
   } else {
     cmsis_nn_fc_params fc_params;
-    fc_params.input_offset = -data.reference_op_data.input_zero_point;
+    fc_params.input_offset = input_offset;
     fc_params.output_offset = data.reference_op_data.output_zero_point;
     fc_params.filter_offset = 0;
     fc_params.activation.min = data.reference_op_data.output_activation_min;
@@ -327,7 +497,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
     case kTfLiteFloat32: {
       const float* bias_data =
           tflite::micro::GetOptionalTensorData<float>(bias);
-      tflite::reference_ops::FullyConnected(
+      tflite::simd_float::FullyConnected(
           FullyConnectedParamsFloat(params->activation),
           tflite::micro::GetTensorShape(input),
           tflite::micro::GetTensorData<float>(input),
@@ -21,17 +21,90 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/reference/process_broadcast_shapes.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/cmsis_nn/broadcast_fivefold.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/kernels/mul.h"
+#include "tensorflow/lite/micro/kernels/x86_int8.h"
 #include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
 namespace tflite {
 namespace {
 
+struct OpData {
+  OpDataMul reference_op_data;
+
+  // Broadcast pattern of the inputs, classified in Prepare.
+  BroadcastableOpCategory broadcast_category;
+  int broadcast_shape[5];
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
+}
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+  auto* params = reinterpret_cast<TfLiteMulParams*>(node->builtin_data);
+
+  TFLITE_DCHECK(node->user_data != nullptr);
+  OpData* data = static_cast<OpData*>(node->user_data);
+
+  TF_LITE_ENSURE_STATUS(
+      CalculateOpDataMul(context, node, params, &data->reference_op_data));
+
+  MicroContext* micro_context = GetMicroContext(context);
+  TfLiteTensor* input1 =
+      micro_context->AllocateTempInputTensor(node, kMulInput1Tensor);
+  TF_LITE_ENSURE(context, input1 != nullptr);
+  TfLiteTensor* input2 =
+      micro_context->AllocateTempInputTensor(node, kMulInput2Tensor);
+  TF_LITE_ENSURE(context, input2 != nullptr);
+
+  tflite::ArithmeticParams broadcast_params;
+  reference_ops::ProcessBroadcastShapes(
+      GetTensorShape(input1), GetTensorShape(input2), &broadcast_params);
+  data->broadcast_category = broadcast_params.broadcast_category;
+  std::copy_n(broadcast_params.broadcast_shape, 5, data->broadcast_shape);
+
+  micro_context->DeallocateTempTfLiteTensor(input1);
+  micro_context->DeallocateTempTfLiteTensor(input2);
+  return kTfLiteOk;
+}
+
+template <typename T, typename ElementwiseMulF>
+void EvalMulBroadcast(const tflite::ArithmeticParams& op_params,
+                      const OpData* data, const TfLiteEvalTensor* input1,
+                      const TfLiteEvalTensor* input2, TfLiteEvalTensor* output,
+                      ElementwiseMulF elementwise_mul) {
+  const T* input1_data = tflite::micro::GetTensorData<T>(input1);
+  const T* input2_data = tflite::micro::GetTensorData<T>(input2);
+  int32_t input1_offset = op_params.input1_offset;
+  int32_t input2_offset = op_params.input2_offset;
+  // BroadcastFivefold expects input1 to be the input that broadcasts fast.
+  if (data->broadcast_category ==
+      BroadcastableOpCategory::kSecondInputBroadcastsFast) {
+    std::swap(input1_data, input2_data);
+    std::swap(input1_offset, input2_offset);
+  }
+  cmsis_nn_broadcast::BroadcastFivefold(
+      data->broadcast_shape, input1_data, input2_data,
+      tflite::micro::GetTensorData<T>(output),
+      [&op_params, input1_offset, input2_offset, elementwise_mul](
+          const T* in1, const T* in2, T* out, int size) {
+        elementwise_mul(in1, in2, input1_offset, input2_offset, out,
+                        op_params.output_offset, op_params.output_multiplier,
+                        op_params.output_shift,
+                        op_params.quantized_activation_min,
+                        op_params.quantized_activation_max, size);
+      });
+}
+
 void EvalQuantized(TfLiteContext* context, TfLiteNode* node,
-                   const OpDataMul* data, const TfLiteEvalTensor* input1,
+                   const OpData* op_data, const TfLiteEvalTensor* input1,
                    const TfLiteEvalTensor* input2, TfLiteEvalTensor* output) {
+  const OpDataMul* data = &op_data->reference_op_data;
   tflite::ArithmeticParams op_params = {};
 
   op_params.quantized_activation_min = data->output_activation_min;
@@ -43,11 +116,16 @@ void EvalQuantized(TfLiteContext* context, TfLiteNode* node,
   op_params.output_multiplier = data->output_multiplier;
   op_params.output_shift = data->output_shift;
 
-  bool need_broadcast = reference_ops::ProcessBroadcastShapes(
-      tflite::micro::GetTensorShape(input1),
-      tflite::micro::GetTensorShape(input2), &op_params);
-
-  if (need_broadcast) {
+  if (cmsis_nn_broadcast::IsFivefold(op_data->broadcast_category)) {
+    if (input1->type == kTfLiteInt8) {
+      EvalMulBroadcast<int8_t>(op_params, op_data, input1, input2, output,
+                               arm_elementwise_mul_s8);
+    } else if (input1->type == kTfLiteInt16) {
+      EvalMulBroadcast<int16_t>(op_params, op_data, input1, input2, output,
+                                arm_elementwise_mul_s16);
+    }
+  } else if (op_data->broadcast_category ==
+             BroadcastableOpCategory::kGenericBroadcast) {
     if (input1->type == kTfLiteInt8) {
       reference_integer_ops::BroadcastMul4DSlow(
           op_params, tflite::micro::GetTensorShape(input1),
@@ -67,6 +145,18 @@ void EvalQuantized(TfLiteContext* context, TfLiteNode* node,
     }
 
   } else {
+#if defined(TF_LITE_MICRO_X86_INT8_ENABLED)
+    if (input1->type == kTfLiteInt8 &&
+        x86_int8::MulElementwise(
+            MatchingElementsSize(tflite::micro::GetTensorShape(input1),
+                                 tflite::micro::GetTensorShape(input2),
+                                 tflite::micro::GetTensorShape(output)),
+            op_params, tflite::micro::GetTensorData<int8_t>(input1),
+            tflite::micro::GetTensorData<int8_t>(input2),
+            tflite::micro::GetTensorData<int8_t>(output))) {
+      return;
+    }
+#endif
     if (input1->type == kTfLiteInt8) {
       arm_elementwise_mul_s8(
           tflite::micro::GetTensorData<int8_t>(input1),
@@ -101,7 +191,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   auto* params = reinterpret_cast<TfLiteMulParams*>(node->builtin_data);
 
   TFLITE_DCHECK(node->user_data != nullptr);
-  const OpDataMul* data = static_cast<const OpDataMul*>(node->user_data);
+  const OpData* data = static_cast<const OpData*>(node->user_data);
 
   const TfLiteEvalTensor* input1 =
       tflite::micro::GetEvalInput(context, node, kMulInput1Tensor);
@@ -118,11 +208,12 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       EvalQuantized(context, node, data, input1, input2, output);
       break;
     case kTfLiteInt32:
-      EvalMulQuantizedReference(context, node, data, input1, input2, output);
+      EvalMulQuantizedReference(context, node, &data->reference_op_data,
+                                input1, input2, output);
       break;
     case kTfLiteFloat32:
-      EvalMulFloatReference(context, node, params, data, input1, input2,
-                            output);
+      EvalMulFloatReference(context, node, params, &data->reference_op_data,
+                            input1, input2, output);
       break;
     default:
       MicroPrintf("Type %s (%d) not supported.",
@@ -137,7 +228,7 @@ TfLiteStatus EvalInt8(TfLiteContext* context, TfLiteNode* node) {
   TFLITE_DCHECK(node->builtin_data != nullptr);
   TFLITE_DCHECK(node->user_data != nullptr);
 
-  const OpDataMul* data = static_cast<const OpDataMul*>(node->user_data);
+  const OpData* data = static_cast<const OpData*>(node->user_data);
   const TfLiteEvalTensor* input1 =
       tflite::micro::GetEvalInput(context, node, kMulInput1Tensor);
   const TfLiteEvalTensor* input2 =
@@ -155,7 +246,7 @@ TfLiteStatus EvalInt16(TfLiteContext* context, TfLiteNode* node) {
   TFLITE_DCHECK(node->builtin_data != nullptr);
   TFLITE_DCHECK(node->user_data != nullptr);
 
-  const OpDataMul* data = static_cast<const OpDataMul*>(node->user_data);
+  const OpData* data = static_cast<const OpData*>(node->user_data);
   const TfLiteEvalTensor* input1 =
       tflite::micro::GetEvalInput(context, node, kMulInput1Tensor);
   const TfLiteEvalTensor* input2 =
@@ -170,15 +261,15 @@ TfLiteStatus EvalInt16(TfLiteContext* context, TfLiteNode* node) {
 }
 
 TfLiteRegistration Register_MUL() {
-  return tflite::micro::RegisterOp(MulInit, MulPrepare, Eval);
+  return tflite::micro::RegisterOp(Init, Prepare, Eval);
 }
 
 TfLiteRegistration Register_MUL_INT8() {
-  return tflite::micro::RegisterOp(MulInit, MulPrepare, EvalInt8);
+  return tflite::micro::RegisterOp(Init, Prepare, EvalInt8);
 }
 
 TfLiteRegistration Register_MUL_INT16() {
-  return tflite::micro::RegisterOp(MulInit, MulPrepare, EvalInt16);
+  return tflite::micro::RegisterOp(Init, Prepare, EvalInt16);
 }
 
 }  // namespace tflite
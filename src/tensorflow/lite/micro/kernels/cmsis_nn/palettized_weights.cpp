@@ -0,0 +1,404 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/cmsis_nn/palettized_weights.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "third_party/cmsis_nn/Include/arm_nnsupportfunctions.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/micro_context.h"
+
+namespace tflite {
+namespace palette {
+
+namespace {
+
+// Output pixels of a convolution that are im2col'ed and multiplied at a time.
+constexpr int kConvPixels = 4;
+
+// Returns the number of output channels to expand at a time if each takes
+// channel_size bytes.
+int TileChannels(int channel_size, int num_channels) {
+  return std::max(
+      1, std::min(num_channels, TF_LITE_MICRO_PALETTE_TILE_BYTES /
+                                    std::max(channel_size, 1)));
+}
+
+// Returns true if the convolution cannot read its input pixels directly as
+// rows of the matrix product.
+bool ConvNeedsIm2col(int filter_height, int filter_width, int stride_height,
+                     int stride_width, int padding_height,
+                     int padding_width) {
+  return filter_height != 1 || filter_width != 1 || stride_height != 1 ||
+         stride_width != 1 || padding_height != 0 || padding_width != 0;
+}
+
+// Returns the palette of the filter, which must be constant and, with
+// per-channel codebooks, quantized along quantized_dimension.
+TfLiteStatus GetPalette(TfLiteContext* context, TfLiteNode* node,
+                        int filter_index, const TfLiteTensor* filter,
+                        int quantized_dimension, PalettizedWeights* weights) {
+  weights->palette =
+      GetMicroContext(context)->GetInputPalette(node, filter_index);
+  weights->tile_channels = 0;
+  weights->scratch_index = -1;
+  if (weights->palette == nullptr) {
+    return kTfLiteOk;
+  }
+  TF_LITE_ENSURE_MSG(context, IsConstantTensor(filter),
+                     "Palettized filters must be constant.");
+  TF_LITE_ENSURE(context,
+                 weights->palette->num_codebooks == 1 ||
+                     weights->palette->quantized_dimension ==
+                         quantized_dimension);
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+void Expand(const TensorPalette& palette, const uint8_t* indices, int first,
+            int count, int channel, int channel_step, int8_t* output) {
+  const int bits = palette.bits;
+  const uint32_t mask = (1u << bits) - 1;
+  const int8_t* codebook = palette.codebooks;
+  int codebook_step = 0;
+  if (palette.num_codebooks > 1) {
+    codebook += channel << bits;
+    codebook_step = channel_step << bits;
+  }
+
+  // Indices are at most 8 bits wide, so one byte refills the bit buffer.
+  const size_t first_bit = static_cast<size_t>(first) * bits;
+  const uint8_t* data = indices + first_bit / 8;
+  uint32_t buffer = 0;
+  int buffered = 0;
+  if (first_bit % 8 != 0) {
+    buffer = *data++ >> (first_bit % 8);
+    buffered = 8 - first_bit % 8;
+  }
+  for (int i = 0; i < count; ++i) {
+    if (buffered < bits) {
+      buffer |= static_cast<uint32_t>(*data++) << buffered;
+      buffered += 8;
+    }
+    output[i] = codebook[buffer & mask];
+    buffer >>= bits;
+    buffered -= bits;
+    codebook += codebook_step;
+  }
+}
+
+TfLiteStatus PrepareFullyConnected(TfLiteContext* context, TfLiteNode* node,
+                                   int filter_index,
+                                   const TfLiteTensor* filter,
+                                   PalettizedWeights* weights) {
+  TF_LITE_ENSURE_STATUS(
+      GetPalette(context, node, filter_index, filter, 0, weights));
+  if (weights->palette == nullptr) {
+    return kTfLiteOk;
+  }
+
+  const RuntimeShape filter_shape = GetTensorShape(filter);
+  const int filter_dim_count = filter_shape.DimensionsCount();
+  const int accum_depth = filter_shape.Dims(filter_dim_count - 1);
+  const int output_depth = filter_shape.Dims(filter_dim_count - 2);
+  weights->tile_channels = TileChannels(accum_depth, output_depth);
+  return context->RequestScratchBufferInArena(
+      context, weights->tile_channels * accum_depth, &weights->scratch_index);
+}
+
+TfLiteStatus PrepareConv(TfLiteContext* context, TfLiteNode* node,
+                         int filter_index, const TfLiteConvParams& params,
+                         const TfLitePaddingValues& padding,
+                         const TfLiteTensor* filter,
+                         PalettizedWeights* weights) {
+  TF_LITE_ENSURE_STATUS(
+      GetPalette(context, node, filter_index, filter, 0, weights));
+  if (weights->palette == nullptr) {
+    return kTfLiteOk;
+  }
+
+  const RuntimeShape filter_shape = GetTensorShape(filter);
+  const int output_depth = filter_shape.Dims(0);
+  const int channel_size =
+      filter_shape.Dims(1) * filter_shape.Dims(2) * filter_shape.Dims(3);
+  weights->tile_channels = TileChannels(channel_size, output_depth);
+
+  int bytes = weights->tile_channels * channel_size;
+  if (ConvNeedsIm2col(filter_shape.Dims(1), filter_shape.Dims(2),
+                      params.stride_height, params.stride_width,
+                      padding.height, padding.width)) {
+    bytes += kConvPixels * channel_size;
+  }
+  if (weights->tile_channels < output_depth) {
+    bytes += kConvPixels * weights->tile_channels;
+  }
+  return context->RequestScratchBufferInArena(context, bytes,
+                                              &weights->scratch_index);
+}
+
+TfLiteStatus PrepareDepthwiseConv(TfLiteContext* context, TfLiteNode* node,
+                                  int filter_index,
+                                  const TfLiteTensor* filter,
+                                  PalettizedWeights* weights) {
+  TF_LITE_ENSURE_STATUS(
+      GetPalette(context, node, filter_index, filter, 3, weights));
+  if (weights->palette == nullptr) {
+    return kTfLiteOk;
+  }
+
+  const RuntimeShape filter_shape = GetTensorShape(filter);
+  const int output_depth = filter_shape.Dims(3);
+  const int filter_size = filter_shape.Dims(1) * filter_shape.Dims(2);
+  weights->tile_channels = TileChannels(filter_size, output_depth);
+  // int32 accumulators for the tile, followed by the expanded filter tile.
+  return context->RequestScratchBufferInArena(
+      context, weights->tile_channels * (sizeof(int32_t) + filter_size),
+      &weights->scratch_index);
+}
+
+void FullyConnected(const FullyConnectedParams& params,
+                    const PalettizedWeights& weights,
+                    const RuntimeShape& input_shape, const int8_t* input_data,
+                    const RuntimeShape& filter_shape,
+                    const uint8_t* filter_indices, const int32_t* bias_data,
+                    const RuntimeShape& output_shape, int8_t* output_data,
+                    int8_t* scratch) {
+  const int filter_dim_count = filter_shape.DimensionsCount();
+  const int output_dim_count = output_shape.DimensionsCount();
+  const int batches = FlatSizeSkipDim(output_shape, output_dim_count - 1);
+  const int output_depth = output_shape.Dims(output_dim_count - 1);
+  const int accum_depth = filter_shape.Dims(filter_dim_count - 1);
+
+  for (int first = 0; first < output_depth; first += weights.tile_channels) {
+    const int rows = std::min(weights.tile_channels, output_depth - first);
+    for (int row = 0; row < rows; ++row) {
+      Expand(*weights.palette, filter_indices, (first + row) * accum_depth,
+             accum_depth, first + row, 0, scratch + row * accum_depth);
+    }
+    for (int b = 0; b < batches; ++b) {
+      TFLITE_DCHECK_EQ(
+          arm_nn_vec_mat_mult_t_s8(
+              input_data + b * accum_depth, scratch,
+              bias_data != nullptr ? bias_data + first : nullptr,
+              output_data + b * output_depth + first, params.input_offset, 0,
+              params.output_offset, params.output_multiplier,
+              params.output_shift, accum_depth, rows,
+              params.quantized_activation_min,
+              params.quantized_activation_max, 1),
+          ARM_CMSIS_NN_SUCCESS);
+    }
+  }
+}
+
+void ConvPerChannel(const ConvParams& params,
+                    const int32_t* output_multiplier,
+                    const int32_t* output_shift,
+                    const PalettizedWeights& weights,
+                    const RuntimeShape& input_shape, const int8_t* input_data,
+                    const RuntimeShape& filter_shape,
+                    const uint8_t* filter_indices, const int32_t* bias_data,
+                    const RuntimeShape& output_shape, int8_t* output_data,
+                    int8_t* scratch) {
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int input_depth = input_shape.Dims(3);
+  const int filter_height = filter_shape.Dims(1);
+  const int filter_width = filter_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int output_depth = output_shape.Dims(3);
+  const int num_pixels =
+      MatchingDim(input_shape, 0, output_shape, 0) * output_height *
+      output_width;
+  const int channel_size = filter_height * filter_width * input_depth;
+  const int tile_channels = weights.tile_channels;
+  const bool needs_im2col = ConvNeedsIm2col(
+      filter_height, filter_width, params.stride_height, params.stride_width,
+      params.padding_values.height, params.padding_values.width);
+  // Without im2col and with the whole filter in one tile all pixels are
+  // multiplied at once.
+  const int chunk_pixels = !needs_im2col && tile_channels == output_depth
+                               ? num_pixels
+                               : kConvPixels;
+
+  int8_t* filter_tile = scratch;
+  int8_t* columns = filter_tile + tile_channels * channel_size;
+  int8_t* output_tile =
+      columns + (needs_im2col ? kConvPixels * channel_size : 0);
+  const int8_t pad_value = static_cast<int8_t>(-params.input_offset);
+
+  for (int first = 0; first < output_depth; first += tile_channels) {
+    const int channels = std::min(tile_channels, output_depth - first);
+    for (int c = 0; c < channels; ++c) {
+      Expand(*weights.palette, filter_indices, (first + c) * channel_size,
+             channel_size, first + c, 0, filter_tile + c * channel_size);
+    }
+
+    for (int pixel = 0; pixel < num_pixels; pixel += chunk_pixels) {
+      const int pixels = std::min(chunk_pixels, num_pixels - pixel);
+      const int8_t* lhs = input_data + pixel * input_depth;
+      if (needs_im2col) {
+        int8_t* column = columns;
+        for (int p = pixel; p < pixel + pixels; ++p) {
+          const int out_x = p % output_width;
+          const int out_y = (p / output_width) % output_height;
+          const int batch = p / (output_width * output_height);
+          for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+            const int in_y = out_y * params.stride_height -
+                             params.padding_values.height +
+                             filter_y * params.dilation_height_factor;
+            for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
+              const int in_x = out_x * params.stride_width -
+                               params.padding_values.width +
+                               filter_x * params.dilation_width_factor;
+              if (in_y >= 0 && in_y < input_height && in_x >= 0 &&
+                  in_x < input_width) {
+                std::memcpy(column,
+                            input_data + ((batch * input_height + in_y) *
+                                              input_width +
+                                          in_x) *
+                                             input_depth,
+                            input_depth);
+              } else {
+                // Padding contributes nothing once the offset is added.
+                std::memset(column, pad_value, input_depth);
+              }
+              column += input_depth;
+            }
+          }
+        }
+        lhs = columns;
+      }
+
+      int8_t* dst = channels == output_depth
+                        ? output_data + pixel * output_depth
+                        : output_tile;
+      TFLITE_DCHECK_EQ(
+          arm_nn_mat_mult_nt_t_s8(
+              lhs, filter_tile,
+              bias_data != nullptr ? bias_data + first : nullptr, dst,
+              output_multiplier + first, output_shift + first, pixels,
+              channels, channel_size, params.input_offset,
+              params.output_offset, params.quantized_activation_min,
+              params.quantized_activation_max),
+          ARM_CMSIS_NN_SUCCESS);
+      if (dst == output_tile) {
+        for (int p = 0; p < pixels; ++p) {
+          std::memcpy(output_data + (pixel + p) * output_depth + first,
+                      output_tile + p * channels, channels);
+        }
+      }
+    }
+  }
+}
+
+void DepthwiseConvPerChannel(
+    const DepthwiseParams& params, const int32_t* output_multiplier,
+    const int32_t* output_shift, const PalettizedWeights& weights,
+    const RuntimeShape& input_shape, const int8_t* input_data,
+    const RuntimeShape& filter_shape, const uint8_t* filter_indices,
+    const int32_t* bias_data, const RuntimeShape& output_shape,
+    int8_t* output_data, int8_t* scratch) {
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int input_depth = input_shape.Dims(3);
+  const int filter_height = filter_shape.Dims(1);
+  const int filter_width = filter_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int output_depth = output_shape.Dims(3);
+  const int depth_multiplier = params.depth_multiplier;
+  const int tile_channels = weights.tile_channels;
+
+  int32_t* acc = reinterpret_cast<int32_t*>(scratch);
+  int8_t* filter_tile = scratch + tile_channels * sizeof(int32_t);
+
+  for (int first = 0; first < output_depth; first += tile_channels) {
+    const int channels = std::min(tile_channels, output_depth - first);
+    for (int i = 0; i < filter_height * filter_width; ++i) {
+      Expand(*weights.palette, filter_indices, i * output_depth + first,
+             channels, first, 1, filter_tile + i * channels);
+    }
+
+    for (int b = 0; b < batches; ++b) {
+      for (int out_y = 0; out_y < output_height; ++out_y) {
+        for (int out_x = 0; out_x < output_width; ++out_x) {
+          for (int c = 0; c < channels; ++c) {
+            acc[c] = bias_data != nullptr ? bias_data[first + c] : 0;
+          }
+          for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+            const int in_y = out_y * params.stride_height -
+                             params.padding_values.height +
+                             filter_y * params.dilation_height_factor;
+            if (in_y < 0 || in_y >= input_height) {
+              continue;
+            }
+            for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
+              const int in_x = out_x * params.stride_width -
+                               params.padding_values.width +
+                               filter_x * params.dilation_width_factor;
+              if (in_x < 0 || in_x >= input_width) {
+                continue;
+              }
+              const int8_t* in =
+                  input_data +
+                  ((b * input_height + in_y) * input_width + in_x) *
+                      input_depth;
+              const int8_t* filter_values =
+                  filter_tile + (filter_y * filter_width + filter_x) * channels;
+              if (depth_multiplier == 1) {
+                in += first;
+                for (int c = 0; c < channels; ++c) {
+                  acc[c] += (in[c] + params.input_offset) * filter_values[c];
+                }
+              } else {
+                for (int c = 0; c < channels; ++c) {
+                  acc[c] +=
+                      (in[(first + c) / depth_multiplier] +
+                       params.input_offset) *
+                      filter_values[c];
+                }
+              }
+            }
+          }
+
+          int8_t* out =
+              output_data +
+              ((b * output_height + out_y) * output_width + out_x) *
+                  output_depth +
+              first;
+          for (int c = 0; c < channels; ++c) {
+            int32_t result = MultiplyByQuantizedMultiplier(
+                acc[c], output_multiplier[first + c],
+                output_shift[first + c]);
+            result += params.output_offset;
+            result = std::max(result, params.quantized_activation_min);
+            result = std::min(result, params.quantized_activation_max);
+            out[c] = static_cast<int8_t>(result);
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace palette
+}  // namespace tflite
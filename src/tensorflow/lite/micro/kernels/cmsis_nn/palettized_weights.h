@@ -0,0 +1,106 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_CMSIS_NN_PALETTIZED_WEIGHTS_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_CMSIS_NN_PALETTIZED_WEIGHTS_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/micro/micro_palette.h"
+
+// Int8 CONV_2D, DEPTHWISE_CONV_2D and FULLY_CONNECTED kernels for palettized
+// filters (see micro_palette.h). The filter is never expanded as a whole:
+// Eval expands a tile of output channels at a time into a scratch buffer of
+// about TF_LITE_MICRO_PALETTE_TILE_BYTES bytes and computes those channels
+// with the CMSIS-NN matrix kernels before moving on to the next tile. Larger
+// tiles cost arena but repeat less of the per-tile work, e.g. the im2col of
+// convolutions.
+#ifndef TF_LITE_MICRO_PALETTE_TILE_BYTES
+#define TF_LITE_MICRO_PALETTE_TILE_BYTES 4096
+#endif
+
+namespace tflite {
+namespace palette {
+
+// Set up by the Prepare functions below.
+struct PalettizedWeights {
+  // nullptr if the filter holds plain int8 values.
+  const TensorPalette* palette;
+
+  // Number of output channels expanded at a time.
+  int tile_channels;
+  int scratch_index;
+};
+
+// Expands elements [first, first + count) of a palettized tensor into output.
+// channel is the index of the first element along the quantized dimension,
+// and channel_step is 1 if the elements belong to consecutive channels, i.e.
+// the quantized dimension is the last one, or 0 if they all belong to
+// channel.
+void Expand(const TensorPalette& palette, const uint8_t* indices, int first,
+            int count, int channel, int channel_step, int8_t* output);
+
+// Each Prepare function sets weights->palette to nullptr if the filter input
+// of node is not palettized, and otherwise requests the scratch buffer for
+// the corresponding Eval function. The glue must check that the input is
+// int8.
+TfLiteStatus PrepareFullyConnected(TfLiteContext* context, TfLiteNode* node,
+                                   int filter_index,
+                                   const TfLiteTensor* filter,
+                                   PalettizedWeights* weights);
+
+TfLiteStatus PrepareConv(TfLiteContext* context, TfLiteNode* node,
+                         int filter_index, const TfLiteConvParams& params,
+                         const TfLitePaddingValues& padding,
+                         const TfLiteTensor* filter,
+                         PalettizedWeights* weights);
+
+TfLiteStatus PrepareDepthwiseConv(TfLiteContext* context, TfLiteNode* node,
+                                  int filter_index,
+                                  const TfLiteTensor* filter,
+                                  PalettizedWeights* weights);
+
+void FullyConnected(const FullyConnectedParams& params,
+                    const PalettizedWeights& weights,
+                    const RuntimeShape& input_shape, const int8_t* input_data,
+                    const RuntimeShape& filter_shape,
+                    const uint8_t* filter_indices, const int32_t* bias_data,
+                    const RuntimeShape& output_shape, int8_t* output_data,
+                    int8_t* scratch);
+
+void ConvPerChannel(const ConvParams& params,
+                    const int32_t* output_multiplier,
+                    const int32_t* output_shift,
+                    const PalettizedWeights& weights,
+                    const RuntimeShape& input_shape, const int8_t* input_data,
+                    const RuntimeShape& filter_shape,
+                    const uint8_t* filter_indices, const int32_t* bias_data,
+                    const RuntimeShape& output_shape, int8_t* output_data,
+                    int8_t* scratch);
+
+void DepthwiseConvPerChannel(
+    const DepthwiseParams& params, const int32_t* output_multiplier,
+    const int32_t* output_shift, const PalettizedWeights& weights,
+    const RuntimeShape& input_shape, const int8_t* input_data,
+    const RuntimeShape& filter_shape, const uint8_t* filter_indices,
+    const int32_t* bias_data, const RuntimeShape& output_shape,
+    int8_t* output_data, int8_t* scratch);
+
+}  // namespace palette
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_CMSIS_NN_PALETTIZED_WEIGHTS_H_
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/kernels/pooling.h"
+#include "tensorflow/lite/micro/kernels/x86_int8.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
 namespace tflite {
@@ -70,6 +71,22 @@ void PopulateCommonParams(
   }
 }
 
+#if defined(TF_LITE_MICRO_X86_INT8_ENABLED)
+PoolParams PoolParamsQuantized(const TfLitePoolParams* params,
+                               const OpData& data) {
+  PoolParams op_params;
+  op_params.stride_height = params->stride_height;
+  op_params.stride_width = params->stride_width;
+  op_params.filter_height = params->filter_height;
+  op_params.filter_width = params->filter_width;
+  op_params.padding_values.height = data.reference_op_data.padding.height;
+  op_params.padding_values.width = data.reference_op_data.padding.width;
+  op_params.quantized_activation_min = data.reference_op_data.activation_min;
+  op_params.quantized_activation_max = data.reference_op_data.activation_max;
+  return op_params;
+}
+#endif
+
 void AverageEvalQuantized(TfLiteContext* context, const TfLiteNode* node,
                           const TfLitePoolParams* params, const OpData& data,
                           const TfLiteEvalTensor* input,
@@ -88,6 +105,15 @@ void AverageEvalQuantized(TfLiteContext* context, const TfLiteNode* node,
   cmsis_nn_dims filter_dims;
   cmsis_nn_context ctx;
 
+#if defined(TF_LITE_MICRO_X86_INT8_ENABLED)
+  if (input->type == kTfLiteInt8 &&
+      x86_int8::AveragePool(PoolParamsQuantized(params, data), input_shape,
+                            micro::GetTensorData<int8_t>(input), output_shape,
+                            micro::GetTensorData<int8_t>(output))) {
+    return;
+  }
+#endif
+
   PopulateCommonParams(context, &input_dims, &output_dims, &pool_params, &ctx,
                        &filter_dims, data, input_shape, output_shape, params);
 
@@ -124,6 +150,15 @@ TfLiteStatus MaxEvalQuantized(TfLiteContext* context, const TfLiteNode* node,
   cmsis_nn_dims filter_dims;
   cmsis_nn_context ctx;
 
+#if defined(TF_LITE_MICRO_X86_INT8_ENABLED)
+  if (input->type == kTfLiteInt8 &&
+      x86_int8::MaxPool(PoolParamsQuantized(params, data), input_shape,
+                        micro::GetTensorData<int8_t>(input), output_shape,
+                        micro::GetTensorData<int8_t>(output))) {
+    return kTfLiteOk;
+  }
+#endif
+
   PopulateCommonParams(context, &input_dims, &output_dims, &pool_params, &ctx,
                        &filter_dims, data, input_shape, output_shape, params);
 
@@ -24,6 +24,8 @@ limitations under the License.
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/op_macros.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/simd_float.h"
+#include "tensorflow/lite/micro/kernels/x86_int8.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
 namespace tflite {
@@ -75,6 +77,42 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   return ret_val;
 }
 
+void EvalInt8(const CMSISNNSoftmaxParams& op_data,
+              const TfLiteEvalTensor* input, TfLiteEvalTensor* output) {
+#if defined(TF_LITE_MICRO_X86_INT8_ENABLED)
+  if (x86_int8::Softmax(op_data.softmax_params,
+                        tflite::micro::GetTensorShape(input),
+                        tflite::micro::GetTensorData<int8_t>(input),
+                        tflite::micro::GetTensorShape(output),
+                        tflite::micro::GetTensorData<int8_t>(output))) {
+    return;
+  }
+#endif
+  arm_softmax_s8(tflite::micro::GetTensorData<int8_t>(input), op_data.num_rows,
+                 op_data.row_size, op_data.softmax_params.input_multiplier,
+                 op_data.softmax_params.input_left_shift,
+                 op_data.softmax_params.diff_min,
+                 tflite::micro::GetTensorData<int8_t>(output));
+}
+
+void EvalInt8Int16(const CMSISNNSoftmaxParams& op_data,
+                   const TfLiteEvalTensor* input, TfLiteEvalTensor* output) {
+#if defined(TF_LITE_MICRO_X86_INT8_ENABLED)
+  if (x86_int8::Softmax(op_data.softmax_params,
+                        tflite::micro::GetTensorShape(input),
+                        tflite::micro::GetTensorData<int8_t>(input),
+                        tflite::micro::GetTensorShape(output),
+                        tflite::micro::GetTensorData<int16_t>(output))) {
+    return;
+  }
+#endif
+  arm_softmax_s8_s16(
+      tflite::micro::GetTensorData<int8_t>(input), op_data.num_rows,
+      op_data.row_size, op_data.softmax_params.input_multiplier,
+      op_data.softmax_params.input_left_shift, op_data.softmax_params.diff_min,
+      tflite::micro::GetTensorData<int16_t>(output));
+}
+
 TfLiteStatus SoftmaxEval(TfLiteContext* context, TfLiteNode* node) {
   const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 0);
   TfLiteEvalTensor* output = tflite::micro::GetEvalOutput(context, node, 0);
@@ -85,7 +123,7 @@ TfLiteStatus SoftmaxEval(TfLiteContext* context, TfLiteNode* node) {
 
   switch (input->type) {
     case kTfLiteFloat32: {
-      tflite::reference_ops::Softmax(
+      tflite::simd_float::Softmax(
           op_data.softmax_params, tflite::micro::GetTensorShape(input),
           tflite::micro::GetTensorData<float>(input),
           tflite::micro::GetTensorShape(output),
@@ -94,19 +132,9 @@ TfLiteStatus SoftmaxEval(TfLiteContext* context, TfLiteNode* node) {
     }
     case kTfLiteInt8: {
       if (output->type == kTfLiteInt8) {
-        arm_softmax_s8(tflite::micro::GetTensorData<int8_t>(input),
-                       op_data.num_rows, op_data.row_size,
-                       op_data.softmax_params.input_multiplier,
-                       op_data.softmax_params.input_left_shift,
-                       op_data.softmax_params.diff_min,
-                       tflite::micro::GetTensorData<int8_t>(output));
+        EvalInt8(op_data, input, output);
       } else {
-        arm_softmax_s8_s16(tflite::micro::GetTensorData<int8_t>(input),
-                           op_data.num_rows, op_data.row_size,
-                           op_data.softmax_params.input_multiplier,
-                           op_data.softmax_params.input_left_shift,
-                           op_data.softmax_params.diff_min,
-                           tflite::micro::GetTensorData<int16_t>(output));
+        EvalInt8Int16(op_data, input, output);
       }
       return kTfLiteOk;
     }
@@ -139,11 +167,7 @@ TfLiteStatus SoftmaxEvalInt8(TfLiteContext* context, TfLiteNode* node) {
   const CMSISNNSoftmaxParams op_data =
       *static_cast<const CMSISNNSoftmaxParams*>(node->user_data);
 
-  arm_softmax_s8(tflite::micro::GetTensorData<int8_t>(input), op_data.num_rows,
-                 op_data.row_size, op_data.softmax_params.input_multiplier,
-                 op_data.softmax_params.input_left_shift,
-                 op_data.softmax_params.diff_min,
-                 tflite::micro::GetTensorData<int8_t>(output));
+  EvalInt8(op_data, input, output);
 
   return kTfLiteOk;
 }
@@ -156,11 +180,7 @@ TfLiteStatus SoftmaxEvalInt8_Int16(TfLiteContext* context, TfLiteNode* node) {
   const CMSISNNSoftmaxParams op_data =
       *static_cast<const CMSISNNSoftmaxParams*>(node->user_data);
 
-  arm_softmax_s8_s16(
-      tflite::micro::GetTensorData<int8_t>(input), op_data.num_rows,
-      op_data.row_size, op_data.softmax_params.input_multiplier,
-      op_data.softmax_params.input_left_shift, op_data.softmax_params.diff_min,
-      tflite::micro::GetTensorData<int16_t>(output));
+  EvalInt8Int16(op_data, input, output);
 
   return kTfLiteOk;
 }
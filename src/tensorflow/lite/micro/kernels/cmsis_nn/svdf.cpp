@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "third_party/cmsis_nn/Include/arm_nn_types.h"
 #include "third_party/cmsis_nn/Include/arm_nnfunctions.h"
+#include "third_party/cmsis_nn/Include/arm_nnsupportfunctions.h"
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/common.h"
@@ -37,42 +38,141 @@ void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   return context->AllocatePersistentBuffer(context, sizeof(OpDataSvdf));
 }
 
-TfLiteStatus EvalIntegerSVDF(TfLiteContext* context, TfLiteNode* node,
-                             const TfLiteEvalTensor* input_tensor,
-                             const TfLiteEvalTensor* weights_feature_tensor,
-                             const TfLiteEvalTensor* weights_time_tensor,
-                             const TfLiteEvalTensor* bias_tensor,
-                             const TfLiteSVDFParams* params,
-                             TfLiteEvalTensor* activation_state_tensor,
-                             TfLiteEvalTensor* output_tensor,
-                             const OpDataSvdf& data) {
-  cmsis_nn_dims input_dims;
-  input_dims.n = input_tensor->dims->data[0];
-  input_dims.h = input_tensor->dims->data[1];
+// Folds the input zero point into a bias for the feature matmul of int8
+// activation states, as the fully connected kernel does. Only the MVE loops
+// of arm_nn_vec_mat_mult_t_s8 skip work for a zero input offset, so
+// elsewhere this needs TF_LITE_MICRO_FOLD_INPUT_OFFSET. The int16 state
+// matmul, arm_nn_vec_mat_mult_t_svdf_s8, takes no bias.
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  TF_LITE_ENSURE_STATUS(PrepareSvdf(context, node));
+#if defined(ARM_MATH_MVEI) || defined(TF_LITE_MICRO_FOLD_INPUT_OFFSET)
+  OpDataSvdf* data = static_cast<OpDataSvdf*>(node->user_data);
+  MicroContext* micro_context = GetMicroContext(context);
+  TfLiteTensor* weights_feature =
+      micro_context->AllocateTempInputTensor(node, kSvdfWeightsFeatureTensor);
+  TF_LITE_ENSURE(context, weights_feature != nullptr);
+  TfLiteTensor* activation_state = micro_context->AllocateTempInputTensor(
+      node, kSvdfInputActivationStateTensor);
+  TF_LITE_ENSURE(context, activation_state != nullptr);
+
+  if (weights_feature->type == kTfLiteInt8 &&
+      activation_state->type == kTfLiteInt8 &&
+      IsConstantTensor(weights_feature) && data->input_zero_point != 0) {
+    const int num_filters = weights_feature->dims->data[0];
+    const int input_size = weights_feature->dims->data[1];
+    data->feature_bias =
+        static_cast<int32_t*>(context->AllocatePersistentBuffer(
+            context, num_filters * sizeof(int32_t)));
+    TF_LITE_ENSURE(context, data->feature_bias != nullptr);
+    const int8_t* weights = GetTensorData<int8_t>(weights_feature);
+    for (int f = 0; f < num_filters; ++f) {
+      int32_t sum = 0;
+      for (int i = 0; i < input_size; ++i) {
+        sum += weights[f * input_size + i];
+      }
+      data->feature_bias[f] = -data->input_zero_point * sum;
+    }
+  }
+
+  micro_context->DeallocateTempTfLiteTensor(weights_feature);
+  micro_context->DeallocateTempTfLiteTensor(activation_state);
+#endif
+  return kTfLiteOk;
+}
 
-  cmsis_nn_dims weights_feature_dims;
-  weights_feature_dims.n = weights_feature_tensor->dims->data[0];
-  weights_feature_dims.h = weights_feature_tensor->dims->data[1];
+// Feature matmul for one batch, writing the activations with a stride of
+// memory_size into the state column that receives this invoke's values.
+arm_cmsis_nn_status FeatureMatMul(const int8_t* input,
+                                  const int8_t* weights_feature,
+                                  const int32_t* feature_bias,
+                                  int8_t* state_column,
+                                  const cmsis_nn_svdf_params& svdf_params,
+                                  const cmsis_nn_per_tensor_quant_params& quant,
+                                  int input_size, int num_filters,
+                                  int memory_size) {
+  return arm_nn_vec_mat_mult_t_s8(
+      input, weights_feature, feature_bias, state_column,
+      feature_bias != nullptr ? 0 : -svdf_params.input_offset, 0, 0,
+      quant.multiplier, quant.shift, input_size, num_filters,
+      svdf_params.input_activation.min, svdf_params.input_activation.max,
+      memory_size);
+}
 
-  cmsis_nn_dims weights_time_dims;
-  weights_time_dims.n = weights_time_tensor->dims->data[0];
-  weights_time_dims.h = weights_time_tensor->dims->data[1];
+arm_cmsis_nn_status FeatureMatMul(const int8_t* input,
+                                  const int8_t* weights_feature,
+                                  const int32_t* feature_bias,
+                                  int16_t* state_column,
+                                  const cmsis_nn_svdf_params& svdf_params,
+                                  const cmsis_nn_per_tensor_quant_params& quant,
+                                  int input_size, int num_filters,
+                                  int memory_size) {
+  TFLITE_DCHECK(feature_bias == nullptr);
+  return arm_nn_vec_mat_mult_t_svdf_s8(
+      input, weights_feature, state_column, -svdf_params.input_offset, 0,
+      memory_size, quant.multiplier, quant.shift, input_size, num_filters,
+      svdf_params.input_activation.min, svdf_params.input_activation.max);
+}
 
-  cmsis_nn_dims bias_dims;
-  bias_dims.n = bias_tensor->dims->data[0];
+// Dot product of n time weights with n contiguous state values, using the same
+// multiply-accumulate sequence as arm_svdf_s8 and arm_svdf_state_s16_s8.
+int32_t TimeDotSegment(const int8_t* v1, const int8_t* v2, int n) {
+  int32_t sum = 0;
+  int j = 0;
+#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_MVEI)
+  for (; j + 4 <= n; j += 4) {
+    q31_t r1_1, r1_2, r2_1, r2_2;
+    v1 = read_and_pad_reordered(v1, &r1_1, &r1_2);
+    v2 = read_and_pad_reordered(v2, &r2_1, &r2_2);
+    sum = __SMLAD(r1_1, r2_1, sum);
+    sum = __SMLAD(r1_2, r2_2, sum);
+  }
+#endif
+  for (; j < n; ++j) {
+    sum += *v1++ * *v2++;
+  }
+  return sum;
+}
 
-  cmsis_nn_dims state_dims;
-  state_dims.n = bias_tensor->dims->data[0];
-  state_dims.h = bias_tensor->dims->data[1];
+int32_t TimeDotSegment(const int16_t* v1, const int16_t* v2, int n) {
+  int32_t sum = 0;
+  int j = 0;
+#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_MVEI)
+  for (; j + 2 <= n; j += 2) {
+    sum = __SMLAD(arm_nn_read_q15x2_ia(&v1), arm_nn_read_q15x2_ia(&v2), sum);
+  }
+#endif
+  for (; j < n; ++j) {
+    sum += *v1++ * *v2++;
+  }
+  return sum;
+}
 
-  cmsis_nn_dims output_dims;
-  output_dims.n = output_tensor->dims->data[0];
-  output_dims.h = output_tensor->dims->data[1];
+// Integer SVDF with the activation state kept as a ring buffer (see
+// OpDataSvdf::activation_state_head). This follows arm_svdf_s8 and
+// arm_svdf_state_s16_s8, which shift the whole state by one column on every
+// invoke, but writes the new column in place and reads the time dimension in
+// two contiguous segments instead.
+template <typename T>
+TfLiteStatus EvalIntegerSvdfRing(TfLiteContext* context,
+                                 const TfLiteEvalTensor* input_tensor,
+                                 const TfLiteEvalTensor* weights_feature_tensor,
+                                 const TfLiteEvalTensor* weights_time_tensor,
+                                 const TfLiteEvalTensor* bias_tensor,
+                                 const TfLiteSVDFParams* params,
+                                 TfLiteEvalTensor* activation_state_tensor,
+                                 TfLiteEvalTensor* output_tensor,
+                                 OpDataSvdf* data) {
+  const int rank = params->rank;
+  const int batch_size = input_tensor->dims->data[0];
+  const int input_size = input_tensor->dims->data[1];
+  const int num_filters = weights_feature_tensor->dims->data[0];
+  const int num_units = num_filters / rank;
+  const int memory_size = weights_time_tensor->dims->data[1];
 
   cmsis_nn_svdf_params svdf_params;
-  svdf_params.rank = params->rank;
-  svdf_params.input_offset = data.input_zero_point;
-  svdf_params.output_offset = data.output_zero_point;
+  svdf_params.rank = rank;
+  svdf_params.input_offset = data->input_zero_point;
+  svdf_params.output_offset = data->output_zero_point;
 
   svdf_params.input_activation.min = INT16_MIN;
   svdf_params.input_activation.max = INT16_MAX;
@@ -81,56 +181,100 @@ TfLiteStatus EvalIntegerSVDF(TfLiteContext* context, TfLiteNode* node,
   svdf_params.output_activation.max = INT8_MAX;
 
   cmsis_nn_per_tensor_quant_params in_quant_params;
-  in_quant_params.multiplier = data.effective_scale_1_a;
-  in_quant_params.shift = data.effective_scale_1_b;
-
-  cmsis_nn_per_tensor_quant_params out_quant_params;
-  out_quant_params.multiplier = data.effective_scale_2_a;
-  out_quant_params.shift = data.effective_scale_2_b;
+  in_quant_params.multiplier = data->effective_scale_1_a;
+  in_quant_params.shift = data->effective_scale_1_b;
 
   TFLITE_DCHECK(context != nullptr);
   TFLITE_DCHECK(context->GetScratchBuffer != nullptr);
 
-  cmsis_nn_context scratch_ctx;
-  scratch_ctx.buf = static_cast<int32_t*>(
-      context->GetScratchBuffer(context, data.scratch_tensor_index));
+  int32_t* scratch = static_cast<int32_t*>(
+      context->GetScratchBuffer(context, data->scratch_tensor_index));
+  int32_t* scratch_output = static_cast<int32_t*>(
+      context->GetScratchBuffer(context, data->scratch_output_tensor_index));
+
+  const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input_tensor);
+  const int8_t* weights_feature_data =
+      tflite::micro::GetTensorData<int8_t>(weights_feature_tensor);
+  const T* weights_time_data =
+      tflite::micro::GetTensorData<T>(weights_time_tensor);
+  T* state_data = tflite::micro::GetTensorData<T>(activation_state_tensor);
+
+  // The new activations overwrite the oldest column of the state ring.
+  const int newest = AdvanceSvdfStateHead(data, memory_size);
+  const int oldest = (newest + 1) % memory_size;
+
+  for (int b = 0; b < batch_size; ++b) {
+    TF_LITE_ENSURE_EQ(
+        context,
+        FeatureMatMul(input_data + b * input_size, weights_feature_data,
+                      data->feature_bias,
+                      state_data + b * num_filters * memory_size + newest,
+                      svdf_params, in_quant_params, input_size, num_filters,
+                      memory_size),
+        ARM_CMSIS_NN_SUCCESS);
+  }
 
-  cmsis_nn_context scratch_output_ctx;
-  scratch_output_ctx.buf = static_cast<int32_t*>(
-      context->GetScratchBuffer(context, data.scratch_output_tensor_index));
+  const int first_segment = memory_size - oldest;
+  for (int b = 0; b < batch_size; ++b) {
+    const T* state_row = state_data + b * num_filters * memory_size;
+    const T* weights_row = weights_time_data;
+    int32_t* scratch_batch = scratch + b * num_filters;
+    for (int i = 0; i < num_filters; ++i) {
+      scratch_batch[i] =
+          TimeDotSegment(weights_row, state_row + oldest, first_segment) +
+          TimeDotSegment(weights_row + first_segment, state_row, oldest);
+      weights_row += memory_size;
+      state_row += memory_size;
+    }
+  }
+
+  const int32_t* bias_data =
+      bias_tensor != nullptr ? tflite::micro::GetTensorData<int32_t>(bias_tensor)
+                             : nullptr;
+  for (int b = 0; b < batch_size; ++b) {
+    const int32_t* scratch_batch = scratch + b * num_filters;
+    int32_t* output_batch = scratch_output + b * num_units;
+    for (int i = 0; i < num_units; ++i) {
+      int32_t sum = bias_data != nullptr ? bias_data[i] : 0;
+      for (int j = 0; j < rank; ++j) {
+        sum += *scratch_batch++;
+      }
+      output_batch[i] = sum;
+    }
+  }
 
   int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output_tensor);
+  for (int i = 0; i < batch_size * num_units; ++i) {
+    const int32_t value =
+        arm_nn_requantize(scratch_output[i], data->effective_scale_2_a,
+                          data->effective_scale_2_b) +
+        svdf_params.output_offset;
+    output_data[i] = static_cast<int8_t>(
+        CLAMP(value, svdf_params.output_activation.max,
+              svdf_params.output_activation.min));
+  }
+  return kTfLiteOk;
+}
 
+TfLiteStatus EvalIntegerSVDF(TfLiteContext* context,
+                             const TfLiteEvalTensor* input_tensor,
+                             const TfLiteEvalTensor* weights_feature_tensor,
+                             const TfLiteEvalTensor* weights_time_tensor,
+                             const TfLiteEvalTensor* bias_tensor,
+                             const TfLiteSVDFParams* params,
+                             TfLiteEvalTensor* activation_state_tensor,
+                             TfLiteEvalTensor* output_tensor,
+                             OpDataSvdf* data) {
   switch (weights_time_tensor->type) {
-    case kTfLiteInt8: {
-      arm_svdf_s8(
-          &scratch_ctx, &scratch_output_ctx, &svdf_params, &in_quant_params,
-          &out_quant_params, &input_dims,
-          tflite::micro::GetTensorData<int8_t>(input_tensor), &state_dims,
-          tflite::micro::GetTensorData<int8_t>(activation_state_tensor),
-          &weights_feature_dims,
-          tflite::micro::GetTensorData<int8_t>(weights_feature_tensor),
-          &weights_time_dims,
-          tflite::micro::GetTensorData<int8_t>(weights_time_tensor), &bias_dims,
-          tflite::micro::GetTensorData<int32_t>(bias_tensor), &output_dims,
-          output_data);
-      return kTfLiteOk;
-    }
+    case kTfLiteInt8:
+      return EvalIntegerSvdfRing<int8_t>(
+          context, input_tensor, weights_feature_tensor, weights_time_tensor,
+          bias_tensor, params, activation_state_tensor, output_tensor, data);
 
-    case kTfLiteInt16: {
-      arm_svdf_state_s16_s8(
-          &scratch_ctx, &scratch_output_ctx, &svdf_params, &in_quant_params,
-          &out_quant_params, &input_dims,
-          tflite::micro::GetTensorData<int8_t>(input_tensor), &state_dims,
-          tflite::micro::GetTensorData<int16_t>(activation_state_tensor),
-          &weights_feature_dims,
-          tflite::micro::GetTensorData<int8_t>(weights_feature_tensor),
-          &weights_time_dims,
-          tflite::micro::GetTensorData<int16_t>(weights_time_tensor),
-          &bias_dims, tflite::micro::GetTensorData<int32_t>(bias_tensor),
-          &output_dims, output_data);
-      return kTfLiteOk;
-    }
+    case kTfLiteInt16:
+      return EvalIntegerSvdfRing<int16_t>(
+          context, input_tensor, weights_feature_tensor, weights_time_tensor,
+          bias_tensor, params, activation_state_tensor, output_tensor, data);
 
     default:
       MicroPrintf("Could not find matching function for type %s.",
@@ -142,7 +286,7 @@ TfLiteStatus EvalIntegerSVDF(TfLiteContext* context, TfLiteNode* node,
 TfLiteStatus EvalSvdf(TfLiteContext* context, TfLiteNode* node) {
   auto* params = reinterpret_cast<TfLiteSVDFParams*>(node->builtin_data);
   TFLITE_DCHECK(node->user_data != nullptr);
-  const OpDataSvdf& data = *(static_cast<const OpDataSvdf*>(node->user_data));
+  OpDataSvdf* data = static_cast<OpDataSvdf*>(node->user_data);
 
   const TfLiteEvalTensor* input =
       tflite::micro::GetEvalInput(context, node, kSvdfInputTensor);
@@ -161,17 +305,16 @@ TfLiteStatus EvalSvdf(TfLiteContext* context, TfLiteNode* node) {
 
   switch (weights_time->type) {
     case kTfLiteFloat32: {
-      EvalFloatSvdfReference(
-          context, node, input, weights_feature, weights_time, bias, params,
-          data.scratch_tensor_index, activation_state, output);
+      EvalFloatSvdfReference(context, node, input, weights_feature,
+                             weights_time, bias, params, activation_state,
+                             output, data);
       return kTfLiteOk;
     }
 
     case kTfLiteInt8:
     case kTfLiteInt16: {
-      return EvalIntegerSVDF(context, node, input, weights_feature,
-                             weights_time, bias, params, activation_state,
-                             output, data);
+      return EvalIntegerSVDF(context, input, weights_feature, weights_time,
+                             bias, params, activation_state, output, data);
     }
 
     default:
@@ -185,7 +328,7 @@ TfLiteStatus EvalSvdf(TfLiteContext* context, TfLiteNode* node) {
 TfLiteStatus EvalSvdfInt8(TfLiteContext* context, TfLiteNode* node) {
   auto* params = reinterpret_cast<TfLiteSVDFParams*>(node->builtin_data);
   TFLITE_DCHECK(node->user_data != nullptr);
-  const OpDataSvdf& data = *(static_cast<const OpDataSvdf*>(node->user_data));
+  OpDataSvdf* data = static_cast<OpDataSvdf*>(node->user_data);
 
   const TfLiteEvalTensor* input =
       tflite::micro::GetEvalInput(context, node, kSvdfInputTensor);
@@ -207,18 +350,18 @@ TfLiteStatus EvalSvdfInt8(TfLiteContext* context, TfLiteNode* node) {
   // Because of the TODO mentioned below, the int16 weight data type is not
   // split into a seperate registration.
   // TODO(#523): remove 16-bit code when no longer needed.
-  return EvalIntegerSVDF(context, node, input, weights_feature, weights_time,
-                         bias, params, activation_state, output, data);
+  return EvalIntegerSVDF(context, input, weights_feature, weights_time, bias,
+                         params, activation_state, output, data);
 }
 
 }  // namespace
 
 TfLiteRegistration Register_SVDF() {
-  return tflite::micro::RegisterOp(Init, PrepareSvdf, EvalSvdf);
+  return tflite::micro::RegisterOp(Init, Prepare, EvalSvdf);
 }
 
 TfLiteRegistration Register_SVDF_INT8() {
-  return tflite::micro::RegisterOp(Init, PrepareSvdf, EvalSvdfInt8);
+  return tflite::micro::RegisterOp(Init, Prepare, EvalSvdfInt8);
 }
 
 }  // namespace tflite
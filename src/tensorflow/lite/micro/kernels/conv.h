@@ -37,9 +37,12 @@ struct OpDataConv {
   int32_t output_multiplier;
   int output_shift;
 
-  // Per channel output multiplier and shift.
+  // Per channel output multiplier and shift. They point into the model if
+  // they were precomputed on the host, see
+  // micro::AllocatePerChannelOutputMultipliers().
   int32_t* per_channel_output_multiplier;
   int32_t* per_channel_output_shift;
+  bool per_channel_output_precomputed;
 
   // The range of the fused activation layer. For example for kNone and
   // uint8_t these would be 0 and 255.
@@ -49,6 +52,12 @@ struct OpDataConv {
   // A buffer used to store unpacked filter values. This is used if the source
   // tensor is of n-bit precision that cannot be easily processed by kernels.
   int filter_buffer_index;
+
+  // Filter transformed in Prepare for the Winograd kernels and the index of
+  // their scratch buffer, or nullptr if the direct convolution is used. See
+  // winograd_conv.h.
+  void* winograd_filter;
+  int winograd_scratch_index;
 };
 
 extern const int kConvInputTensor;
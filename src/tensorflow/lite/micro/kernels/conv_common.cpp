@@ -108,17 +108,23 @@ TfLiteStatus CalculateOpDataConv(TfLiteContext* context, TfLiteNode* node,
   if (data_type != kTfLiteFloat32) {
     int output_channels = filter->dims->data[kConvQuantizedDimension];
 
+    // Precomputed per-channel values are read from the model and only need
+    // the checks.
+    const bool precomputed = data->per_channel_output_precomputed;
     TF_LITE_ENSURE_STATUS(tflite::PopulateConvolutionQuantizationParams(
         context, input, filter, bias, output, params.activation,
         &data->output_multiplier, &data->output_shift,
         &data->output_activation_min, &data->output_activation_max,
-        data->per_channel_output_multiplier, data->per_channel_output_shift,
+        precomputed ? nullptr : data->per_channel_output_multiplier,
+        precomputed ? nullptr : data->per_channel_output_shift,
         output_channels));
   }
 
   data->input_zero_point = input->params.zero_point;
   data->filter_zero_point = filter->params.zero_point;
   data->output_zero_point = output->params.zero_point;
+  data->winograd_filter = nullptr;
+  data->winograd_scratch_index = -1;
 
   micro_context->DeallocateTempTfLiteTensor(input);
   micro_context->DeallocateTempTfLiteTensor(filter);
@@ -154,14 +160,12 @@ TfLiteStatus ConvPrepare(TfLiteContext* context, TfLiteNode* node) {
   const int output_width = output->dims->data[2];
   const int output_height = output->dims->data[1];
 
-  // Dynamically allocate per-channel quantization parameters.
+  // Allocate per-channel quantization parameters unless they were
+  // precomputed.
   const int num_channels = filter->dims->data[kConvQuantizedDimension];
-  data->per_channel_output_multiplier =
-      static_cast<int32_t*>(context->AllocatePersistentBuffer(
-          context, num_channels * sizeof(int32_t)));
-  data->per_channel_output_shift =
-      static_cast<int32_t*>(context->AllocatePersistentBuffer(
-          context, num_channels * sizeof(int32_t)));
+  TF_LITE_ENSURE_STATUS(micro::AllocatePerChannelOutputMultipliers(
+      context, node, num_channels, &data->per_channel_output_multiplier,
+      &data->per_channel_output_shift, &data->per_channel_output_precomputed));
 
   // All per-channel quantized tensors need valid zero point and scale arrays.
   if (input->type == kTfLiteInt8 || input->type == kTfLiteInt16) {
@@ -113,11 +113,15 @@ TfLiteStatus CalculateOpDataDepthwiseConv(
   if (data_type != kTfLiteFloat32) {
     int output_channels = filter->dims->data[kDepthwiseConvQuantizedDimension];
 
+    // Precomputed per-channel values are read from the model and only need
+    // the checks.
+    const bool precomputed = data->per_channel_output_precomputed;
     TF_LITE_ENSURE_STATUS(tflite::PopulateConvolutionQuantizationParams(
         context, input, filter, bias, output, params.activation,
         &data->output_multiplier, &data->output_shift,
         &data->output_activation_min, &data->output_activation_max,
-        data->per_channel_output_multiplier, data->per_channel_output_shift,
+        precomputed ? nullptr : data->per_channel_output_multiplier,
+        precomputed ? nullptr : data->per_channel_output_shift,
         output_channels));
   }
 
@@ -159,14 +163,12 @@ TfLiteStatus DepthwiseConvPrepare(TfLiteContext* context, TfLiteNode* node) {
   const int output_width = output->dims->data[2];
   const int output_height = output->dims->data[1];
 
-  // Dynamically allocate per-channel quantization parameters.
+  // Allocate per-channel quantization parameters unless they were
+  // precomputed.
   const int num_channels = filter->dims->data[kDepthwiseConvQuantizedDimension];
-  data->per_channel_output_multiplier =
-      static_cast<int32_t*>(context->AllocatePersistentBuffer(
-          context, num_channels * sizeof(int32_t)));
-  data->per_channel_output_shift =
-      static_cast<int32_t*>(context->AllocatePersistentBuffer(
-          context, num_channels * sizeof(int32_t)));
+  TF_LITE_ENSURE_STATUS(micro::AllocatePerChannelOutputMultipliers(
+      context, node, num_channels, &data->per_channel_output_multiplier,
+      &data->per_channel_output_shift, &data->per_channel_output_precomputed));
 
   // All per-channel quantized tensors need valid zero point and scale arrays.
   if (input->type == kTfLiteInt8) {
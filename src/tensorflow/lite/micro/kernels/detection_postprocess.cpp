@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <numeric>
 #include <tuple>
 
@@ -56,6 +58,13 @@ constexpr int kBatchSize = 1;
 
 constexpr int kNumDetectionsPerClass = 100;
 
+// The quantized fast path compares boxes in Q16 fixed point. Coordinates are
+// clamped to +/-kMaxFixedPointBoxCoordinate so that the 64-bit intersection
+// over union comparison cannot overflow. Box coordinates of SSD style models
+// are normalized to the image size, far inside this range.
+constexpr int kBoxFixedPointBits = 16;
+constexpr float kMaxFixedPointBoxCoordinate = 32.0f;
+
 // Object Detection model produces axis-aligned boxes in two formats:
 // BoxCorner represents the lower left corner (xmin, ymin) and
 // the upper right corner (xmax, ymax).
@@ -88,6 +97,15 @@ static_assert(sizeof(BoxCornerEncoding) == sizeof(float) * kNumCoordBox,
 static_assert(sizeof(CenterSizeEncoding) == sizeof(float) * kNumCoordBox,
               "Size of CenterSizeEncoding is 4 float values");
 
+// BoxCornerEncoding in Q16 fixed point, used for the integer intersection over
+// union computation.
+struct FixedPointBoxCornerEncoding {
+  int32_t ymin;
+  int32_t xmin;
+  int32_t ymax;
+  int32_t xmax;
+};
+
 struct OpData {
   int max_detections;
   int max_classes_per_detection;  // Fast Non-Max-Suppression
@@ -110,6 +128,14 @@ struct OpData {
   int sorted_indices_idx;
   int buffer_idx;
   int selected_idx;
+  int selected_fixed_point_boxes_idx;
+
+  // Precomputed thresholds for the quantized fast path. A class score passes
+  // the score threshold iff its quantized value is at least
+  // quantized_score_threshold. The intersection over union threshold is in
+  // Q16.
+  int32_t quantized_score_threshold;
+  int32_t fixed_point_iou_threshold;
 
   // Cached tensor scale and zero point values for quantized operations
   TfLiteQuantizationParams input_box_encodings;
@@ -149,6 +175,40 @@ void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   return op_data;
 }
 
+class Dequantizer {
+ public:
+  Dequantizer(int zero_point, float scale)
+      : zero_point_(zero_point), scale_(scale) {}
+  explicit Dequantizer(const TfLiteQuantizationParams& params)
+      : zero_point_(params.zero_point), scale_(params.scale) {}
+  float operator()(int32_t x) const {
+    return (static_cast<float>(x) - zero_point_) * scale_;
+  }
+
+ private:
+  int zero_point_;
+  float scale_;
+};
+
+bool IsQuantizedType(TfLiteType type) {
+  return type == kTfLiteUInt8 || type == kTfLiteInt8;
+}
+
+// Returns the smallest quantized value whose dequantized value is at least
+// threshold, or one past the largest value of T if there is none. Dequantizing
+// is monotonic, so comparing quantized scores against this value selects
+// exactly the same candidates as comparing the dequantized scores.
+template <typename T>
+int32_t QuantizeScoreThreshold(float threshold,
+                               const TfLiteQuantizationParams& params) {
+  const Dequantizer dequantize(params);
+  int32_t value = std::numeric_limits<T>::min();
+  for (; value <= std::numeric_limits<T>::max(); ++value) {
+    if (dequantize(value) >= threshold) break;
+  }
+  return value;
+}
+
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   auto* op_data = static_cast<OpData*>(node->user_data);
 
@@ -181,40 +241,91 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   op_data->input_anchors.scale = input_anchors->params.scale;
   op_data->input_anchors.zero_point = input_anchors->params.zero_point;
 
-  // Scratch tensors
-  context->RequestScratchBufferInArena(context, num_boxes,
-                                       &op_data->active_candidate_idx);
-  context->RequestScratchBufferInArena(context,
-                                       num_boxes * kNumCoordBox * sizeof(float),
-                                       &op_data->decoded_boxes_idx);
-  context->RequestScratchBufferInArena(
-      context,
-      input_class_predictions->dims->data[1] *
-          input_class_predictions->dims->data[2] * sizeof(float),
-      &op_data->scores_idx);
-
-  // Additional buffers
-  context->RequestScratchBufferInArena(context, num_boxes * sizeof(float),
-                                       &op_data->score_buffer_idx);
-  context->RequestScratchBufferInArena(context, num_boxes * sizeof(float),
-                                       &op_data->keep_scores_idx);
-  context->RequestScratchBufferInArena(
-      context, op_data->max_detections * num_boxes * sizeof(float),
-      &op_data->scores_after_regular_non_max_suppression_idx);
-  context->RequestScratchBufferInArena(
-      context, op_data->max_detections * num_boxes * sizeof(float),
-      &op_data->sorted_values_idx);
-  context->RequestScratchBufferInArena(context, num_boxes * sizeof(int),
-                                       &op_data->keep_indices_idx);
-  context->RequestScratchBufferInArena(
-      context, op_data->max_detections * num_boxes * sizeof(int),
-      &op_data->sorted_indices_idx);
-  int buffer_size = std::max(num_classes, op_data->max_detections);
-  context->RequestScratchBufferInArena(
-      context, buffer_size * num_boxes * sizeof(int), &op_data->buffer_idx);
-  buffer_size = std::min(num_boxes, op_data->max_detections);
-  context->RequestScratchBufferInArena(
-      context, buffer_size * num_boxes * sizeof(int), &op_data->selected_idx);
+  if (input_class_predictions->type == kTfLiteUInt8) {
+    op_data->quantized_score_threshold = QuantizeScoreThreshold<uint8_t>(
+        op_data->non_max_suppression_score_threshold,
+        op_data->input_class_predictions);
+  } else if (input_class_predictions->type == kTfLiteInt8) {
+    op_data->quantized_score_threshold = QuantizeScoreThreshold<int8_t>(
+        op_data->non_max_suppression_score_threshold,
+        op_data->input_class_predictions);
+  }
+  op_data->fixed_point_iou_threshold = static_cast<int32_t>(
+      std::round(op_data->intersection_over_union_threshold *
+                 static_cast<float>(1 << kBoxFixedPointBits)));
+
+  // Scratch tensors. Buffers that the selected path does not use are not
+  // requested and keep the index -1.
+  op_data->active_candidate_idx = -1;
+  op_data->decoded_boxes_idx = -1;
+  op_data->scores_idx = -1;
+  op_data->score_buffer_idx = -1;
+  op_data->keep_scores_idx = -1;
+  op_data->scores_after_regular_non_max_suppression_idx = -1;
+  op_data->sorted_values_idx = -1;
+  op_data->keep_indices_idx = -1;
+  op_data->sorted_indices_idx = -1;
+  op_data->buffer_idx = -1;
+  op_data->selected_idx = -1;
+  op_data->selected_fixed_point_boxes_idx = -1;
+  const int max_selected = std::min(num_boxes, op_data->max_detections);
+  if (!op_data->use_regular_non_max_suppression &&
+      IsQuantizedType(input_class_predictions->type)) {
+    // NonMaxSuppressionMultiClassFastQuantized() keeps the maximum class score
+    // and the candidate index per anchor, the decoded and fixed point boxes
+    // and the index of every selected anchor and sorts the classes of one
+    // anchor at a time.
+    context->RequestScratchBufferInArena(
+        context, num_boxes * sizeof(int32_t), &op_data->score_buffer_idx);
+    context->RequestScratchBufferInArena(
+        context, num_boxes * sizeof(int), &op_data->keep_indices_idx);
+    context->RequestScratchBufferInArena(
+        context, max_selected * sizeof(BoxCornerEncoding),
+        &op_data->decoded_boxes_idx);
+    context->RequestScratchBufferInArena(
+        context, max_selected * sizeof(int), &op_data->selected_idx);
+    context->RequestScratchBufferInArena(
+        context, max_selected * sizeof(FixedPointBoxCornerEncoding),
+        &op_data->selected_fixed_point_boxes_idx);
+    context->RequestScratchBufferInArena(
+        context, num_classes * sizeof(int), &op_data->buffer_idx);
+  } else {
+    context->RequestScratchBufferInArena(context, num_boxes,
+                                         &op_data->active_candidate_idx);
+    context->RequestScratchBufferInArena(
+        context, num_boxes * kNumCoordBox * sizeof(float),
+        &op_data->decoded_boxes_idx);
+    if (IsQuantizedType(input_class_predictions->type)) {
+      context->RequestScratchBufferInArena(
+          context,
+          input_class_predictions->dims->data[1] *
+              input_class_predictions->dims->data[2] * sizeof(float),
+          &op_data->scores_idx);
+    }
+
+    // Additional buffers
+    context->RequestScratchBufferInArena(context, num_boxes * sizeof(float),
+                                         &op_data->score_buffer_idx);
+    context->RequestScratchBufferInArena(context, num_boxes * sizeof(float),
+                                         &op_data->keep_scores_idx);
+    context->RequestScratchBufferInArena(
+        context, op_data->max_detections * num_boxes * sizeof(float),
+        &op_data->scores_after_regular_non_max_suppression_idx);
+    context->RequestScratchBufferInArena(
+        context, op_data->max_detections * num_boxes * sizeof(float),
+        &op_data->sorted_values_idx);
+    context->RequestScratchBufferInArena(context, num_boxes * sizeof(int),
+                                         &op_data->keep_indices_idx);
+    context->RequestScratchBufferInArena(
+        context, op_data->max_detections * num_boxes * sizeof(int),
+        &op_data->sorted_indices_idx);
+    int buffer_size = std::max(num_classes, op_data->max_detections);
+    context->RequestScratchBufferInArena(
+        context, buffer_size * num_boxes * sizeof(int), &op_data->buffer_idx);
+    context->RequestScratchBufferInArena(
+        context, max_selected * num_boxes * sizeof(int),
+        &op_data->selected_idx);
+  }
 
   // Outputs: detection_boxes, detection_scores, detection_classes,
   // num_detections
@@ -227,19 +338,6 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   return kTfLiteOk;
 }
 
-class Dequantizer {
- public:
-  Dequantizer(int zero_point, float scale)
-      : zero_point_(zero_point), scale_(scale) {}
-  float operator()(uint8_t x) {
-    return (static_cast<float>(x) - zero_point_) * scale_;
-  }
-
- private:
-  int zero_point_;
-  float scale_;
-};
-
 template <class T>
 T ReInterpretTensor(const TfLiteEvalTensor* tensor) {
   const float* tensor_base = tflite::micro::GetTensorData<float>(tensor);
@@ -252,6 +350,87 @@ T ReInterpretTensor(TfLiteEvalTensor* tensor) {
   return reinterpret_cast<T>(tensor_base);
 }
 
+// Reads the CenterSizeEncoding at index idx, dequantizing it if needed.
+template <typename T>
+CenterSizeEncoding ReadCenterSizeEncoding(
+    const TfLiteEvalTensor* tensor, int stride, int idx,
+    const TfLiteQuantizationParams& params) {
+  const T* values = tflite::micro::GetTensorData<T>(tensor) + idx * stride;
+  const Dequantizer dequantize(params);
+  CenterSizeEncoding encoding;
+  encoding.y = dequantize(values[0]);
+  encoding.x = dequantize(values[1]);
+  encoding.h = dequantize(values[2]);
+  encoding.w = dequantize(values[3]);
+  return encoding;
+}
+
+TfLiteStatus GetCenterSizeEncoding(const TfLiteEvalTensor* tensor, int stride,
+                                   int idx,
+                                   const TfLiteQuantizationParams& params,
+                                   CenterSizeEncoding* encoding) {
+  switch (tensor->type) {
+    case kTfLiteFloat32:
+      // Please see DequantizeBoxEncodings function for the support detail.
+      *encoding = *reinterpret_cast<const CenterSizeEncoding*>(
+          tflite::micro::GetTensorData<float>(tensor) + idx * stride);
+      return kTfLiteOk;
+    case kTfLiteUInt8:
+      *encoding = ReadCenterSizeEncoding<uint8_t>(tensor, stride, idx, params);
+      return kTfLiteOk;
+    case kTfLiteInt8:
+      *encoding = ReadCenterSizeEncoding<int8_t>(tensor, stride, idx, params);
+      return kTfLiteOk;
+    default:
+      // Unsupported type.
+      return kTfLiteError;
+  }
+}
+
+// Decodes the box at index idx to (ymin, xmin, ymax, xmax) based on its
+// anchor.
+TfLiteStatus DecodeCenterSizeBox(const TfLiteEvalTensor* input_box_encodings,
+                                 const TfLiteEvalTensor* input_anchors,
+                                 const OpData* op_data, int idx,
+                                 BoxCornerEncoding* box) {
+  CenterSizeEncoding box_centersize;
+  CenterSizeEncoding anchor;
+  TF_LITE_ENSURE_STATUS(GetCenterSizeEncoding(
+      input_box_encodings, input_box_encodings->dims->data[2], idx,
+      op_data->input_box_encodings, &box_centersize));
+  TF_LITE_ENSURE_STATUS(GetCenterSizeEncoding(input_anchors, kNumCoordBox,
+                                              idx, op_data->input_anchors,
+                                              &anchor));
+  const CenterSizeEncoding& scale_values = op_data->scale_values;
+
+  float ycenter = static_cast<float>(static_cast<double>(box_centersize.y) /
+                                         static_cast<double>(scale_values.y) *
+                                         static_cast<double>(anchor.h) +
+                                     static_cast<double>(anchor.y));
+
+  float xcenter = static_cast<float>(static_cast<double>(box_centersize.x) /
+                                         static_cast<double>(scale_values.x) *
+                                         static_cast<double>(anchor.w) +
+                                     static_cast<double>(anchor.x));
+
+  float half_h =
+      static_cast<float>(0.5 *
+                         (std::exp(static_cast<double>(box_centersize.h) /
+                                   static_cast<double>(scale_values.h))) *
+                         static_cast<double>(anchor.h));
+  float half_w =
+      static_cast<float>(0.5 *
+                         (std::exp(static_cast<double>(box_centersize.w) /
+                                   static_cast<double>(scale_values.w))) *
+                         static_cast<double>(anchor.w));
+
+  box->ymin = ycenter - half_h;
+  box->xmin = xcenter - half_w;
+  box->ymax = ycenter + half_h;
+  box->xmax = xcenter + half_w;
+  return kTfLiteOk;
+}
+
 TfLiteStatus DecodeCenterSizeBoxes(TfLiteContext* context, TfLiteNode* node,
                                    OpData* op_data) {
   // Parse input tensor boxencodings
@@ -263,62 +442,18 @@ TfLiteStatus DecodeCenterSizeBoxes(TfLiteContext* context, TfLiteNode* node,
   const TfLiteEvalTensor* input_anchors =
       tflite::micro::GetEvalInput(context, node, kInputTensorAnchors);
 
-  // Decode the boxes to get (ymin, xmin, ymax, xmax) based on the anchors
-  CenterSizeEncoding box_centersize;
-  CenterSizeEncoding scale_values = op_data->scale_values;
-  CenterSizeEncoding anchor;
+  BoxCornerEncoding* decoded_boxes = reinterpret_cast<BoxCornerEncoding*>(
+      context->GetScratchBuffer(context, op_data->decoded_boxes_idx));
   for (int idx = 0; idx < num_boxes; ++idx) {
-    switch (input_box_encodings->type) {
-        // Float
-      case kTfLiteFloat32: {
-        // Please see DequantizeBoxEncodings function for the support detail.
-        const int box_encoding_idx = idx * input_box_encodings->dims->data[2];
-        const float* boxes = &(tflite::micro::GetTensorData<float>(
-            input_box_encodings)[box_encoding_idx]);
-        box_centersize = *reinterpret_cast<const CenterSizeEncoding*>(boxes);
-        anchor =
-            ReInterpretTensor<const CenterSizeEncoding*>(input_anchors)[idx];
-        break;
-      }
-      default:
-        // Unsupported type.
-        return kTfLiteError;
-    }
-
-    float ycenter = static_cast<float>(static_cast<double>(box_centersize.y) /
-                                           static_cast<double>(scale_values.y) *
-                                           static_cast<double>(anchor.h) +
-                                       static_cast<double>(anchor.y));
-
-    float xcenter = static_cast<float>(static_cast<double>(box_centersize.x) /
-                                           static_cast<double>(scale_values.x) *
-                                           static_cast<double>(anchor.w) +
-                                       static_cast<double>(anchor.x));
-
-    float half_h =
-        static_cast<float>(0.5 *
-                           (std::exp(static_cast<double>(box_centersize.h) /
-                                     static_cast<double>(scale_values.h))) *
-                           static_cast<double>(anchor.h));
-    float half_w =
-        static_cast<float>(0.5 *
-                           (std::exp(static_cast<double>(box_centersize.w) /
-                                     static_cast<double>(scale_values.w))) *
-                           static_cast<double>(anchor.w));
-
-    float* decoded_boxes = reinterpret_cast<float*>(
-        context->GetScratchBuffer(context, op_data->decoded_boxes_idx));
-    auto& box = reinterpret_cast<BoxCornerEncoding*>(decoded_boxes)[idx];
-    box.ymin = ycenter - half_h;
-    box.xmin = xcenter - half_w;
-    box.ymax = ycenter + half_h;
-    box.xmax = xcenter + half_w;
+    TF_LITE_ENSURE_STATUS(DecodeCenterSizeBox(
+        input_box_encodings, input_anchors, op_data, idx, &decoded_boxes[idx]));
   }
   return kTfLiteOk;
 }
 
-void DecreasingPartialArgSort(const float* values, int num_values,
-                              int num_to_sort, int* indices) {
+template <typename T>
+void DecreasingPartialArgSort(const T* values, int num_values, int num_to_sort,
+                              int* indices) {
   std::iota(indices, indices + num_values, 0);
   std::partial_sort(indices, indices + num_to_sort, indices + num_values,
                     [&values](const int i, const int j) {
@@ -419,6 +554,47 @@ float ComputeIntersectionOverUnion(const float* decoded_boxes, const int i,
   return intersection_area / (area_i + area_j - intersection_area);
 }
 
+int32_t ToFixedPointBoxCoordinate(float value) {
+  value = std::min(std::max(value, -kMaxFixedPointBoxCoordinate),
+                   kMaxFixedPointBoxCoordinate);
+  return static_cast<int32_t>(
+      std::round(value * static_cast<float>(1 << kBoxFixedPointBits)));
+}
+
+FixedPointBoxCornerEncoding ToFixedPointBox(const BoxCornerEncoding& box) {
+  FixedPointBoxCornerEncoding fixed_point_box;
+  fixed_point_box.ymin = ToFixedPointBoxCoordinate(box.ymin);
+  fixed_point_box.xmin = ToFixedPointBoxCoordinate(box.xmin);
+  fixed_point_box.ymax = ToFixedPointBoxCoordinate(box.ymax);
+  fixed_point_box.xmax = ToFixedPointBoxCoordinate(box.xmax);
+  return fixed_point_box;
+}
+
+// Integer equivalent of
+// ComputeIntersectionOverUnion(...) > intersection_over_union_threshold, with
+// the threshold in Q16. The division is avoided by comparing
+// intersection * 2^16 against threshold * union.
+bool IntersectionOverUnionExceedsThreshold(
+    const FixedPointBoxCornerEncoding& box_i,
+    const FixedPointBoxCornerEncoding& box_j, int32_t threshold) {
+  const int64_t area_i = static_cast<int64_t>(box_i.ymax - box_i.ymin) *
+                         (box_i.xmax - box_i.xmin);
+  const int64_t area_j = static_cast<int64_t>(box_j.ymax - box_j.ymin) *
+                         (box_j.xmax - box_j.xmin);
+  if (area_i <= 0 || area_j <= 0) return false;
+  const int32_t intersection_ymin = std::max(box_i.ymin, box_j.ymin);
+  const int32_t intersection_xmin = std::max(box_i.xmin, box_j.xmin);
+  const int32_t intersection_ymax = std::min(box_i.ymax, box_j.ymax);
+  const int32_t intersection_xmax = std::min(box_i.xmax, box_j.xmax);
+  const int64_t intersection_area =
+      static_cast<int64_t>(
+          std::max(intersection_ymax - intersection_ymin, int32_t{0})) *
+      std::max(intersection_xmax - intersection_xmin, int32_t{0});
+  const int64_t union_area = area_i + area_j - intersection_area;
+  return intersection_area * (int64_t{1} << kBoxFixedPointBits) >
+         static_cast<int64_t>(threshold) * union_area;
+}
+
 // NonMaxSuppressionSingleClass() prunes out the box locations with high overlap
 // before selecting the highest scoring boxes (max_detections in number)
 // It assumes all boxes are good in beginning and sorts based on the scores.
@@ -734,6 +910,179 @@ TfLiteStatus NonMaxSuppressionMultiClassFastHelper(TfLiteContext* context,
   return kTfLiteOk;
 }
 
+// Quantized version of NonMaxSuppressionMultiClassFastHelper(). It produces the
+// same detections as dequantizing the class predictions, decoding all boxes
+// and running the float helper, but does much less work:
+// 1) The per anchor maximum class scores are compared against the score
+// threshold in the quantized domain.
+// 2) Surviving anchors are kept in a max-heap and popped lazily in decreasing
+// score order (ties go to the lower anchor index, as in DecreasingArgSort()).
+// Popping stops as soon as max_detections boxes have been selected.
+// 3) Only popped anchors are decoded, and each is compared only against the
+// boxes selected so far, using an integer intersection over union. The boxes
+// are kept per selected anchor, so the scratch buffers of this path hold at
+// most max_detections boxes instead of one per anchor.
+// Unlike the float path, boxes that are never popped are not validated.
+template <typename T>
+TfLiteStatus NonMaxSuppressionMultiClassFastQuantized(TfLiteContext* context,
+                                                      TfLiteNode* node,
+                                                      OpData* op_data) {
+  const TfLiteEvalTensor* input_box_encodings =
+      tflite::micro::GetEvalInput(context, node, kInputTensorBoxEncodings);
+  const TfLiteEvalTensor* input_class_predictions =
+      tflite::micro::GetEvalInput(context, node, kInputTensorClassPredictions);
+  const TfLiteEvalTensor* input_anchors =
+      tflite::micro::GetEvalInput(context, node, kInputTensorAnchors);
+  TfLiteEvalTensor* detection_boxes =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensorDetectionBoxes);
+  TfLiteEvalTensor* detection_classes = tflite::micro::GetEvalOutput(
+      context, node, kOutputTensorDetectionClasses);
+  TfLiteEvalTensor* detection_scores =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensorDetectionScores);
+  TfLiteEvalTensor* num_detections =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensorNumDetections);
+
+  TF_LITE_ENSURE_EQ(context, input_box_encodings->dims->data[0], kBatchSize);
+  TF_LITE_ENSURE(context, input_box_encodings->dims->data[2] >= kNumCoordBox);
+  const int num_boxes = input_box_encodings->dims->data[1];
+  const int num_classes = op_data->num_classes;
+  const int max_categories_per_anchor = op_data->max_classes_per_detection;
+  const int max_detections = op_data->max_detections;
+
+  TF_LITE_ENSURE_EQ(context, input_class_predictions->dims->data[0],
+                    kBatchSize);
+  TF_LITE_ENSURE_EQ(context, input_class_predictions->dims->data[1], num_boxes);
+  const int num_classes_with_background =
+      input_class_predictions->dims->data[2];
+  TF_LITE_ENSURE(context, (num_classes_with_background - num_classes <= 1));
+  TF_LITE_ENSURE(context, (num_classes_with_background >= num_classes));
+
+  // The row index offset is 1 if background class is included and 0 otherwise.
+  int label_offset = num_classes_with_background - num_classes;
+  TF_LITE_ENSURE(context, (max_categories_per_anchor > 0));
+  TF_LITE_ENSURE(context, (max_detections >= 0));
+  TF_LITE_ENSURE(context,
+                 (op_data->intersection_over_union_threshold > 0.0f) &&
+                     (op_data->intersection_over_union_threshold <= 1.0f));
+  const int num_categories_per_anchor =
+      std::min(max_categories_per_anchor, num_classes);
+
+  const T* scores = tflite::micro::GetTensorData<T>(input_class_predictions);
+  int32_t* max_scores = reinterpret_cast<int32_t*>(
+      context->GetScratchBuffer(context, op_data->score_buffer_idx));
+  int* candidates = reinterpret_cast<int*>(
+      context->GetScratchBuffer(context, op_data->keep_indices_idx));
+
+  int num_candidates = 0;
+  for (int row = 0; row < num_boxes; row++) {
+    const T* box_scores =
+        scores + row * num_classes_with_background + label_offset;
+    const int32_t max_score =
+        *std::max_element(box_scores, box_scores + num_classes);
+    if (max_score >= op_data->quantized_score_threshold) {
+      max_scores[row] = max_score;
+      candidates[num_candidates++] = row;
+    }
+  }
+
+  const auto lower_priority = [max_scores](const int i, const int j) {
+    return max_scores[i] < max_scores[j] ||
+           (max_scores[i] == max_scores[j] && i > j);
+  };
+  std::make_heap(candidates, candidates + num_candidates, lower_priority);
+
+  BoxCornerEncoding* decoded_boxes = reinterpret_cast<BoxCornerEncoding*>(
+      context->GetScratchBuffer(context, op_data->decoded_boxes_idx));
+  int* selected = reinterpret_cast<int*>(
+      context->GetScratchBuffer(context, op_data->selected_idx));
+  FixedPointBoxCornerEncoding* selected_boxes =
+      reinterpret_cast<FixedPointBoxCornerEncoding*>(context->GetScratchBuffer(
+          context, op_data->selected_fixed_point_boxes_idx));
+
+  const int output_size = std::min(num_candidates, max_detections);
+  int selected_size = 0;
+  while (num_candidates > 0 && selected_size < output_size) {
+    std::pop_heap(candidates, candidates + num_candidates, lower_priority);
+    const int anchor_index = candidates[--num_candidates];
+
+    BoxCornerEncoding box;
+    TF_LITE_ENSURE_STATUS(DecodeCenterSizeBox(
+        input_box_encodings, input_anchors, op_data, anchor_index, &box));
+    // ymax>=ymin, xmax>=xmin
+    TF_LITE_ENSURE(context, box.ymin < box.ymax && box.xmin < box.xmax);
+
+    const FixedPointBoxCornerEncoding fixed_point_box = ToFixedPointBox(box);
+    bool suppressed = false;
+    for (int i = 0; i < selected_size; ++i) {
+      if (IntersectionOverUnionExceedsThreshold(
+              selected_boxes[i], fixed_point_box,
+              op_data->fixed_point_iou_threshold)) {
+        suppressed = true;
+        break;
+      }
+    }
+    if (!suppressed) {
+      selected[selected_size] = anchor_index;
+      decoded_boxes[selected_size] = box;
+      selected_boxes[selected_size] = fixed_point_box;
+      selected_size++;
+    }
+  }
+
+  // Allocate output tensors
+  const Dequantizer dequantize(op_data->input_class_predictions);
+  int* class_indices = reinterpret_cast<int*>(
+      context->GetScratchBuffer(context, op_data->buffer_idx));
+  int output_box_index = 0;
+
+  for (int i = 0; i < selected_size; i++) {
+    int selected_index = selected[i];
+
+    const T* box_scores =
+        scores + selected_index * num_classes_with_background + label_offset;
+    DecreasingPartialArgSort(box_scores, num_classes, num_categories_per_anchor,
+                             class_indices);
+
+    for (int col = 0; col < num_categories_per_anchor; ++col) {
+      int box_offset = num_categories_per_anchor * output_box_index + col;
+
+      // detection_boxes
+      ReInterpretTensor<BoxCornerEncoding*>(detection_boxes)[box_offset] =
+          decoded_boxes[i];
+
+      // detection_classes
+      tflite::micro::GetTensorData<float>(detection_classes)[box_offset] =
+          class_indices[col];
+
+      // detection_scores
+      tflite::micro::GetTensorData<float>(detection_scores)[box_offset] =
+          dequantize(box_scores[class_indices[col]]);
+
+      output_box_index++;
+    }
+  }
+
+  tflite::micro::GetTensorData<float>(num_detections)[0] = output_box_index;
+  return kTfLiteOk;
+}
+
+// Dequantizes the class predictions into the scores scratch buffer.
+template <typename T>
+const float* DequantizeClassPredictions(TfLiteContext* context,
+                                        const OpData* op_data,
+                                        const TfLiteEvalTensor* predictions) {
+  const int num_scores =
+      predictions->dims->data[1] * predictions->dims->data[2];
+  const T* quantized = tflite::micro::GetTensorData<T>(predictions);
+  float* scores = reinterpret_cast<float*>(
+      context->GetScratchBuffer(context, op_data->scores_idx));
+  const Dequantizer dequantize(op_data->input_class_predictions);
+  for (int i = 0; i < num_scores; ++i) {
+    scores[i] = dequantize(quantized[i]);
+  }
+  return scores;
+}
+
 TfLiteStatus NonMaxSuppressionMultiClass(TfLiteContext* context,
                                          TfLiteNode* node, OpData* op_data) {
   // Get the input tensors
@@ -758,6 +1107,14 @@ TfLiteStatus NonMaxSuppressionMultiClass(TfLiteContext* context,
     case kTfLiteFloat32:
       scores = tflite::micro::GetTensorData<float>(input_class_predictions);
       break;
+    case kTfLiteUInt8:
+      scores = DequantizeClassPredictions<uint8_t>(context, op_data,
+                                                   input_class_predictions);
+      break;
+    case kTfLiteInt8:
+      scores = DequantizeClassPredictions<int8_t>(context, op_data,
+                                                  input_class_predictions);
+      break;
     default:
       // Unsupported type.
       return kTfLiteError;
@@ -784,6 +1141,25 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   // and do all calculations in float. Mixed quantized/float calculations are
   // currently not supported in TFLite.
 
+  // Quantized class predictions with fast Non Maximal Suppression take a path
+  // that filters and ranks the quantized scores directly and only decodes the
+  // boxes it visits.
+  if (!op_data->use_regular_non_max_suppression) {
+    const TfLiteEvalTensor* input_class_predictions =
+        tflite::micro::GetEvalInput(context, node,
+                                    kInputTensorClassPredictions);
+    switch (input_class_predictions->type) {
+      case kTfLiteUInt8:
+        return NonMaxSuppressionMultiClassFastQuantized<uint8_t>(context, node,
+                                                                 op_data);
+      case kTfLiteInt8:
+        return NonMaxSuppressionMultiClassFastQuantized<int8_t>(context, node,
+                                                                op_data);
+      default:
+        break;
+    }
+  }
+
   // This fills in temporary decoded_boxes
   // by transforming input_box_encodings and input_anchors from
   // CenterSizeEncodings to BoxCornerEncoding
@@ -17,7 +17,9 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/gather_rows.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/micro_log.h"
 #include "tensorflow/lite/micro/micro_utils.h"
 
@@ -28,6 +30,20 @@ constexpr int kInputTensor = 0;
 constexpr int kInputPositions = 1;
 constexpr int kOutputTensor = 0;
 
+struct OpData {
+  // True for axis == 0 and batch_dims == 0, i.e. an embedding lookup that
+  // copies whole rows of the input.
+  bool is_row_gather;
+  int num_rows;
+  int row_bytes;
+  GatherRowCache row_cache;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
+}
+
 template <typename InputT, typename CoordsT = int32_t>
 TfLiteStatus Gather(const TfLiteGatherParams* params,
                     const TfLiteEvalTensor* input,
@@ -159,6 +175,23 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     TF_LITE_ENSURE_EQ(context, input->dims->data[i], coords->dims->data[i]);
   }
 
+  TFLITE_DCHECK(node->user_data != nullptr);
+  OpData* data = static_cast<OpData*>(node->user_data);
+  data->is_row_gather = axis == 0 && batch_dims == 0;
+  if (data->is_row_gather) {
+    size_t type_size;
+    TF_LITE_ENSURE_OK(context, TfLiteTypeSizeOf(input->type, &type_size));
+    data->num_rows = SizeOfDimension(input, 0);
+    data->row_bytes = 0;
+    if (data->num_rows > 0) {
+      data->row_bytes = static_cast<int>(NumElements(input) / data->num_rows *
+                                         type_size);
+    }
+    TF_LITE_ENSURE_OK(context,
+                      GatherRowCacheInit(context, input, data->num_rows,
+                                         data->row_bytes, &data->row_cache));
+  }
+
   // GATHER updates the output tensor dimensions, but TfLiteTensor in the
   // MicroInterpreter is a temporary allocation. We must therefore relocate the
   // dims from the FlatBuffer to the persistant storage arena.
@@ -198,6 +231,17 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TfLiteEvalTensor* output =
       tflite::micro::GetEvalOutput(context, node, kOutputTensor);
 
+  TFLITE_DCHECK(node->user_data != nullptr);
+  OpData* data = static_cast<OpData*>(node->user_data);
+
+  if (data->is_row_gather && coords->type == kTfLiteInt32) {
+    return GatherRows(
+        context, &data->row_cache,
+        static_cast<const uint8_t*>(input->data.data), data->num_rows,
+        data->row_bytes, tflite::micro::GetTensorData<int32_t>(coords),
+        ElementCount(*coords->dims), static_cast<uint8_t*>(output->data.data));
+  }
+
   if (coords->type == kTfLiteInt32) {
     switch (input->type) {
       case kTfLiteFloat32:
@@ -218,7 +262,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 }  // namespace
 
 TfLiteRegistration Register_GATHER() {
-  return tflite::micro::RegisterOp(nullptr, Prepare, Eval);
+  return tflite::micro::RegisterOp(Init, Prepare, Eval);
 }
 
 }  // namespace tflite
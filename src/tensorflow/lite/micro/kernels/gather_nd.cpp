@@ -16,7 +16,9 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/gather_rows.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/micro_log.h"
 #include "tensorflow/lite/micro/micro_utils.h"
 
@@ -28,6 +30,20 @@ constexpr int kIndices = 1;
 constexpr int kOutputTensor = 0;
 constexpr int MAX_INDICES_ND = 5;
 
+struct OpData {
+  // True when each index selects a slice along the first params dimension,
+  // i.e. an embedding lookup that copies whole rows of params.
+  bool is_row_gather;
+  int num_rows;
+  int row_bytes;
+  GatherRowCache row_cache;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
+}
+
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   MicroContext* micro_context = GetMicroContext(context);
 
@@ -86,6 +102,23 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   // Assign to output the input type.
   output->type = params->type;
 
+  TFLITE_DCHECK(node->user_data != nullptr);
+  OpData* data = static_cast<OpData*>(node->user_data);
+  data->is_row_gather = indices_nd == 1;
+  if (data->is_row_gather) {
+    size_t type_size;
+    TF_LITE_ENSURE_OK(context, TfLiteTypeSizeOf(params->type, &type_size));
+    data->num_rows = SizeOfDimension(params, 0);
+    data->row_bytes = 0;
+    if (data->num_rows > 0) {
+      data->row_bytes = static_cast<int>(NumElements(params) / data->num_rows *
+                                         type_size);
+    }
+    TF_LITE_ENSURE_OK(context,
+                      GatherRowCacheInit(context, params, data->num_rows,
+                                         data->row_bytes, &data->row_cache));
+  }
+
   // The tensor output dims must be relocated
   // from the FlatBuffer to the persistant storage arena.
   TfLiteEvalTensor* output_eval =
@@ -193,6 +226,17 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TfLiteEvalTensor* output =
       tflite::micro::GetEvalOutput(context, node, kOutputTensor);
 
+  TFLITE_DCHECK(node->user_data != nullptr);
+  OpData* data = static_cast<OpData*>(node->user_data);
+
+  if (data->is_row_gather && indices->type == kTfLiteInt32) {
+    return GatherRows(
+        context, &data->row_cache,
+        static_cast<const uint8_t*>(params->data.data), data->num_rows,
+        data->row_bytes, tflite::micro::GetTensorData<int32_t>(indices),
+        ElementCount(*indices->dims), static_cast<uint8_t*>(output->data.data));
+  }
+
   switch (indices->type) {
     case kTfLiteInt32:
       return EvalGatherNd<int32_t>(context, params, indices, output);
@@ -206,7 +250,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 }  // namespace
 
 TfLiteRegistration Register_GATHER_ND() {
-  return tflite::micro::RegisterOp(nullptr, Prepare, Eval);
+  return tflite::micro::RegisterOp(Init, Prepare, Eval);
 }
 
 }  // namespace tflite
@@ -0,0 +1,125 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/gather_rows.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+
+namespace tflite {
+
+namespace {
+
+// Caches larger than this are scanned linearly often enough that a miss costs
+// more than the flash read it saves.
+constexpr int kMaxCacheSlots = 32;
+
+// Returns the row to copy for index, loading it into the least recently used
+// slot on a miss.
+const uint8_t* LookupRow(GatherRowCache* cache, const uint8_t* table,
+                         int row_bytes, int32_t index, bool* hit) {
+  uint8_t* rows = cache->rows;
+  int victim = 0;
+  for (int i = 0; i < cache->num_slots; ++i) {
+    if (cache->row_ids[i] == index) {
+      cache->last_used[i] = ++cache->clock;
+      *hit = true;
+      return rows + i * row_bytes;
+    }
+    if (cache->last_used[i] < cache->last_used[victim]) {
+      victim = i;
+    }
+  }
+  *hit = false;
+  uint8_t* slot = rows + victim * row_bytes;
+  std::memcpy(slot, table + index * row_bytes, row_bytes);
+  cache->row_ids[victim] = index;
+  cache->last_used[victim] = ++cache->clock;
+  return slot;
+}
+
+}  // namespace
+
+TfLiteStatus GatherRowCacheInit(TfLiteContext* context,
+                                const TfLiteTensor* table, int num_rows,
+                                int row_bytes, GatherRowCache* cache) {
+  cache->rows = nullptr;
+  cache->row_ids = nullptr;
+  cache->last_used = nullptr;
+  cache->num_slots = 0;
+  cache->clock = 0;
+
+  if (TF_LITE_MICRO_GATHER_ROW_CACHE_BYTES == 0 || row_bytes <= 0 ||
+      !IsConstantTensor(table)) {
+    return kTfLiteOk;
+  }
+  const int num_slots =
+      std::min({TF_LITE_MICRO_GATHER_ROW_CACHE_BYTES / row_bytes,
+                kMaxCacheSlots, num_rows});
+  if (num_slots < 2) {
+    return kTfLiteOk;
+  }
+
+  cache->rows = static_cast<uint8_t*>(
+      context->AllocatePersistentBuffer(context, num_slots * row_bytes));
+  cache->row_ids = static_cast<int32_t*>(
+      context->AllocatePersistentBuffer(context, num_slots * sizeof(int32_t)));
+  cache->last_used = static_cast<uint32_t*>(
+      context->AllocatePersistentBuffer(context, num_slots * sizeof(uint32_t)));
+  TF_LITE_ENSURE(context, cache->rows != nullptr &&
+                              cache->row_ids != nullptr &&
+                              cache->last_used != nullptr);
+  for (int i = 0; i < num_slots; ++i) {
+    cache->row_ids[i] = -1;
+    cache->last_used[i] = 0;
+  }
+  cache->num_slots = num_slots;
+  return kTfLiteOk;
+}
+
+TfLiteStatus GatherRows(TfLiteContext* context, GatherRowCache* cache,
+                        const uint8_t* table, int num_rows, int row_bytes,
+                        const int32_t* indices, int num_indices,
+                        uint8_t* output) {
+  uint32_t hits = 0;
+  for (int i = 0; i < num_indices; ++i) {
+    const int32_t index = indices[i];
+    if (index < 0 || index >= num_rows) {
+      MicroPrintf("Gather index %d out of range [0, %d).", index, num_rows);
+      return kTfLiteError;
+    }
+    const uint8_t* row = table + index * row_bytes;
+    if (cache->num_slots > 0) {
+      bool hit;
+      row = LookupRow(cache, table, row_bytes, index, &hit);
+      hits += hit ? 1 : 0;
+    }
+    std::memcpy(output + i * row_bytes, row, row_bytes);
+  }
+
+  if (cache->num_slots > 0 && context->profiler != nullptr) {
+    MicroProfilerInterface* profiler =
+        reinterpret_cast<MicroProfilerInterface*>(context->profiler);
+    profiler->AddToCounter("GATHER_ROW_CACHE_HIT", hits);
+    profiler->AddToCounter("GATHER_ROW_CACHE_MISS", num_indices - hits);
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
@@ -0,0 +1,64 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_GATHER_ROWS_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_GATHER_ROWS_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+
+// Embedding lookups, i.e. GATHER along axis 0 and GATHER_ND with a single
+// index per slice, copy whole rows of a table that usually lives in flash.
+// GatherRows handles that case with one memcpy per index and validates every
+// index against the table size.
+//
+// Defining TF_LITE_MICRO_GATHER_ROW_CACHE_BYTES to a non-zero value also keeps
+// a small least-recently-used cache of table rows in the persistent arena, so
+// that repeated token ids are served from SRAM. The cache is only used for
+// constant tables. Hits and misses are reported to the profiler through the
+// "GATHER_ROW_CACHE_HIT" and "GATHER_ROW_CACHE_MISS" counters.
+#ifndef TF_LITE_MICRO_GATHER_ROW_CACHE_BYTES
+#define TF_LITE_MICRO_GATHER_ROW_CACHE_BYTES 0
+#endif
+
+namespace tflite {
+
+struct GatherRowCache {
+  uint8_t* rows;
+  int32_t* row_ids;
+  uint32_t* last_used;
+  int num_slots;
+  uint32_t clock;
+};
+
+// Sets up cache for table, which has num_rows rows of row_bytes bytes. The
+// cache is left disabled (num_slots == 0) unless
+// TF_LITE_MICRO_GATHER_ROW_CACHE_BYTES holds at least two rows and table is
+// constant.
+TfLiteStatus GatherRowCacheInit(TfLiteContext* context,
+                                const TfLiteTensor* table, int num_rows,
+                                int row_bytes, GatherRowCache* cache);
+
+// Copies rows indices[0], ..., indices[num_indices - 1] of table, which has
+// num_rows rows of row_bytes bytes, to consecutive rows of output. Returns an
+// error if any index is outside [0, num_rows).
+TfLiteStatus GatherRows(TfLiteContext* context, GatherRowCache* cache,
+                        const uint8_t* table, int num_rows, int row_bytes,
+                        const int32_t* indices, int num_indices,
+                        uint8_t* output);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_GATHER_ROWS_H_
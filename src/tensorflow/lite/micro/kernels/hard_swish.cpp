@@ -32,7 +32,7 @@ namespace tflite {
 namespace {
 void* HardSwishInit(TfLiteContext* context, const char* buffer, size_t length) {
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
-  return context->AllocatePersistentBuffer(context, sizeof(HardSwishParams));
+  return context->AllocatePersistentBuffer(context, sizeof(OpDataHardSwish));
 }
 
 TfLiteStatus HardSwishEval(TfLiteContext* context, TfLiteNode* node) {
@@ -40,7 +40,8 @@ TfLiteStatus HardSwishEval(TfLiteContext* context, TfLiteNode* node) {
       tflite::micro::GetEvalInput(context, node, kHardSwishInputTensor);
   TfLiteEvalTensor* output =
       tflite::micro::GetEvalOutput(context, node, kHardSwishOutputTensor);
-  HardSwishParams* params = static_cast<HardSwishParams*>(node->user_data);
+  const OpDataHardSwish* data =
+      static_cast<const OpDataHardSwish*>(node->user_data);
 
   switch (input->type) {
     case kTfLiteFloat32: {
@@ -51,11 +52,14 @@ TfLiteStatus HardSwishEval(TfLiteContext* context, TfLiteNode* node) {
           tflite::micro::GetTensorData<float>(output));
     } break;
     case kTfLiteInt8: {
-      tflite::reference_ops::HardSwish<int8_t>(
-          *params, tflite::micro::GetTensorShape(input),
-          tflite::micro::GetTensorData<int8_t>(input),
-          tflite::micro::GetTensorShape(output),
-          tflite::micro::GetTensorData<int8_t>(output));
+      const int flat_size = MatchingFlatSize(
+          tflite::micro::GetTensorShape(input),
+          tflite::micro::GetTensorShape(output));
+      const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+      int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+      for (int i = 0; i < flat_size; ++i) {
+        output_data[i] = LUTLookup(input_data[i], data->lut_int8);
+      }
     } break;
     default: {
       MicroPrintf("Unsupported type %s", TfLiteTypeGetName(input->type));
@@ -18,12 +18,20 @@ limitations under the License.
 
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/types.h"
 
 namespace tflite {
 
 extern const int kHardSwishInputTensor;
 extern const int kHardSwishOutputTensor;
 
+struct OpDataHardSwish {
+  HardSwishParams params;
+
+  // Lookup table for the int8 path generated in Prepare, in LUTLookup() order.
+  int8_t* lut_int8;
+};
+
 TfLiteStatus HardSwishPrepare(TfLiteContext* context, TfLiteNode* node);
 }  // namespace tflite
 
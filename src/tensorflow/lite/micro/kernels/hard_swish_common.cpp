@@ -46,7 +46,8 @@ TfLiteStatus HardSwishPrepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE(context, output != nullptr);
 
   if (input->type == kTfLiteInt8) {
-    HardSwishParams* params = static_cast<HardSwishParams*>(node->user_data);
+    OpDataHardSwish* data = static_cast<OpDataHardSwish*>(node->user_data);
+    HardSwishParams* params = &data->params;
 
     params->input_zero_point = input->params.zero_point;
     params->output_zero_point = output->params.zero_point;
@@ -75,6 +76,17 @@ TfLiteStatus HardSwishPrepare(TfLiteContext* context, TfLiteNode* node) {
     DownScaleInt32ToInt16Multiplier(
         reluish_multiplier_fixedpoint_int32,
         &params->reluish_multiplier_fixedpoint_int16);
+
+    // Tabulate the reference kernel over all 256 inputs.
+    data->lut_int8 = static_cast<int8_t*>(context->AllocatePersistentBuffer(
+        context, LUTSize<int8_t>() * sizeof(int8_t)));
+    TF_LITE_ENSURE(context, data->lut_int8 != nullptr);
+    for (int i = 0; i < LUTSize<int8_t>(); ++i) {
+      data->lut_int8[i] = static_cast<int8_t>(i);
+    }
+    const RuntimeShape lut_shape({LUTSize<int8_t>()});
+    reference_ops::HardSwish<int8_t>(*params, lut_shape, data->lut_int8,
+                                     lut_shape, data->lut_int8);
   }
 
   micro_context->DeallocateTempTfLiteTensor(input);
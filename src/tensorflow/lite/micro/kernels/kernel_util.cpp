@@ -276,5 +276,34 @@ TfLiteEvalTensor MakeUnpackedInt4Tensor(TfLiteContext* context,
   return new_tensor;
 }
 
+TfLiteStatus AllocatePerChannelOutputMultipliers(TfLiteContext* context,
+                                                 const TfLiteNode* node,
+                                                 int num_channels,
+                                                 int32_t** multiplier,
+                                                 int32_t** shift,
+                                                 bool* precomputed) {
+  const OutputMultipliers* output_multipliers =
+      GetMicroContext(context)->GetOutputMultipliers(node);
+  if (output_multipliers != nullptr) {
+    TF_LITE_ENSURE_MSG(context,
+                       output_multipliers->num_channels == num_channels,
+                       "Precomputed output multipliers do not match the "
+                       "number of channels.");
+    // Kernels only read the values, which live in flash.
+    *multiplier = const_cast<int32_t*>(output_multipliers->multipliers);
+    *shift = const_cast<int32_t*>(output_multipliers->shifts);
+    *precomputed = true;
+    return kTfLiteOk;
+  }
+
+  *multiplier = static_cast<int32_t*>(context->AllocatePersistentBuffer(
+      context, num_channels * sizeof(int32_t)));
+  *shift = static_cast<int32_t*>(context->AllocatePersistentBuffer(
+      context, num_channels * sizeof(int32_t)));
+  TF_LITE_ENSURE(context, *multiplier != nullptr && *shift != nullptr);
+  *precomputed = false;
+  return kTfLiteOk;
+}
+
 }  // namespace micro
 }  // namespace tflite
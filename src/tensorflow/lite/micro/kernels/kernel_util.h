@@ -139,6 +139,18 @@ TfLiteStatus CopySubgraphOutputsToOpOutputs(TfLiteContext* context,
 TfLiteEvalTensor MakeUnpackedInt4Tensor(TfLiteContext* context,
                                         int scratch_buffer_index,
                                         const TfLiteEvalTensor* tensor);
+
+// Sets multiplier and shift to the num_channels per-channel output multipliers
+// and shifts of a node. If they were precomputed on the host, see
+// micro_output_multipliers.h, they point into the model and precomputed is set
+// to true. Otherwise they are allocated in the persistent arena for the kernel
+// to compute. Must be called from Prepare.
+TfLiteStatus AllocatePerChannelOutputMultipliers(TfLiteContext* context,
+                                                 const TfLiteNode* node,
+                                                 int num_channels,
+                                                 int32_t** multiplier,
+                                                 int32_t** shift,
+                                                 bool* precomputed);
 }  // namespace micro
 }  // namespace tflite
 
@@ -62,11 +62,21 @@ TfLiteStatus LogisticEval(TfLiteContext* context, TfLiteNode* node) {
   } else if (input->type == kTfLiteInt16) {
     switch (output->type) {
       case kTfLiteInt16: {
-        reference_integer_ops::Logistic(
-            data->input_multiplier, data->input_left_shift,
-            NumElements(input->dims),
-            tflite::micro::GetTensorData<int16_t>(input),
-            tflite::micro::GetTensorData<int16_t>(output));
+        if (data->lut_int16 == nullptr) {
+          reference_integer_ops::Logistic(
+              data->input_multiplier, data->input_left_shift,
+              NumElements(input->dims),
+              tflite::micro::GetTensorData<int16_t>(input),
+              tflite::micro::GetTensorData<int16_t>(output));
+          return kTfLiteOk;
+        }
+        const int flat_size = NumElements(input->dims);
+        const int16_t* input_data =
+            tflite::micro::GetTensorData<int16_t>(input);
+        int16_t* output_data = tflite::micro::GetTensorData<int16_t>(output);
+        for (int i = 0; i < flat_size; ++i) {
+          output_data[i] = LUTLookup(input_data[i], data->lut_int16);
+        }
         return kTfLiteOk;
       }
       default:
@@ -78,12 +88,12 @@ TfLiteStatus LogisticEval(TfLiteContext* context, TfLiteNode* node) {
   } else if (input->type == kTfLiteInt8) {
     switch (output->type) {
       case kTfLiteInt8: {
-        reference_integer_ops::Logistic(
-            data->input_zero_point, data->input_range_radius,
-            data->input_multiplier, data->input_left_shift,
-            NumElements(input->dims),
-            tflite::micro::GetTensorData<int8_t>(input),
-            tflite::micro::GetTensorData<int8_t>(output));
+        const int flat_size = NumElements(input->dims);
+        const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+        int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+        for (int i = 0; i < flat_size; ++i) {
+          output_data[i] = LUTLookup(input_data[i], data->lut_int8);
+        }
         return kTfLiteOk;
       }
       default:
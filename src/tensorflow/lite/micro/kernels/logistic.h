@@ -30,6 +30,12 @@ struct OpDataLogistic {
   int32_t input_range_radius;
   int32_t input_multiplier;
   int input_left_shift;
+
+  // Lookup tables generated in Prepare, see LUTSize() for their length.
+  // lut_int16 is nullptr unless TF_LITE_MICRO_INT16_ACTIVATION_LUT is
+  // defined, see LUTLookup() for why.
+  int8_t* lut_int8;
+  int16_t* lut_int16;
 };
 
 TfLiteStatus CalculateArithmeticOpDataLogistic(TfLiteContext* context,
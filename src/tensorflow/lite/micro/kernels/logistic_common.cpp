@@ -58,6 +58,20 @@ TfLiteStatus CalculateArithmeticOpDataLogistic(TfLiteContext* context,
 
     data->input_range_radius =
         CalculateInputRadius(kInputIntegerBits, data->input_left_shift, 31);
+
+    // The int8 function only has 256 possible inputs, so tabulate the
+    // reference kernel once. The table is in LUTLookup() order, i.e. indexed
+    // by the input reinterpreted as uint8_t.
+    data->lut_int8 = static_cast<int8_t*>(context->AllocatePersistentBuffer(
+        context, LUTSize<int8_t>() * sizeof(int8_t)));
+    TF_LITE_ENSURE(context, data->lut_int8 != nullptr);
+    for (int i = 0; i < LUTSize<int8_t>(); ++i) {
+      data->lut_int8[i] = static_cast<int8_t>(i);
+    }
+    reference_integer_ops::Logistic(
+        data->input_zero_point, data->input_range_radius,
+        data->input_multiplier, data->input_left_shift, LUTSize<int8_t>(),
+        data->lut_int8, data->lut_int8);
   }
 
   if (input->type == kTfLiteInt16) {
@@ -102,6 +116,18 @@ TfLiteStatus CalculateArithmeticOpDataLogistic(TfLiteContext* context,
         context, CheckedLog2(output->params.scale, &output_scale_log2_rounded));
     TF_LITE_ENSURE_EQ(context, output_scale_log2_rounded,
                       -kOutputFractionalBits);
+
+    data->lut_int16 = nullptr;
+#if defined(TF_LITE_MICRO_INT16_ACTIVATION_LUT)
+    data->lut_int16 = static_cast<int16_t*>(context->AllocatePersistentBuffer(
+        context, LUTSize<int16_t>() * sizeof(int16_t)));
+    TF_LITE_ENSURE(context, data->lut_int16 != nullptr);
+    LUTPopulate<int16_t>(
+        input->params.scale, input->params.zero_point, output->params.scale,
+        output->params.zero_point,
+        [](float value) { return 1.0f / (1.0f + std::exp(-value)); },
+        data->lut_int16);
+#endif
   }
 
   micro_context->DeallocateTempTfLiteTensor(input);
@@ -37,6 +37,7 @@ TfLiteRegistration Register_ARG_MAX();
 TfLiteRegistration Register_ARG_MIN();
 TfLiteRegistration Register_ASSIGN_VARIABLE();
 TfLiteRegistration Register_AVERAGE_POOL_2D();
+TfLiteRegistration Register_BATCH_MATMUL();
 TfLiteRegistration Register_BATCH_TO_SPACE_ND();
 TfLiteRegistration Register_BROADCAST_ARGS();
 TfLiteRegistration Register_BROADCAST_TO();
@@ -0,0 +1,315 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/simd_float.h"
+
+#if defined(TF_LITE_MICRO_SIMD_FLOAT_ENABLED)
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "tensorflow/lite/kernels/internal/common.h"
+
+namespace tflite {
+namespace simd_float {
+namespace {
+
+constexpr int kLanes = TF_LITE_MICRO_SIMD_FLOAT_WIDTH;
+
+typedef float FloatVector __attribute__((vector_size(kLanes * sizeof(float))));
+
+// Tensor data is only guaranteed to be float aligned, so vectors are moved in
+// and out with memcpy, which compilers lower to unaligned vector loads/stores.
+inline FloatVector LoadVector(const float* data) {
+  FloatVector vector;
+  std::memcpy(&vector, data, sizeof(vector));
+  return vector;
+}
+
+inline void StoreVector(float* data, FloatVector vector) {
+  std::memcpy(data, &vector, sizeof(vector));
+}
+
+inline float HorizontalSum(FloatVector vector) {
+  float sum = 0.f;
+  for (int i = 0; i < kLanes; ++i) {
+    sum += vector[i];
+  }
+  return sum;
+}
+
+inline float DotProduct(const float* a, const float* b, int size) {
+  FloatVector acc = {};
+  int i = 0;
+  for (; i <= size - kLanes; i += kLanes) {
+    acc += LoadVector(a + i) * LoadVector(b + i);
+  }
+  float sum = HorizontalSum(acc);
+  for (; i < size; ++i) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+}  // namespace
+
+void Conv(const ConvParams& params, const RuntimeShape& input_shape,
+          const float* input_data, const RuntimeShape& filter_shape,
+          const float* filter_data, const RuntimeShape& bias_shape,
+          const float* bias_data, const RuntimeShape& output_shape,
+          float* output_data) {
+  const int stride_width = params.stride_width;
+  const int stride_height = params.stride_height;
+  const int dilation_width_factor = params.dilation_width_factor;
+  const int dilation_height_factor = params.dilation_height_factor;
+  const int pad_width = params.padding_values.width;
+  const int pad_height = params.padding_values.height;
+  const float output_activation_min = params.float_activation_min;
+  const float output_activation_max = params.float_activation_max;
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(filter_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_depth = input_shape.Dims(3);
+  const int output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
+  if (bias_data) {
+    TFLITE_DCHECK_EQ(bias_shape.FlatSize(), output_depth);
+  }
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int filter_height = filter_shape.Dims(1);
+  const int filter_width = filter_shape.Dims(2);
+  const int filter_input_depth = filter_shape.Dims(3);
+  const int groups = input_depth / filter_input_depth;
+  TFLITE_DCHECK_EQ(input_depth % filter_input_depth, 0);
+  const int filters_per_group = output_depth / groups;
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const int in_y_origin = (out_y * stride_height) - pad_height;
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin = (out_x * stride_width) - pad_width;
+        float* output_pixel =
+            &output_data[Offset(output_shape, batch, out_y, out_x, 0)];
+        for (int out_channel = 0; out_channel < output_depth; ++out_channel) {
+          const int group = out_channel / filters_per_group;
+          float total = 0.f;
+          for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+            const int in_y = in_y_origin + dilation_height_factor * filter_y;
+            if (in_y < 0 || in_y >= input_height) {
+              continue;
+            }
+            for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
+              const int in_x = in_x_origin + dilation_width_factor * filter_x;
+              // Zero padding by omitting the areas outside the image.
+              if (in_x < 0 || in_x >= input_width) {
+                continue;
+              }
+              total += DotProduct(
+                  &input_data[Offset(input_shape, batch, in_y, in_x,
+                                     group * filter_input_depth)],
+                  &filter_data[Offset(filter_shape, out_channel, filter_y,
+                                      filter_x, 0)],
+                  filter_input_depth);
+            }
+          }
+          const float bias_value = bias_data ? bias_data[out_channel] : 0.0f;
+          output_pixel[out_channel] = ActivationFunctionWithMinMax(
+              total + bias_value, output_activation_min, output_activation_max);
+        }
+      }
+    }
+  }
+}
+
+void DepthwiseConv(const DepthwiseParams& params,
+                   const RuntimeShape& input_shape, const float* input_data,
+                   const RuntimeShape& filter_shape, const float* filter_data,
+                   const RuntimeShape& bias_shape, const float* bias_data,
+                   const RuntimeShape& output_shape, float* output_data) {
+  // Only the depth_multiplier == 1 case has channels that are contiguous in
+  // the input, filter and output at the same time.
+  if (params.depth_multiplier != 1) {
+    reference_ops::DepthwiseConv(params, input_shape, input_data,
+                                 filter_shape, filter_data, bias_shape,
+                                 bias_data, output_shape, output_data);
+    return;
+  }
+
+  const int stride_width = params.stride_width;
+  const int stride_height = params.stride_height;
+  const int dilation_width_factor = params.dilation_width_factor;
+  const int dilation_height_factor = params.dilation_height_factor;
+  const int pad_width = params.padding_values.width;
+  const int pad_height = params.padding_values.height;
+  const float output_activation_min = params.float_activation_min;
+  const float output_activation_max = params.float_activation_max;
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(filter_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int depth = MatchingDim(filter_shape, 3, output_shape, 3);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int filter_height = filter_shape.Dims(1);
+  const int filter_width = filter_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  TFLITE_DCHECK_EQ(depth, input_shape.Dims(3));
+
+  for (int b = 0; b < batches; ++b) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const int in_y_origin = (out_y * stride_height) - pad_height;
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin = (out_x * stride_width) - pad_width;
+        float* output_pixel =
+            &output_data[Offset(output_shape, b, out_y, out_x, 0)];
+        // Accumulate whole vectors of channels, then the remaining channels
+        // one at a time.
+        int channel = 0;
+        for (; channel <= depth - kLanes; channel += kLanes) {
+          FloatVector acc = {};
+          for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+            const int in_y = in_y_origin + dilation_height_factor * filter_y;
+            if (in_y < 0 || in_y >= input_height) {
+              continue;
+            }
+            for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
+              const int in_x = in_x_origin + dilation_width_factor * filter_x;
+              if (in_x < 0 || in_x >= input_width) {
+                continue;
+              }
+              acc += LoadVector(&input_data[Offset(input_shape, b, in_y, in_x,
+                                                   channel)]) *
+                     LoadVector(&filter_data[Offset(filter_shape, 0, filter_y,
+                                                    filter_x, channel)]);
+            }
+          }
+          if (bias_data) {
+            acc += LoadVector(&bias_data[channel]);
+          }
+          StoreVector(&output_pixel[channel], acc);
+        }
+        for (; channel < depth; ++channel) {
+          float total = 0.f;
+          for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+            const int in_y = in_y_origin + dilation_height_factor * filter_y;
+            if (in_y < 0 || in_y >= input_height) {
+              continue;
+            }
+            for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
+              const int in_x = in_x_origin + dilation_width_factor * filter_x;
+              if (in_x < 0 || in_x >= input_width) {
+                continue;
+              }
+              total +=
+                  input_data[Offset(input_shape, b, in_y, in_x, channel)] *
+                  filter_data[Offset(filter_shape, 0, filter_y, filter_x,
+                                     channel)];
+            }
+          }
+          output_pixel[channel] =
+              total + (bias_data ? bias_data[channel] : 0.f);
+        }
+        for (channel = 0; channel < depth; ++channel) {
+          output_pixel[channel] = ActivationFunctionWithMinMax(
+              output_pixel[channel], output_activation_min,
+              output_activation_max);
+        }
+      }
+    }
+  }
+}
+
+void FullyConnected(const FullyConnectedParams& params,
+                    const RuntimeShape& input_shape, const float* input_data,
+                    const RuntimeShape& weights_shape,
+                    const float* weights_data, const RuntimeShape& bias_shape,
+                    const float* bias_data, const RuntimeShape& output_shape,
+                    float* output_data) {
+  const float output_activation_min = params.float_activation_min;
+  const float output_activation_max = params.float_activation_max;
+  const int output_dims_count = output_shape.DimensionsCount();
+  const int weights_dims_count = weights_shape.DimensionsCount();
+  const int batches = FlatSizeSkipDim(output_shape, output_dims_count - 1);
+  const int output_depth = MatchingDim(weights_shape, weights_dims_count - 2,
+                                       output_shape, output_dims_count - 1);
+  const int accum_depth = weights_shape.Dims(weights_dims_count - 1);
+  for (int b = 0; b < batches; ++b) {
+    const float* input_row = input_data + b * accum_depth;
+    for (int out_c = 0; out_c < output_depth; ++out_c) {
+      const float total = DotProduct(
+          input_row, weights_data + out_c * accum_depth, accum_depth);
+      const float bias_value = bias_data ? bias_data[out_c] : 0.0f;
+      output_data[out_c + output_depth * b] = ActivationFunctionWithMinMax(
+          total + bias_value, output_activation_min, output_activation_max);
+    }
+  }
+}
+
+void Softmax(const SoftmaxParams& params, const RuntimeShape& input_shape,
+             const float* input_data, const RuntimeShape& output_shape,
+             float* output_data) {
+  const int trailing_dim = input_shape.DimensionsCount() - 1;
+  const int outer_size =
+      MatchingFlatSizeSkipDim(input_shape, trailing_dim, output_shape);
+  const int depth =
+      MatchingDim(input_shape, trailing_dim, output_shape, trailing_dim);
+  const float beta = static_cast<float>(params.beta);
+
+  for (int i = 0; i < outer_size; ++i) {
+    const float* input_row = input_data + i * depth;
+    float* output_row = output_data + i * depth;
+
+    float max = std::numeric_limits<float>::lowest();
+    for (int c = 0; c < depth; ++c) {
+      max = std::max(max, input_row[c]);
+    }
+
+    // exp() has no portable vector form, so only the reductions and the
+    // normalization are vectorized.
+    for (int c = 0; c < depth; ++c) {
+      output_row[c] = std::exp((input_row[c] - max) * beta);
+    }
+    FloatVector sum_vector = {};
+    int c = 0;
+    for (; c <= depth - kLanes; c += kLanes) {
+      sum_vector += LoadVector(&output_row[c]);
+    }
+    float sum = HorizontalSum(sum_vector);
+    for (; c < depth; ++c) {
+      sum += output_row[c];
+    }
+
+    const float reciprocal_sum = 1.f / sum;
+    for (c = 0; c <= depth - kLanes; c += kLanes) {
+      StoreVector(&output_row[c], LoadVector(&output_row[c]) * reciprocal_sum);
+    }
+    for (; c < depth; ++c) {
+      output_row[c] *= reciprocal_sum;
+    }
+  }
+}
+
+}  // namespace simd_float
+}  // namespace tflite
+
+#endif  // defined(TF_LITE_MICRO_SIMD_FLOAT_ENABLED)
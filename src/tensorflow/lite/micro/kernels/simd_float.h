@@ -0,0 +1,119 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_SIMD_FLOAT_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_SIMD_FLOAT_H_
+
+#include "tensorflow/lite/kernels/internal/reference/conv.h"
+#include "tensorflow/lite/kernels/internal/reference/depthwiseconv_float.h"
+#include "tensorflow/lite/kernels/internal/reference/fully_connected.h"
+#include "tensorflow/lite/kernels/internal/reference/softmax.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+
+// Portable vectorized float kernels written with the GCC/Clang vector
+// extensions, so the same source compiles to SSE/AVX on x86, NEON on
+// Cortex-A and Helium on Cortex-M55, and to unrolled scalar FPU code on cores
+// without a vector unit such as the Cortex-M7.
+//
+// The backend is selected at build time by defining TF_LITE_MICRO_SIMD_FLOAT.
+// TF_LITE_MICRO_SIMD_FLOAT_WIDTH optionally sets the number of float lanes
+// (default 4). Without TF_LITE_MICRO_SIMD_FLOAT, or with a compiler that does
+// not support vector extensions, the functions below forward to
+// reference_ops. Results differ from reference_ops only by the reordering of
+// the floating point accumulations.
+#if defined(TF_LITE_MICRO_SIMD_FLOAT) && defined(__GNUC__)
+#define TF_LITE_MICRO_SIMD_FLOAT_ENABLED
+#ifndef TF_LITE_MICRO_SIMD_FLOAT_WIDTH
+#define TF_LITE_MICRO_SIMD_FLOAT_WIDTH 4
+#endif
+#endif
+
+namespace tflite {
+namespace simd_float {
+
+#if defined(TF_LITE_MICRO_SIMD_FLOAT_ENABLED)
+
+void Conv(const ConvParams& params, const RuntimeShape& input_shape,
+          const float* input_data, const RuntimeShape& filter_shape,
+          const float* filter_data, const RuntimeShape& bias_shape,
+          const float* bias_data, const RuntimeShape& output_shape,
+          float* output_data);
+
+void DepthwiseConv(const DepthwiseParams& params,
+                   const RuntimeShape& input_shape, const float* input_data,
+                   const RuntimeShape& filter_shape, const float* filter_data,
+                   const RuntimeShape& bias_shape, const float* bias_data,
+                   const RuntimeShape& output_shape, float* output_data);
+
+void FullyConnected(const FullyConnectedParams& params,
+                    const RuntimeShape& input_shape, const float* input_data,
+                    const RuntimeShape& weights_shape,
+                    const float* weights_data, const RuntimeShape& bias_shape,
+                    const float* bias_data, const RuntimeShape& output_shape,
+                    float* output_data);
+
+void Softmax(const SoftmaxParams& params, const RuntimeShape& input_shape,
+             const float* input_data, const RuntimeShape& output_shape,
+             float* output_data);
+
+#else
+
+inline void Conv(const ConvParams& params, const RuntimeShape& input_shape,
+                 const float* input_data, const RuntimeShape& filter_shape,
+                 const float* filter_data, const RuntimeShape& bias_shape,
+                 const float* bias_data, const RuntimeShape& output_shape,
+                 float* output_data) {
+  reference_ops::Conv(params, input_shape, input_data, filter_shape,
+                      filter_data, bias_shape, bias_data, output_shape,
+                      output_data, RuntimeShape(), nullptr);
+}
+
+inline void DepthwiseConv(const DepthwiseParams& params,
+                          const RuntimeShape& input_shape,
+                          const float* input_data,
+                          const RuntimeShape& filter_shape,
+                          const float* filter_data,
+                          const RuntimeShape& bias_shape,
+                          const float* bias_data,
+                          const RuntimeShape& output_shape,
+                          float* output_data) {
+  reference_ops::DepthwiseConv(params, input_shape, input_data, filter_shape,
+                               filter_data, bias_shape, bias_data,
+                               output_shape, output_data);
+}
+
+inline void FullyConnected(
+    const FullyConnectedParams& params, const RuntimeShape& input_shape,
+    const float* input_data, const RuntimeShape& weights_shape,
+    const float* weights_data, const RuntimeShape& bias_shape,
+    const float* bias_data, const RuntimeShape& output_shape,
+    float* output_data) {
+  reference_ops::FullyConnected(params, input_shape, input_data, weights_shape,
+                                weights_data, bias_shape, bias_data,
+                                output_shape, output_data);
+}
+
+inline void Softmax(const SoftmaxParams& params,
+                    const RuntimeShape& input_shape, const float* input_data,
+                    const RuntimeShape& output_shape, float* output_data) {
+  reference_ops::Softmax(params, input_shape, input_data, output_shape,
+                         output_data);
+}
+
+#endif  // defined(TF_LITE_MICRO_SIMD_FLOAT_ENABLED)
+
+}  // namespace simd_float
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_SIMD_FLOAT_H_
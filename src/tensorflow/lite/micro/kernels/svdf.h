@@ -34,6 +34,18 @@ struct OpDataSvdf {
   int input_zero_point;
   int output_zero_point;
   int activation_state_zero_point;
+
+  // The activation state is a ring buffer along the memory dimension instead
+  // of being shifted by one column on every invoke. Each of the
+  // batch_size * num_filters rows of memory_size values holds its newest
+  // activation at column activation_state_head; the older ones precede it
+  // cyclically, so the oldest is at (activation_state_head + 1) % memory_size.
+  int activation_state_head;
+
+  // Bias of the feature matmul with the input zero point folded in, i.e.
+  // -input_zero_point * sum(weights_feature[f][:]). Only set by the CMSIS-NN
+  // kernel for int8 activation states; nullptr otherwise.
+  int32_t* feature_bias;
 };
 
 // Input tensors.
@@ -47,6 +59,33 @@ extern const int kSvdfInputActivationStateTensor;
 // Output tensor.
 extern const int kSvdfOutputTensor;
 
+// Moves the activation state ring forward by one step and returns the column
+// that receives this invoke's activations.
+inline int AdvanceSvdfStateHead(OpDataSvdf* data, int memory_size) {
+  data->activation_state_head =
+      (data->activation_state_head + 1) % memory_size;
+  return data->activation_state_head;
+}
+
+// Returns the dot product of a row of the time weights, ordered from the oldest
+// to the newest activation, with the ring ordered row of the activation state
+// whose oldest value is at column oldest. The state is read as the two
+// contiguous segments [oldest, memory_size) and [0, oldest).
+template <typename AccT, typename WeightT, typename StateT>
+inline AccT SvdfTimeDotProduct(const WeightT* weights, const StateT* state,
+                               int memory_size, int oldest,
+                               AccT state_zero_point) {
+  AccT sum = 0;
+  const int first_segment = memory_size - oldest;
+  for (int j = 0; j < first_segment; ++j) {
+    sum += weights[j] * (state[oldest + j] - state_zero_point);
+  }
+  for (int j = 0; j < oldest; ++j) {
+    sum += weights[first_segment + j] * (state[j] - state_zero_point);
+  }
+  return sum;
+}
+
 void EvalInt8SvdfReference(TfLiteContext* context, TfLiteNode* node,
                            const TfLiteEvalTensor* input_tensor,
                            const TfLiteEvalTensor* weights_feature_tensor,
@@ -54,8 +93,7 @@ void EvalInt8SvdfReference(TfLiteContext* context, TfLiteNode* node,
                            const TfLiteEvalTensor* bias_tensor,
                            const TfLiteSVDFParams* params,
                            TfLiteEvalTensor* activation_state_tensor,
-                           TfLiteEvalTensor* output_tensor,
-                           const OpDataSvdf& data);
+                           TfLiteEvalTensor* output_tensor, OpDataSvdf* data);
 
 // TODO(#523): remove 16-bit code when no longer needed.
 void EvalInt16SvdfReference(TfLiteContext* context, TfLiteNode* node,
@@ -66,14 +104,14 @@ void EvalInt16SvdfReference(TfLiteContext* context, TfLiteNode* node,
                             const TfLiteSVDFParams* params,
                             TfLiteEvalTensor* activation_state_tensor,
                             TfLiteEvalTensor* output_tensor,
-                            const OpDataSvdf& data);
+                            OpDataSvdf* data);
 
 void EvalFloatSvdfReference(
     TfLiteContext* context, TfLiteNode* node, const TfLiteEvalTensor* input,
     const TfLiteEvalTensor* weights_feature,
     const TfLiteEvalTensor* weights_time, const TfLiteEvalTensor* bias,
-    const TfLiteSVDFParams* params, int scratch_tensor_index,
-    TfLiteEvalTensor* activation_state, TfLiteEvalTensor* output);
+    const TfLiteSVDFParams* params, TfLiteEvalTensor* activation_state,
+    TfLiteEvalTensor* output, OpDataSvdf* data);
 
 TfLiteStatus PrepareSvdf(TfLiteContext* context, TfLiteNode* node);
 
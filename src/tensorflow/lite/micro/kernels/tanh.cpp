@@ -39,6 +39,12 @@ struct OpData {
   int32_t input_range_radius;
   int32_t input_multiplier;
   int input_left_shift;
+
+  // Lookup tables generated in Prepare, see LUTSize() for their length.
+  // lut_int16 is nullptr unless TF_LITE_MICRO_INT16_ACTIVATION_LUT is
+  // defined, see LUTLookup() for why.
+  int8_t* lut_int8;
+  int16_t* lut_int16;
 };
 
 void* TanhInit(TfLiteContext* context, const char* buffer, size_t length) {
@@ -71,6 +77,21 @@ TfLiteStatus CalculateArithmeticOpData(TfLiteContext* context, TfLiteNode* node,
 
     data->input_range_radius =
         CalculateInputRadius(kInputIntegerBits, data->input_left_shift, 31);
+
+    // Tabulate the reference kernel over all 256 inputs, in LUTLookup()
+    // order.
+    data->lut_int8 = static_cast<int8_t*>(context->AllocatePersistentBuffer(
+        context, LUTSize<int8_t>() * sizeof(int8_t)));
+    TF_LITE_ENSURE(context, data->lut_int8 != nullptr);
+    for (int i = 0; i < LUTSize<int8_t>(); ++i) {
+      data->lut_int8[i] = static_cast<int8_t>(i);
+    }
+    const RuntimeShape lut_shape({LUTSize<int8_t>()});
+    reference_integer_ops::Tanh(data->input_zero_point,
+                                data->input_range_radius,
+                                data->input_multiplier, data->input_left_shift,
+                                lut_shape, data->lut_int8, lut_shape,
+                                data->lut_int8);
   }
 
   if (input->type == kTfLiteInt16) {
@@ -124,6 +145,17 @@ TfLiteStatus CalculateArithmeticOpData(TfLiteContext* context, TfLiteNode* node,
         context, CheckedLog2(output->params.scale, &output_scale_log2_rounded));
     TF_LITE_ENSURE_EQ(context, output_scale_log2_rounded,
                       -kOutputFractionalBits);
+
+    data->lut_int16 = nullptr;
+#if defined(TF_LITE_MICRO_INT16_ACTIVATION_LUT)
+    data->lut_int16 = static_cast<int16_t*>(context->AllocatePersistentBuffer(
+        context, LUTSize<int16_t>() * sizeof(int16_t)));
+    TF_LITE_ENSURE(context, data->lut_int16 != nullptr);
+    LUTPopulate<int16_t>(
+        input->params.scale, input->params.zero_point, output->params.scale,
+        output->params.zero_point,
+        [](float value) { return std::tanh(value); }, data->lut_int16);
+#endif
   }
 
   micro_context->DeallocateTempTfLiteTensor(input);
@@ -165,21 +197,34 @@ TfLiteStatus TanhEval(TfLiteContext* context, TfLiteNode* node) {
       return kTfLiteOk;
     } break;
     case kTfLiteInt16: {
-      reference_integer_ops::Tanh(
-          data.input_multiplier, data.input_left_shift,
+      if (data.lut_int16 == nullptr) {
+        reference_integer_ops::Tanh(
+            data.input_multiplier, data.input_left_shift,
+            tflite::micro::GetTensorShape(input),
+            tflite::micro::GetTensorData<int16_t>(input),
+            tflite::micro::GetTensorShape(output),
+            tflite::micro::GetTensorData<int16_t>(output));
+        return kTfLiteOk;
+      }
+      const int flat_size = MatchingFlatSize(
           tflite::micro::GetTensorShape(input),
-          tflite::micro::GetTensorData<int16_t>(input),
-          tflite::micro::GetTensorShape(output),
-          tflite::micro::GetTensorData<int16_t>(output));
+          tflite::micro::GetTensorShape(output));
+      const int16_t* input_data = tflite::micro::GetTensorData<int16_t>(input);
+      int16_t* output_data = tflite::micro::GetTensorData<int16_t>(output);
+      for (int i = 0; i < flat_size; ++i) {
+        output_data[i] = LUTLookup(input_data[i], data.lut_int16);
+      }
       return kTfLiteOk;
     } break;
     case kTfLiteInt8: {
-      reference_integer_ops::Tanh(
-          data.input_zero_point, data.input_range_radius, data.input_multiplier,
-          data.input_left_shift, tflite::micro::GetTensorShape(input),
-          tflite::micro::GetTensorData<int8_t>(input),
-          tflite::micro::GetTensorShape(output),
-          tflite::micro::GetTensorData<int8_t>(output));
+      const int flat_size = MatchingFlatSize(
+          tflite::micro::GetTensorShape(input),
+          tflite::micro::GetTensorShape(output));
+      const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+      int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+      for (int i = 0; i < flat_size; ++i) {
+        output_data[i] = LUTLookup(input_data[i], data.lut_int8);
+      }
       return kTfLiteOk;
     } break;
     default:
@@ -192,10 +192,9 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 
   // Quantized 16x8 kernels use an int64 scratch buffer.
   if (input->type == kTfLiteInt16) {
-    TFLITE_DCHECK(context->RequestScratchBufferInArena != nullptr);
-    TFLITE_DCHECK(context->RequestScratchBufferInArena(
-                      context,
+    TFLITE_DCHECK(micro_context->RequestAlignedScratchBufferInArena(
                       GetTensorShape(output).FlatSize() * sizeof(std::int64_t),
+                      alignof(std::int64_t),
                       &(data->scratch_buffer_index)) == kTfLiteOk);
   }
 
@@ -0,0 +1,379 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/winograd_conv.h"
+
+#include <algorithm>
+
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/micro_context.h"
+
+namespace tflite {
+namespace winograd {
+
+namespace {
+
+// Input tile side, output tile side and number of transformed values.
+constexpr int kInputTile = 4;
+constexpr int kOutputTile = 2;
+constexpr int kTransformSize = kInputTile * kInputTile;
+
+// Bytes of TF_LITE_MICRO_WINOGRAD_CONV_MAX_BYTES that the transformed filters
+// of the model prepared through owner took so far. It lives in the persistent
+// arena of that model. All layers of a model are prepared in one go, so only
+// the budget of the model prepared last is kept.
+struct FilterBudget {
+  const MicroContext* owner;
+  size_t used_bytes;
+};
+
+FilterBudget* current_budget = nullptr;
+
+// Returns the budget of the model that context belongs to, allocating it on
+// the first Winograd layer of that model. Returns nullptr if it does not fit
+// in the arena.
+FilterBudget* GetFilterBudget(TfLiteContext* context) {
+  const MicroContext* micro_context = GetMicroContext(context);
+  if (current_budget == nullptr || current_budget->owner != micro_context) {
+    current_budget = static_cast<FilterBudget*>(
+        context->AllocatePersistentBuffer(context, sizeof(FilterBudget)));
+    if (current_budget == nullptr) {
+      return nullptr;
+    }
+    current_budget->owner = micro_context;
+    current_budget->used_bytes = 0;
+  }
+  return current_budget;
+}
+
+// Returns true if the Winograd kernels take fewer operations than the direct
+// convolution. Each 2x2 output tile costs 16 multiply-adds per channel pair
+// plus about 32 additions per input channel and 24 per output channel for the
+// transforms, while the direct convolution takes 9 multiply-adds per output
+// and channel pair. Partial tiles at the border count in full.
+bool WorthTransforming(int input_depth, int output_depth, int output_height,
+                       int output_width) {
+  const int64_t tiles =
+      static_cast<int64_t>((output_height + kOutputTile - 1) / kOutputTile) *
+      ((output_width + kOutputTile - 1) / kOutputTile);
+  const int64_t channel_pairs =
+      static_cast<int64_t>(input_depth) * output_depth;
+  const int64_t winograd_ops =
+      tiles * (16 * channel_pairs + 32 * input_depth + 24 * output_depth);
+  const int64_t direct_ops =
+      static_cast<int64_t>(output_height) * output_width * 9 * channel_pairs;
+  return winograd_ops < direct_ops;
+}
+
+// Computes out = G * g * G^T for a 3x3 filter g whose values are
+// filter[i * stride], with G scaled by 2 so that it only has integer entries:
+//   G = [[2, 0, 0], [1, 1, 1], [1, -1, 1], [0, 0, 2]]
+// The result is 4 times the usual Winograd filter transform.
+template <typename FilterT, typename T>
+void TransformFilterTile(const FilterT* filter, int stride, T* out) {
+  T g[9];
+  for (int i = 0; i < 9; ++i) {
+    g[i] = static_cast<T>(filter[i * stride]);
+  }
+  T t[4][3];
+  for (int j = 0; j < 3; ++j) {
+    t[0][j] = 2 * g[j];
+    t[1][j] = g[j] + g[3 + j] + g[6 + j];
+    t[2][j] = g[j] - g[3 + j] + g[6 + j];
+    t[3][j] = 2 * g[6 + j];
+  }
+  for (int i = 0; i < 4; ++i) {
+    out[i * 4 + 0] = 2 * t[i][0];
+    out[i * 4 + 1] = t[i][0] + t[i][1] + t[i][2];
+    out[i * 4 + 2] = t[i][0] - t[i][1] + t[i][2];
+    out[i * 4 + 3] = 2 * t[i][2];
+  }
+}
+
+// Transforms an [output_depth, 3, 3, input_depth] filter into
+// [16, input_depth, output_depth], so that the multiply-adds of each
+// transformed position run over contiguous output channels. Values are scaled
+// by scale to undo the factor 4 of TransformFilterTile where possible.
+template <typename FilterT, typename TransformedT, typename T>
+void TransformFilter(const RuntimeShape& filter_shape,
+                     const FilterT* filter_data, T scale,
+                     TransformedT* transformed) {
+  const int output_depth = filter_shape.Dims(0);
+  const int input_depth = filter_shape.Dims(3);
+  for (int out_channel = 0; out_channel < output_depth; ++out_channel) {
+    for (int in_channel = 0; in_channel < input_depth; ++in_channel) {
+      T tile[kTransformSize];
+      TransformFilterTile(
+          filter_data + Offset(filter_shape, out_channel, 0, 0, in_channel),
+          input_depth, tile);
+      for (int i = 0; i < kTransformSize; ++i) {
+        transformed[(i * input_depth + in_channel) * output_depth +
+                    out_channel] = static_cast<TransformedT>(tile[i] * scale);
+      }
+    }
+  }
+}
+
+// Computes out = B^T * d * B for a 4x4 input tile d, with
+//   B^T = [[1, 0, -1, 0], [0, 1, 1, 0], [0, -1, 1, 0], [0, 1, 0, -1]]
+// out is written with a stride of depth elements.
+template <typename T>
+void TransformInputTile(const T* d, int depth, T* out) {
+  T t[4][4];
+  for (int j = 0; j < 4; ++j) {
+    t[0][j] = d[j] - d[8 + j];
+    t[1][j] = d[4 + j] + d[8 + j];
+    t[2][j] = d[8 + j] - d[4 + j];
+    t[3][j] = d[4 + j] - d[12 + j];
+  }
+  for (int i = 0; i < 4; ++i) {
+    out[(i * 4 + 0) * depth] = t[i][0] - t[i][2];
+    out[(i * 4 + 1) * depth] = t[i][1] + t[i][2];
+    out[(i * 4 + 2) * depth] = t[i][2] - t[i][1];
+    out[(i * 4 + 3) * depth] = t[i][1] - t[i][3];
+  }
+}
+
+// Computes out = A^T * m * A for 4x4 values m read with a stride of depth
+// elements, with A^T = [[1, 1, 1, 0], [0, 1, -1, -1]].
+template <typename T>
+void TransformOutputTile(const T* m, int depth, T out[4]) {
+  T t[2][4];
+  for (int j = 0; j < 4; ++j) {
+    const T m0 = m[j * depth];
+    const T m1 = m[(4 + j) * depth];
+    const T m2 = m[(8 + j) * depth];
+    const T m3 = m[(12 + j) * depth];
+    t[0][j] = m0 + m1 + m2;
+    t[1][j] = m1 - m2 - m3;
+  }
+  for (int i = 0; i < 2; ++i) {
+    out[i * 2 + 0] = t[i][0] + t[i][1] + t[i][2];
+    out[i * 2 + 1] = t[i][1] - t[i][2] - t[i][3];
+  }
+}
+
+// Runs the convolution tile by tile. input_tiles holds the 16 transformed
+// values of every input channel and products the 16 values of every output
+// channel. finish(sum, out_channel) turns an output of the transforms into
+// the output value.
+template <typename InputT, typename FilterT, typename TransformT,
+          typename AccT, typename OutputT, typename FinishF>
+void ConvTiles(const ConvParams& params, const RuntimeShape& input_shape,
+               const InputT* input_data, const RuntimeShape& filter_shape,
+               const FilterT* transformed_filter,
+               const RuntimeShape& output_shape, OutputT* output_data,
+               TransformT* input_tiles, AccT* products, FinishF finish) {
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int input_depth = MatchingDim(input_shape, 3, filter_shape, 3);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
+  const int pad_height = params.padding_values.height;
+  const int pad_width = params.padding_values.width;
+
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int out_y = 0; out_y < output_height; out_y += kOutputTile) {
+      for (int out_x = 0; out_x < output_width; out_x += kOutputTile) {
+        const int in_y_origin = out_y - pad_height;
+        const int in_x_origin = out_x - pad_width;
+
+        // Gather and transform the 4x4 input window of each channel. Values
+        // outside the image are the zero padding.
+        for (int in_channel = 0; in_channel < input_depth; ++in_channel) {
+          TransformT d[kTransformSize];
+          for (int y = 0; y < kInputTile; ++y) {
+            const int in_y = in_y_origin + y;
+            for (int x = 0; x < kInputTile; ++x) {
+              const int in_x = in_x_origin + x;
+              const bool is_point_inside_image =
+                  (in_x >= 0) && (in_x < input_width) && (in_y >= 0) &&
+                  (in_y < input_height);
+              d[y * kInputTile + x] =
+                  is_point_inside_image
+                      ? static_cast<TransformT>(input_data[Offset(
+                            input_shape, batch, in_y, in_x, in_channel)])
+                      : 0;
+            }
+          }
+          TransformInputTile(d, input_depth, input_tiles + in_channel);
+        }
+
+        // Multiply with the transformed filter: one input_depth by
+        // output_depth matrix product per transformed position.
+        for (int i = 0; i < kTransformSize; ++i) {
+          AccT* product = products + i * output_depth;
+          std::fill_n(product, output_depth, AccT(0));
+          const TransformT* input_tile = input_tiles + i * input_depth;
+          const FilterT* filter =
+              transformed_filter + i * input_depth * output_depth;
+          for (int in_channel = 0; in_channel < input_depth; ++in_channel) {
+            const AccT input_val = static_cast<AccT>(input_tile[in_channel]);
+            for (int out_channel = 0; out_channel < output_depth;
+                 ++out_channel) {
+              product[out_channel] +=
+                  input_val * static_cast<AccT>(filter[out_channel]);
+            }
+            filter += output_depth;
+          }
+        }
+
+        const int tile_height = std::min(kOutputTile, output_height - out_y);
+        const int tile_width = std::min(kOutputTile, output_width - out_x);
+        for (int out_channel = 0; out_channel < output_depth; ++out_channel) {
+          AccT out[kOutputTile * kOutputTile];
+          TransformOutputTile(products + out_channel, output_depth, out);
+          for (int y = 0; y < tile_height; ++y) {
+            for (int x = 0; x < tile_width; ++x) {
+              output_data[Offset(output_shape, batch, out_y + y, out_x + x,
+                                 out_channel)] =
+                  finish(out[y * kOutputTile + x], out_channel);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TfLiteStatus PrepareConv(TfLiteContext* context,
+                         const TfLiteConvParams& params,
+                         const TfLiteTensor* input, const TfLiteTensor* filter,
+                         const TfLiteTensor* output, OpDataConv* data) {
+  if (TF_LITE_MICRO_WINOGRAD_CONV_MAX_BYTES == 0 ||
+      !IsConstantTensor(filter) || params.stride_width != 1 ||
+      params.stride_height != 1 || params.dilation_width_factor != 1 ||
+      params.dilation_height_factor != 1 || filter->dims->size != 4 ||
+      filter->dims->data[1] != 3 || filter->dims->data[2] != 3) {
+    return kTfLiteOk;
+  }
+  const int output_depth = filter->dims->data[0];
+  const int input_depth = filter->dims->data[3];
+  // Grouped convolutions keep the direct kernels.
+  if (input->dims->data[3] != input_depth ||
+      !WorthTransforming(input_depth, output_depth, output->dims->data[1],
+                         output->dims->data[2])) {
+    return kTfLiteOk;
+  }
+
+  size_t filter_element_bytes;
+  size_t scratch_bytes;
+  if (input->type == kTfLiteFloat32 && filter->type == kTfLiteFloat32) {
+    filter_element_bytes = sizeof(float);
+    scratch_bytes = kTransformSize * (output_depth + input_depth) * sizeof(float);
+  } else if (input->type == kTfLiteInt16 && filter->type == kTfLiteInt8) {
+    filter_element_bytes = sizeof(int16_t);
+    scratch_bytes = kTransformSize * (output_depth * sizeof(int64_t) +
+                                      input_depth * sizeof(int32_t));
+  } else {
+    return kTfLiteOk;
+  }
+  const size_t filter_bytes =
+      kTransformSize * input_depth * output_depth * filter_element_bytes;
+  FilterBudget* budget = GetFilterBudget(context);
+  TF_LITE_ENSURE(context, budget != nullptr);
+  if (budget->used_bytes + filter_bytes >
+      TF_LITE_MICRO_WINOGRAD_CONV_MAX_BYTES) {
+    return kTfLiteOk;
+  }
+
+  void* transformed =
+      context->AllocatePersistentBuffer(context, filter_bytes);
+  TF_LITE_ENSURE(context, transformed != nullptr);
+  if (input->type == kTfLiteFloat32) {
+    TransformFilter(GetTensorShape(filter), GetTensorData<float>(filter),
+                    0.25f, static_cast<float*>(transformed));
+  } else {
+    // Kept 4x scaled, which is undone exactly after the output transform.
+    // The largest value is 9 * 128, so int16 holds it.
+    TransformFilter(GetTensorShape(filter), GetTensorData<int8_t>(filter),
+                    int32_t{1}, static_cast<int16_t*>(transformed));
+  }
+  // The int64_t accumulators come first in the scratch buffer.
+  TF_LITE_ENSURE_STATUS(
+      GetMicroContext(context)->RequestAlignedScratchBufferInArena(
+          scratch_bytes, alignof(int64_t), &data->winograd_scratch_index));
+  budget->used_bytes += filter_bytes;
+  data->winograd_filter = transformed;
+  return kTfLiteOk;
+}
+
+void FreeConv(TfLiteContext* context) {
+  if (current_budget != nullptr &&
+      current_budget->owner == GetMicroContext(context)) {
+    current_budget = nullptr;
+  }
+}
+
+void Conv(const ConvParams& params, const RuntimeShape& input_shape,
+          const float* input_data, const RuntimeShape& filter_shape,
+          const float* transformed_filter, const float* bias_data,
+          const RuntimeShape& output_shape, float* output_data,
+          float* scratch) {
+  const int output_depth = output_shape.Dims(3);
+  const float output_activation_min = params.float_activation_min;
+  const float output_activation_max = params.float_activation_max;
+  ConvTiles(params, input_shape, input_data, filter_shape, transformed_filter,
+            output_shape, output_data,
+            scratch + kTransformSize * output_depth, scratch,
+            [=](float sum, int out_channel) {
+              if (bias_data) {
+                sum += bias_data[out_channel];
+              }
+              return ActivationFunctionWithMinMax(sum, output_activation_min,
+                                                  output_activation_max);
+            });
+}
+
+void ConvPerChannel(const ConvParams& params,
+                    const int32_t* output_multiplier,
+                    const int32_t* output_shift,
+                    const RuntimeShape& input_shape, const int16_t* input_data,
+                    const RuntimeShape& filter_shape,
+                    const int16_t* transformed_filter,
+                    const int64_t* bias_data,
+                    const RuntimeShape& output_shape, int16_t* output_data,
+                    int64_t* scratch) {
+  const int output_depth = output_shape.Dims(3);
+  const int32_t output_activation_min = params.quantized_activation_min;
+  const int32_t output_activation_max = params.quantized_activation_max;
+  TFLITE_DCHECK_LE(output_activation_min, output_activation_max);
+  ConvTiles(params, input_shape, input_data, filter_shape, transformed_filter,
+            output_shape, output_data,
+            reinterpret_cast<int32_t*>(scratch + kTransformSize * output_depth),
+            scratch, [=](int64_t sum, int out_channel) {
+              // The filter transform is scaled by 4 and sum is an exact
+              // multiple of 4.
+              int64_t acc = sum / 4;
+              if (bias_data) {
+                acc += bias_data[out_channel];
+              }
+              int32_t scaled_acc = MultiplyByQuantizedMultiplier(
+                  acc, output_multiplier[out_channel],
+                  output_shift[out_channel]);
+              scaled_acc = std::max(scaled_acc, output_activation_min);
+              scaled_acc = std::min(scaled_acc, output_activation_max);
+              return static_cast<int16_t>(scaled_acc);
+            });
+}
+
+}  // namespace winograd
+}  // namespace tflite
@@ -0,0 +1,86 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_WINOGRAD_CONV_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_WINOGRAD_CONV_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/micro/kernels/conv.h"
+
+// Winograd F(2x2, 3x3) kernels for 3x3, stride 1, undilated CONV_2D with
+// float32 or int16 activations. Each 2x2 block of outputs takes 16
+// multiply-adds per input/output channel pair instead of 36.
+//
+// The filter is transformed once in Prepare into the persistent arena, which
+// needs 16/9 of the float filter size, or 32/9 of the int8 filter size for
+// int16 activations. As arenas sized for the direct kernels may not have that
+// room, the kernels are opt-in: TF_LITE_MICRO_WINOGRAD_CONV_MAX_BYTES
+// defaults to 0, which disables them. Defining it to a non-zero value enables
+// the kernels for the layers whose shape makes the transforms worth their
+// cost, in the order they are prepared, as long as all transformed filters of
+// the model fit in that many bytes together. The filter must be constant. Only
+// the CMSIS-NN CONV_2D kernel uses them.
+//
+// scripts/benchmark_winograd_conv.cpp compares the kernels with the reference
+// kernels for accuracy and speed.
+//
+// The int16 kernel transforms with integer matrices scaled by 2, so its
+// results are bit-exact with reference_integer_ops::ConvPerChannel. The float
+// kernel differs from reference_ops::Conv by floating point rounding only.
+#ifndef TF_LITE_MICRO_WINOGRAD_CONV_MAX_BYTES
+#define TF_LITE_MICRO_WINOGRAD_CONV_MAX_BYTES 0
+#endif
+
+namespace tflite {
+namespace winograd {
+
+// Sets data->winograd_filter and data->winograd_scratch_index if the
+// convolution described by params and the tensors should use the Winograd
+// kernels and its transformed filter fits in what is left of the budget, and
+// leaves them untouched otherwise. Must be called after
+// CalculateOpDataConv.
+TfLiteStatus PrepareConv(TfLiteContext* context,
+                         const TfLiteConvParams& params,
+                         const TfLiteTensor* input, const TfLiteTensor* filter,
+                         const TfLiteTensor* output, OpDataConv* data);
+
+// Releases the budget of the model that context belongs to. Must be called
+// from the free function of the kernels that call PrepareConv.
+void FreeConv(TfLiteContext* context);
+
+// filter_shape is the shape of the untransformed filter.
+void Conv(const ConvParams& params, const RuntimeShape& input_shape,
+          const float* input_data, const RuntimeShape& filter_shape,
+          const float* transformed_filter, const float* bias_data,
+          const RuntimeShape& output_shape, float* output_data,
+          float* scratch);
+
+void ConvPerChannel(const ConvParams& params,
+                    const int32_t* output_multiplier,
+                    const int32_t* output_shift,
+                    const RuntimeShape& input_shape, const int16_t* input_data,
+                    const RuntimeShape& filter_shape,
+                    const int16_t* transformed_filter,
+                    const int64_t* bias_data,
+                    const RuntimeShape& output_shape, int16_t* output_data,
+                    int64_t* scratch);
+
+}  // namespace winograd
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_WINOGRAD_CONV_H_
@@ -0,0 +1,933 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/x86_int8.h"
+
+#if defined(TF_LITE_MICRO_X86_INT8_ENABLED)
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "third_party/gemmlowp/fixedpoint/fixedpoint.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/add.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/mul.h"
+
+// Functions using intrinsics are compiled for the instruction set they need
+// and only called after the CPU has been checked, so the rest of the build
+// does not need -mavx2.
+#define TF_LITE_MICRO_X86_AVX2 __attribute__((target("avx2")))
+#define TF_LITE_MICRO_X86_AVX512_VNNI \
+  __attribute__((target("avx2,avx512vl,avx512vnni")))
+
+namespace tflite {
+namespace x86_int8 {
+namespace {
+
+enum class Isa { kGeneric, kAvx2, kAvx512Vnni };
+
+Isa DetectIsa() {
+  __builtin_cpu_init();
+  if (!__builtin_cpu_supports("avx2")) {
+    return Isa::kGeneric;
+  }
+  if (__builtin_cpu_supports("avx512vl") &&
+      __builtin_cpu_supports("avx512vnni")) {
+    return Isa::kAvx512Vnni;
+  }
+  return Isa::kAvx2;
+}
+
+Isa GetIsa() {
+  static const Isa isa = DetectIsa();
+  return isa;
+}
+
+bool HasAvx2() { return GetIsa() != Isa::kGeneric; }
+
+TF_LITE_MICRO_X86_AVX2 inline __m256i LoadInt8AsInt16(const int8_t* data) {
+  return _mm256_cvtepi8_epi16(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)));
+}
+
+TF_LITE_MICRO_X86_AVX2 inline __m256i LoadInt8AsInt32(const int8_t* data) {
+  return _mm256_cvtepi8_epi32(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data)));
+}
+
+TF_LITE_MICRO_X86_AVX2 inline __m256i LoadInt32(const int32_t* data) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+}
+
+// Stores eight lanes that have already been clamped to the int8 range.
+TF_LITE_MICRO_X86_AVX2 inline void StoreInt32AsInt8(int8_t* data,
+                                                    __m256i vector) {
+  const __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(vector),
+                                         _mm256_extracti128_si256(vector, 1));
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(data),
+                   _mm_packs_epi16(packed, packed));
+}
+
+// Stores eight lanes that have already been clamped to the int16 range.
+TF_LITE_MICRO_X86_AVX2 inline void StoreInt32AsInt16(int16_t* data,
+                                                     __m256i vector) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(data),
+                   _mm_packs_epi32(_mm256_castsi256_si128(vector),
+                                   _mm256_extracti128_si256(vector, 1)));
+}
+
+TF_LITE_MICRO_X86_AVX2 inline int32_t HorizontalSum(__m256i vector) {
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(vector),
+                              _mm256_extracti128_si256(vector, 1));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(sum);
+}
+
+TF_LITE_MICRO_X86_AVX2 inline __m256i Clamp(__m256i vector, __m256i min,
+                                            __m256i max) {
+  return _mm256_min_epi32(_mm256_max_epi32(vector, min), max);
+}
+
+// Lane-wise gemmlowp::SaturatingRoundingDoublingHighMul. For every product p,
+// gemmlowp's nudge-and-truncate rounding equals floor((p + 2^30) / 2^31), and
+// the low 32 bits of that are the same for a logical and an arithmetic shift.
+TF_LITE_MICRO_X86_AVX2 inline __m256i SaturatingRoundingDoublingHighMul(
+    __m256i a, __m256i b) {
+  const __m256i nudge = _mm256_set1_epi64x(int64_t{1} << 30);
+  const __m256i even = _mm256_srli_epi64(
+      _mm256_add_epi64(_mm256_mul_epi32(a, b), nudge), 31);
+  const __m256i odd = _mm256_srli_epi64(
+      _mm256_add_epi64(_mm256_mul_epi32(_mm256_srli_epi64(a, 32),
+                                        _mm256_srli_epi64(b, 32)),
+                       nudge),
+      31);
+  const __m256i result =
+      _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+  const __m256i int32_min =
+      _mm256_set1_epi32(std::numeric_limits<int32_t>::min());
+  const __m256i overflow = _mm256_and_si256(_mm256_cmpeq_epi32(a, int32_min),
+                                            _mm256_cmpeq_epi32(b, int32_min));
+  return _mm256_blendv_epi8(
+      result, _mm256_set1_epi32(std::numeric_limits<int32_t>::max()),
+      overflow);
+}
+
+// Lane-wise gemmlowp::RoundingDivideByPOT with a per-lane exponent.
+TF_LITE_MICRO_X86_AVX2 inline __m256i RoundingDivideByPOT(__m256i x,
+                                                          __m256i exponent) {
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i mask = _mm256_sub_epi32(_mm256_sllv_epi32(one, exponent), one);
+  const __m256i remainder = _mm256_and_si256(x, mask);
+  const __m256i threshold = _mm256_add_epi32(
+      _mm256_srai_epi32(mask, 1),
+      _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), x), one));
+  return _mm256_add_epi32(
+      _mm256_srav_epi32(x, exponent),
+      _mm256_and_si256(_mm256_cmpgt_epi32(remainder, threshold), one));
+}
+
+// Lane-wise tflite::MultiplyByQuantizedMultiplier.
+TF_LITE_MICRO_X86_AVX2 inline __m256i MultiplyByQuantizedMultiplier(
+    __m256i x, __m256i multiplier, __m256i shift) {
+#if TFLITE_SINGLE_ROUNDING
+  int32_t x_lanes[8];
+  int32_t multiplier_lanes[8];
+  int32_t shift_lanes[8];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(x_lanes), x);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(multiplier_lanes),
+                      multiplier);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(shift_lanes), shift);
+  for (int i = 0; i < 8; ++i) {
+    x_lanes[i] = tflite::MultiplyByQuantizedMultiplier(
+        x_lanes[i], multiplier_lanes[i], shift_lanes[i]);
+  }
+  return LoadInt32(x_lanes);
+#else
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i left_shift = _mm256_max_epi32(shift, zero);
+  const __m256i right_shift =
+      _mm256_max_epi32(_mm256_sub_epi32(zero, shift), zero);
+  return RoundingDivideByPOT(
+      SaturatingRoundingDoublingHighMul(_mm256_sllv_epi32(x, left_shift),
+                                        multiplier),
+      right_shift);
+#endif
+}
+
+// Returns sum((a[i] + a_offset) * (b[i] + b_offset)) over `size` elements.
+// Both offset operands fit in int16, so pairs of products are accumulated
+// into int32 lanes exactly.
+typedef int32_t (*DotProductFn)(const int8_t* a, int32_t a_offset,
+                                const int8_t* b, int32_t b_offset, int size);
+
+TF_LITE_MICRO_X86_AVX2 int32_t DotProductAvx2(const int8_t* a,
+                                              int32_t a_offset,
+                                              const int8_t* b,
+                                              int32_t b_offset, int size) {
+  const __m256i a_offset_vector = _mm256_set1_epi16(a_offset);
+  const __m256i b_offset_vector = _mm256_set1_epi16(b_offset);
+  __m256i acc = _mm256_setzero_si256();
+  int i = 0;
+  for (; i <= size - 16; i += 16) {
+    const __m256i a_vector =
+        _mm256_add_epi16(LoadInt8AsInt16(a + i), a_offset_vector);
+    const __m256i b_vector =
+        _mm256_add_epi16(LoadInt8AsInt16(b + i), b_offset_vector);
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(a_vector, b_vector));
+  }
+  int32_t sum = HorizontalSum(acc);
+  for (; i < size; ++i) {
+    sum += (a[i] + a_offset) * (b[i] + b_offset);
+  }
+  return sum;
+}
+
+TF_LITE_MICRO_X86_AVX512_VNNI int32_t DotProductAvx512Vnni(const int8_t* a,
+                                                           int32_t a_offset,
+                                                           const int8_t* b,
+                                                           int32_t b_offset,
+                                                           int size) {
+  const __m256i a_offset_vector = _mm256_set1_epi16(a_offset);
+  const __m256i b_offset_vector = _mm256_set1_epi16(b_offset);
+  __m256i acc = _mm256_setzero_si256();
+  int i = 0;
+  for (; i <= size - 16; i += 16) {
+    const __m256i a_vector =
+        _mm256_add_epi16(LoadInt8AsInt16(a + i), a_offset_vector);
+    const __m256i b_vector =
+        _mm256_add_epi16(LoadInt8AsInt16(b + i), b_offset_vector);
+    acc = _mm256_dpwssd_epi32(acc, a_vector, b_vector);
+  }
+  int32_t sum = HorizontalSum(acc);
+  for (; i < size; ++i) {
+    sum += (a[i] + a_offset) * (b[i] + b_offset);
+  }
+  return sum;
+}
+
+DotProductFn GetDotProduct() {
+  switch (GetIsa()) {
+    case Isa::kAvx512Vnni:
+      return DotProductAvx512Vnni;
+    case Isa::kAvx2:
+      return DotProductAvx2;
+    default:
+      return nullptr;
+  }
+}
+
+inline int8_t RequantizeToInt8(int32_t acc, int32_t multiplier, int32_t shift,
+                               int32_t output_offset, int32_t activation_min,
+                               int32_t activation_max) {
+  acc = tflite::MultiplyByQuantizedMultiplier(acc, multiplier, shift);
+  acc += output_offset;
+  acc = std::max(acc, activation_min);
+  acc = std::min(acc, activation_max);
+  return static_cast<int8_t>(acc);
+}
+
+TF_LITE_MICRO_X86_AVX2 void DepthwiseConvPerChannelAvx2(
+    const DepthwiseParams& params, const int32_t* output_multiplier,
+    const int32_t* output_shift, const RuntimeShape& input_shape,
+    const int8_t* input_data, const RuntimeShape& filter_shape,
+    const int8_t* filter_data, const RuntimeShape& bias_shape,
+    const int32_t* bias_data, const RuntimeShape& output_shape,
+    int8_t* output_data) {
+  const int stride_width = params.stride_width;
+  const int stride_height = params.stride_height;
+  const int dilation_width_factor = params.dilation_width_factor;
+  const int dilation_height_factor = params.dilation_height_factor;
+  const int pad_width = params.padding_values.width;
+  const int pad_height = params.padding_values.height;
+  const int32_t input_offset = params.input_offset;
+  const int32_t output_offset = params.output_offset;
+  const int32_t output_activation_min = params.quantized_activation_min;
+  const int32_t output_activation_max = params.quantized_activation_max;
+
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int depth = MatchingDim(filter_shape, 3, output_shape, 3);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int filter_height = filter_shape.Dims(1);
+  const int filter_width = filter_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+
+  const __m256i input_offset_vector = _mm256_set1_epi32(input_offset);
+  const __m256i output_offset_vector = _mm256_set1_epi32(output_offset);
+  const __m256i activation_min_vector =
+      _mm256_set1_epi32(output_activation_min);
+  const __m256i activation_max_vector =
+      _mm256_set1_epi32(output_activation_max);
+
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const int in_y_origin = (out_y * stride_height) - pad_height;
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin = (out_x * stride_width) - pad_width;
+        int8_t* output_pixel =
+            &output_data[Offset(output_shape, batch, out_y, out_x, 0)];
+        int channel = 0;
+        for (; channel <= depth - 8; channel += 8) {
+          __m256i acc = _mm256_setzero_si256();
+          for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+            const int in_y = in_y_origin + dilation_height_factor * filter_y;
+            if (in_y < 0 || in_y >= input_height) {
+              continue;
+            }
+            for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
+              const int in_x = in_x_origin + dilation_width_factor * filter_x;
+              if (in_x < 0 || in_x >= input_width) {
+                continue;
+              }
+              const __m256i input_vector = _mm256_add_epi32(
+                  LoadInt8AsInt32(&input_data[Offset(input_shape, batch, in_y,
+                                                     in_x, channel)]),
+                  input_offset_vector);
+              const __m256i filter_vector = LoadInt8AsInt32(&filter_data[Offset(
+                  filter_shape, 0, filter_y, filter_x, channel)]);
+              acc = _mm256_add_epi32(
+                  acc, _mm256_mullo_epi32(input_vector, filter_vector));
+            }
+          }
+          if (bias_data) {
+            acc = _mm256_add_epi32(acc, LoadInt32(&bias_data[channel]));
+          }
+          acc = MultiplyByQuantizedMultiplier(
+              acc, LoadInt32(&output_multiplier[channel]),
+              LoadInt32(&output_shift[channel]));
+          acc = Clamp(_mm256_add_epi32(acc, output_offset_vector),
+                      activation_min_vector, activation_max_vector);
+          StoreInt32AsInt8(&output_pixel[channel], acc);
+        }
+        for (; channel < depth; ++channel) {
+          int32_t acc = 0;
+          for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+            const int in_y = in_y_origin + dilation_height_factor * filter_y;
+            if (in_y < 0 || in_y >= input_height) {
+              continue;
+            }
+            for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
+              const int in_x = in_x_origin + dilation_width_factor * filter_x;
+              if (in_x < 0 || in_x >= input_width) {
+                continue;
+              }
+              const int32_t input_val =
+                  input_data[Offset(input_shape, batch, in_y, in_x, channel)];
+              const int32_t filter_val = filter_data[Offset(
+                  filter_shape, 0, filter_y, filter_x, channel)];
+              acc += filter_val * (input_val + input_offset);
+            }
+          }
+          if (bias_data) {
+            acc += bias_data[channel];
+          }
+          output_pixel[channel] = RequantizeToInt8(
+              acc, output_multiplier[channel], output_shift[channel],
+              output_offset, output_activation_min, output_activation_max);
+        }
+      }
+    }
+  }
+}
+
+TF_LITE_MICRO_X86_AVX2 void AddElementwiseAvx2(int size,
+                                               const ArithmeticParams& params,
+                                               const int8_t* input1_data,
+                                               const int8_t* input2_data,
+                                               int8_t* output_data) {
+  const __m256i input1_offset = _mm256_set1_epi32(params.input1_offset);
+  const __m256i input2_offset = _mm256_set1_epi32(params.input2_offset);
+  const __m256i left_shift = _mm256_set1_epi32(params.left_shift);
+  const __m256i input1_multiplier = _mm256_set1_epi32(params.input1_multiplier);
+  const __m256i input1_shift = _mm256_set1_epi32(params.input1_shift);
+  const __m256i input2_multiplier = _mm256_set1_epi32(params.input2_multiplier);
+  const __m256i input2_shift = _mm256_set1_epi32(params.input2_shift);
+  const __m256i output_multiplier = _mm256_set1_epi32(params.output_multiplier);
+  const __m256i output_shift = _mm256_set1_epi32(params.output_shift);
+  const __m256i output_offset = _mm256_set1_epi32(params.output_offset);
+  const __m256i activation_min =
+      _mm256_set1_epi32(params.quantized_activation_min);
+  const __m256i activation_max =
+      _mm256_set1_epi32(params.quantized_activation_max);
+
+  int i = 0;
+  for (; i <= size - 8; i += 8) {
+    const __m256i input1_val = _mm256_sllv_epi32(
+        _mm256_add_epi32(LoadInt8AsInt32(input1_data + i), input1_offset),
+        left_shift);
+    const __m256i input2_val = _mm256_sllv_epi32(
+        _mm256_add_epi32(LoadInt8AsInt32(input2_data + i), input2_offset),
+        left_shift);
+    const __m256i raw_sum = _mm256_add_epi32(
+        MultiplyByQuantizedMultiplier(input1_val, input1_multiplier,
+                                      input1_shift),
+        MultiplyByQuantizedMultiplier(input2_val, input2_multiplier,
+                                      input2_shift));
+    const __m256i raw_output = _mm256_add_epi32(
+        MultiplyByQuantizedMultiplier(raw_sum, output_multiplier,
+                                      output_shift),
+        output_offset);
+    StoreInt32AsInt8(output_data + i,
+                     Clamp(raw_output, activation_min, activation_max));
+  }
+  for (; i < size; ++i) {
+    output_data[i] =
+        reference_integer_ops::AddFunc(input1_data[i], input2_data[i], params);
+  }
+}
+
+TF_LITE_MICRO_X86_AVX2 void MulElementwiseAvx2(int size,
+                                               const ArithmeticParams& params,
+                                               const int8_t* input1_data,
+                                               const int8_t* input2_data,
+                                               int8_t* output_data) {
+  const __m256i input1_offset = _mm256_set1_epi32(params.input1_offset);
+  const __m256i input2_offset = _mm256_set1_epi32(params.input2_offset);
+  const __m256i output_multiplier = _mm256_set1_epi32(params.output_multiplier);
+  const __m256i output_shift = _mm256_set1_epi32(params.output_shift);
+  const __m256i output_offset = _mm256_set1_epi32(params.output_offset);
+  const __m256i activation_min =
+      _mm256_set1_epi32(params.quantized_activation_min);
+  const __m256i activation_max =
+      _mm256_set1_epi32(params.quantized_activation_max);
+
+  int i = 0;
+  for (; i <= size - 8; i += 8) {
+    const __m256i input1_val =
+        _mm256_add_epi32(LoadInt8AsInt32(input1_data + i), input1_offset);
+    const __m256i input2_val =
+        _mm256_add_epi32(LoadInt8AsInt32(input2_data + i), input2_offset);
+    const __m256i unclamped_result = _mm256_add_epi32(
+        MultiplyByQuantizedMultiplier(
+            _mm256_mullo_epi32(input1_val, input2_val), output_multiplier,
+            output_shift),
+        output_offset);
+    StoreInt32AsInt8(output_data + i,
+                     Clamp(unclamped_result, activation_min, activation_max));
+  }
+  reference_integer_ops::MulElementwise(size - i, params, input1_data + i,
+                                        input2_data + i, output_data + i);
+}
+
+// Computes the clamped filter window of a pooling output pixel, as
+// reference_integer_ops does.
+struct PoolWindow {
+  int in_x_origin;
+  int in_y_origin;
+  int filter_x_start;
+  int filter_x_end;
+  int filter_y_start;
+  int filter_y_end;
+};
+
+inline PoolWindow GetPoolWindow(const PoolParams& params, int input_height,
+                                int input_width, int out_y, int out_x) {
+  PoolWindow window;
+  window.in_x_origin =
+      (out_x * params.stride_width) - params.padding_values.width;
+  window.in_y_origin =
+      (out_y * params.stride_height) - params.padding_values.height;
+  window.filter_x_start = std::max(0, -window.in_x_origin);
+  window.filter_x_end =
+      std::min(params.filter_width, input_width - window.in_x_origin);
+  window.filter_y_start = std::max(0, -window.in_y_origin);
+  window.filter_y_end =
+      std::min(params.filter_height, input_height - window.in_y_origin);
+  return window;
+}
+
+inline int8_t RoundedAverage(int32_t acc, int filter_count,
+                             const PoolParams& params) {
+  acc = acc > 0 ? (acc + filter_count / 2) / filter_count
+                : (acc - filter_count / 2) / filter_count;
+  acc = std::max(acc, params.quantized_activation_min);
+  acc = std::min(acc, params.quantized_activation_max);
+  return static_cast<int8_t>(acc);
+}
+
+TF_LITE_MICRO_X86_AVX2 bool AveragePoolAvx2(const PoolParams& params,
+                                            const RuntimeShape& input_shape,
+                                            const int8_t* input_data,
+                                            const RuntimeShape& output_shape,
+                                            int8_t* output_data) {
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int depth = MatchingDim(input_shape, 3, output_shape, 3);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const PoolWindow window =
+            GetPoolWindow(params, input_height, input_width, out_y, out_x);
+        if (window.filter_x_end <= window.filter_x_start ||
+            window.filter_y_end <= window.filter_y_start) {
+          return false;
+        }
+        const int filter_count =
+            (window.filter_x_end - window.filter_x_start) *
+            (window.filter_y_end - window.filter_y_start);
+        int8_t* output_pixel =
+            &output_data[Offset(output_shape, batch, out_y, out_x, 0)];
+        int channel = 0;
+        for (; channel <= depth - 8; channel += 8) {
+          __m256i acc = _mm256_setzero_si256();
+          for (int filter_y = window.filter_y_start;
+               filter_y < window.filter_y_end; ++filter_y) {
+            for (int filter_x = window.filter_x_start;
+                 filter_x < window.filter_x_end; ++filter_x) {
+              acc = _mm256_add_epi32(
+                  acc, LoadInt8AsInt32(&input_data[Offset(
+                           input_shape, batch, window.in_y_origin + filter_y,
+                           window.in_x_origin + filter_x, channel)]));
+            }
+          }
+          int32_t sums[8];
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums), acc);
+          for (int i = 0; i < 8; ++i) {
+            output_pixel[channel + i] =
+                RoundedAverage(sums[i], filter_count, params);
+          }
+        }
+        for (; channel < depth; ++channel) {
+          int32_t acc = 0;
+          for (int filter_y = window.filter_y_start;
+               filter_y < window.filter_y_end; ++filter_y) {
+            for (int filter_x = window.filter_x_start;
+                 filter_x < window.filter_x_end; ++filter_x) {
+              acc += input_data[Offset(input_shape, batch,
+                                       window.in_y_origin + filter_y,
+                                       window.in_x_origin + filter_x, channel)];
+            }
+          }
+          output_pixel[channel] = RoundedAverage(acc, filter_count, params);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+TF_LITE_MICRO_X86_AVX2 void MaxPoolAvx2(const PoolParams& params,
+                                        const RuntimeShape& input_shape,
+                                        const int8_t* input_data,
+                                        const RuntimeShape& output_shape,
+                                        int8_t* output_data) {
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int depth = MatchingDim(input_shape, 3, output_shape, 3);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int8_t activation_min =
+      static_cast<int8_t>(params.quantized_activation_min);
+  const int8_t activation_max =
+      static_cast<int8_t>(params.quantized_activation_max);
+  const __m256i activation_min_vector = _mm256_set1_epi8(activation_min);
+  const __m256i activation_max_vector = _mm256_set1_epi8(activation_max);
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const PoolWindow window =
+            GetPoolWindow(params, input_height, input_width, out_y, out_x);
+        int8_t* output_pixel =
+            &output_data[Offset(output_shape, batch, out_y, out_x, 0)];
+        int channel = 0;
+        for (; channel <= depth - 32; channel += 32) {
+          __m256i max =
+              _mm256_set1_epi8(std::numeric_limits<int8_t>::lowest());
+          for (int filter_y = window.filter_y_start;
+               filter_y < window.filter_y_end; ++filter_y) {
+            for (int filter_x = window.filter_x_start;
+                 filter_x < window.filter_x_end; ++filter_x) {
+              max = _mm256_max_epi8(
+                  max, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+                           &input_data[Offset(input_shape, batch,
+                                              window.in_y_origin + filter_y,
+                                              window.in_x_origin + filter_x,
+                                              channel)])));
+            }
+          }
+          max = _mm256_min_epi8(_mm256_max_epi8(max, activation_min_vector),
+                                activation_max_vector);
+          _mm256_storeu_si256(
+              reinterpret_cast<__m256i*>(&output_pixel[channel]), max);
+        }
+        for (; channel < depth; ++channel) {
+          int8_t max = std::numeric_limits<int8_t>::lowest();
+          for (int filter_y = window.filter_y_start;
+               filter_y < window.filter_y_end; ++filter_y) {
+            for (int filter_x = window.filter_x_start;
+                 filter_x < window.filter_x_end; ++filter_x) {
+              max = std::max(
+                  max, input_data[Offset(input_shape, batch,
+                                         window.in_y_origin + filter_y,
+                                         window.in_x_origin + filter_x,
+                                         channel)]);
+            }
+          }
+          max = std::max(max, activation_min);
+          max = std::min(max, activation_max);
+          output_pixel[channel] = max;
+        }
+      }
+    }
+  }
+}
+
+TF_LITE_MICRO_X86_AVX2 inline void StoreOutput(int8_t* data, __m256i vector) {
+  StoreInt32AsInt8(data, vector);
+}
+
+TF_LITE_MICRO_X86_AVX2 inline void StoreOutput(int16_t* data,
+                                               __m256i vector) {
+  StoreInt32AsInt16(data, vector);
+}
+
+// Same arithmetic as reference_ops::Softmax for int8 input. An int8 row has
+// at most 256 distinct differences to its maximum, so exp() of every
+// difference is computed once per call and looked up for each element.
+template <typename OutputT>
+TF_LITE_MICRO_X86_AVX2 void SoftmaxAvx2(const SoftmaxParams& params,
+                                        const RuntimeShape& input_shape,
+                                        const int8_t* input_data,
+                                        const RuntimeShape& output_shape,
+                                        OutputT* output_data) {
+  static constexpr int kScaledDiffIntegerBits = 5;
+  static constexpr int kAccumulationIntegerBits = 12;
+  using FixedPointScaledDiff =
+      gemmlowp::FixedPoint<int32_t, kScaledDiffIntegerBits>;
+  using FixedPointAccum =
+      gemmlowp::FixedPoint<int32_t, kAccumulationIntegerBits>;
+  using FixedPoint0 = gemmlowp::FixedPoint<int32_t, 0>;
+  constexpr int kTableSize = 256;
+
+  // Both tables are indexed by max_in_row - input, and are zero for
+  // differences below diff_min so they drop out of the sum.
+  int32_t exp_table[kTableSize];
+  int32_t accum_table[kTableSize];
+  const int max_index = std::min(kTableSize - 1, -params.diff_min);
+  for (int index = 0; index < kTableSize; ++index) {
+    if (index > max_index) {
+      exp_table[index] = 0;
+      accum_table[index] = 0;
+      continue;
+    }
+    const int32_t input_diff_rescaled =
+        MultiplyByQuantizedMultiplierGreaterThanOne(
+            -index, params.input_multiplier, params.input_left_shift);
+    const FixedPoint0 exp_value = gemmlowp::exp_on_negative_values(
+        FixedPointScaledDiff::FromRaw(input_diff_rescaled));
+    exp_table[index] = exp_value.raw();
+    accum_table[index] =
+        gemmlowp::Rescale<kAccumulationIntegerBits>(exp_value).raw();
+  }
+
+  const int trailing_dim = input_shape.DimensionsCount() - 1;
+  const int outer_size =
+      MatchingFlatSizeSkipDim(input_shape, trailing_dim, output_shape);
+  const int depth =
+      MatchingDim(input_shape, trailing_dim, output_shape, trailing_dim);
+  constexpr int32_t kOutputMin = std::numeric_limits<OutputT>::min();
+  constexpr int32_t kOutputMax = std::numeric_limits<OutputT>::max();
+  const __m256i max_index_vector = _mm256_set1_epi32(max_index);
+  const __m256i output_min_vector = _mm256_set1_epi32(kOutputMin);
+  const __m256i output_max_vector = _mm256_set1_epi32(kOutputMax);
+
+  for (int i = 0; i < outer_size; ++i) {
+    const int8_t* input_row = input_data + i * depth;
+    OutputT* output_row = output_data + i * depth;
+
+    __m256i max_vector =
+        _mm256_set1_epi8(std::numeric_limits<int8_t>::min());
+    int c = 0;
+    for (; c <= depth - 32; c += 32) {
+      max_vector = _mm256_max_epi8(
+          max_vector, _mm256_loadu_si256(
+                          reinterpret_cast<const __m256i*>(input_row + c)));
+    }
+    int8_t max_lanes[32];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(max_lanes), max_vector);
+    int8_t max_in_row = *std::max_element(max_lanes, max_lanes + 32);
+    for (; c < depth; ++c) {
+      max_in_row = std::max(max_in_row, input_row[c]);
+    }
+    const __m256i max_in_row_vector = _mm256_set1_epi32(max_in_row);
+
+    __m256i sum_vector = _mm256_setzero_si256();
+    for (c = 0; c <= depth - 8; c += 8) {
+      const __m256i index =
+          _mm256_sub_epi32(max_in_row_vector, LoadInt8AsInt32(input_row + c));
+      sum_vector = _mm256_add_epi32(
+          sum_vector, _mm256_i32gather_epi32(accum_table, index, 4));
+    }
+    int32_t sum = HorizontalSum(sum_vector);
+    for (; c < depth; ++c) {
+      sum += accum_table[max_in_row - input_row[c]];
+    }
+    const FixedPointAccum sum_of_exps = FixedPointAccum::FromRaw(sum);
+
+    int num_bits_over_unit;
+    const FixedPoint0 shifted_scale = FixedPoint0::FromRaw(GetReciprocal(
+        sum_of_exps.raw(), kAccumulationIntegerBits, &num_bits_over_unit));
+    const int exponent = num_bits_over_unit + 31 - (sizeof(OutputT) * 8);
+
+    // Exponents past 31 are outside what the vector shifts reproduce, so
+    // such rows take the scalar loop below.
+    c = 0;
+    if (exponent <= 31) {
+      const __m256i scale_vector = _mm256_set1_epi32(shifted_scale.raw());
+      const __m256i exponent_vector = _mm256_set1_epi32(exponent);
+      for (; c <= depth - 8; c += 8) {
+        const __m256i index = _mm256_sub_epi32(max_in_row_vector,
+                                               LoadInt8AsInt32(input_row + c));
+        const __m256i exp_in_0 = _mm256_i32gather_epi32(exp_table, index, 4);
+        const __m256i unsat_output = RoundingDivideByPOT(
+            SaturatingRoundingDoublingHighMul(scale_vector, exp_in_0),
+            exponent_vector);
+        const __m256i output =
+            Clamp(_mm256_add_epi32(unsat_output, output_min_vector),
+                  output_min_vector, output_max_vector);
+        const __m256i skipped = _mm256_cmpgt_epi32(index, max_index_vector);
+        StoreOutput(output_row + c,
+                    _mm256_blendv_epi8(output, output_min_vector, skipped));
+      }
+    }
+    for (; c < depth; ++c) {
+      const int index = max_in_row - input_row[c];
+      if (index <= max_index) {
+        const int32_t unsat_output = gemmlowp::RoundingDivideByPOT(
+            (shifted_scale * FixedPoint0::FromRaw(exp_table[index])).raw(),
+            exponent);
+        const int32_t shifted_output = unsat_output + kOutputMin;
+        output_row[c] = static_cast<OutputT>(
+            std::max(std::min(shifted_output, kOutputMax), kOutputMin));
+      } else {
+        output_row[c] = static_cast<OutputT>(kOutputMin);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int ConvPerChannelScratchSize(const RuntimeShape& filter_shape) {
+  return filter_shape.Dims(1) * filter_shape.Dims(2) * filter_shape.Dims(3);
+}
+
+bool ConvPerChannel(const ConvParams& params, const int32_t* output_multiplier,
+                    const int32_t* output_shift,
+                    const RuntimeShape& input_shape, const int8_t* input_data,
+                    const RuntimeShape& filter_shape, const int8_t* filter_data,
+                    const RuntimeShape& bias_shape, const int32_t* bias_data,
+                    const RuntimeShape& output_shape, int8_t* output_data,
+                    int8_t* scratch) {
+  const DotProductFn dot_product = GetDotProduct();
+  if (dot_product == nullptr || scratch == nullptr) {
+    return false;
+  }
+
+  const int32_t input_offset = params.input_offset;
+  const int stride_width = params.stride_width;
+  const int stride_height = params.stride_height;
+  const int dilation_width_factor = params.dilation_width_factor;
+  const int dilation_height_factor = params.dilation_height_factor;
+  const int pad_width = params.padding_values.width;
+  const int pad_height = params.padding_values.height;
+  const int32_t output_offset = params.output_offset;
+  const int32_t output_activation_min = params.quantized_activation_min;
+  const int32_t output_activation_max = params.quantized_activation_max;
+
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_depth = input_shape.Dims(3);
+  const int output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int filter_height = filter_shape.Dims(1);
+  const int filter_width = filter_shape.Dims(2);
+  const int filter_input_depth = filter_shape.Dims(3);
+  const int groups = input_depth / filter_input_depth;
+  const int filters_per_group = output_depth / groups;
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int patch_size = ConvPerChannelScratchSize(filter_shape);
+
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const int in_y_origin = (out_y * stride_height) - pad_height;
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin = (out_x * stride_width) - pad_width;
+        for (int group = 0; group < groups; ++group) {
+          // Gather the receptive field into a contiguous patch laid out like
+          // one filter. Padding is filled with the input zero point, which
+          // contributes nothing once input_offset is added.
+          int8_t* patch = scratch;
+          for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+            const int in_y = in_y_origin + dilation_height_factor * filter_y;
+            for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
+              const int in_x = in_x_origin + dilation_width_factor * filter_x;
+              if (in_y < 0 || in_y >= input_height || in_x < 0 ||
+                  in_x >= input_width) {
+                std::memset(patch, -input_offset, filter_input_depth);
+              } else {
+                std::memcpy(patch,
+                            &input_data[Offset(input_shape, batch, in_y, in_x,
+                                               group * filter_input_depth)],
+                            filter_input_depth);
+              }
+              patch += filter_input_depth;
+            }
+          }
+          for (int out_channel = group * filters_per_group;
+               out_channel < (group + 1) * filters_per_group; ++out_channel) {
+            int32_t acc = dot_product(
+                scratch, input_offset,
+                &filter_data[Offset(filter_shape, out_channel, 0, 0, 0)], 0,
+                patch_size);
+            if (bias_data) {
+              acc += bias_data[out_channel];
+            }
+            output_data[Offset(output_shape, batch, out_y, out_x,
+                               out_channel)] =
+                RequantizeToInt8(acc, output_multiplier[out_channel],
+                                 output_shift[out_channel], output_offset,
+                                 output_activation_min, output_activation_max);
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool DepthwiseConvPerChannel(
+    const DepthwiseParams& params, const int32_t* output_multiplier,
+    const int32_t* output_shift, const RuntimeShape& input_shape,
+    const int8_t* input_data, const RuntimeShape& filter_shape,
+    const int8_t* filter_data, const RuntimeShape& bias_shape,
+    const int32_t* bias_data, const RuntimeShape& output_shape,
+    int8_t* output_data) {
+  if (!HasAvx2() || params.depth_multiplier != 1) {
+    return false;
+  }
+  DepthwiseConvPerChannelAvx2(params, output_multiplier, output_shift,
+                              input_shape, input_data, filter_shape,
+                              filter_data, bias_shape, bias_data, output_shape,
+                              output_data);
+  return true;
+}
+
+bool FullyConnected(const FullyConnectedParams& params,
+                    const RuntimeShape& input_shape, const int8_t* input_data,
+                    const RuntimeShape& filter_shape, const int8_t* filter_data,
+                    const RuntimeShape& bias_shape, const int32_t* bias_data,
+                    const RuntimeShape& output_shape, int8_t* output_data) {
+  const DotProductFn dot_product = GetDotProduct();
+  if (dot_product == nullptr) {
+    return false;
+  }
+  const int filter_dim_count = filter_shape.DimensionsCount();
+  const int output_dim_count = output_shape.DimensionsCount();
+  const int batches = FlatSizeSkipDim(output_shape, output_dim_count - 1);
+  const int output_depth = output_shape.Dims(output_dim_count - 1);
+  const int accum_depth = filter_shape.Dims(filter_dim_count - 1);
+  for (int b = 0; b < batches; ++b) {
+    for (int out_c = 0; out_c < output_depth; ++out_c) {
+      int32_t acc = dot_product(input_data + b * accum_depth,
+                                params.input_offset,
+                                filter_data + out_c * accum_depth,
+                                params.weights_offset, accum_depth);
+      if (bias_data) {
+        acc += bias_data[out_c];
+      }
+      output_data[out_c + output_depth * b] = RequantizeToInt8(
+          acc, params.output_multiplier, params.output_shift,
+          params.output_offset, params.quantized_activation_min,
+          params.quantized_activation_max);
+    }
+  }
+  return true;
+}
+
+bool AddElementwise(int size, const ArithmeticParams& params,
+                    const int8_t* input1_data, const int8_t* input2_data,
+                    int8_t* output_data) {
+  if (!HasAvx2()) {
+    return false;
+  }
+  AddElementwiseAvx2(size, params, input1_data, input2_data, output_data);
+  return true;
+}
+
+bool MulElementwise(int size, const ArithmeticParams& params,
+                    const int8_t* input1_data, const int8_t* input2_data,
+                    int8_t* output_data) {
+  if (!HasAvx2()) {
+    return false;
+  }
+  MulElementwiseAvx2(size, params, input1_data, input2_data, output_data);
+  return true;
+}
+
+bool AveragePool(const PoolParams& params, const RuntimeShape& input_shape,
+                 const int8_t* input_data, const RuntimeShape& output_shape,
+                 int8_t* output_data) {
+  if (!HasAvx2()) {
+    return false;
+  }
+  return AveragePoolAvx2(params, input_shape, input_data, output_shape,
+                         output_data);
+}
+
+bool MaxPool(const PoolParams& params, const RuntimeShape& input_shape,
+             const int8_t* input_data, const RuntimeShape& output_shape,
+             int8_t* output_data) {
+  if (!HasAvx2()) {
+    return false;
+  }
+  MaxPoolAvx2(params, input_shape, input_data, output_shape, output_data);
+  return true;
+}
+
+bool Softmax(const SoftmaxParams& params, const RuntimeShape& input_shape,
+             const int8_t* input_data, const RuntimeShape& output_shape,
+             int8_t* output_data) {
+  if (!HasAvx2()) {
+    return false;
+  }
+  SoftmaxAvx2(params, input_shape, input_data, output_shape, output_data);
+  return true;
+}
+
+bool Softmax(const SoftmaxParams& params, const RuntimeShape& input_shape,
+             const int8_t* input_data, const RuntimeShape& output_shape,
+             int16_t* output_data) {
+  if (!HasAvx2()) {
+    return false;
+  }
+  SoftmaxAvx2(params, input_shape, input_data, output_shape, output_data);
+  return true;
+}
+
+}  // namespace x86_int8
+}  // namespace tflite
+
+#endif  // defined(TF_LITE_MICRO_X86_INT8_ENABLED)
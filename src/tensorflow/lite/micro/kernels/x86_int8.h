@@ -0,0 +1,97 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_X86_INT8_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_X86_INT8_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/kernels/internal/types.h"
+
+// Optional x86-64 int8 kernels for replaying models on Linux hosts with the
+// same build that runs on device. When enabled, the CMSIS-NN kernels try these
+// first and run their regular implementation whenever a function returns
+// false, e.g. on a CPU without AVX2 or for an unsupported configuration.
+//
+// The backend is compiled in by defining TF_LITE_MICRO_X86_INT8. The
+// instruction set is selected at runtime: AVX2 is required, and the
+// convolution and fully connected dot products use AVX-512 VNNI when the CPU
+// supports it. Outputs are bit-exact with reference_integer_ops.
+#if defined(TF_LITE_MICRO_X86_INT8) && defined(__x86_64__) && \
+    defined(__GNUC__)
+#define TF_LITE_MICRO_X86_INT8_ENABLED
+#endif
+
+namespace tflite {
+namespace x86_int8 {
+
+#if defined(TF_LITE_MICRO_X86_INT8_ENABLED)
+
+// Returns the number of bytes of scratch memory ConvPerChannel needs.
+int ConvPerChannelScratchSize(const RuntimeShape& filter_shape);
+
+bool ConvPerChannel(const ConvParams& params, const int32_t* output_multiplier,
+                    const int32_t* output_shift,
+                    const RuntimeShape& input_shape, const int8_t* input_data,
+                    const RuntimeShape& filter_shape, const int8_t* filter_data,
+                    const RuntimeShape& bias_shape, const int32_t* bias_data,
+                    const RuntimeShape& output_shape, int8_t* output_data,
+                    int8_t* scratch);
+
+// Only depth_multiplier == 1 is handled.
+bool DepthwiseConvPerChannel(
+    const DepthwiseParams& params, const int32_t* output_multiplier,
+    const int32_t* output_shift, const RuntimeShape& input_shape,
+    const int8_t* input_data, const RuntimeShape& filter_shape,
+    const int8_t* filter_data, const RuntimeShape& bias_shape,
+    const int32_t* bias_data, const RuntimeShape& output_shape,
+    int8_t* output_data);
+
+bool FullyConnected(const FullyConnectedParams& params,
+                    const RuntimeShape& input_shape, const int8_t* input_data,
+                    const RuntimeShape& filter_shape, const int8_t* filter_data,
+                    const RuntimeShape& bias_shape, const int32_t* bias_data,
+                    const RuntimeShape& output_shape, int8_t* output_data);
+
+// Element-wise (non-broadcast) ADD and MUL over `size` elements.
+bool AddElementwise(int size, const ArithmeticParams& params,
+                    const int8_t* input1_data, const int8_t* input2_data,
+                    int8_t* output_data);
+
+bool MulElementwise(int size, const ArithmeticParams& params,
+                    const int8_t* input1_data, const int8_t* input2_data,
+                    int8_t* output_data);
+
+bool AveragePool(const PoolParams& params, const RuntimeShape& input_shape,
+                 const int8_t* input_data, const RuntimeShape& output_shape,
+                 int8_t* output_data);
+
+bool MaxPool(const PoolParams& params, const RuntimeShape& input_shape,
+             const int8_t* input_data, const RuntimeShape& output_shape,
+             int8_t* output_data);
+
+bool Softmax(const SoftmaxParams& params, const RuntimeShape& input_shape,
+             const int8_t* input_data, const RuntimeShape& output_shape,
+             int8_t* output_data);
+
+bool Softmax(const SoftmaxParams& params, const RuntimeShape& input_shape,
+             const int8_t* input_data, const RuntimeShape& output_shape,
+             int16_t* output_data);
+
+#endif  // defined(TF_LITE_MICRO_X86_INT8_ENABLED)
+
+}  // namespace x86_int8
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_X86_INT8_H_
@@ -21,6 +21,7 @@ limitations under the License.
 #include "third_party/flatbuffers/include/flatbuffers/flatbuffers.h"
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/micro/micro_arena_constants.h"
 #include "tensorflow/lite/micro/tflite_bridge/flatbuffer_conversions_bridge.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
@@ -98,6 +99,19 @@ TfLiteStatus TfLiteTypeSizeOf(TfLiteType type, size_t* size) {
   return kTfLiteOk;
 }
 
+size_t TensorDataAlignment(TfLiteType type, size_t min_alignment) {
+  size_t alignment = min_alignment;
+  size_t type_size;
+  if (TfLiteTypeSizeOf(type, &type_size) == kTfLiteOk &&
+      type_size > alignment) {
+    alignment = type_size;
+  }
+  if (alignment > static_cast<size_t>(MicroArenaBufferAlignment())) {
+    alignment = MicroArenaBufferAlignment();
+  }
+  return alignment;
+}
+
 TfLiteStatus BytesRequiredForTensor(const tflite::Tensor& flatbuffer_tensor,
                                     size_t* bytes, size_t* type_size) {
   int element_count = 1;
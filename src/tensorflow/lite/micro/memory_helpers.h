@@ -42,6 +42,11 @@ size_t AlignSizeUp(size_t count = 1) {
 // Returns size in bytes for a given TfLiteType.
 TfLiteStatus TfLiteTypeSizeOf(TfLiteType type, size_t* size);
 
+// Returns the alignment of the data of a tensor of the given type in the
+// arena: the size of its elements, but at least min_alignment and at most
+// MicroArenaBufferAlignment().
+size_t TensorDataAlignment(TfLiteType type, size_t min_alignment);
+
 // How many bytes are needed to hold a tensor's contents.
 TfLiteStatus BytesRequiredForTensor(const tflite::Tensor& flatbuffer_tensor,
                                     size_t* bytes, size_t* type_size);
@@ -101,6 +101,7 @@ TfLiteStatus GreedyMemoryPlanner::AddBuffer(int size, int first_time_used,
   current->first_time_used = first_time_used;
   current->last_time_used = last_time_used;
   current->offline_offset = kOnlinePlannedBuffer;
+  current->alignment = 1;
   ++buffer_count_;
   need_to_calculate_offsets_ = true;
   return kTfLiteOk;
@@ -117,6 +118,16 @@ TfLiteStatus GreedyMemoryPlanner::AddBuffer(int size, int first_time_used,
   return kTfLiteOk;
 }
 
+void GreedyMemoryPlanner::SetBufferAlignment(int buffer_index,
+                                             int alignment) {
+  if ((buffer_index < 0) || (buffer_index >= buffer_count_) ||
+      (alignment < 1)) {
+    return;
+  }
+  requirements_[buffer_index].alignment = alignment;
+  need_to_calculate_offsets_ = true;
+}
+
 bool GreedyMemoryPlanner::DoesEntryOverlapInTime(
     const GreedyMemoryPlanner::ListEntry* entry, const int first_time_used,
     const int last_time_used) const {
@@ -220,6 +231,7 @@ void GreedyMemoryPlanner::CalculateOffsetsIfNeeded() {
     const int wanted_size = wanted_requirements->size;
     const int wanted_first_time_used = wanted_requirements->first_time_used;
     const int wanted_last_time_used = wanted_requirements->last_time_used;
+    const int wanted_alignment = wanted_requirements->alignment;
 
     // Find the first buffer that's active in our time range. All placed
     // buffers are stored in the order of their starting position in the arena
@@ -242,7 +254,10 @@ void GreedyMemoryPlanner::CalculateOffsetsIfNeeded() {
           const int prior_entry_offset =
               prior_entry->offset + candidate_requirements->size;
           if (prior_entry_offset > candidate_offset) {
-            candidate_offset = prior_entry_offset;
+            // Round up to the alignment of the wanted buffer, which may be
+            // larger than the one of the buffers placed before it.
+            candidate_offset = (prior_entry_offset + wanted_alignment - 1) /
+                               wanted_alignment * wanted_alignment;
           }
         }
         if (next_entry == nullptr) {
@@ -56,7 +56,7 @@ class GreedyMemoryPlanner : public MicroMemoryPlanner {
   // planned for will depend on the size of this scratch memory, so you should
   // enlarge it if you see an error when calling AddBuffer(). The memory can be
   // reused once you're done with the planner, as long as you copy the
-  // calculated offsets to another location. Each buffer requires about 36 bytes
+  // calculated offsets to another location. Each buffer requires about 40 bytes
   // of scratch.
   TfLiteStatus Init(unsigned char* scratch_buffer,
                     int scratch_buffer_size) override;
@@ -70,6 +70,10 @@ class GreedyMemoryPlanner : public MicroMemoryPlanner {
   TfLiteStatus AddBuffer(int size, int first_time_used, int last_time_used,
                          int offline_offset) override;
 
+  // Buffers are placed at offsets that are multiples of their alignment, 1 by
+  // default.
+  void SetBufferAlignment(int buffer_index, int alignment) override;
+
   // Returns the high-water mark of used memory. This is the minimum size of a
   // memory arena you'd need to allocate to hold these buffers.
   size_t GetMaximumMemorySize() override;
@@ -134,6 +138,7 @@ class GreedyMemoryPlanner : public MicroMemoryPlanner {
     int offline_offset;
     int first_time_used;
     int last_time_used;
+    int alignment;
   };
 
   // Working arrays used during the layout algorithm.
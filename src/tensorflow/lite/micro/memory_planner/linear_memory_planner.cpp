@@ -23,6 +23,14 @@ LinearMemoryPlanner::LinearMemoryPlanner()
     : current_buffer_count_(0), next_free_offset_(0) {}
 LinearMemoryPlanner::~LinearMemoryPlanner() {}
 
+TfLiteStatus LinearMemoryPlanner::Init(unsigned char* scratch_buffer,
+                                       int scratch_buffer_size) {
+  // Reset internal states, so that the planner can plan another model.
+  current_buffer_count_ = 0;
+  next_free_offset_ = 0;
+  return kTfLiteOk;
+}
+
 TfLiteStatus LinearMemoryPlanner::AddBuffer(int size, int first_time_used,
                                             int last_time_used) {
   if (current_buffer_count_ >= kMaxBufferCount) {
@@ -35,6 +43,17 @@ TfLiteStatus LinearMemoryPlanner::AddBuffer(int size, int first_time_used,
   return kTfLiteOk;
 }
 
+void LinearMemoryPlanner::SetBufferAlignment(int buffer_index,
+                                             int alignment) {
+  if ((buffer_index != current_buffer_count_ - 1) || (alignment < 1)) {
+    return;
+  }
+  const size_t size = next_free_offset_ - buffer_offsets_[buffer_index];
+  buffer_offsets_[buffer_index] =
+      (buffer_offsets_[buffer_index] + alignment - 1) / alignment * alignment;
+  next_free_offset_ = buffer_offsets_[buffer_index] + size;
+}
+
 size_t LinearMemoryPlanner::GetMaximumMemorySize() { return next_free_offset_; }
 
 int LinearMemoryPlanner::GetBufferCount() { return current_buffer_count_; }
@@ -28,9 +28,15 @@ class LinearMemoryPlanner : public MicroMemoryPlanner {
   LinearMemoryPlanner();
   ~LinearMemoryPlanner() override;
 
+  TfLiteStatus Init(unsigned char* scratch_buffer,
+                    int scratch_buffer_size) override;
+
   TfLiteStatus AddBuffer(int size, int first_time_used,
                          int last_time_used) override;
 
+  // Moves the buffer added last up to the alignment.
+  void SetBufferAlignment(int buffer_index, int alignment) override;
+
   size_t GetMaximumMemorySize() override;
   int GetBufferCount() override;
   TfLiteStatus GetOffsetForBuffer(int buffer_index, int* offset) override;
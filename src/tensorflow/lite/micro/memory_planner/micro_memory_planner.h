@@ -71,6 +71,29 @@ class MicroMemoryPlanner {
   // Calculated layout offset for the N-th buffer added to the planner.
   virtual TfLiteStatus GetOffsetForBuffer(int buffer_index, int* offset) = 0;
 
+  // Calculated address of the N-th buffer added to the planner when the plan
+  // starts at arena_start. Planners that place buffers outside of the arena
+  // override this. By default, the buffer is at its offset in the arena.
+  virtual TfLiteStatus GetAddressForBuffer(int buffer_index,
+                                           uint8_t* arena_start,
+                                           uint8_t** address) {
+    int offset = -1;
+    TF_LITE_ENSURE_STATUS(GetOffsetForBuffer(buffer_index, &offset));
+    *address = arena_start + offset;
+    return kTfLiteOk;
+  }
+
+  // Hint about how often the N-th buffer is accessed during an invocation,
+  // relative to the other buffers. Planners that ignore it need not override
+  // this.
+  virtual void SetBufferAccessWeight(int buffer_index, int access_weight) {}
+
+  // Alignment in bytes, a power of two, that the offset of the N-th buffer
+  // must be a multiple of. It is set right after the buffer is added. Planners
+  // that ignore it only produce aligned offsets when every buffer size is a
+  // multiple of every alignment, as with the default MicroAlignmentPolicy.
+  virtual void SetBufferAlignment(int buffer_index, int alignment) {}
+
   // Provides the scratch buffer in case that the memory planner needs it.
   // The lifetime of scratch buffers lifetime lasts until the static memory plan
   // is committed.
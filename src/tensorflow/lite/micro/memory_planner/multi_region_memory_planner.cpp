@@ -0,0 +1,368 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/memory_planner/multi_region_memory_planner.h"
+
+#include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/micro/micro_arena_constants.h"
+#include "tensorflow/lite/micro/micro_log.h"
+
+namespace tflite {
+
+MultiRegionMemoryPlanner::MultiRegionMemoryPlanner() {
+  regions_[0].base = nullptr;
+  regions_[0].size = 0;
+  regions_[0].latency_weight = 1;
+  regions_[0].first_entry_index = -1;
+  regions_[0].used = 0;
+}
+
+MultiRegionMemoryPlanner::~MultiRegionMemoryPlanner() {
+  // We don't own the scratch buffer or the regions, so don't deallocate
+  // anything.
+}
+
+TfLiteStatus MultiRegionMemoryPlanner::AddRegion(uint8_t* base, size_t size,
+                                                 int latency_weight) {
+  if (num_regions_ >= kMaxRegions) {
+    MicroPrintf("Too many memory regions (max is %d)", kMaxRegions - 1);
+    return kTfLiteError;
+  }
+  if (base == nullptr) {
+    MicroPrintf("Memory region %d has no base address", num_regions_);
+    return kTfLiteError;
+  }
+  uint8_t* aligned_base = AlignPointerUp(base, MicroArenaBufferAlignment());
+  const size_t alignment_loss = aligned_base - base;
+  Region* region = &regions_[num_regions_];
+  region->base = aligned_base;
+  region->size = size > alignment_loss ? size - alignment_loss : 0;
+  region->latency_weight = latency_weight;
+  region->first_entry_index = -1;
+  region->used = 0;
+  ++num_regions_;
+  need_to_calculate_plan_ = true;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MultiRegionMemoryPlanner::Init(unsigned char* scratch_buffer,
+                                            int scratch_buffer_size) {
+  // Reset internal states
+  buffer_count_ = 0;
+  need_to_calculate_plan_ = true;
+
+  // Allocate the arrays we need within the scratch buffer arena and hand the
+  // rest to the arena planner.
+  max_buffer_count_ = scratch_buffer_size / per_buffer_size();
+
+  unsigned char* next_free = scratch_buffer;
+  requirements_ = reinterpret_cast<BufferRequirements*>(next_free);
+  next_free += sizeof(BufferRequirements) * max_buffer_count_;
+
+  buffer_ids_sorted_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+
+  region_entries_ = reinterpret_cast<ListEntry*>(next_free);
+  next_free += sizeof(ListEntry) * max_buffer_count_;
+
+  arena_planner_scratch_ = next_free;
+  arena_planner_scratch_size_ =
+      scratch_buffer_size - static_cast<int>(next_free - scratch_buffer);
+  return arena_planner_.Init(arena_planner_scratch_,
+                             arena_planner_scratch_size_);
+}
+
+TfLiteStatus MultiRegionMemoryPlanner::AddBuffer(int size, int first_time_used,
+                                                 int last_time_used) {
+  return AddBuffer(size, first_time_used, last_time_used,
+                   kOnlinePlannedBuffer);
+}
+
+TfLiteStatus MultiRegionMemoryPlanner::AddBuffer(int size, int first_time_used,
+                                                 int last_time_used,
+                                                 int offline_offset) {
+  if (buffer_count_ >= max_buffer_count_) {
+    MicroPrintf("Too many buffers (max is %d)", max_buffer_count_);
+    return kTfLiteError;
+  }
+  BufferRequirements* current = &requirements_[buffer_count_];
+  current->size = size;
+  current->first_time_used = first_time_used;
+  current->last_time_used = last_time_used;
+  current->offline_offset = offline_offset;
+  current->access_weight = 1;
+  current->alignment = 1;
+  current->region = 0;
+  current->offset = -1;
+  ++buffer_count_;
+  need_to_calculate_plan_ = true;
+  return kTfLiteOk;
+}
+
+void MultiRegionMemoryPlanner::SetBufferAccessWeight(int buffer_index,
+                                                     int access_weight) {
+  if ((buffer_index < 0) || (buffer_index >= buffer_count_)) {
+    return;
+  }
+  requirements_[buffer_index].access_weight = access_weight;
+  need_to_calculate_plan_ = true;
+}
+
+void MultiRegionMemoryPlanner::SetBufferAlignment(int buffer_index,
+                                                  int alignment) {
+  if ((buffer_index < 0) || (buffer_index >= buffer_count_) ||
+      (alignment < 1)) {
+    return;
+  }
+  requirements_[buffer_index].alignment = alignment;
+  need_to_calculate_plan_ = true;
+}
+
+bool MultiRegionMemoryPlanner::IsHigherPriority(
+    const BufferRequirements& a, const BufferRequirements& b) const {
+  // Placing a buffer in fast memory saves time in proportion to its size and
+  // number of accesses, and uses up space in proportion to its size and
+  // lifetime, so rank by accesses per unit of lifetime.
+  const int64_t a_lifetime = a.last_time_used - a.first_time_used + 1;
+  const int64_t b_lifetime = b.last_time_used - b.first_time_used + 1;
+  const int64_t a_rank = static_cast<int64_t>(a.access_weight) * b_lifetime;
+  const int64_t b_rank = static_cast<int64_t>(b.access_weight) * a_lifetime;
+  if (a_rank != b_rank) {
+    return a_rank > b_rank;
+  }
+  // Smaller buffers are more likely to fit next to the ones already placed.
+  return a.size < b.size;
+}
+
+bool MultiRegionMemoryPlanner::PlaceInRegion(int requirements_index,
+                                             int region_index) {
+  Region* region = &regions_[region_index];
+  BufferRequirements* wanted = &requirements_[requirements_index];
+
+  // Find the first gap between the buffers of the region that are active at
+  // the same time as the wanted buffer, like GreedyMemoryPlanner does.
+  int candidate_offset = 0;
+  for (int i = region->first_entry_index; i != -1;
+       i = region_entries_[i].next_entry_index) {
+    const ListEntry* entry = &region_entries_[i];
+    const BufferRequirements* placed =
+        &requirements_[entry->requirements_index];
+    if ((placed->first_time_used > wanted->last_time_used) ||
+        (wanted->first_time_used > placed->last_time_used)) {
+      continue;
+    }
+    if (entry->offset - candidate_offset >= wanted->size) {
+      break;
+    }
+    const int placed_end = entry->offset + placed->size;
+    if (placed_end > candidate_offset) {
+      candidate_offset = (placed_end + wanted->alignment - 1) /
+                         wanted->alignment * wanted->alignment;
+    }
+  }
+  const size_t end = static_cast<size_t>(candidate_offset) + wanted->size;
+  if (end > region->size) {
+    return false;
+  }
+
+  wanted->region = region_index;
+  wanted->offset = candidate_offset;
+  if (end > region->used) {
+    region->used = end;
+  }
+
+  // Keep the entries of the region ordered by offset.
+  const int new_entry_index = next_free_entry_++;
+  ListEntry* new_entry = &region_entries_[new_entry_index];
+  new_entry->offset = candidate_offset;
+  new_entry->requirements_index = requirements_index;
+  int* link = &region->first_entry_index;
+  while (*link != -1 && region_entries_[*link].offset <= candidate_offset) {
+    link = &region_entries_[*link].next_entry_index;
+  }
+  new_entry->next_entry_index = *link;
+  *link = new_entry_index;
+  return true;
+}
+
+void MultiRegionMemoryPlanner::CalculatePlanIfNeeded() {
+  if (!need_to_calculate_plan_) {
+    return;
+  }
+  need_to_calculate_plan_ = false;
+
+  // Sort the online planned buffers by descending priority. Offline planned
+  // buffers always stay at their offset in the arena.
+  int sorted_count = 0;
+  for (int i = 0; i < buffer_count_; ++i) {
+    requirements_[i].region = 0;
+    requirements_[i].offset = -1;
+    if (requirements_[i].offline_offset != kOnlinePlannedBuffer) {
+      continue;
+    }
+    int j = sorted_count++;
+    while (j > 0 &&
+           IsHigherPriority(requirements_[i],
+                            requirements_[buffer_ids_sorted_[j - 1]])) {
+      buffer_ids_sorted_[j] = buffer_ids_sorted_[j - 1];
+      --j;
+    }
+    buffer_ids_sorted_[j] = i;
+  }
+
+  // Order the regions that are faster than the arena by latency.
+  int region_order[kMaxRegions];
+  int fast_region_count = 0;
+  for (int r = 1; r < num_regions_; ++r) {
+    regions_[r].first_entry_index = -1;
+    regions_[r].used = 0;
+    if (regions_[r].latency_weight > regions_[0].latency_weight) {
+      continue;
+    }
+    int j = fast_region_count++;
+    while (j > 0 && regions_[r].latency_weight <
+                        regions_[region_order[j - 1]].latency_weight) {
+      region_order[j] = region_order[j - 1];
+      --j;
+    }
+    region_order[j] = r;
+  }
+
+  next_free_entry_ = 0;
+  for (int i = 0; i < sorted_count; ++i) {
+    for (int j = 0; j < fast_region_count; ++j) {
+      if (PlaceInRegion(buffer_ids_sorted_[i], region_order[j])) {
+        break;
+      }
+    }
+  }
+
+  // Plan everything left in the arena. The arena planner has room for as many
+  // buffers as this one, so adding them cannot fail.
+  arena_planner_.Init(arena_planner_scratch_, arena_planner_scratch_size_);
+  int arena_buffer_count = 0;
+  for (int i = 0; i < buffer_count_; ++i) {
+    BufferRequirements* current = &requirements_[i];
+    if (current->region != 0) {
+      continue;
+    }
+    if (current->offline_offset == kOnlinePlannedBuffer) {
+      arena_planner_.AddBuffer(current->size, current->first_time_used,
+                               current->last_time_used);
+    } else {
+      arena_planner_.AddBuffer(current->size, current->first_time_used,
+                               current->last_time_used,
+                               current->offline_offset);
+    }
+    arena_planner_.SetBufferAlignment(arena_buffer_count++,
+                                      current->alignment);
+  }
+  int arena_index = 0;
+  for (int i = 0; i < buffer_count_; ++i) {
+    if (requirements_[i].region == 0) {
+      arena_planner_.GetOffsetForBuffer(arena_index++,
+                                        &requirements_[i].offset);
+    }
+  }
+  regions_[0].used = arena_planner_.GetMaximumMemorySize();
+
+  weighted_access_cost_ = 0;
+  for (int i = 0; i < buffer_count_; ++i) {
+    const BufferRequirements* current = &requirements_[i];
+    weighted_access_cost_ += static_cast<uint64_t>(current->size) *
+                             current->access_weight *
+                             regions_[current->region].latency_weight;
+  }
+}
+
+size_t MultiRegionMemoryPlanner::GetMaximumMemorySize() {
+  CalculatePlanIfNeeded();
+  return regions_[0].used;
+}
+
+int MultiRegionMemoryPlanner::GetBufferCount() { return buffer_count_; }
+
+TfLiteStatus MultiRegionMemoryPlanner::GetOffsetForBuffer(int buffer_index,
+                                                          int* offset) {
+  CalculatePlanIfNeeded();
+  if ((buffer_index < 0) || (buffer_index >= buffer_count_)) {
+    MicroPrintf("buffer index %d is outside range 0 to %d", buffer_index,
+                buffer_count_);
+    return kTfLiteError;
+  }
+  *offset = requirements_[buffer_index].offset;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MultiRegionMemoryPlanner::GetAddressForBuffer(
+    int buffer_index, uint8_t* arena_start, uint8_t** address) {
+  int offset = -1;
+  TF_LITE_ENSURE_STATUS(GetOffsetForBuffer(buffer_index, &offset));
+  const int region = requirements_[buffer_index].region;
+  uint8_t* base = region == 0 ? arena_start : regions_[region].base;
+  *address = base + offset;
+  return kTfLiteOk;
+}
+
+int MultiRegionMemoryPlanner::GetRegionForBuffer(int buffer_index) {
+  CalculatePlanIfNeeded();
+  if ((buffer_index < 0) || (buffer_index >= buffer_count_)) {
+    return -1;
+  }
+  return requirements_[buffer_index].region;
+}
+
+size_t MultiRegionMemoryPlanner::GetRegionUsage(int region) {
+  CalculatePlanIfNeeded();
+  if ((region < 0) || (region >= num_regions_)) {
+    return 0;
+  }
+  return regions_[region].used;
+}
+
+uint64_t MultiRegionMemoryPlanner::GetWeightedAccessCost() {
+  CalculatePlanIfNeeded();
+  return weighted_access_cost_;
+}
+
+void MultiRegionMemoryPlanner::PrintMemoryPlan() {
+  CalculatePlanIfNeeded();
+
+  for (int i = 0; i < buffer_count_; ++i) {
+    const BufferRequirements* current = &requirements_[i];
+    MicroPrintf(
+        "%d: size=%d, region=%d, offset=%d, first_used=%d last_used=%d "
+        "accesses=%d",
+        i, current->size, current->region, current->offset,
+        current->first_time_used, current->last_time_used,
+        current->access_weight);
+  }
+  for (int r = 0; r < num_regions_; ++r) {
+    if (r == 0) {
+      MicroPrintf("Region 0 (arena): used=%d latency_weight=%d",
+                  static_cast<int>(regions_[r].used),
+                  regions_[r].latency_weight);
+    } else {
+      MicroPrintf("Region %d: used=%d of %d latency_weight=%d", r,
+                  static_cast<int>(regions_[r].used),
+                  static_cast<int>(regions_[r].size),
+                  regions_[r].latency_weight);
+    }
+  }
+  MicroPrintf("Weighted access cost: %u",
+              static_cast<uint32_t>(GetWeightedAccessCost()));
+}
+
+}  // namespace tflite
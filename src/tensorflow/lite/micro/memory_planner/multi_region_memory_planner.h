@@ -0,0 +1,178 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_MULTI_REGION_MEMORY_PLANNER_H_
+#define TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_MULTI_REGION_MEMORY_PLANNER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "tensorflow/lite/micro/memory_planner/micro_memory_planner.h"
+
+namespace tflite {
+
+// A memory planner that places buffers in fast memories outside of the arena,
+// such as the DTCM of a Cortex-M7, and the rest in the arena.
+//
+// Buffers are ranked by how often they are accessed per unit of lifetime,
+// using the access weights passed through SetBufferAccessWeight(), so that
+// scratch buffers and activations read by several nodes come first. In that
+// order, each buffer goes to the fastest region where it fits next to the
+// buffers already placed there that are live at the same time. Buffers that
+// fit nowhere and offline planned buffers are planned in the arena with a
+// GreedyMemoryPlanner. Kernels only see the resulting buffer addresses, so
+// they need no changes.
+//
+// Usage:
+//
+//   MultiRegionMemoryPlanner planner;
+//   planner.AddRegion(dtcm_buffer, sizeof(dtcm_buffer), /*latency_weight=*/1);
+//   planner.set_arena_latency_weight(3);
+//   MicroAllocator* allocator = MicroAllocator::Create(
+//       tensor_arena, kTensorArenaSize, &planner);
+//   MicroInterpreter interpreter(model, op_resolver, allocator);
+//
+// The region memory is only used for buffers of the memory plan and, like the
+// head of the arena, is overwritten when another model is planned.
+class MultiRegionMemoryPlanner : public MicroMemoryPlanner {
+ public:
+  // Maximum number of regions, including the arena.
+  static constexpr int kMaxRegions = 4;
+
+  MultiRegionMemoryPlanner();
+  ~MultiRegionMemoryPlanner() override;
+
+  // Adds a region of size bytes at base. Regions are filled in order of
+  // increasing latency_weight. latency_weight is the relative cost of an
+  // access to the region and is also used by GetWeightedAccessCost().
+  TfLiteStatus AddRegion(uint8_t* base, size_t size, int latency_weight);
+
+  // Sets the relative cost of an access to the arena, 1 by default. Regions
+  // with a higher latency weight than the arena are never used.
+  void set_arena_latency_weight(int latency_weight) {
+    regions_[0].latency_weight = latency_weight;
+  }
+
+  TfLiteStatus Init(unsigned char* scratch_buffer,
+                    int scratch_buffer_size) override;
+
+  TfLiteStatus AddBuffer(int size, int first_time_used,
+                         int last_time_used) override;
+
+  TfLiteStatus AddBuffer(int size, int first_time_used, int last_time_used,
+                         int offline_offset) override;
+
+  void SetBufferAccessWeight(int buffer_index, int access_weight) override;
+
+  void SetBufferAlignment(int buffer_index, int alignment) override;
+
+  // Returns the part of the plan that is placed in the arena.
+  size_t GetMaximumMemorySize() override;
+
+  int GetBufferCount() override;
+
+  // Offset of the buffer in its region, see GetRegionForBuffer().
+  TfLiteStatus GetOffsetForBuffer(int buffer_index, int* offset) override;
+
+  TfLiteStatus GetAddressForBuffer(int buffer_index, uint8_t* arena_start,
+                                   uint8_t** address) override;
+
+  // Prints the placement of every buffer and the usage of every region.
+  void PrintMemoryPlan() override;
+
+  // Returns 0 if the buffer is placed in the arena and i if it is placed in
+  // the i-th region added with AddRegion(). Like the offsets, this is only
+  // available until the scratch buffer passed to Init() is released.
+  int GetRegionForBuffer(int buffer_index);
+
+  // Returns the number of bytes of a region used by the last plan, with
+  // region 0 being the arena.
+  size_t GetRegionUsage(int region);
+
+  // Returns the sum of size * access weight * latency weight of the region
+  // over all buffers of the last plan, an estimate of the memory access time
+  // of one invocation that allows comparing placements on the host.
+  uint64_t GetWeightedAccessCost();
+
+  // Number of bytes required in order to plan a buffer.
+  static size_t per_buffer_size() {
+    return sizeof(BufferRequirements) +  // requirements_
+           sizeof(int) +                 // buffer_ids_sorted_
+           sizeof(ListEntry) +           // region_entries_
+           GreedyMemoryPlanner::per_buffer_size();
+  }
+
+ private:
+  struct BufferRequirements {
+    int size;
+    int first_time_used;
+    int last_time_used;
+    int offline_offset;
+    int access_weight;
+    int alignment;
+    // Outcome of the plan.
+    int region;
+    int offset;
+  };
+
+  // Buffers placed in a region, ordered by offset.
+  struct ListEntry {
+    int offset;
+    int requirements_index;
+    int next_entry_index;
+  };
+
+  struct Region {
+    uint8_t* base;
+    size_t size;
+    int latency_weight;
+    int first_entry_index;
+    size_t used;
+  };
+
+  // Returns true if buffer a should be placed before buffer b.
+  bool IsHigherPriority(const BufferRequirements& a,
+                        const BufferRequirements& b) const;
+
+  // Places the buffer in region if it fits.
+  bool PlaceInRegion(int requirements_index, int region);
+
+  void CalculatePlanIfNeeded();
+
+  Region regions_[kMaxRegions];
+  int num_regions_ = 1;
+
+  GreedyMemoryPlanner arena_planner_;
+  unsigned char* arena_planner_scratch_ = nullptr;
+  int arena_planner_scratch_size_ = 0;
+
+  int max_buffer_count_ = 0;
+  int buffer_count_ = 0;
+  BufferRequirements* requirements_ = nullptr;
+  int* buffer_ids_sorted_ = nullptr;
+  ListEntry* region_entries_ = nullptr;
+  int next_free_entry_ = 0;
+
+  bool need_to_calculate_plan_ = true;
+  uint64_t weighted_access_cost_ = 0;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_MULTI_REGION_MEMORY_PLANNER_H_
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "tensorflow/lite/micro/micro_arena_constants.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
 namespace tflite {
@@ -29,6 +30,10 @@ namespace tflite {
 namespace {
 constexpr char kOfflineMemAllocMetadata[] = "OfflineMemoryAllocation";
 constexpr int kUninitializedLifetime = -1;
+// Kernels typically pass over their scratch buffers several times per
+// invocation, e.g. once per output channel or row, so weight them above a
+// tensor that is written once and read once.
+constexpr int kScratchBufferAccessWeight = 4;
 }  // namespace
 
 // Mark the given Allocation info as first created at the specified allocation
@@ -176,7 +181,8 @@ TfLiteStatus AllocationInfoBuilder::ValidateSubgraph(
 }
 
 TfLiteStatus AllocationInfoBuilder::InitializeAllocationInfo(
-    const int32_t* offline_offsets, SubgraphAllocations* allocations) {
+    const int32_t* offline_offsets, SubgraphAllocations* allocations,
+    size_t tensor_alignment) {
   AllocationInfo* allocation_info = info_.allocation_info;
   // Initialize allocation info for every tensor in every subgraph.
   for (size_t subgraph_idx = 0; subgraph_idx < model_->subgraphs()->size();
@@ -198,6 +204,9 @@ TfLiteStatus AllocationInfoBuilder::InitializeAllocationInfo(
 
       current->first_created = kUninitializedLifetime;
       current->last_used = kUninitializedLifetime;
+      current->access_weight = 0;
+      current->alignment =
+          TensorDataAlignment(eval_tensors[i].type, tensor_alignment);
       current->needs_allocating =
           (eval_tensors[i].data.data == nullptr) &&
           (!subgraph->tensors()->Get(i)->is_variable()) &&
@@ -224,6 +233,8 @@ TfLiteStatus AllocationInfoBuilder::InitializeAllocationInfo(
     AllocationInfo* current = &scratch_allocation_info[i];
     current->first_created = kUninitializedLifetime;
     current->last_used = kUninitializedLifetime;
+    current->access_weight = kScratchBufferAccessWeight;
+    current->alignment = MicroArenaBufferAlignment();
     current->needs_allocating = true;
     current->offline_offset = kOnlinePlannedBuffer;
   }
@@ -264,6 +275,7 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
       const int tensor_index = op->outputs()->Get(n);
       AllocationInfo* current = &subgraph_allocation_info[tensor_index];
       UpdateFirstCreated(current, allocation_scope_count_);
+      current->access_weight++;
     }
 
     // Keep track of scope count before any subgraphs, so that scratch buffers'
@@ -286,6 +298,7 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
         // or producer op, or it is not part of the memory plan (weight, bias
         // tensor).
         UpdateLastUsed(current, allocation_scope_count_);
+        current->access_weight++;
       }
     }
     for (size_t n = 0; op->outputs() != nullptr && n < op->outputs()->size();
@@ -312,6 +325,7 @@ TfLiteStatus AllocationInfoBuilder::MarkAllocationLifetimes(
             &(scratch_buffer_handles[scratch_idx]);
         current->output_ptr = reinterpret_cast<void**>(&current_handle->data);
         current->bytes = request.bytes;
+        current->alignment = request.alignment;
         UpdateFirstCreated(current, start_allocation_scope_count);
         UpdateLastUsed(current, allocation_scope_count_);
       }
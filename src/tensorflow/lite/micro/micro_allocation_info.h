@@ -30,6 +30,11 @@ struct AllocationInfo {
   int first_created;
   int last_used;
   int32_t offline_offset;
+  // Relative number of accesses during an invocation, see
+  // MicroMemoryPlanner::SetBufferAccessWeight().
+  int access_weight;
+  // Alignment of the buffer in the memory plan, see MicroAlignmentPolicy.
+  size_t alignment;
   bool needs_allocating;
 };
 
@@ -80,8 +85,10 @@ class AllocationInfoBuilder {
   TfLiteStatus FreeAllocationInfo();
 
   // Initialize AllocationInfo for all tensors and scratch buffers in the graph.
+  // Tensors are aligned to at least tensor_alignment.
   TfLiteStatus InitializeAllocationInfo(const int32_t* offline_offsets,
-                                        SubgraphAllocations* allocations);
+                                        SubgraphAllocations* allocations,
+                                        size_t tensor_alignment);
 
   // Mark the scope of each tensor and scratch buffer across the graph. Enter
   // all possible subgraphs invoked by each control flow operator. This method
@@ -15,8 +15,10 @@ limitations under the License.
 
 #include "tensorflow/lite/micro/micro_allocator.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include "third_party/flatbuffers/include/flatbuffers/flatbuffers.h"
 #include "tensorflow/lite/c/common.h"
@@ -71,6 +73,15 @@ class MicroBuiltinDataAllocator : public TfLiteBridgeBuiltinDataAllocator {
   IPersistentBufferAllocator* persistent_allocator_;
 };
 
+// Returns true if alignment is a power of two of at least min_alignment that
+// the arena, which starts at a MicroArenaBufferAlignment() boundary, can
+// provide.
+bool IsValidAlignment(size_t alignment, size_t min_alignment) {
+  return alignment >= min_alignment &&
+         alignment <= static_cast<size_t>(MicroArenaBufferAlignment()) &&
+         (alignment & (alignment - 1)) == 0;
+}
+
 TfLiteStatus CreatePlan(MicroMemoryPlanner* planner,
                         const AllocationInfo* allocation_info,
                         size_t allocation_info_size) {
@@ -78,8 +89,10 @@ TfLiteStatus CreatePlan(MicroMemoryPlanner* planner,
   for (size_t i = 0; i < allocation_info_size; ++i) {
     const AllocationInfo* current = &allocation_info[i];
     if (current->needs_allocating) {
+      // Padding every buffer to its alignment keeps the offsets of the buffers
+      // that the planner places right after it aligned.
       size_t aligned_bytes_required =
-          AlignSizeUp(current->bytes, MicroArenaBufferAlignment());
+          AlignSizeUp(current->bytes, current->alignment);
       if (current->offline_offset == kOnlinePlannedBuffer) {
         TF_LITE_ENSURE_STATUS(planner->AddBuffer(aligned_bytes_required,
                                                  current->first_created,
@@ -89,6 +102,10 @@ TfLiteStatus CreatePlan(MicroMemoryPlanner* planner,
             planner->AddBuffer(aligned_bytes_required, current->first_created,
                                current->last_used, current->offline_offset));
       }
+      planner->SetBufferAccessWeight(planner->GetBufferCount() - 1,
+                                     current->access_weight);
+      planner->SetBufferAlignment(planner->GetBufferCount() - 1,
+                                  current->alignment);
     }
   }
   return kTfLiteOk;
@@ -102,10 +119,10 @@ TfLiteStatus CommitPlan(MicroMemoryPlanner* planner, uint8_t* starting_point,
   for (size_t i = 0; i < allocation_info_size; ++i) {
     const AllocationInfo* current = &allocation_info[i];
     if (current->needs_allocating) {
-      int offset = -1;
-      TF_LITE_ENSURE_STATUS(
-          planner->GetOffsetForBuffer(planner_index, &offset));
-      *current->output_ptr = reinterpret_cast<void*>(starting_point + offset);
+      uint8_t* address = nullptr;
+      TF_LITE_ENSURE_STATUS(planner->GetAddressForBuffer(
+          planner_index, starting_point, &address));
+      *current->output_ptr = reinterpret_cast<void*>(address);
       ++planner_index;
     }
   }
@@ -154,6 +171,76 @@ INonPersistentBufferAllocator* CreateNonPersistentArenaAllocator(
   return non_persistent_buffer_allocator;
 }
 
+uint64_t NumElements(const Tensor* tensor) {
+  uint64_t num_elements = 1;
+  if (tensor->shape() != nullptr) {
+    for (int32_t dim : *tensor->shape()) {
+      num_elements *= dim;
+    }
+  }
+  return num_elements;
+}
+
+// Estimates the multiply-accumulates of op from the shapes of its output and
+// filter.
+uint64_t EstimateOpMacs(BuiltinOperator op_code, const SubGraph* subgraph,
+                        const Operator* op) {
+  if (op->outputs() == nullptr || op->outputs()->size() == 0 ||
+      op->outputs()->Get(0) < 0) {
+    return 1;
+  }
+  uint64_t macs =
+      NumElements(subgraph->tensors()->Get(op->outputs()->Get(0)));
+  const Tensor* filter = nullptr;
+  if (op->inputs() != nullptr && op->inputs()->size() > 1 &&
+      op->inputs()->Get(1) >= 0) {
+    filter = subgraph->tensors()->Get(op->inputs()->Get(1));
+  }
+  if (filter != nullptr && filter->shape() != nullptr &&
+      filter->shape()->size() > 0) {
+    const auto* shape = filter->shape();
+    switch (op_code) {
+      case BuiltinOperator_CONV_2D:
+      case BuiltinOperator_FULLY_CONNECTED:
+        // Each output reads a filter row.
+        if (shape->Get(0) > 0) {
+          macs *= NumElements(filter) / shape->Get(0);
+        }
+        break;
+      case BuiltinOperator_DEPTHWISE_CONV_2D:
+        if (shape->size() == 4) {
+          macs *= shape->Get(1) * shape->Get(2);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  return macs > 0 ? macs : 1;
+}
+
+// Returns the data of the metadata buffer with the given name, or nullptr if
+// the model has none.
+const flatbuffers::Vector<uint8_t>* FindMetadataBuffer(const Model* model,
+                                                       const char* name) {
+  if (model->metadata() == nullptr) {
+    return nullptr;
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers =
+      model->buffers();
+  const flatbuffers::Vector<uint8_t>* metadata_data = nullptr;
+  for (size_t i = 0; i < model->metadata()->size(); ++i) {
+    const Metadata* metadata = model->metadata()->Get(i);
+    if (metadata->name() != nullptr &&
+        metadata->name()->size() == strlen(name) &&
+        strncmp(metadata->name()->c_str(), name, strlen(name)) == 0 &&
+        metadata->buffer() < buffers->size()) {
+      metadata_data = buffers->Get(metadata->buffer())->data();
+    }
+  }
+  return metadata_data;
+}
+
 }  // namespace
 
 namespace internal {
@@ -470,6 +557,9 @@ SubgraphAllocations* MicroAllocator::StartModelAllocation(const Model* model) {
   }
 
   if (AllocateTfLiteEvalTensors(model, output) != kTfLiteOk ||
+      AllocateTensorPalettes(model) != kTfLiteOk ||
+      AllocateOutputMultipliers(model) != kTfLiteOk ||
+      AllocateWeightStreaming(model) != kTfLiteOk ||
       AllocateNodeAndRegistrations(model, output) != kTfLiteOk) {
     return nullptr;
   }
@@ -490,21 +580,74 @@ TfLiteStatus MicroAllocator::FinishModelAllocation(
   TF_LITE_ENSURE_STATUS(AllocateScratchBufferHandles(
       scratch_buffer_handles, scratch_buffer_request_count_));
 
+  // The requests are in the head section, which the plan overwrites.
+  scratch_buffer_info_ = nullptr;
+  scratch_buffer_info_count_ = 0;
+  if (keep_scratch_buffer_info_ && scratch_buffer_request_count_ > 0) {
+    scratch_buffer_info_ = reinterpret_cast<ScratchBufferInfo*>(
+        persistent_buffer_allocator_->AllocatePersistentBuffer(
+            sizeof(ScratchBufferInfo) * scratch_buffer_request_count_,
+            alignof(ScratchBufferInfo)));
+    if (scratch_buffer_info_ == nullptr) {
+      MicroPrintf("Failed to allocate memory for the scratch buffer info");
+      return kTfLiteError;
+    }
+    const internal::ScratchBufferRequest* requests =
+        GetScratchBufferRequests();
+    for (size_t i = 0; i < scratch_buffer_request_count_; ++i) {
+      scratch_buffer_info_[i].subgraph_idx = requests[i].subgraph_idx;
+      scratch_buffer_info_[i].node_idx = requests[i].node_idx;
+      scratch_buffer_info_[i].bytes = requests[i].bytes;
+      scratch_buffer_info_[i].requested_bytes = requests[i].requested_bytes;
+      scratch_buffer_info_[i].data = nullptr;
+    }
+    scratch_buffer_info_count_ = scratch_buffer_request_count_;
+  }
+
   // Plan all subgraphs and scratch buffers together.
   TF_LITE_ENSURE_STATUS(CommitStaticMemoryPlan(model, subgraph_allocations,
                                                *scratch_buffer_handles));
+  for (size_t i = 0; i < scratch_buffer_info_count_; ++i) {
+    scratch_buffer_info_[i].data = (*scratch_buffer_handles)[i].data;
+  }
   model_is_allocating_ = false;
   return kTfLiteOk;
 }
 
 void* MicroAllocator::AllocatePersistentBuffer(size_t bytes) {
-  return persistent_buffer_allocator_->AllocatePersistentBuffer(
-      bytes, MicroArenaBufferAlignment());
+  return AllocateAlignedPersistentBuffer(
+      bytes, alignment_policy_.persistent_alignment);
+}
+
+void* MicroAllocator::AllocateAlignedPersistentBuffer(size_t bytes,
+                                                      size_t alignment) {
+  if (!IsValidAlignment(alignment, 1)) {
+    MicroPrintf("Invalid persistent buffer alignment %d",
+                static_cast<int>(alignment));
+    return nullptr;
+  }
+  if (alignment < alignment_policy_.persistent_alignment) {
+    alignment = alignment_policy_.persistent_alignment;
+  }
+  return persistent_buffer_allocator_->AllocatePersistentBuffer(bytes,
+                                                                alignment);
 }
 
 TfLiteStatus MicroAllocator::RequestScratchBufferInArena(size_t bytes,
                                                          int subgraph_idx,
                                                          int* buffer_idx) {
+  return RequestAlignedScratchBufferInArena(
+      bytes, alignment_policy_.scratch_alignment, subgraph_idx, buffer_idx);
+}
+
+TfLiteStatus MicroAllocator::RequestAlignedScratchBufferInArena(
+    size_t bytes, size_t alignment, int subgraph_idx, int* buffer_idx) {
+  if (!IsValidAlignment(alignment, 1)) {
+    MicroPrintf("Invalid scratch buffer alignment %d",
+                static_cast<int>(alignment));
+    return kTfLiteError;
+  }
+
   // All scratch buffer requests are stored in the head section of the arena
   // when a model is in the prepare phase. First align a scratch buffer request
   // pointer to the start of the head:
@@ -532,8 +675,13 @@ TfLiteStatus MicroAllocator::RequestScratchBufferInArena(size_t bytes,
   // Assign -1 as a sentinel value that will be updated when the node finishes
   // allocating:
   current_request->bytes = bytes;
+  current_request->requested_bytes = bytes;
   current_request->node_idx = kUnassignedScratchBufferRequestIndex;
   current_request->subgraph_idx = subgraph_idx;
+  current_request->alignment =
+      alignment > alignment_policy_.scratch_alignment
+          ? alignment
+          : alignment_policy_.scratch_alignment;
 
   // Assign the current request index to the out-param:
   *buffer_idx = scratch_buffer_request_count_;
@@ -551,6 +699,7 @@ TfLiteStatus MicroAllocator::FinishPrepareNodeAllocations(int node_id) {
   // Find and update any new scratch buffer requests for the current node:
   internal::ScratchBufferRequest* requests = GetScratchBufferRequests();
 
+  int request_index = 0;
   for (size_t i = 0; i < scratch_buffer_request_count_; ++i) {
     // A request with a node_idx of -1 is a sentinel value used to indicate this
     // was a new request for the current node. The allocator finally knows the
@@ -559,6 +708,7 @@ TfLiteStatus MicroAllocator::FinishPrepareNodeAllocations(int node_id) {
     // to allocate at most kMaxScratchBuffersPerOp requests:
     if (requests[i].node_idx == kUnassignedScratchBufferRequestIndex) {
       requests[i].node_idx = node_id;
+      ApplyScratchBufferOverride(&requests[i], request_index++);
     }
   }
 
@@ -573,6 +723,36 @@ TfLiteStatus MicroAllocator::FinishPrepareNodeAllocations(int node_id) {
   return kTfLiteOk;
 }
 
+void MicroAllocator::SetScratchBufferOverrides(
+    const ScratchBufferOverride* overrides, int count) {
+  scratch_buffer_overrides_ = overrides;
+  num_scratch_buffer_overrides_ = count;
+}
+
+void MicroAllocator::ApplyScratchBufferOverride(
+    internal::ScratchBufferRequest* request, int request_index) {
+  for (int i = 0; i < num_scratch_buffer_overrides_; ++i) {
+    const ScratchBufferOverride& entry = scratch_buffer_overrides_[i];
+    if (entry.subgraph_idx == request->subgraph_idx &&
+        entry.node_idx == request->node_idx &&
+        entry.request_index == request_index &&
+        entry.requested_bytes == request->requested_bytes &&
+        entry.bytes < request->bytes) {
+      overridden_scratch_bytes_ += request->bytes - entry.bytes;
+      request->bytes = entry.bytes;
+      return;
+    }
+  }
+}
+
+void MicroAllocator::GetNonPersistentRegion(uint8_t** start, size_t* bytes,
+                                            size_t* planned_bytes) const {
+  *start = non_persistent_buffer_allocator_->GetOverlayMemoryAddress();
+  *bytes = non_persistent_buffer_allocator_->GetNonPersistentUsedBytes() +
+           non_persistent_buffer_allocator_->GetAvailableMemory(1);
+  *planned_bytes = max_head_buffer_usage_;
+}
+
 size_t MicroAllocator::used_bytes() const {
   return non_persistent_buffer_allocator_->GetNonPersistentUsedBytes() +
          persistent_buffer_allocator_->GetPersistentUsedBytes();
@@ -676,6 +856,10 @@ TfLiteTensor* MicroAllocator::AllocateTempTfLiteTensor(
   TfLiteTensor* tensor = reinterpret_cast<TfLiteTensor*>(
       non_persistent_buffer_allocator_->AllocateTemp(sizeof(TfLiteTensor),
                                                      alignof(TfLiteTensor)));
+  if (tensor == nullptr) {
+    MicroPrintf("Failed to allocate memory for a temp TfLiteTensor.");
+    return nullptr;
+  }
 
   // Populate any fields from the flatbuffer, since this TfLiteTensor struct is
   // allocated in the temp section of the arena, ensure that additional
@@ -745,6 +929,480 @@ TfLiteStatus MicroAllocator::AllocateTfLiteEvalTensors(
   return kTfLiteOk;
 }
 
+TfLiteStatus MicroAllocator::AllocateTensorPalettes(const Model* model) {
+  tensor_palettes_ = nullptr;
+  num_tensor_palettes_ = 0;
+  const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers =
+      model->buffers();
+  const flatbuffers::Vector<uint8_t>* metadata_data =
+      FindMetadataBuffer(model, kPaletteMetadataName);
+  if (metadata_data == nullptr) {
+    return kTfLiteOk;
+  }
+
+  const uint32_t* words =
+      reinterpret_cast<const uint32_t*>(metadata_data->data());
+  const size_t num_words = metadata_data->size() / sizeof(uint32_t);
+  if (num_words < 2 || words[0] != kPaletteMetadataVersion ||
+      num_words != 2 + static_cast<size_t>(words[1]) *
+                           kPaletteMetadataEntryWords) {
+    MicroPrintf("Invalid %s metadata.", kPaletteMetadataName);
+    return kTfLiteError;
+  }
+  const int num_entries = static_cast<int>(words[1]);
+  if (num_entries == 0) {
+    return kTfLiteOk;
+  }
+  tensor_palettes_ = reinterpret_cast<TensorPaletteEntry*>(
+      persistent_buffer_allocator_->AllocatePersistentBuffer(
+          sizeof(TensorPaletteEntry) * num_entries,
+          alignof(TensorPaletteEntry)));
+  if (tensor_palettes_ == nullptr) {
+    MicroPrintf("Failed to allocate memory for tensor palettes.");
+    return kTfLiteError;
+  }
+
+  for (int i = 0; i < num_entries; ++i) {
+    const uint32_t* entry = words + 2 + i * kPaletteMetadataEntryWords;
+    const uint32_t subgraph_index = entry[0];
+    const uint32_t tensor_index = entry[1];
+    const uint32_t bits = entry[2];
+    const uint32_t num_codebooks = entry[3];
+    const uint32_t codebook_buffer = entry[4];
+
+    if (subgraph_index >= model->subgraphs()->size() ||
+        tensor_index >=
+            model->subgraphs()->Get(subgraph_index)->tensors()->size() ||
+        bits < 1 || bits > 8 || codebook_buffer >= buffers->size()) {
+      MicroPrintf("Invalid palette entry %d.", i);
+      return kTfLiteError;
+    }
+    const Tensor* tensor =
+        model->subgraphs()->Get(subgraph_index)->tensors()->Get(tensor_index);
+    if (tensor->type() != TensorType_INT8 || tensor->shape() == nullptr) {
+      MicroPrintf("Palettized tensor %d must be an int8 tensor with a shape.",
+                  tensor_index);
+      return kTfLiteError;
+    }
+
+    // The tensor buffer holds the packed indices instead of the values.
+    size_t num_elements = 1;
+    for (int32_t dim : *tensor->shape()) {
+      num_elements *= dim;
+    }
+    const flatbuffers::Vector<uint8_t>* indices =
+        tensor->buffer() < buffers->size()
+            ? buffers->Get(tensor->buffer())->data()
+            : nullptr;
+    if (indices == nullptr ||
+        indices->size() != (num_elements * bits + 7) / 8) {
+      MicroPrintf("Palettized tensor %d does not hold %d %d-bit indices.",
+                  tensor_index, num_elements, bits);
+      return kTfLiteError;
+    }
+
+    int quantized_dimension = 0;
+    if (tensor->quantization() != nullptr) {
+      quantized_dimension = tensor->quantization()->quantized_dimension();
+    }
+    const flatbuffers::Vector<uint8_t>* codebooks =
+        buffers->Get(codebook_buffer)->data();
+    if (quantized_dimension < 0 ||
+        quantized_dimension >= static_cast<int>(tensor->shape()->size()) ||
+        (num_codebooks != 1 &&
+         num_codebooks != static_cast<uint32_t>(
+                              tensor->shape()->Get(quantized_dimension))) ||
+        codebooks == nullptr || codebooks->size() != num_codebooks << bits) {
+      MicroPrintf("Palettized tensor %d has invalid codebooks.", tensor_index);
+      return kTfLiteError;
+    }
+
+    TensorPaletteEntry& result = tensor_palettes_[i];
+    result.subgraph_index = subgraph_index;
+    result.tensor_index = tensor_index;
+    result.palette.bits = bits;
+    result.palette.num_codebooks = num_codebooks;
+    result.palette.quantized_dimension = quantized_dimension;
+    result.palette.codebooks =
+        reinterpret_cast<const int8_t*>(codebooks->data());
+  }
+  num_tensor_palettes_ = num_entries;
+  return kTfLiteOk;
+}
+
+const TensorPalette* MicroAllocator::GetTensorPalette(int subgraph_idx,
+                                                      int tensor_idx) const {
+  for (int i = 0; i < num_tensor_palettes_; ++i) {
+    if (tensor_palettes_[i].subgraph_index == subgraph_idx &&
+        tensor_palettes_[i].tensor_index == tensor_idx) {
+      return &tensor_palettes_[i].palette;
+    }
+  }
+  return nullptr;
+}
+
+TfLiteStatus MicroAllocator::AllocateOutputMultipliers(const Model* model) {
+  output_multipliers_ = nullptr;
+  num_output_multipliers_ = 0;
+  const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers =
+      model->buffers();
+  const flatbuffers::Vector<uint8_t>* metadata_data =
+      FindMetadataBuffer(model, kOutputMultiplierMetadataName);
+  if (metadata_data == nullptr) {
+    return kTfLiteOk;
+  }
+
+  const uint32_t* words =
+      reinterpret_cast<const uint32_t*>(metadata_data->data());
+  const size_t num_words = metadata_data->size() / sizeof(uint32_t);
+  if (num_words < 2 || words[0] != kOutputMultiplierMetadataVersion ||
+      num_words != 2 + static_cast<size_t>(words[1]) *
+                           kOutputMultiplierMetadataEntryWords) {
+    MicroPrintf("Invalid %s metadata.", kOutputMultiplierMetadataName);
+    return kTfLiteError;
+  }
+  const int num_entries = static_cast<int>(words[1]);
+  if (num_entries == 0) {
+    return kTfLiteOk;
+  }
+  output_multipliers_ = reinterpret_cast<OutputMultipliersEntry*>(
+      persistent_buffer_allocator_->AllocatePersistentBuffer(
+          sizeof(OutputMultipliersEntry) * num_entries,
+          alignof(OutputMultipliersEntry)));
+  if (output_multipliers_ == nullptr) {
+    MicroPrintf("Failed to allocate memory for output multipliers.");
+    return kTfLiteError;
+  }
+
+  for (int i = 0; i < num_entries; ++i) {
+    const uint32_t* entry =
+        words + 2 + i * kOutputMultiplierMetadataEntryWords;
+    const uint32_t subgraph_index = entry[0];
+    const uint32_t tensor_index = entry[1];
+    const uint32_t num_channels = entry[2];
+    const uint32_t values_buffer = entry[3];
+
+    if (subgraph_index >= model->subgraphs()->size() ||
+        tensor_index >=
+            model->subgraphs()->Get(subgraph_index)->tensors()->size() ||
+        num_channels == 0 || values_buffer >= buffers->size()) {
+      MicroPrintf("Invalid output multiplier entry %d.", i);
+      return kTfLiteError;
+    }
+    // The buffer data is aligned to 16 bytes by the schema.
+    const flatbuffers::Vector<uint8_t>* values =
+        buffers->Get(values_buffer)->data();
+    if (values == nullptr ||
+        values->size() != 2 * num_channels * sizeof(int32_t) ||
+        reinterpret_cast<uintptr_t>(values->data()) % alignof(int32_t) != 0) {
+      MicroPrintf("Output multipliers of tensor %d do not hold %d channels.",
+                  tensor_index, num_channels);
+      return kTfLiteError;
+    }
+
+    OutputMultipliersEntry& result = output_multipliers_[i];
+    result.subgraph_index = subgraph_index;
+    result.tensor_index = tensor_index;
+    result.output_multipliers.num_channels = num_channels;
+    result.output_multipliers.multipliers =
+        reinterpret_cast<const int32_t*>(values->data());
+    result.output_multipliers.shifts =
+        result.output_multipliers.multipliers + num_channels;
+  }
+  num_output_multipliers_ = num_entries;
+  return kTfLiteOk;
+}
+
+const OutputMultipliers* MicroAllocator::GetOutputMultipliers(
+    int subgraph_idx, int tensor_idx) const {
+  for (int i = 0; i < num_output_multipliers_; ++i) {
+    if (output_multipliers_[i].subgraph_index == subgraph_idx &&
+        output_multipliers_[i].tensor_index == tensor_idx) {
+      return &output_multipliers_[i].output_multipliers;
+    }
+  }
+  return nullptr;
+}
+
+TfLiteStatus MicroAllocator::SetAlignmentPolicy(
+    const MicroAlignmentPolicy& policy) {
+  // Kernels cast scratch buffers and tensors to at least int32_t and store
+  // 64-bit values and pointers in their persistent buffers.
+  if (!IsValidAlignment(policy.tensor_alignment, alignof(int32_t)) ||
+      !IsValidAlignment(policy.scratch_alignment, alignof(int32_t)) ||
+      !IsValidAlignment(policy.persistent_alignment, alignof(int64_t))) {
+    MicroPrintf(
+        "Invalid alignment policy: tensors %d, scratch %d, persistent %d",
+        static_cast<int>(policy.tensor_alignment),
+        static_cast<int>(policy.scratch_alignment),
+        static_cast<int>(policy.persistent_alignment));
+    return kTfLiteError;
+  }
+  alignment_policy_ = policy;
+  return kTfLiteOk;
+}
+
+void MicroAllocator::SetWeightStreaming(MicroWeightProvider* provider,
+                                        size_t min_tensor_bytes,
+                                        size_t max_staging_bytes) {
+  weight_provider_ = provider;
+  min_streamed_tensor_bytes_ = min_tensor_bytes;
+  max_weight_staging_bytes_ = max_staging_bytes;
+}
+
+TfLiteStatus MicroAllocator::AllocateWeightStreaming(const Model* model) {
+  weight_streamer_ = nullptr;
+  weight_streaming_steps_ = nullptr;
+  weight_streaming_subgraph_first_step_ = nullptr;
+  if (weight_provider_ == nullptr) {
+    return kTfLiteOk;
+  }
+
+  const int num_subgraphs = model->subgraphs()->size();
+  const size_t max_tensor_bytes = max_weight_staging_bytes_ / 2;
+  int* subgraph_first_step = reinterpret_cast<int*>(
+      persistent_buffer_allocator_->AllocatePersistentBuffer(
+          sizeof(int) * (num_subgraphs + 1), alignof(int)));
+  if (subgraph_first_step == nullptr) {
+    MicroPrintf("Failed to allocate memory for weight streaming.");
+    return kTfLiteError;
+  }
+
+  // The first pass counts the steps and sizes the slots, the second one
+  // fills in the steps.
+  MicroWeightStreamer::Step* steps = nullptr;
+  size_t slot_bytes = 0;
+  for (int pass = 0; pass < 2; ++pass) {
+    int num_steps = 0;
+    for (int subgraph_idx = 0; subgraph_idx < num_subgraphs; ++subgraph_idx) {
+      subgraph_first_step[subgraph_idx] = num_steps;
+      const SubGraph* subgraph = model->subgraphs()->Get(subgraph_idx);
+      const uint32_t operators_size = NumSubgraphOperators(subgraph);
+      for (uint32_t i = 0; i < operators_size; ++i) {
+        const Operator* op = subgraph->operators()->Get(i);
+        const BuiltinOperator op_code =
+            GetBuiltinCode(model->operator_codes()->Get(op->opcode_index()));
+        if (op_code == BuiltinOperator_IF ||
+            op_code == BuiltinOperator_WHILE ||
+            op_code == BuiltinOperator_CALL_ONCE || op->inputs() == nullptr) {
+          continue;
+        }
+        int node_steps = 0;
+        for (int32_t tensor_idx : *op->inputs()) {
+          if (node_steps == 2) {
+            break;
+          }
+          if (tensor_idx < 0) {
+            continue;
+          }
+          const Tensor* tensor = subgraph->tensors()->Get(tensor_idx);
+          const flatbuffers::Vector<uint8_t>* data =
+              tensor->buffer() < model->buffers()->size()
+                  ? model->buffers()->Get(tensor->buffer())->data()
+                  : nullptr;
+          if (data == nullptr || data->size() < min_streamed_tensor_bytes_ ||
+              data->size() > max_tensor_bytes || data->size() == 0 ||
+              tensor->is_variable()) {
+            continue;
+          }
+
+          // The eval tensor keeps pointing at the staging area after the
+          // node, so no other node may read the tensor.
+          int uses = 0;
+          for (uint32_t j = 0; j < operators_size; ++j) {
+            const Operator* other = subgraph->operators()->Get(j);
+            if (other->inputs() == nullptr) {
+              continue;
+            }
+            for (int32_t other_idx : *other->inputs()) {
+              uses += other_idx == tensor_idx ? 1 : 0;
+            }
+          }
+          if (subgraph->outputs() != nullptr) {
+            for (int32_t output_idx : *subgraph->outputs()) {
+              uses += output_idx == tensor_idx ? 1 : 0;
+            }
+          }
+          if (uses != 1) {
+            continue;
+          }
+
+          if (pass == 0) {
+            slot_bytes =
+                std::max(slot_bytes, static_cast<size_t>(data->size()));
+          } else {
+            MicroWeightStreamer::Step& step = steps[num_steps];
+            step.node_index = i;
+            step.tensor_index = tensor_idx;
+            step.source = data->data();
+            step.bytes = data->size();
+          }
+          ++num_steps;
+          ++node_steps;
+        }
+      }
+    }
+    subgraph_first_step[num_subgraphs] = num_steps;
+
+    if (num_steps == 0) {
+      return kTfLiteOk;
+    }
+    if (pass == 0) {
+      steps = reinterpret_cast<MicroWeightStreamer::Step*>(
+          persistent_buffer_allocator_->AllocatePersistentBuffer(
+              sizeof(MicroWeightStreamer::Step) * num_steps,
+              alignof(MicroWeightStreamer::Step)));
+      if (steps == nullptr) {
+        MicroPrintf("Failed to allocate %d weight streaming steps.",
+                    num_steps);
+        return kTfLiteError;
+      }
+    }
+  }
+
+  slot_bytes = AlignSizeUp(slot_bytes, MicroArenaBufferAlignment());
+  uint8_t* staging = persistent_buffer_allocator_->AllocatePersistentBuffer(
+      2 * slot_bytes, MicroArenaBufferAlignment());
+  uint8_t* streamer_buffer =
+      persistent_buffer_allocator_->AllocatePersistentBuffer(
+          sizeof(MicroWeightStreamer), alignof(MicroWeightStreamer));
+  if (staging == nullptr || streamer_buffer == nullptr) {
+    MicroPrintf("Failed to allocate %d bytes for weight streaming.",
+                static_cast<int>(2 * slot_bytes));
+    return kTfLiteError;
+  }
+  weight_streamer_ = new (streamer_buffer) MicroWeightStreamer(
+      weight_provider_, steps, subgraph_first_step, staging, slot_bytes);
+  weight_streaming_steps_ = steps;
+  weight_streaming_subgraph_first_step_ = subgraph_first_step;
+  return kTfLiteOk;
+}
+
+bool MicroAllocator::IsTensorStreamed(int subgraph_idx, int tensor_idx) const {
+  if (weight_streamer_ == nullptr) {
+    return false;
+  }
+  for (int i = weight_streaming_subgraph_first_step_[subgraph_idx];
+       i < weight_streaming_subgraph_first_step_[subgraph_idx + 1]; ++i) {
+    if (weight_streaming_steps_[i].tensor_index == tensor_idx) {
+      return true;
+    }
+  }
+  return false;
+}
+
+TfLiteStatus MicroAllocator::CacheConstantTensors(
+    const Model* model, SubgraphAllocations* subgraph_allocations,
+    size_t budget_bytes, const MicroProfiler* calibration) {
+  // Node ticks are only known for subgraph 0, whose nodes are the
+  // calibration events in order, once per invocation.
+  const int num_main_ops = NumSubgraphOperators(model, 0);
+  if (calibration != nullptr &&
+      (num_main_ops == 0 || calibration->num_events() == 0 ||
+       calibration->num_events() % num_main_ops != 0)) {
+    MicroPrintf(
+        "Calibration events do not match the model, ranking cached tensors "
+        "by bytes per MAC instead.");
+    calibration = nullptr;
+  }
+
+  // Each pass copies the best remaining tensor that fits. Copied tensors no
+  // longer point into the flatbuffer, which takes them out of later passes.
+  // This avoids temporary allocations, which could overlap with the copies.
+  size_t remaining_bytes = budget_bytes;
+  while (true) {
+    int best_subgraph_idx = -1;
+    int best_tensor_idx = -1;
+    const uint8_t* best_data = nullptr;
+    uint64_t best_bytes = 0;
+    uint64_t best_cost = 0;
+
+    for (size_t subgraph_idx = 0; subgraph_idx < model->subgraphs()->size();
+         ++subgraph_idx) {
+      const SubGraph* subgraph = model->subgraphs()->Get(subgraph_idx);
+      const uint32_t operators_size = NumSubgraphOperators(subgraph);
+      for (uint32_t i = 0; i < operators_size; ++i) {
+        const Operator* op = subgraph->operators()->Get(i);
+        if (op->inputs() == nullptr) {
+          continue;
+        }
+        const BuiltinOperator op_code =
+            GetBuiltinCode(model->operator_codes()->Get(op->opcode_index()));
+
+        // The ticks of the node in the calibration run, or its MACs.
+        uint64_t cost = 0;
+        if (calibration != nullptr) {
+          if (subgraph_idx == 0) {
+            for (int event = i; event < calibration->num_events();
+                 event += num_main_ops) {
+              cost += calibration->GetEventTicks(event);
+            }
+          }
+        } else {
+          cost = EstimateOpMacs(op_code, subgraph, op);
+        }
+
+        for (int32_t tensor_idx : *op->inputs()) {
+          if (tensor_idx < 0 ||
+              IsTensorStreamed(subgraph_idx, tensor_idx)) {
+            continue;
+          }
+          const Tensor* tensor = subgraph->tensors()->Get(tensor_idx);
+          const flatbuffers::Vector<uint8_t>* data =
+              tensor->buffer() < model->buffers()->size()
+                  ? model->buffers()->Get(tensor->buffer())->data()
+                  : nullptr;
+          const TfLiteEvalTensor& eval_tensor =
+              subgraph_allocations[subgraph_idx].tensors[tensor_idx];
+          if (data == nullptr || data->size() == 0 || tensor->is_variable() ||
+              eval_tensor.data.data != data->data()) {
+            continue;
+          }
+          const uint64_t bytes = data->size();
+          if (AlignSizeUp(bytes, MicroArenaBufferAlignment()) >
+              remaining_bytes) {
+            continue;
+          }
+
+          // With ticks, more ticks per byte is better. With MACs, more bytes
+          // per MAC is better, i.e. fewer MACs per byte.
+          bool is_better;
+          if (best_data == nullptr) {
+            is_better = true;
+          } else if (calibration != nullptr) {
+            is_better = cost * best_bytes > best_cost * bytes;
+          } else {
+            is_better = bytes * best_cost > best_bytes * cost;
+          }
+          if (is_better) {
+            best_subgraph_idx = subgraph_idx;
+            best_tensor_idx = tensor_idx;
+            best_data = data->data();
+            best_bytes = bytes;
+            best_cost = cost;
+          }
+        }
+      }
+    }
+    if (best_data == nullptr) {
+      return kTfLiteOk;
+    }
+
+    uint8_t* copy = persistent_buffer_allocator_->AllocatePersistentBuffer(
+        best_bytes, MicroArenaBufferAlignment());
+    if (copy == nullptr) {
+      // The arena is full, keep the tensors copied so far.
+      return kTfLiteOk;
+    }
+    std::memcpy(copy, best_data, best_bytes);
+    TfLiteEvalTensor& eval_tensor =
+        subgraph_allocations[best_subgraph_idx].tensors[best_tensor_idx];
+    eval_tensor.data.data = copy;
+    remaining_bytes -= AlignSizeUp(best_bytes, MicroArenaBufferAlignment());
+    cached_tensor_bytes_ += best_bytes;
+  }
+}
+
 TfLiteStatus MicroAllocator::AllocateVariables(
     const SubGraph* subgraph, TfLiteEvalTensor* eval_tensors,
     const int32_t* offline_planner_offsets) {
@@ -759,7 +1417,9 @@ TfLiteStatus MicroAllocator::AllocateVariables(
 
         eval_tensors[i].data.data =
             persistent_buffer_allocator_->AllocatePersistentBuffer(
-                buffer_size, MicroArenaBufferAlignment());
+                buffer_size,
+                TensorDataAlignment(eval_tensors[i].type,
+                                    alignment_policy_.tensor_alignment));
 
         if (eval_tensors[i].data.data == nullptr) {
           MicroPrintf("Failed to allocate variable tensor of size %d",
@@ -825,8 +1485,9 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
         subgraph, allocations[subgraph_idx].tensors, offline_planner_offsets));
   }
 
-  TF_LITE_ENSURE_STATUS(
-      builder.InitializeAllocationInfo(offline_planner_offsets, allocations));
+  TF_LITE_ENSURE_STATUS(builder.InitializeAllocationInfo(
+      offline_planner_offsets, allocations,
+      alignment_policy_.tensor_alignment));
 
   internal::ScratchBufferRequest* scratch_buffer_requests =
       GetScratchBufferRequests();
@@ -850,6 +1511,17 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
   TF_LITE_ENSURE_STATUS(
       CreatePlan(memory_planner_, allocation_info, allocation_info_count));
 
+  // The scratch buffers follow the tensors in the allocation info.
+  const int tensor_count =
+      allocation_info_count - static_cast<int>(scratch_buffer_request_count_);
+  for (int i = 0; i < tensor_count; ++i) {
+    const AllocationInfo& current = allocation_info[i];
+    if (current.needs_allocating) {
+      RecordPlannedTensor(current.bytes,
+                          AlignSizeUp(current.bytes, current.alignment));
+    }
+  }
+
   // Commit the plan.
   TF_LITE_ENSURE_STATUS(
       CommitPlan(memory_planner_,
@@ -911,6 +1583,7 @@ TfLiteStatus MicroAllocator::InitScratchBufferData() {
   // A model is preparing to allocate resources, ensure that scratch buffer
   // request counter is cleared:
   scratch_buffer_request_count_ = 0;
+  overridden_scratch_bytes_ = 0;
 
   // All requests will be stored in the head section. Each kernel is allowed at
   // most kMaxScratchBuffersPerOp requests. Adjust the head to reserve at most
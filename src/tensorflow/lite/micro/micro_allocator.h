@@ -23,6 +23,11 @@ limitations under the License.
 #include "tensorflow/lite/micro/compatibility.h"
 #include "tensorflow/lite/micro/flatbuffer_utils.h"
 #include "tensorflow/lite/micro/memory_planner/micro_memory_planner.h"
+#include "tensorflow/lite/micro/micro_arena_constants.h"
+#include "tensorflow/lite/micro/micro_output_multipliers.h"
+#include "tensorflow/lite/micro/micro_palette.h"
+#include "tensorflow/lite/micro/micro_profiler.h"
+#include "tensorflow/lite/micro/micro_weight_streamer.h"
 #include "tensorflow/lite/micro/tflite_bridge/flatbuffer_conversions_bridge.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
@@ -62,12 +67,61 @@ struct ScratchBufferRequest {
   // have `before` = node_idx and `after` = node_idx.
   int node_idx;
   int subgraph_idx;
+  // Alignment of the buffer in the memory plan, see MicroAlignmentPolicy.
+  size_t alignment;
+  // Number of bytes requested by the kernel, before a ScratchBufferOverride
+  // replaced `bytes`.
+  size_t requested_bytes;
 };
 
 }  // namespace internal
 
+// Minimum alignment of the buffers that MicroAllocator places in the arena, by
+// kind of allocation, see MicroAllocator::SetAlignmentPolicy(). Every buffer
+// is padded to its alignment, so the default of MicroArenaBufferAlignment()
+// for everything wastes up to 15 bytes per tensor and kernel allocation on
+// cores whose kernels never load more than 4 or 8 bytes at once. Kernels that
+// need more, e.g. for SIMD loads, declare it with
+// MicroContext::AllocateAlignedPersistentBuffer() and
+// MicroContext::RequestAlignedScratchBufferInArena().
+//
+// All values must be powers of two of at most MicroArenaBufferAlignment().
+struct MicroAlignmentPolicy {
+  // Activation tensors in the head and variable tensors in the tail. A tensor
+  // is also aligned to the size of its elements. At least 4.
+  size_t tensor_alignment = MicroArenaBufferAlignment();
+  // Scratch buffers requested by kernels. At least 4.
+  size_t scratch_alignment = MicroArenaBufferAlignment();
+  // Persistent buffers allocated by kernels, e.g. their OpData. At least 8.
+  size_t persistent_alignment = MicroArenaBufferAlignment();
+};
+
+// Replaces the size of a scratch buffer request of a kernel, e.g. to shrink a
+// buffer that the kernel sizes for the worst case down to what it writes for
+// the model, see MicroArenaTracer::LogScratchBufferOverrides(). An entry
+// applies to the request_index-th request of the node only while the kernel
+// requests exactly requested_bytes, and can only shrink the buffer.
+//
+// Overrides are measured for one model, kernel implementation and set of
+// inputs. They are unsafe for kernels whose use of a buffer depends on the
+// values of their inputs.
+struct ScratchBufferOverride {
+  int subgraph_idx;
+  int node_idx;
+  int request_index;
+  size_t requested_bytes;
+  size_t bytes;
+};
+
+// Per-operator state that is not stored in the model. The TfLiteNode that is
+// passed to the kernels is assembled from it and from the operator in the
+// flatbuffer before every call, see MicroGraph, so that the persistent arena
+// does not hold a copy of the inputs, outputs and custom options of every
+// operator. The registration is shared by all operators of the same type.
+// user_data is written back after Prepare, since kernels may set it there.
 struct NodeAndRegistration {
-  TfLiteNode node;
+  void* builtin_data;
+  void* user_data;
   const TfLiteRegistration* registration;
 };
 
@@ -79,6 +133,19 @@ struct ScratchBufferHandle {
   uint8_t* data;
 };
 
+// A scratch buffer requested by a kernel, as kept by the allocator after the
+// memory plan is committed, see MicroAllocator::KeepScratchBufferInfo(). The
+// entries are in the order of the buffer indices returned to the kernels.
+struct ScratchBufferInfo {
+  int subgraph_idx;
+  int node_idx;
+  // Number of bytes planned for the buffer and requested by the kernel. They
+  // differ if a ScratchBufferOverride shrank the buffer.
+  size_t bytes;
+  size_t requested_bytes;
+  uint8_t* data;
+};
+
 // Stores all per-subgraph allocations. This includes the node and registration
 // array, and tensor list for each subgraph.
 struct SubgraphAllocations {
@@ -209,12 +276,27 @@ class MicroAllocator {
   // arena.
   virtual void* AllocatePersistentBuffer(size_t bytes);
 
+  // Same as AllocatePersistentBuffer() for a buffer that needs to be aligned
+  // to more than the persistent alignment of the policy. Returns nullptr if
+  // alignment is not a power of two of at most MicroArenaBufferAlignment().
+  virtual void* AllocateAlignedPersistentBuffer(size_t bytes,
+                                                size_t alignment);
+
   // Register a scratch buffer of size `bytes` for Node with `node_id`.
   // This method only requests a buffer with a given size to be used after a
   // model has finished allocation via FinishModelAllocation(). All requested
   // buffers will be accessible by the out-param in that method.
-  TfLiteStatus RequestScratchBufferInArena(size_t bytes, int subgraph_idx,
-                                           int* buffer_idx);
+  virtual TfLiteStatus RequestScratchBufferInArena(size_t bytes,
+                                                   int subgraph_idx,
+                                                   int* buffer_idx);
+
+  // Same as RequestScratchBufferInArena() for a buffer that needs to be
+  // aligned to more than the scratch alignment of the policy. alignment must
+  // be a power of two of at most MicroArenaBufferAlignment().
+  virtual TfLiteStatus RequestAlignedScratchBufferInArena(size_t bytes,
+                                                          size_t alignment,
+                                                          int subgraph_idx,
+                                                          int* buffer_idx);
 
   // Finish allocating a specific NodeAndRegistration prepare block (kernel
   // entry for a model) with a given node ID. This call ensures that any scratch
@@ -228,6 +310,96 @@ class MicroAllocator {
 
   TfLiteBridgeBuiltinDataAllocator* GetBuiltinDataAllocator();
 
+  // Returns the palette of a palettized tensor, or nullptr if the tensor holds
+  // plain values. Only valid after StartModelAllocation().
+  const TensorPalette* GetTensorPalette(int subgraph_idx,
+                                        int tensor_idx) const;
+
+  // Returns the precomputed output multipliers of the operator that writes a
+  // tensor, or nullptr if the kernel computes them. Only valid after
+  // StartModelAllocation().
+  const OutputMultipliers* GetOutputMultipliers(int subgraph_idx,
+                                                int tensor_idx) const;
+
+  // Sets the minimum alignment of tensors, scratch buffers and kernel
+  // persistent buffers. Must be called before StartModelAllocation(). Returns
+  // an error and keeps the current policy if a value is out of range, see
+  // MicroAlignmentPolicy.
+  TfLiteStatus SetAlignmentPolicy(const MicroAlignmentPolicy& policy);
+
+  const MicroAlignmentPolicy& alignment_policy() const {
+    return alignment_policy_;
+  }
+
+  // Streams constant tensors of min_tensor_bytes up to max_staging_bytes / 2
+  // bytes through provider while the model is invoked, see
+  // micro_weight_streamer.h. The two staging slots are allocated in the tail
+  // section and sized for the largest streamed tensor. Only tensors that are
+  // read by a single node other than a control flow op are streamed, at most
+  // two per node. Must be called before StartModelAllocation().
+  void SetWeightStreaming(MicroWeightProvider* provider,
+                          size_t min_tensor_bytes, size_t max_staging_bytes);
+
+  // Returns the streamer created by StartModelAllocation(), or nullptr if no
+  // tensor is streamed.
+  MicroWeightStreamer* weight_streamer() const { return weight_streamer_; }
+
+  // Returns true if the tensor is streamed. Only valid after
+  // StartModelAllocation().
+  bool IsTensorStreamed(int subgraph_idx, int tensor_idx) const;
+
+  // Copies constant tensors from the model flatbuffer into the tail section,
+  // up to budget_bytes in total and without using memory that is still free
+  // for temporary allocations, and points their TfLiteEvalTensors at the
+  // copies. Must be called after FinishModelAllocation().
+  //
+  // Tensors are copied in order of expected gain. If calibration holds the
+  // events of one or more invocations of the model, e.g. from a MicroProfiler
+  // passed to an earlier interpreter, tensors are ranked by the ticks taken
+  // by the nodes reading them per byte. Otherwise they are ranked by bytes
+  // per multiply-accumulate of those nodes, which favours memory-bound
+  // layers such as FULLY_CONNECTED and DEPTHWISE_CONV_2D.
+  TfLiteStatus CacheConstantTensors(const Model* model,
+                                    SubgraphAllocations* subgraph_allocations,
+                                    size_t budget_bytes,
+                                    const MicroProfiler* calibration);
+
+  // Returns the number of bytes copied by CacheConstantTensors().
+  size_t cached_tensor_bytes() const { return cached_tensor_bytes_; }
+
+  // Shrinks scratch buffer requests of the kernels as given by overrides, see
+  // ScratchBufferOverride. Must be called before StartModelAllocation(). The
+  // lifetime of overrides should be at least as long as the allocator.
+  void SetScratchBufferOverrides(const ScratchBufferOverride* overrides,
+                                 int count);
+
+  // Returns the number of bytes that the overrides removed from the scratch
+  // buffer requests. Only valid after FinishModelAllocation().
+  size_t overridden_scratch_bytes() const { return overridden_scratch_bytes_; }
+
+  // Keeps a copy of the scratch buffer requests of the kernels in the tail
+  // section, which costs sizeof(ScratchBufferInfo) bytes per buffer. Only
+  // needed by tools that check how kernels use their buffers, see
+  // MicroArenaTracer. Must be called before StartModelAllocation().
+  void KeepScratchBufferInfo() { keep_scratch_buffer_info_ = true; }
+
+  // Returns the scratch buffers of the model, or nullptr if
+  // KeepScratchBufferInfo() was not called. Only valid after
+  // FinishModelAllocation().
+  const ScratchBufferInfo* scratch_buffer_info() const {
+    return scratch_buffer_info_;
+  }
+  size_t scratch_buffer_info_count() const {
+    return scratch_buffer_info_count_;
+  }
+
+  // Gets the memory that activation tensors, scratch buffers and temporary
+  // allocations share while the model is invoked: the head section, whose
+  // first planned_bytes hold the memory plan, followed by the free memory up
+  // to the tail section. Only valid after FinishModelAllocation().
+  void GetNonPersistentRegion(uint8_t** start, size_t* bytes,
+                              size_t* planned_bytes) const;
+
  protected:
   MicroAllocator(SingleArenaBufferAllocator* memory_allocator,
                  MicroMemoryPlanner* memory_planner);
@@ -248,6 +420,18 @@ class MicroAllocator {
   virtual TfLiteStatus AllocateTfLiteEvalTensors(
       const Model* model, SubgraphAllocations* subgraph_allocations);
 
+  // Reads and validates the list of palettized tensors in the model metadata,
+  // see micro_palette.h.
+  virtual TfLiteStatus AllocateTensorPalettes(const Model* model);
+
+  // Reads and validates the list of precomputed output multipliers in the
+  // model metadata, see micro_output_multipliers.h.
+  virtual TfLiteStatus AllocateOutputMultipliers(const Model* model);
+
+  // Picks the tensors to stream if SetWeightStreaming() was called and
+  // allocates the staging area and the MicroWeightStreamer for them.
+  virtual TfLiteStatus AllocateWeightStreaming(const Model* model);
+
   // Allocates persistent tensor buffers for variable tensors in the subgraph.
   // Online and offline variable tensors are handled differently hence the
   // offline_planner_offsets parameter is needed.
@@ -269,6 +453,11 @@ class MicroAllocator {
                                                           int subgraph_idx,
                                                           bool allocate_temp);
 
+  // Called for every tensor added to the memory plan of the head with its
+  // size before and after padding it to its alignment. Only used to account
+  // for the padding, see RecordingMicroAllocator.
+  virtual void RecordPlannedTensor(size_t bytes, size_t planned_bytes) {}
+
  private:
   // Commits a memory plan for all non-persistent buffer allocations in the
   // 'head' section of the memory arena. The eval_tensors pointer is the list of
@@ -291,6 +480,11 @@ class MicroAllocator {
   // preparing.
   TfLiteStatus InitScratchBufferData();
 
+  // Shrinks a request of the node that finished preparing if an entry of
+  // SetScratchBufferOverrides() matches it.
+  void ApplyScratchBufferOverride(internal::ScratchBufferRequest* request,
+                                  int request_index);
+
   // Returns the pointer for the array of ScratchBufferRequest allocations in
   // the head section.
   internal::ScratchBufferRequest* GetScratchBufferRequests();
@@ -318,6 +512,44 @@ class MicroAllocator {
   // to ensure that multi-tenant allocations can share the head for buffers.
   size_t max_head_buffer_usage_ = 0;
 
+  // Palettized tensors of the model, in the tail section.
+  struct TensorPaletteEntry {
+    int subgraph_index;
+    int tensor_index;
+    TensorPalette palette;
+  };
+  TensorPaletteEntry* tensor_palettes_ = nullptr;
+  int num_tensor_palettes_ = 0;
+
+  // Precomputed output multipliers of the model, keyed by the output tensor
+  // of their operator, in the tail section.
+  struct OutputMultipliersEntry {
+    int subgraph_index;
+    int tensor_index;
+    OutputMultipliers output_multipliers;
+  };
+  OutputMultipliersEntry* output_multipliers_ = nullptr;
+  int num_output_multipliers_ = 0;
+
+  MicroWeightProvider* weight_provider_ = nullptr;
+  size_t min_streamed_tensor_bytes_ = 0;
+  size_t max_weight_staging_bytes_ = 0;
+  MicroWeightStreamer* weight_streamer_ = nullptr;
+  const MicroWeightStreamer::Step* weight_streaming_steps_ = nullptr;
+  const int* weight_streaming_subgraph_first_step_ = nullptr;
+
+  size_t cached_tensor_bytes_ = 0;
+
+  const ScratchBufferOverride* scratch_buffer_overrides_ = nullptr;
+  int num_scratch_buffer_overrides_ = 0;
+  size_t overridden_scratch_bytes_ = 0;
+
+  bool keep_scratch_buffer_info_ = false;
+  ScratchBufferInfo* scratch_buffer_info_ = nullptr;
+  size_t scratch_buffer_info_count_ = 0;
+
+  MicroAlignmentPolicy alignment_policy_;
+
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
 
@@ -0,0 +1,564 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/micro_arena_tracer.h"
+
+#include <cinttypes>
+#include <cstring>
+
+#include "tensorflow/lite/micro/flatbuffer_utils.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/micro/micro_arena_constants.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/schema/schema_utils.h"
+
+namespace tflite {
+namespace {
+
+// Returns the number of subgraphs that a control flow operator invokes, the
+// same way AllocationInfoBuilder plans them.
+int GetInvokedSubgraphs(const Model* model, const Operator* op,
+                        int* subgraphs) {
+  const OperatorCode* opcode = model->operator_codes()->Get(op->opcode_index());
+  switch (GetBuiltinCode(opcode)) {
+    case BuiltinOperator_IF:
+      subgraphs[0] = op->builtin_options_as_IfOptions()->then_subgraph_index();
+      subgraphs[1] = op->builtin_options_as_IfOptions()->else_subgraph_index();
+      return 2;
+    case BuiltinOperator_CALL_ONCE:
+      subgraphs[0] =
+          op->builtin_options_as_CallOnceOptions()->init_subgraph_index();
+      return 1;
+    case BuiltinOperator_WHILE:
+      subgraphs[0] =
+          op->builtin_options_as_WhileOptions()->cond_subgraph_index();
+      subgraphs[1] =
+          op->builtin_options_as_WhileOptions()->body_subgraph_index();
+      return 2;
+    default:
+      return 0;
+  }
+}
+
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
+const char* GetOpName(const Model* model, const Operator* op) {
+  const OperatorCode* opcode = model->operator_codes()->Get(op->opcode_index());
+  const BuiltinOperator code = GetBuiltinCode(opcode);
+  if (code == BuiltinOperator_CUSTOM) {
+    return opcode->custom_code() != nullptr ? opcode->custom_code()->c_str()
+                                            : "CUSTOM";
+  }
+  return EnumNameBuiltinOperator(code);
+}
+#endif
+
+}  // namespace
+
+TfLiteStatus MicroArenaTracer::Init(const Model* model,
+                                    const MicroAllocator* allocator,
+                                    const SubgraphAllocations* allocations) {
+  model_ = model;
+  allocator_ = allocator;
+  allocator->GetNonPersistentRegion(&region_, &region_bytes_, &planned_bytes_);
+  depth_ = 0;
+  num_invocations_ = 0;
+  ClearRecords();
+
+  num_subgraphs_ = model->subgraphs()->size();
+  if (num_subgraphs_ > kMaxSubgraphs) {
+    MicroPrintf("MicroArenaTracer supports at most %d subgraphs, got %d",
+                kMaxSubgraphs, num_subgraphs_);
+    return kTfLiteError;
+  }
+  int tensor_count = 0;
+  for (int s = 0; s < num_subgraphs_; ++s) {
+    subgraph_first_tensor_[s] = tensor_count;
+    tensor_count += model->subgraphs()->Get(s)->tensors()->size();
+  }
+  subgraph_first_tensor_[num_subgraphs_] = tensor_count;
+  if (tensor_count > kMaxTensors) {
+    MicroPrintf("MicroArenaTracer supports at most %d tensors, got %d",
+                kMaxTensors, tensor_count);
+    return kTfLiteError;
+  }
+
+  scratch_buffers_ = allocator->scratch_buffer_info();
+  num_scratch_buffers_ = allocator->scratch_buffer_info_count();
+  if (num_scratch_buffers_ > kMaxScratchBuffers) {
+    MicroPrintf("MicroArenaTracer supports at most %d scratch buffers, got %d",
+                kMaxScratchBuffers, num_scratch_buffers_);
+    return kTfLiteError;
+  }
+
+  for (int s = 0; s < num_subgraphs_; ++s) {
+    const SubGraph* subgraph = model->subgraphs()->Get(s);
+    const int operators_size = NumSubgraphOperators(subgraph);
+    TensorInfo* infos = &tensors_[subgraph_first_tensor_[s]];
+    for (size_t t = 0; t < subgraph->tensors()->size(); ++t) {
+      TensorInfo* info = &infos[t];
+      info->offset = -1;
+      info->bytes = 0;
+      info->first_use = operators_size;
+      info->last_use = -1;
+      const TfLiteEvalTensor& tensor = allocations[s].tensors[t];
+      size_t bytes = 0;
+      const uint8_t* data = static_cast<const uint8_t*>(tensor.data.data);
+      if (data == nullptr ||
+          TfLiteEvalTensorByteLength(&tensor, &bytes) != kTfLiteOk ||
+          bytes == 0 || data < region_ ||
+          data + bytes > region_ + region_bytes_) {
+        continue;
+      }
+      info->offset = static_cast<int32_t>(data - region_);
+      info->bytes = static_cast<uint32_t>(bytes);
+      // Variable tensors keep their values between invocations.
+      if (subgraph->tensors()->Get(t)->is_variable()) {
+        info->first_use = 0;
+        info->last_use = operators_size - 1;
+      }
+    }
+
+    // Inputs are written before the first node and outputs read after the
+    // last one.
+    for (size_t i = 0;
+         subgraph->inputs() != nullptr && i < subgraph->inputs()->size(); ++i) {
+      infos[subgraph->inputs()->Get(i)].first_use = 0;
+    }
+    for (size_t i = 0;
+         subgraph->outputs() != nullptr && i < subgraph->outputs()->size();
+         ++i) {
+      infos[subgraph->outputs()->Get(i)].last_use = operators_size - 1;
+    }
+    for (int i = 0; i < operators_size; ++i) {
+      const Operator* op = subgraph->operators()->Get(i);
+      for (int pass = 0; pass < 2; ++pass) {
+        const flatbuffers::Vector<int32_t>* indices =
+            pass == 0 ? op->inputs() : op->outputs();
+        for (size_t n = 0; indices != nullptr && n < indices->size(); ++n) {
+          // Optional tensors have an index of -1.
+          const int tensor_index = indices->Get(n);
+          if (tensor_index < 0) {
+            continue;
+          }
+          TensorInfo* info = &infos[tensor_index];
+          if (i < info->first_use) {
+            info->first_use = i;
+          }
+          if (i > info->last_use) {
+            info->last_use = i;
+          }
+        }
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
+void MicroArenaTracer::ClearRecords() {
+  num_records_ = 0;
+  for (int i = 0; i < kMaxScratchBuffers; ++i) {
+    scratch_used_bytes_[i] = 0;
+  }
+}
+
+size_t MicroArenaTracer::GetScratchBufferUsedBytes(int buffer_idx) const {
+  if (buffer_idx < 0 || buffer_idx >= num_scratch_buffers_) {
+    return 0;
+  }
+  return scratch_used_bytes_[buffer_idx];
+}
+
+bool MicroArenaTracer::AddSubgraphTensors(int subgraph_idx, int node_idx,
+                                          Interval* intervals,
+                                          int* count) const {
+  const int first = subgraph_first_tensor_[subgraph_idx];
+  const int end = subgraph_first_tensor_[subgraph_idx + 1];
+  const SubGraph* subgraph = model_->subgraphs()->Get(subgraph_idx);
+  for (int t = first; t < end; ++t) {
+    const TensorInfo& info = tensors_[t];
+    if (info.offset < 0) {
+      continue;
+    }
+    bool live;
+    if (node_idx >= 0) {
+      live = info.first_use <= node_idx && node_idx <= info.last_use;
+    } else {
+      // The operator that invokes the subgraph copies its inputs and outputs.
+      live = false;
+      const int tensor_index = t - first;
+      for (int pass = 0; pass < 2 && !live; ++pass) {
+        const flatbuffers::Vector<int32_t>* io =
+            pass == 0 ? subgraph->inputs() : subgraph->outputs();
+        for (size_t n = 0; io != nullptr && n < io->size(); ++n) {
+          if (io->Get(n) == tensor_index) {
+            live = true;
+            break;
+          }
+        }
+      }
+    }
+    if (!live) {
+      continue;
+    }
+    if (*count >= kMaxLiveBuffers) {
+      return false;
+    }
+    intervals[(*count)++] = {static_cast<uint32_t>(info.offset),
+                             static_cast<uint32_t>(info.offset) + info.bytes,
+                             t - first, false};
+  }
+  return true;
+}
+
+int MicroArenaTracer::CollectLiveBuffers(const Level* levels, int num_levels,
+                                         bool own_scratch_buffers,
+                                         Interval* intervals) const {
+  int count = 0;
+  for (int level = 0; level < num_levels; ++level) {
+    const int subgraph_idx = levels[level].subgraph_idx;
+    const int node_idx = levels[level].node_idx;
+    if (!AddSubgraphTensors(subgraph_idx, node_idx, intervals, &count)) {
+      return -1;
+    }
+
+    int invoked_subgraphs[2];
+    const int num_invoked_subgraphs = GetInvokedSubgraphs(
+        model_, model_->subgraphs()->Get(subgraph_idx)->operators()->Get(
+                    node_idx),
+        invoked_subgraphs);
+    for (int i = 0; i < num_invoked_subgraphs; ++i) {
+      if (!AddSubgraphTensors(invoked_subgraphs[i], -1, intervals, &count)) {
+        return -1;
+      }
+    }
+
+    if (level == num_levels - 1 && !own_scratch_buffers) {
+      continue;
+    }
+    for (int i = 0; i < num_scratch_buffers_; ++i) {
+      const ScratchBufferInfo& buffer = scratch_buffers_[i];
+      if (buffer.subgraph_idx != subgraph_idx || buffer.node_idx != node_idx ||
+          !IsTracked(buffer)) {
+        continue;
+      }
+      if (count >= kMaxLiveBuffers) {
+        return -1;
+      }
+      const uint32_t begin = static_cast<uint32_t>(buffer.data - region_);
+      intervals[count++] = {begin, begin + static_cast<uint32_t>(buffer.bytes),
+                            i, true};
+    }
+  }
+
+  // Insertion sort, there are only a few buffers per node.
+  for (int i = 1; i < count; ++i) {
+    const Interval current = intervals[i];
+    int j = i - 1;
+    for (; j >= 0 && intervals[j].begin > current.begin; --j) {
+      intervals[j + 1] = intervals[j];
+    }
+    intervals[j + 1] = current;
+  }
+  return count;
+}
+
+void MicroArenaTracer::BeginNode(int subgraph_idx, int node_idx) {
+  const int depth = depth_++;
+  if (region_ == nullptr || depth >= kMaxDepth) {
+    return;
+  }
+  if (depth == 0) {
+    // The tail may have grown since Init(), e.g. by caching constant tensors.
+    allocator_->GetNonPersistentRegion(&region_, &region_bytes_,
+                                       &planned_bytes_);
+    // Alternate the poison byte per invocation of the model, to see bytes
+    // that kernels write with the poison value.
+    if (subgraph_idx == 0 && node_idx == 0) {
+      poison_byte_ = (num_invocations_++ % 2) == 0
+                         ? kPoisonByte
+                         : static_cast<uint8_t>(~kPoisonByte);
+    }
+  }
+  levels_[depth] = {subgraph_idx, node_idx, true};
+  const int count = CollectLiveBuffers(levels_, depth + 1, false, intervals_);
+  if (count < 0) {
+    MicroPrintf("MicroArenaTracer: node %d of subgraph %d has more than %d "
+                "live buffers and is not traced",
+                node_idx, subgraph_idx, kMaxLiveBuffers);
+    levels_[depth].traced = false;
+    return;
+  }
+
+  size_t gap_begin = 0;
+  for (int i = 0; i <= count; ++i) {
+    const size_t gap_end =
+        i < count && intervals_[i].begin < region_bytes_ ? intervals_[i].begin
+                                                         : region_bytes_;
+    if (gap_end > gap_begin) {
+      memset(region_ + gap_begin, poison_byte_, gap_end - gap_begin);
+    }
+    if (i < count && intervals_[i].end > gap_begin) {
+      gap_begin = intervals_[i].end;
+    }
+  }
+}
+
+void MicroArenaTracer::EndNode() {
+  const int depth = --depth_;
+  if (region_ == nullptr || depth >= kMaxDepth || !levels_[depth].traced) {
+    return;
+  }
+  const Level& level = levels_[depth];
+  const int count = CollectLiveBuffers(levels_, depth + 1, false, intervals_);
+  if (count < 0) {
+    return;
+  }
+
+  // The scratch buffers of the node were poisoned along with the free memory.
+  int own_scratch_buffers[kMaxLiveBuffers];
+  int num_own_scratch_buffers = 0;
+  for (int i = 0; i < num_scratch_buffers_ &&
+                  num_own_scratch_buffers < kMaxLiveBuffers;
+       ++i) {
+    if (scratch_buffers_[i].subgraph_idx == level.subgraph_idx &&
+        scratch_buffers_[i].node_idx == level.node_idx &&
+        IsTracked(scratch_buffers_[i])) {
+      own_scratch_buffers[num_own_scratch_buffers++] = i;
+    }
+  }
+
+  size_t high_water_bytes = 0;
+  size_t stray_bytes = 0;
+  size_t temp_end = 0;
+  size_t gap_begin = 0;
+  for (int i = 0; i <= count; ++i) {
+    const size_t gap_end =
+        i < count && intervals_[i].begin < region_bytes_ ? intervals_[i].begin
+                                                         : region_bytes_;
+    for (size_t offset = gap_begin; offset < gap_end; ++offset) {
+      if (region_[offset] == poison_byte_) {
+        continue;
+      }
+      high_water_bytes = offset + 1;
+      bool in_scratch_buffer = false;
+      for (int j = 0; j < num_own_scratch_buffers; ++j) {
+        const int buffer_idx = own_scratch_buffers[j];
+        const ScratchBufferInfo& buffer = scratch_buffers_[buffer_idx];
+        const size_t begin = buffer.data - region_;
+        if (offset >= begin && offset < begin + buffer.bytes) {
+          if (offset + 1 - begin > scratch_used_bytes_[buffer_idx]) {
+            scratch_used_bytes_[buffer_idx] = offset + 1 - begin;
+          }
+          in_scratch_buffer = true;
+          break;
+        }
+      }
+      if (in_scratch_buffer) {
+        continue;
+      }
+      if (offset < planned_bytes_) {
+        ++stray_bytes;
+      } else {
+        temp_end = offset + 1;
+      }
+    }
+    if (i < count) {
+      if (intervals_[i].end > gap_begin) {
+        gap_begin = intervals_[i].end;
+      }
+      if (intervals_[i].end > high_water_bytes) {
+        high_water_bytes = intervals_[i].end;
+      }
+    }
+  }
+  const size_t temp_bytes =
+      temp_end > planned_bytes_ ? temp_end - planned_bytes_ : 0;
+  UpdateRecord(level.subgraph_idx, level.node_idx, high_water_bytes,
+               stray_bytes, temp_bytes);
+}
+
+void MicroArenaTracer::UpdateRecord(int subgraph_idx, int node_idx,
+                                    size_t high_water_bytes, size_t stray_bytes,
+                                    size_t temp_bytes) {
+  const int index = FindRecord(subgraph_idx, node_idx);
+  NodeRecord* record;
+  if (index >= 0) {
+    record = &records_[index];
+  } else if (num_records_ < kMaxRecords) {
+    record = &records_[num_records_++];
+    *record = {subgraph_idx, node_idx, 0, 0, 0, 0};
+  } else {
+    return;
+  }
+  record->invocations++;
+  if (high_water_bytes > record->high_water_bytes) {
+    record->high_water_bytes = high_water_bytes;
+  }
+  if (stray_bytes > record->stray_bytes) {
+    record->stray_bytes = stray_bytes;
+  }
+  if (temp_bytes > record->temp_bytes) {
+    record->temp_bytes = temp_bytes;
+  }
+}
+
+bool MicroArenaTracer::IsTracked(const ScratchBufferInfo& buffer) const {
+  return buffer.bytes > 0 && buffer.data >= region_ &&
+         buffer.data + buffer.bytes <= region_ + region_bytes_;
+}
+
+int MicroArenaTracer::FindRecord(int subgraph_idx, int node_idx) const {
+  for (int i = 0; i < num_records_; ++i) {
+    if (records_[i].subgraph_idx == subgraph_idx &&
+        records_[i].node_idx == node_idx) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+size_t MicroArenaTracer::GetScratchBufferOverrideBytes(int buffer_idx) const {
+  const ScratchBufferInfo& buffer = scratch_buffers_[buffer_idx];
+  // Buffers of nodes that were never invoked, e.g. in a branch of an IF that
+  // was not taken, and buffers outside the region were not measured.
+  if (!IsTracked(buffer) ||
+      FindRecord(buffer.subgraph_idx, buffer.node_idx) < 0) {
+    return 0;
+  }
+  size_t bytes = AlignSizeUp(scratch_used_bytes_[buffer_idx],
+                             MicroArenaBufferAlignment());
+  if (bytes == 0) {
+    bytes = MicroArenaBufferAlignment();
+  }
+  return bytes < buffer.requested_bytes ? bytes : 0;
+}
+
+void MicroArenaTracer::LogJson() const {
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
+  MicroPrintf("{\"arena_bytes\":%" PRIu32 ",\"planned_bytes\":%" PRIu32
+              ",\"nodes\":[",
+              static_cast<uint32_t>(region_bytes_),
+              static_cast<uint32_t>(planned_bytes_));
+  Interval intervals[kMaxLiveBuffers];
+  for (int r = 0; r < num_records_; ++r) {
+    const NodeRecord& record = records_[r];
+    const Operator* op = model_->subgraphs()
+                             ->Get(record.subgraph_idx)
+                             ->operators()
+                             ->Get(record.node_idx);
+    MicroPrintf("{\"subgraph\":%d,\"node\":%d,\"op\":\"%s\",\"invocations\":%d,"
+                "\"high_water_bytes\":%" PRIu32 ",\"stray_bytes\":%" PRIu32
+                ",\"temp_bytes\":%" PRIu32 ",\"buffers\":[",
+                record.subgraph_idx, record.node_idx, GetOpName(model_, op),
+                record.invocations,
+                static_cast<uint32_t>(record.high_water_bytes),
+                static_cast<uint32_t>(record.stray_bytes),
+                static_cast<uint32_t>(record.temp_bytes));
+    const Level level = {record.subgraph_idx, record.node_idx, true};
+    const int count = CollectLiveBuffers(&level, 1, true, intervals);
+    for (int i = 0; i < count; ++i) {
+      const Interval& interval = intervals[i];
+      const char* separator = i + 1 < count ? "," : "";
+      if (interval.is_scratch) {
+        MicroPrintf("{\"kind\":\"scratch\",\"index\":%d,\"offset\":%" PRIu32
+                    ",\"bytes\":%" PRIu32 ",\"used_bytes\":%" PRIu32 "}%s",
+                    interval.index, interval.begin,
+                    interval.end - interval.begin,
+                    static_cast<uint32_t>(scratch_used_bytes_[interval.index]),
+                    separator);
+      } else {
+        MicroPrintf("{\"kind\":\"tensor\",\"index\":%d,\"offset\":%" PRIu32
+                    ",\"bytes\":%" PRIu32 "}%s",
+                    interval.index, interval.begin,
+                    interval.end - interval.begin, separator);
+      }
+    }
+    MicroPrintf("]}%s", r + 1 < num_records_ ? "," : "");
+  }
+  MicroPrintf("]}");
+#endif
+}
+
+void MicroArenaTracer::LogScratchBufferUsage() const {
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
+  MicroPrintf(
+      "\"Subgraph\",\"Node\",\"Op\",\"Buffer\",\"Requested\",\"Planned\","
+      "\"Written\"");
+  for (int i = 0; i < num_scratch_buffers_; ++i) {
+    const ScratchBufferInfo& buffer = scratch_buffers_[i];
+    if (!IsTracked(buffer) ||
+        FindRecord(buffer.subgraph_idx, buffer.node_idx) < 0) {
+      continue;
+    }
+    const Operator* op = model_->subgraphs()
+                             ->Get(buffer.subgraph_idx)
+                             ->operators()
+                             ->Get(buffer.node_idx);
+    MicroPrintf("%d,%d,%s,%d,%" PRIu32 ",%" PRIu32 ",%" PRIu32,
+                buffer.subgraph_idx, buffer.node_idx, GetOpName(model_, op), i,
+                static_cast<uint32_t>(buffer.requested_bytes),
+                static_cast<uint32_t>(buffer.bytes),
+                static_cast<uint32_t>(scratch_used_bytes_[i]));
+  }
+#endif
+}
+
+void MicroArenaTracer::LogScratchBufferOverrides() const {
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
+  int count = 0;
+  for (int i = 0; i < num_scratch_buffers_; ++i) {
+    if (GetScratchBufferOverrideBytes(i) > 0) {
+      ++count;
+    }
+  }
+  MicroPrintf("// Scratch buffer overrides measured by MicroArenaTracer over "
+              "%d invocations.",
+              num_invocations_);
+  if (count == 0) {
+    MicroPrintf("const tflite::ScratchBufferOverride* const "
+                "kScratchBufferOverrides = nullptr;");
+    MicroPrintf("const int kNumScratchBufferOverrides = 0;");
+    return;
+  }
+  MicroPrintf(
+      "const tflite::ScratchBufferOverride kScratchBufferOverrides[] = {");
+  int request_index = 0;
+  for (int i = 0; i < num_scratch_buffers_; ++i) {
+    const ScratchBufferInfo& buffer = scratch_buffers_[i];
+    if (i > 0 && buffer.subgraph_idx == scratch_buffers_[i - 1].subgraph_idx &&
+        buffer.node_idx == scratch_buffers_[i - 1].node_idx) {
+      ++request_index;
+    } else {
+      request_index = 0;
+    }
+    const size_t bytes = GetScratchBufferOverrideBytes(i);
+    if (bytes == 0) {
+      continue;
+    }
+    const Operator* op = model_->subgraphs()
+                             ->Get(buffer.subgraph_idx)
+                             ->operators()
+                             ->Get(buffer.node_idx);
+    MicroPrintf("    {%d, %d, %d, %" PRIu32 ", %" PRIu32 "},  // %s",
+                buffer.subgraph_idx, buffer.node_idx, request_index,
+                static_cast<uint32_t>(buffer.requested_bytes),
+                static_cast<uint32_t>(bytes), GetOpName(model_, op));
+  }
+  MicroPrintf("};");
+  MicroPrintf("const int kNumScratchBufferOverrides = %d;", count);
+#endif
+}
+
+}  // namespace tflite
@@ -0,0 +1,211 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_ARENA_TRACER_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_ARENA_TRACER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+// MicroArenaTracer measures how much of the tensor arena every operator
+// actually touches while the model is invoked, as opposed to the size of the
+// memory plan that MicroInterpreter::arena_used_bytes() reports.
+//
+// Before each node is invoked, every byte of the non-persistent part of the
+// arena that holds no live tensor is filled with a poison byte, kPoisonByte
+// or its complement on alternate invocations of the model. After the node
+// returns, the bytes that changed tell
+//  - how many bytes of each of its scratch buffers the kernel wrote,
+//  - whether it wrote to planned memory outside its tensors and scratch
+//    buffers, e.g. by overrunning an output, and
+//  - how far above the memory plan temporary allocations reached.
+// Bytes that a kernel writes with the poison value itself and writes to
+// other tensors that are live are not seen, so the results are lower bounds.
+// Invoking the model at least twice catches the former.
+//
+// The results are merged over all invocations of a node and can be exported
+// with LogJson() together with the offsets of the buffers that are live at
+// every node, e.g. to draw a heatmap of the arena with
+// scripts/arena_heatmap.py.
+//
+// Usage:
+//   MicroArenaTracer tracer;
+//   interpreter.SetArenaTracer(&tracer);
+//   interpreter.AllocateTensors();
+//   interpreter.Invoke();
+//   tracer.LogJson();
+//
+// Scratch buffers that kernels size for the worst case can then be shrunk to
+// what they wrote with the table that LogScratchBufferOverrides() prints, see
+// MicroInterpreter::SetScratchBufferOverrides().
+//
+// Poisoning costs a pass over the free arena per node, so this is a debugging
+// tool. A node that invokes subgraphs, e.g. WHILE, is measured after its
+// last inner node. Tensors and scratch buffers that a MultiRegionMemoryPlanner
+// places outside the arena are not tracked and are left out of the records.
+class MicroArenaTracer {
+ public:
+  static constexpr uint8_t kPoisonByte = 0xA5;
+
+  struct NodeRecord {
+    int subgraph_idx;
+    int node_idx;
+    int invocations;
+    // Highest offset in the arena below which the node's live tensors and the
+    // bytes it wrote lie.
+    size_t high_water_bytes;
+    // Bytes written to planned memory that held none of the node's tensors or
+    // scratch buffers.
+    size_t stray_bytes;
+    // Extent of the writes above the memory plan, i.e. temporary allocations.
+    size_t temp_bytes;
+  };
+
+  MicroArenaTracer() = default;
+  virtual ~MicroArenaTracer() = default;
+
+  // Computes the lifetimes of the tensors of the model from its graph and
+  // clears all records. Called by MicroInterpreter::AllocateTensors(), after
+  // the allocator committed its memory plan with KeepScratchBufferInfo().
+  TfLiteStatus Init(const Model* model, const MicroAllocator* allocator,
+                    const SubgraphAllocations* allocations);
+
+  // Called by MicroGraph around the invocation of every node. Calls nest when
+  // a node invokes subgraphs.
+  void BeginNode(int subgraph_idx, int node_idx);
+  void EndNode();
+
+  // Clears all records, e.g. between a warm-up and a measured invocation.
+  void ClearRecords();
+
+  int num_records() const { return num_records_; }
+  const NodeRecord& record(int index) const { return records_[index]; }
+
+  // Returns the most bytes the kernel wrote to the scratch buffer with the
+  // given index, see MicroContext::GetScratchBuffer().
+  size_t GetScratchBufferUsedBytes(int buffer_idx) const;
+
+  // Prints the records and the buffers that are live at every recorded node
+  // as JSON, see scripts/arena_heatmap.py for the format.
+  void LogJson() const;
+
+  // Prints the requested, planned and written bytes of every scratch buffer
+  // of the recorded nodes in CSV format.
+  void LogScratchBufferUsage() const;
+
+  // Prints a C++ table of ScratchBufferOverride entries that shrink every
+  // scratch buffer of the recorded nodes to the bytes the kernel wrote,
+  // rounded up to MicroArenaBufferAlignment(). The table is named
+  // kScratchBufferOverrides and has kNumScratchBufferOverrides entries.
+  void LogScratchBufferOverrides() const;
+
+ private:
+  static constexpr int kMaxSubgraphs = 8;
+  static constexpr int kMaxTensors = 1024;
+  static constexpr int kMaxScratchBuffers = 256;
+  static constexpr int kMaxRecords = 256;
+  static constexpr int kMaxLiveBuffers = 128;
+  static constexpr int kMaxDepth = 4;
+
+  // A range of the arena, relative to its start. index is the tensor index
+  // for tensors and the buffer index for scratch buffers.
+  struct Interval {
+    uint32_t begin;
+    uint32_t end;
+    int index;
+    bool is_scratch;
+  };
+
+  struct TensorInfo {
+    // Offset in the arena, or -1 if the tensor is not in the tracked region.
+    int32_t offset;
+    uint32_t bytes;
+    // Nodes of the subgraph between which the tensor is live.
+    int first_use;
+    int last_use;
+  };
+
+  struct Level {
+    int subgraph_idx;
+    int node_idx;
+    // False if the node had too many live buffers to be traced.
+    bool traced;
+  };
+
+  // Collects the buffers that must not be poisoned while the node of the
+  // innermost of the given levels is invoked, sorted by offset: the tensors
+  // that are live at every level, the inputs and outputs of the subgraphs
+  // that the levels invoke and the scratch buffers of the outer levels. With
+  // own_scratch_buffers, the scratch buffers of the innermost level are added
+  // too. Returns the number of intervals, or -1 if there are too many.
+  int CollectLiveBuffers(const Level* levels, int num_levels,
+                         bool own_scratch_buffers, Interval* intervals) const;
+
+  // Adds the tensors of a subgraph that are live at node_idx, or its inputs
+  // and outputs if node_idx is -1.
+  bool AddSubgraphTensors(int subgraph_idx, int node_idx, Interval* intervals,
+                          int* count) const;
+
+  void UpdateRecord(int subgraph_idx, int node_idx, size_t high_water_bytes,
+                    size_t stray_bytes, size_t temp_bytes);
+
+  // Returns whether a scratch buffer lies in the traced region, buffers that a
+  // MultiRegionMemoryPlanner placed in another memory do not.
+  bool IsTracked(const ScratchBufferInfo& buffer) const;
+
+  // Returns the index of the record of a node, or -1 if it has none.
+  int FindRecord(int subgraph_idx, int node_idx) const;
+
+  // Returns the bytes of a scratch buffer to override its request with, or 0
+  // if it cannot be shrunk.
+  size_t GetScratchBufferOverrideBytes(int buffer_idx) const;
+
+  const Model* model_ = nullptr;
+  const MicroAllocator* allocator_ = nullptr;
+  uint8_t* region_ = nullptr;
+  size_t region_bytes_ = 0;
+  size_t planned_bytes_ = 0;
+
+  int num_subgraphs_ = 0;
+  int subgraph_first_tensor_[kMaxSubgraphs + 1];
+  TensorInfo tensors_[kMaxTensors];
+
+  const ScratchBufferInfo* scratch_buffers_ = nullptr;
+  int num_scratch_buffers_ = 0;
+  size_t scratch_used_bytes_[kMaxScratchBuffers];
+
+  NodeRecord records_[kMaxRecords];
+  int num_records_ = 0;
+
+  Level levels_[kMaxDepth];
+  int depth_ = 0;
+  int num_invocations_ = 0;
+  uint8_t poison_byte_ = kPoisonByte;
+
+  Interval intervals_[kMaxLiveBuffers];
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_ARENA_TRACER_H_
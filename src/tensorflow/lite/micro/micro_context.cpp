@@ -38,6 +38,17 @@ TfLiteStatus MicroContext::RequestScratchBufferInArena(size_t bytes,
       bytes, graph_.GetCurrentSubgraphIndex(), buffer_idx);
 }
 
+void* MicroContext::AllocateAlignedPersistentBuffer(size_t bytes,
+                                                    size_t alignment) {
+  return allocator_.AllocateAlignedPersistentBuffer(bytes, alignment);
+}
+
+TfLiteStatus MicroContext::RequestAlignedScratchBufferInArena(
+    size_t bytes, size_t alignment, int* buffer_idx) {
+  return allocator_.RequestAlignedScratchBufferInArena(
+      bytes, alignment, graph_.GetCurrentSubgraphIndex(), buffer_idx);
+}
+
 void* MicroContext::GetScratchBuffer(int buffer_idx) {
   ScratchBufferHandle* handle = scratch_buffer_handles_ + buffer_idx;
   return handle->data;
@@ -60,6 +71,40 @@ int MicroContext::GetTensorIndex(int index, int max_size,
   return -1;
 }
 
+const SparsityParameters* MicroContext::GetInputSparsity(
+    const TfLiteNode* node, int index) {
+  const int tensor_index =
+      GetTensorIndex(index, node->inputs->size, node->inputs->data);
+  if (tensor_index < 0 || model_ == nullptr) {
+    return nullptr;
+  }
+  const SubGraph* subgraph =
+      model_->subgraphs()->Get(graph_.GetCurrentSubgraphIndex());
+  return subgraph->tensors()->Get(tensor_index)->sparsity();
+}
+
+const TensorPalette* MicroContext::GetInputPalette(const TfLiteNode* node,
+                                                  int index) {
+  const int tensor_index =
+      GetTensorIndex(index, node->inputs->size, node->inputs->data);
+  if (tensor_index < 0) {
+    return nullptr;
+  }
+  return allocator_.GetTensorPalette(graph_.GetCurrentSubgraphIndex(),
+                                     tensor_index);
+}
+
+const OutputMultipliers* MicroContext::GetOutputMultipliers(
+    const TfLiteNode* node) {
+  const int tensor_index =
+      GetTensorIndex(0, node->outputs->size, node->outputs->data);
+  if (tensor_index < 0) {
+    return nullptr;
+  }
+  return allocator_.GetOutputMultipliers(graph_.GetCurrentSubgraphIndex(),
+                                         tensor_index);
+}
+
 TfLiteTensor* MicroContext::AllocateTempInputTensor(const TfLiteNode* node,
                                                     int index) {
   const int tensor_index =
@@ -19,6 +19,9 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_graph.h"
+#include "tensorflow/lite/micro/micro_kernel_tuner.h"
+#include "tensorflow/lite/micro/micro_output_multipliers.h"
+#include "tensorflow/lite/micro/micro_palette.h"
 
 namespace tflite {
 // MicroContext is eventually going to become the API between TFLM and the
@@ -50,6 +53,16 @@ class MicroContext {
   virtual TfLiteStatus RequestScratchBufferInArena(size_t bytes,
                                                    int* buffer_idx);
 
+  // Same as AllocatePersistentBuffer() and RequestScratchBufferInArena() for
+  // kernels that need their buffer aligned to more than the alignment policy
+  // of the allocator guarantees, see MicroAlignmentPolicy, e.g. for int64_t
+  // values or SIMD loads. alignment must be a power of two of at most
+  // MicroArenaBufferAlignment().
+  virtual void* AllocateAlignedPersistentBuffer(size_t bytes, size_t alignment);
+  virtual TfLiteStatus RequestAlignedScratchBufferInArena(size_t bytes,
+                                                          size_t alignment,
+                                                          int* buffer_idx);
+
   // Get the scratch buffer pointer.
   // This method is only available in Eval stage.
   // Virtual so that it can be faked for kernel tests.
@@ -80,6 +93,24 @@ class MicroContext {
   virtual TfLiteTensor* AllocateTempIntermediateTensor(const TfLiteNode* node,
                                                        int index);
 
+  // Returns the sparsity parameters stored in the model for the specified
+  // input tensor of a given node, or nullptr if the tensor is dense. TFLM does
+  // not populate TfLiteTensor::sparsity, so kernels that support sparse
+  // weights decode these in Prepare.
+  virtual const SparsityParameters* GetInputSparsity(const TfLiteNode* node,
+                                                     int index);
+
+  // Returns the palette of an input tensor of a given node, or nullptr if the
+  // tensor holds plain values. The data of a palettized tensor is its packed
+  // indices, see micro_palette.h.
+  virtual const TensorPalette* GetInputPalette(const TfLiteNode* node,
+                                               int index);
+
+  // Returns the per-channel output multipliers and shifts that were
+  // precomputed on the host for a given node, or nullptr if the kernel has to
+  // compute them. See micro_output_multipliers.h.
+  virtual const OutputMultipliers* GetOutputMultipliers(const TfLiteNode* node);
+
   // Deallocates a temp TfLiteTensor.
   // Virtual so that it can be faked for kernel tests.
   virtual void DeallocateTempTfLiteTensor(TfLiteTensor* tensor);
@@ -97,6 +128,15 @@ class MicroContext {
 
   MicroGraph& graph() { return graph_; }
 
+  // Returns the kernel tuner set through MicroInterpreter::SetKernelTuner, or
+  // nullptr if kernels should use their default implementations.
+  MicroKernelTuner* kernel_tuner() { return kernel_tuner_; }
+
+  // Not API between TFLM and kernels. Used by the interpreter.
+  void set_kernel_tuner(MicroKernelTuner* kernel_tuner) {
+    kernel_tuner_ = kernel_tuner;
+  }
+
   // Sets the pointer to a list of ScratchBufferHandle instances.
   // Not API between TFLM and kernels. Primarily used by the framework for
   // housekeeping in MicroContext.
@@ -113,6 +153,7 @@ class MicroContext {
 
   ScratchBufferHandle* scratch_buffer_handles_ = nullptr;
   void* external_context_payload_ = nullptr;
+  MicroKernelTuner* kernel_tuner_ = nullptr;
 
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
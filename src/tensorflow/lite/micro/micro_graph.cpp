@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/micro/flatbuffer_utils.h"
 #include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/micro/micro_arena_tracer.h"
 #include "tensorflow/lite/micro/micro_log.h"
 #include "tensorflow/lite/micro/micro_profiler.h"
 #include "tensorflow/lite/schema/schema_generated.h"
@@ -35,6 +36,26 @@ const char* OpNameFromRegistration(const TfLiteRegistration* registration) {
   }
 }
 
+// Assembles the TfLiteNode of an operator. The arrays point into the
+// flatbuffer, only the builtin and user data are stored in the arena.
+TfLiteNode MakeNode(const Operator* op,
+                    const NodeAndRegistration& node_and_registration) {
+  TfLiteNode node = {};
+  node.inputs = FlatBufferVectorToTfLiteTypeArray(op->inputs());
+  node.outputs = FlatBufferVectorToTfLiteTypeArray(op->outputs());
+  if (op->intermediates() != nullptr && op->intermediates()->size() > 0) {
+    node.intermediates = FlatBufferVectorToTfLiteTypeArray(op->intermediates());
+  }
+  node.user_data = node_and_registration.user_data;
+  node.builtin_data = node_and_registration.builtin_data;
+  // The interpreter rejects builtin operators with custom options.
+  if (op->custom_options() != nullptr) {
+    node.custom_initial_data = op->custom_options()->data();
+    node.custom_initial_data_size = op->custom_options()->size();
+  }
+  return node;
+}
+
 }  // namespace
 
 MicroGraph::MicroGraph(TfLiteContext* context, const Model* model,
@@ -60,23 +81,26 @@ TfLiteStatus MicroGraph::InitSubgraphs() {
     current_subgraph_index_ = subgraph_idx;
     uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
     for (size_t i = 0; i < operators_size; ++i) {
-      TfLiteNode* node =
-          &(subgraph_allocations_[subgraph_idx].node_and_registrations[i].node);
+      NodeAndRegistration* node_and_registration =
+          &subgraph_allocations_[subgraph_idx].node_and_registrations[i];
       const TfLiteRegistration* registration =
-          subgraph_allocations_[subgraph_idx]
-              .node_and_registrations[i]
-              .registration;
+          node_and_registration->registration;
       size_t init_data_size;
       const char* init_data;
       if (registration->builtin_code == BuiltinOperator_CUSTOM) {
-        init_data = reinterpret_cast<const char*>(node->custom_initial_data);
-        init_data_size = node->custom_initial_data_size;
+        const auto* custom_options =
+            (*subgraphs_)[subgraph_idx]->operators()->Get(i)->custom_options();
+        init_data = custom_options != nullptr
+                        ? reinterpret_cast<const char*>(custom_options->data())
+                        : nullptr;
+        init_data_size = custom_options != nullptr ? custom_options->size() : 0;
       } else {
-        init_data = reinterpret_cast<const char*>(node->builtin_data);
+        init_data =
+            reinterpret_cast<const char*>(node_and_registration->builtin_data);
         init_data_size = 0;
       }
       if (registration->init) {
-        node->user_data =
+        node_and_registration->user_data =
             registration->init(context_, init_data, init_data_size);
       }
     }
@@ -94,14 +118,18 @@ TfLiteStatus MicroGraph::PrepareSubgraphs() {
     current_subgraph_index_ = subgraph_idx;
     uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
     for (size_t i = 0; i < operators_size; ++i) {
-      TfLiteNode* node =
-          &(subgraph_allocations_[subgraph_idx].node_and_registrations[i].node);
+      NodeAndRegistration& node_and_registration =
+          subgraph_allocations_[subgraph_idx].node_and_registrations[i];
       const TfLiteRegistration* registration =
-          subgraph_allocations_[subgraph_idx]
-              .node_and_registrations[i]
-              .registration;
+          node_and_registration.registration;
       if (registration->prepare != nullptr) {
-        TfLiteStatus prepare_status = registration->prepare(context_, node);
+        TfLiteNode node = MakeNode(
+            (*subgraphs_)[subgraph_idx]->operators()->Get(i),
+            node_and_registration);
+        TfLiteStatus prepare_status = registration->prepare(context_, &node);
+        // Some kernels only allocate their user_data in Prepare, e.g. int8
+        // CUMSUM and LOG_SOFTMAX, so keep it for Eval and Free.
+        node_and_registration.user_data = node.user_data;
         if (prepare_status != kTfLiteOk) {
           MicroPrintf("Node %s (number %df) failed to prepare with status %d",
                       OpNameFromRegistration(registration), i, prepare_status);
@@ -124,16 +152,14 @@ TfLiteStatus MicroGraph::FreeSubgraphs() {
     current_subgraph_index_ = subgraph_idx;
     uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
     for (size_t i = 0; i < operators_size; ++i) {
-      TfLiteNode* node =
-          &(subgraph_allocations_[subgraph_idx].node_and_registrations[i].node);
+      const NodeAndRegistration& node_and_registration =
+          subgraph_allocations_[subgraph_idx].node_and_registrations[i];
       const TfLiteRegistration* registration =
-          subgraph_allocations_[subgraph_idx]
-              .node_and_registrations[i]
-              .registration;
+          node_and_registration.registration;
       // registration is allocated outside the interpreter, so double check to
       // make sure it's not nullptr;
       if (registration != nullptr && registration->free != nullptr) {
-        registration->free(context_, node->user_data);
+        registration->free(context_, node_and_registration.user_data);
       }
     }
   }
@@ -153,11 +179,13 @@ TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
   }
   uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
   for (size_t i = 0; i < operators_size; ++i) {
-    TfLiteNode* node =
-        &(subgraph_allocations_[subgraph_idx].node_and_registrations[i].node);
-    const TfLiteRegistration* registration = subgraph_allocations_[subgraph_idx]
-                                                 .node_and_registrations[i]
-                                                 .registration;
+    const NodeAndRegistration& node_and_registration =
+        subgraph_allocations_[subgraph_idx].node_and_registrations[i];
+    const TfLiteRegistration* registration = node_and_registration.registration;
+    // A local node, since kernels such as IF and WHILE invoke other subgraphs
+    // from their Invoke.
+    TfLiteNode node = MakeNode((*subgraphs_)[subgraph_idx]->operators()->Get(i),
+                               node_and_registration);
 
 // This ifdef is needed (even though ScopedMicroProfiler itself is a no-op with
 // -DTF_LITE_STRIP_ERROR_STRINGS) because the function OpNameFromRegistration is
@@ -168,8 +196,20 @@ TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
         reinterpret_cast<MicroProfilerInterface*>(context_->profiler));
 #endif
 
+    MicroWeightStreamer* weight_streamer = allocator_->weight_streamer();
+    if (weight_streamer != nullptr) {
+      TF_LITE_ENSURE_STATUS(weight_streamer->StageNodeInputs(
+          subgraph_idx, i, subgraph_allocations_[subgraph_idx].tensors));
+    }
+
+    if (arena_tracer_ != nullptr) {
+      arena_tracer_->BeginNode(subgraph_idx, i);
+    }
     TFLITE_DCHECK(registration->invoke);
-    TfLiteStatus invoke_status = registration->invoke(context_, node);
+    TfLiteStatus invoke_status = registration->invoke(context_, &node);
+    if (arena_tracer_ != nullptr) {
+      arena_tracer_->EndNode();
+    }
 
     // All TfLiteTensor structs used in the kernel are allocated from temp
     // memory in the allocator. This creates a chain of allocations in the
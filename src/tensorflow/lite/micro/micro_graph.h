@@ -23,6 +23,8 @@ limitations under the License.
 
 namespace tflite {
 
+class MicroArenaTracer;
+
 // Abstracts the details of interacting with the tflite::Model.
 //
 // Provides methods to access, initialize, prepare, invoke and free any
@@ -87,6 +89,11 @@ class MicroGraph {
   // Get the resource variables for this TFLM graph.
   MicroResourceVariables* GetResourceVariables() { return resource_variables_; }
 
+  // Traces the arena usage of every node that InvokeSubgraph() invokes, see
+  // micro_arena_tracer.h. Passing nullptr disables tracing.
+  void SetArenaTracer(MicroArenaTracer* tracer) { arena_tracer_ = tracer; }
+  MicroArenaTracer* arena_tracer() { return arena_tracer_; }
+
  private:
   TfLiteContext* context_;
   const Model* model_;
@@ -95,6 +102,7 @@ class MicroGraph {
   int current_subgraph_index_;
   MicroResourceVariables* resource_variables_;
   const flatbuffers::Vector<flatbuffers::Offset<SubGraph>>* subgraphs_;
+  MicroArenaTracer* arena_tracer_ = nullptr;
 
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
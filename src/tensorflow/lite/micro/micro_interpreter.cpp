@@ -124,18 +124,11 @@ TfLiteStatus MicroInterpreter::PrepareNodeAndRegistrationDataFromFlatbuffer() {
       BuiltinOperator op_type =
           static_cast<BuiltinOperator>(registration->builtin_code);
 
-      const char* custom_data = nullptr;
-      size_t custom_data_size = 0;
       unsigned char* builtin_data = nullptr;
 
-      if (op_type == BuiltinOperator_CUSTOM) {
-        // Custom Ops may or may not have a non-null custom_options field.
-        if (op->custom_options() != nullptr) {
-          custom_data =
-              reinterpret_cast<const char*>(op->custom_options()->data());
-          custom_data_size = op->custom_options()->size();
-        }
-      } else {
+      // Custom Ops may or may not have a non-null custom_options field, which
+      // MicroGraph passes to them directly from the flatbuffer.
+      if (op_type != BuiltinOperator_CUSTOM) {
         if (op->custom_options() != nullptr) {
           MicroPrintf(
               "Unsupported behavior: found builtin operator %s with custom "
@@ -156,24 +149,10 @@ TfLiteStatus MicroInterpreter::PrepareNodeAndRegistrationDataFromFlatbuffer() {
             parser, op, builtin_data_allocator, (void**)(&builtin_data)));
       }
 
-      TfLiteIntArray* inputs_array =
-          FlatBufferVectorToTfLiteTypeArray(op->inputs());
-      TfLiteIntArray* outputs_array =
-          FlatBufferVectorToTfLiteTypeArray(op->outputs());
-
-      TfLiteNode* node = &(
-          graph_.GetAllocations()[subgraph_idx].node_and_registrations[i].node);
-      *node = {};
-      node->inputs = inputs_array;
-      node->outputs = outputs_array;
-      node->builtin_data = reinterpret_cast<void*>(builtin_data);
-      node->custom_initial_data = custom_data;
-      node->custom_initial_data_size = custom_data_size;
-
-      if (op->intermediates() && (op->intermediates()->size() > 0)) {
-        node->intermediates =
-            FlatBufferVectorToTfLiteTypeArray(op->intermediates());
-      }
+      NodeAndRegistration* node_and_registration =
+          &graph_.GetAllocations()[subgraph_idx].node_and_registrations[i];
+      node_and_registration->builtin_data = builtin_data;
+      node_and_registration->user_data = nullptr;
     }
   }
   return kTfLiteOk;
@@ -190,6 +169,10 @@ TfLiteStatus MicroInterpreter::AllocateTensors() {
 
   graph_.SetSubgraphAllocations(allocations);
 
+  if (micro_context_.kernel_tuner() != nullptr) {
+    micro_context_.kernel_tuner()->BeginModel(model_);
+  }
+
   TF_LITE_ENSURE_STATUS(PrepareNodeAndRegistrationDataFromFlatbuffer());
 
   // Only allow AllocatePersistentBuffer in Init stage.
@@ -266,10 +249,25 @@ TfLiteStatus MicroInterpreter::AllocateTensors() {
 
   TF_LITE_ENSURE_STATUS(Reset());
 
+  if (graph_.arena_tracer() != nullptr) {
+    TF_LITE_ENSURE_STATUS(graph_.arena_tracer()->Init(
+        model_, &allocator_, graph_.GetAllocations()));
+  }
+
   tensors_allocated_ = true;
   return kTfLiteOk;
 }
 
+TfLiteStatus MicroInterpreter::AllocateTensors(
+    size_t weight_cache_bytes, const MicroProfiler* calibration) {
+  TF_LITE_ENSURE_STATUS(AllocateTensors());
+  if (weight_cache_bytes == 0) {
+    return kTfLiteOk;
+  }
+  return allocator_.CacheConstantTensors(model_, graph_.GetAllocations(),
+                                         weight_cache_bytes, calibration);
+}
+
 TfLiteStatus MicroInterpreter::Invoke() {
   if (initialization_status_ != kTfLiteOk) {
     MicroPrintf("Invoke() called after initialization failed\n");
@@ -316,4 +314,54 @@ TfLiteStatus MicroInterpreter::SetMicroExternalContext(
   return micro_context_.set_external_context(external_context_payload);
 }
 
+TfLiteStatus MicroInterpreter::SetKernelTuner(MicroKernelTuner* tuner) {
+  if (tensors_allocated_) {
+    MicroPrintf("SetKernelTuner() must be called before AllocateTensors()");
+    return kTfLiteError;
+  }
+  micro_context_.set_kernel_tuner(tuner);
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroInterpreter::SetAlignmentPolicy(
+    const MicroAlignmentPolicy& policy) {
+  if (tensors_allocated_) {
+    MicroPrintf("SetAlignmentPolicy() must be called before AllocateTensors()");
+    return kTfLiteError;
+  }
+  return allocator_.SetAlignmentPolicy(policy);
+}
+
+TfLiteStatus MicroInterpreter::SetArenaTracer(MicroArenaTracer* tracer) {
+  if (tensors_allocated_) {
+    MicroPrintf("SetArenaTracer() must be called before AllocateTensors()");
+    return kTfLiteError;
+  }
+  allocator_.KeepScratchBufferInfo();
+  graph_.SetArenaTracer(tracer);
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroInterpreter::SetScratchBufferOverrides(
+    const ScratchBufferOverride* overrides, int count) {
+  if (tensors_allocated_) {
+    MicroPrintf(
+        "SetScratchBufferOverrides() must be called before AllocateTensors()");
+    return kTfLiteError;
+  }
+  allocator_.SetScratchBufferOverrides(overrides, count);
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroInterpreter::SetWeightStreaming(
+    MicroWeightProvider* provider, size_t min_tensor_bytes,
+    size_t max_staging_bytes) {
+  if (tensors_allocated_) {
+    MicroPrintf("SetWeightStreaming() must be called before AllocateTensors()");
+    return kTfLiteError;
+  }
+  allocator_.SetWeightStreaming(provider, min_tensor_bytes, max_staging_bytes);
+  return kTfLiteOk;
+}
+
 }  // namespace tflite
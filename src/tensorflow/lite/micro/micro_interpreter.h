@@ -24,10 +24,15 @@ limitations under the License.
 #include "tensorflow/lite/core/api/error_reporter.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_arena_tracer.h"
 #include "tensorflow/lite/micro/micro_context.h"
 #include "tensorflow/lite/micro/micro_graph.h"
+#include "tensorflow/lite/micro/micro_kernel_tuner.h"
 #include "tensorflow/lite/micro/micro_op_resolver.h"
+#include "tensorflow/lite/micro/micro_profiler.h"
 #include "tensorflow/lite/micro/micro_profiler_interface.h"
+#include "tensorflow/lite/micro/micro_weight_provider.h"
+#include "tensorflow/lite/micro/micro_weight_streamer.h"
 #include "tensorflow/lite/portable_type_to_tflitetype.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
@@ -68,6 +73,15 @@ class MicroInterpreter {
   // intermediate tensors.
   TfLiteStatus AllocateTensors();
 
+  // Runs AllocateTensors() and then spends up to weight_cache_bytes of the
+  // arena left over on copies of constant tensors, so that kernels read them
+  // from SRAM instead of flash, see MicroAllocator::CacheConstantTensors.
+  // calibration, if not nullptr, holds the events of earlier invocations of
+  // the same model and is used to pick the tensors. Keep enough of the arena
+  // free for the temporary allocations kernels make during Invoke().
+  TfLiteStatus AllocateTensors(size_t weight_cache_bytes,
+                               const MicroProfiler* calibration = nullptr);
+
   // In order to support partial graph runs for strided models, this can return
   // values other than kTfLiteOk and kTfLiteError.
   // TODO(b/149795762): Add this to the TfLiteStatus enum.
@@ -79,6 +93,41 @@ class MicroInterpreter {
   // one external context.
   TfLiteStatus SetMicroExternalContext(void* external_context_payload);
 
+  // Enables kernel auto-tuning with the given tuner, see micro_kernel_tuner.h.
+  // Must be called before AllocateTensors(). Nodes are tuned during the first
+  // Invoke() unless tuner already holds choices for this model. The lifetime
+  // of tuner should be at least as long as this interpreter.
+  TfLiteStatus SetKernelTuner(MicroKernelTuner* tuner);
+
+  // Sets the minimum alignment of the buffers the allocator places in the
+  // arena, see MicroAlignmentPolicy. Must be called before AllocateTensors().
+  TfLiteStatus SetAlignmentPolicy(const MicroAlignmentPolicy& policy);
+
+  // Measures the arena that every node touches while the model is invoked,
+  // see micro_arena_tracer.h. Must be called before AllocateTensors(). The
+  // lifetime of tracer should be at least as long as this interpreter.
+  TfLiteStatus SetArenaTracer(MicroArenaTracer* tracer);
+
+  // Shrinks the scratch buffers that kernels request, see
+  // ScratchBufferOverride. Must be called before AllocateTensors(). The
+  // lifetime of overrides should be at least as long as this interpreter.
+  TfLiteStatus SetScratchBufferOverrides(
+      const ScratchBufferOverride* overrides, int count);
+
+  // Streams constant tensors through provider while the model is invoked,
+  // see MicroAllocator::SetWeightStreaming. Must be called before
+  // AllocateTensors(). The lifetime of provider should be at least as long as
+  // this interpreter.
+  TfLiteStatus SetWeightStreaming(MicroWeightProvider* provider,
+                                  size_t min_tensor_bytes,
+                                  size_t max_staging_bytes);
+
+  // Returns the weight streamer, e.g. for its stall statistics, or nullptr if
+  // no tensor is streamed.
+  const MicroWeightStreamer* weight_streamer() const {
+    return allocator_.weight_streamer();
+  }
+
   TfLiteTensor* input(size_t index);
   size_t inputs_size() const {
     return model_->subgraphs()->Get(0)->inputs()->size();
@@ -0,0 +1,139 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/micro_kernel_tuner.h"
+
+namespace tflite {
+
+namespace {
+
+template <typename T>
+uint32_t HashValue(uint32_t hash, T value) {
+  return MicroKernelTuner::Hash(hash, &value, sizeof(value));
+}
+
+uint32_t HashVector(uint32_t hash,
+                    const flatbuffers::Vector<int32_t>* vector) {
+  if (vector == nullptr) {
+    return HashValue(hash, -1);
+  }
+  hash = HashValue(hash, vector->size());
+  return MicroKernelTuner::Hash(hash, vector->data(),
+                                vector->size() * sizeof(int32_t));
+}
+
+// Hashes the structure of model: operators, their connections and the types
+// and shapes of the tensors. Weight values are left out since they do not
+// change which kernel is fastest.
+uint32_t HashModel(const Model* model) {
+  uint32_t hash = MicroKernelTuner::kInitialHash;
+  if (model->operator_codes() != nullptr) {
+    for (const OperatorCode* code : *model->operator_codes()) {
+      hash = HashValue(hash, static_cast<int32_t>(code->builtin_code()));
+      hash = HashValue(hash, code->version());
+    }
+  }
+  if (model->subgraphs() == nullptr) {
+    return hash;
+  }
+  for (const SubGraph* subgraph : *model->subgraphs()) {
+    if (subgraph->tensors() != nullptr) {
+      for (const Tensor* tensor : *subgraph->tensors()) {
+        hash = HashValue(hash, static_cast<int32_t>(tensor->type()));
+        hash = HashValue(hash, tensor->buffer());
+        hash = HashVector(hash, tensor->shape());
+      }
+    }
+    if (subgraph->operators() != nullptr) {
+      for (const Operator* op : *subgraph->operators()) {
+        hash = HashValue(hash, op->opcode_index());
+        hash = HashVector(hash, op->inputs());
+        hash = HashVector(hash, op->outputs());
+      }
+    }
+  }
+  return hash;
+}
+
+}  // namespace
+
+MicroKernelTuner::MicroKernelTuner() {
+  table_.model_hash = 0;
+  table_.num_entries = 0;
+}
+
+void MicroKernelTuner::LoadTable(const MicroKernelTuningTable& table) {
+  table_ = table;
+  if (table_.num_entries > MicroKernelTuningTable::kMaxEntries) {
+    table_.num_entries = 0;
+  }
+  table_changed_ = false;
+}
+
+void MicroKernelTuner::BeginModel(const Model* model) {
+  const uint32_t model_hash = HashModel(model);
+  if (table_.model_hash != model_hash) {
+    table_.model_hash = model_hash;
+    table_.num_entries = 0;
+    table_changed_ = true;
+  }
+  next_slot_ = 0;
+}
+
+int MicroKernelTuner::RegisterNode(uint32_t signature) {
+  if (next_slot_ >= MicroKernelTuningTable::kMaxEntries) {
+    return -1;
+  }
+  const int slot = next_slot_++;
+  MicroKernelTuningTable::Entry& entry = table_.entries[slot];
+  if (slot >= static_cast<int>(table_.num_entries) ||
+      entry.signature != signature) {
+    entry.signature = signature;
+    entry.choice = kUntuned;
+    table_changed_ = true;
+  }
+  if (slot >= static_cast<int>(table_.num_entries)) {
+    table_.num_entries = slot + 1;
+  }
+  return slot;
+}
+
+int MicroKernelTuner::GetChoice(int slot) const {
+  if (slot < 0 || slot >= static_cast<int>(table_.num_entries)) {
+    return kUntuned;
+  }
+  return table_.entries[slot].choice;
+}
+
+void MicroKernelTuner::SetChoice(int slot, int choice) {
+  if (slot < 0 || slot >= static_cast<int>(table_.num_entries)) {
+    return;
+  }
+  table_.entries[slot].choice = choice;
+  table_changed_ = true;
+}
+
+uint32_t MicroKernelTuner::Hash(uint32_t hash, const void* data,
+                                size_t bytes) {
+  // 32-bit FNV-1a.
+  const uint8_t* byte_data = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < bytes; ++i) {
+    hash ^= byte_data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+}  // namespace tflite
@@ -0,0 +1,104 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_KERNEL_TUNER_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_KERNEL_TUNER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+// Kernel choices recorded by MicroKernelTuner for one model. This is plain
+// data, so an application can write it to flash once the model has been
+// invoked and pass it to MicroKernelTuner::LoadTable on later boots.
+struct MicroKernelTuningTable {
+  static constexpr int kMaxEntries = 64;
+
+  struct Entry {
+    // Identifies the node configuration the choice was made for.
+    uint32_t signature;
+    int32_t choice;
+  };
+
+  uint32_t model_hash;
+  uint32_t num_entries;
+  Entry entries[kMaxEntries];
+};
+
+// MicroKernelTuner lets kernels that have several implementations for a node
+// time them on the target and keep the fastest. Tuning is opt-in: it only
+// happens for interpreters that were given a tuner through
+// MicroInterpreter::SetKernelTuner.
+//
+// Kernels register each tunable node in Prepare and get back a slot. On the
+// first Invoke a slot has no choice yet, so the kernel runs every candidate
+// once, times it with GetCurrentTimeTicks() and records the fastest. Later
+// invocations, and later boots that load the exported table, use the recorded
+// choice directly.
+class MicroKernelTuner {
+ public:
+  // Returned by GetChoice for slots that have not been tuned yet.
+  static constexpr int kUntuned = -1;
+
+  MicroKernelTuner();
+
+  // Replaces all choices with the ones in table, e.g. a table that was
+  // exported from an earlier run and stored in flash. Choices made for a
+  // different model or node configuration are discarded when the model is
+  // prepared.
+  void LoadTable(const MicroKernelTuningTable& table);
+
+  // Returns the choices made so far, for export.
+  const MicroKernelTuningTable& table() const { return table_; }
+
+  // Returns true if any choice was made or discarded since construction or
+  // the last LoadTable call, i.e. whether the table needs to be exported
+  // again.
+  bool table_changed() const { return table_changed_; }
+
+  // Called by the interpreter before the model's nodes are prepared. Keeps
+  // the current choices if they were made for model and clears them
+  // otherwise.
+  void BeginModel(const Model* model);
+
+  // Called by kernels in Prepare for a node with several candidate
+  // implementations. signature must identify everything the choice depends
+  // on, e.g. shapes and parameters. Returns the slot to pass to GetChoice and
+  // SetChoice, or -1 if the table is full and the node is not tuned.
+  int RegisterNode(uint32_t signature);
+
+  // Returns the choice recorded for slot, or kUntuned.
+  int GetChoice(int slot) const;
+
+  // Records choice for slot.
+  void SetChoice(int slot, int choice);
+
+  // Hash helper for computing signatures: returns hash updated with the
+  // bytes of data. Start from kInitialHash.
+  static constexpr uint32_t kInitialHash = 2166136261u;
+  static uint32_t Hash(uint32_t hash, const void* data, size_t bytes);
+
+ private:
+  MicroKernelTuningTable table_;
+  int next_slot_ = 0;
+  bool table_changed_ = false;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_KERNEL_TUNER_H_
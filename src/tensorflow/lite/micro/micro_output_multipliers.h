@@ -0,0 +1,52 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_OUTPUT_MULTIPLIERS_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_OUTPUT_MULTIPLIERS_H_
+
+#include <cstdint>
+
+namespace tflite {
+
+// The per-channel output multipliers and shifts that quantized convolutions
+// and fully connected layers requantize their accumulators with only depend on
+// the scales of the tensors, so they can be computed on the host. Kernels
+// then point at them in the model instead of allocating and computing them
+// in Prepare.
+//
+// Precomputed operators are listed in a model metadata entry named
+// kOutputMultiplierMetadataName, whose buffer holds little-endian uint32
+// words: the version kOutputMultiplierMetadataVersion, the number of entries,
+// and then for every entry the subgraph index, the index of the output tensor
+// of the operator, the number of channels and the index of the buffer holding
+// the int32 multipliers of all channels followed by their int32 shifts. See
+// scripts/precompute_output_multipliers.cpp.
+constexpr char kOutputMultiplierMetadataName[] = "TFLM_OUTPUT_MULTIPLIERS";
+constexpr uint32_t kOutputMultiplierMetadataVersion = 1;
+constexpr int kOutputMultiplierMetadataEntryWords = 4;
+
+struct OutputMultipliers {
+  int num_channels;
+
+  // num_channels values each, in the model flatbuffer. The shifts are
+  // exponents as returned by QuantizeMultiplier(), i.e. positive values shift
+  // left.
+  const int32_t* multipliers;
+  const int32_t* shifts;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_OUTPUT_MULTIPLIERS_H_
@@ -0,0 +1,51 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_PALETTE_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_PALETTE_H_
+
+#include <cstdint>
+
+namespace tflite {
+
+// A palettized int8 tensor stores a `bits` wide index per element into a
+// codebook of 1 << bits int8 values instead of the values themselves. The
+// indices are packed LSB first, in the usual element order, into the tensor
+// buffer, so a 4-bit palette halves the flash taken by the tensor. There is
+// either one codebook for the whole tensor or one per channel along the
+// quantized dimension.
+//
+// Palettized tensors are listed in a model metadata entry named
+// kPaletteMetadataName, whose buffer holds little-endian uint32 words: the
+// version kPaletteMetadataVersion, the number of entries, and then for every
+// entry the subgraph index, tensor index, index bit width, number of
+// codebooks and the index of the buffer holding the codebooks. See
+// scripts/palettize_tflite.cpp.
+constexpr char kPaletteMetadataName[] = "TFLM_PALETTE";
+constexpr uint32_t kPaletteMetadataVersion = 1;
+constexpr int kPaletteMetadataEntryWords = 5;
+
+struct TensorPalette {
+  int bits;
+  int num_codebooks;
+  int quantized_dimension;
+
+  // num_codebooks x (1 << bits) values, in the model flatbuffer.
+  const int8_t* codebooks;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_PALETTE_H_
@@ -40,6 +40,24 @@ void MicroProfiler::EndEvent(uint32_t event_handle) {
   end_ticks_[event_handle] = GetCurrentTimeTicks();
 }
 
+void MicroProfiler::AddToCounter(const char* tag, uint32_t delta) {
+  int position = FindCounter(tag);
+  if (position < 0) {
+    if (num_counters_ == kMaxCounters) {
+      return;
+    }
+    position = num_counters_++;
+    counters_[position].tag = tag;
+    counters_[position].value = 0;
+  }
+  counters_[position].value += delta;
+}
+
+uint32_t MicroProfiler::GetCounter(const char* tag) const {
+  const int position = FindCounter(tag);
+  return position < 0 ? 0 : counters_[position].value;
+}
+
 uint32_t MicroProfiler::GetTotalTicks() const {
   int32_t ticks = 0;
   for (int i = 0; i < num_events_; ++i) {
@@ -68,6 +86,15 @@ void MicroProfiler::LogCsv() const {
 #endif
 }
 
+void MicroProfiler::LogCountersCsv() const {
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS)
+  MicroPrintf("\"Counter\",\"Value\"");
+  for (int i = 0; i < num_counters_; ++i) {
+    MicroPrintf("%s,%" PRIu32, counters_[i].tag, counters_[i].value);
+  }
+#endif
+}
+
 void MicroProfiler::LogTicksPerTagCsv() {
 #if !defined(TF_LITE_STRIP_ERROR_STRINGS)
   MicroPrintf(
@@ -112,4 +139,13 @@ int MicroProfiler::FindExistingOrNextPosition(const char* tag_name) {
   }
   return pos < num_events_ ? pos : -1;
 }
+
+int MicroProfiler::FindCounter(const char* tag) const {
+  for (int i = 0; i < num_counters_; ++i) {
+    if (counters_[i].tag == tag || strcmp(counters_[i].tag, tag) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
 }  // namespace tflite
@@ -44,9 +44,30 @@ class MicroProfiler : public MicroProfilerInterface {
   // for a particular event_handle, the duration of that event will be 0 ticks.
   virtual void EndEvent(uint32_t event_handle) override;
 
+  // Adds delta to the counter with the given tag, creating it on first use.
+  // Deltas for tags beyond the first kMaxCounters distinct ones are dropped.
+  // The lifetime of the tag parameter must exceed that of the MicroProfiler.
+  virtual void AddToCounter(const char* tag, uint32_t delta) override;
+
   // Clears all the events that have been currently profiled.
   void ClearEvents() { num_events_ = 0; }
 
+  // Clears all the counters.
+  void ClearCounters() { num_counters_ = 0; }
+
+  // Returns the number of events recorded since the last ClearEvents() call,
+  // up to kMaxEvents.
+  int num_events() const { return num_events_; }
+
+  // Returns the ticks taken by the event with the given handle.
+  uint32_t GetEventTicks(int event_handle) const {
+    return end_ticks_[event_handle] - start_ticks_[event_handle];
+  }
+
+  // Returns the value of the counter with the given tag, or 0 if no delta has
+  // been added to it.
+  uint32_t GetCounter(const char* tag) const;
+
   // Returns the sum of the ticks taken across all the events. This number
   // is only meaningful if all of the events are disjoint (the end time of
   // event[i] <= start time of event[i+1]).
@@ -60,6 +81,9 @@ class MicroProfiler : public MicroProfilerInterface {
   // Separated Value) form.
   void LogCsv() const;
 
+  // Prints the value of each counter in CSV format.
+  void LogCountersCsv() const;
+
   // Prints  total ticks for each unique tag in CSV format.
   // Output will have one row for each unique tag along with the
   // total ticks summed across all events with that particular tag.
@@ -87,6 +111,18 @@ class MicroProfiler : public MicroProfilerInterface {
 
   int FindExistingOrNextPosition(const char* tag_name);
 
+  // Maximum number of distinct counter tags.
+  static constexpr int kMaxCounters = 16;
+
+  struct Counter {
+    const char* tag;
+    uint32_t value;
+  };
+  Counter counters_[kMaxCounters];
+  int num_counters_ = 0;
+
+  int FindCounter(const char* tag) const;
+
   TF_LITE_REMOVE_VIRTUAL_DELETE;
 };
 
@@ -31,6 +31,11 @@ class MicroProfilerInterface {
 
   // Marks the end of an event associated with event_handle.
   virtual void EndEvent(uint32_t event_handle) = 0;
+
+  // Adds delta to the counter identified by tag. Kernels use counters to
+  // report statistics that are not durations, such as cache hits. The default
+  // implementation discards them.
+  virtual void AddToCounter(const char* tag, uint32_t delta) {}
 };
 
 }  // namespace tflite
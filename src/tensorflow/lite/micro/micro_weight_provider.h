@@ -0,0 +1,63 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_WEIGHT_PROVIDER_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_WEIGHT_PROVIDER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/compatibility.h"
+
+namespace tflite {
+
+// Copies the data of streamed constant tensors from the storage holding the
+// model, e.g. external XIP or SPI flash, into SRAM. See
+// micro_weight_streamer.h for how tensors get streamed.
+//
+// Reads are asynchronous so that the copy of the next node's weights can
+// overlap with the computation of the current node, e.g. by handing them to a
+// DMA engine. At most one read is in flight at any time.
+class MicroWeightProvider {
+ public:
+  virtual ~MicroWeightProvider() {}
+
+  // Starts copying bytes bytes to destination. source is the address of the
+  // data inside the model flatbuffer, which implementations map to a location
+  // in their storage.
+  virtual TfLiteStatus StartRead(const void* source, size_t bytes,
+                                 void* destination) = 0;
+
+  // Blocks until the read started last has completed.
+  virtual TfLiteStatus WaitForRead() = 0;
+};
+
+// Reads from storage that is mapped into the address space, such as XIP
+// flash, with memcpy. Ports with a DMA engine can derive from this class and
+// start a transfer in StartRead instead.
+class MemoryMappedWeightProvider : public MicroWeightProvider {
+ public:
+  TfLiteStatus StartRead(const void* source, size_t bytes,
+                         void* destination) override;
+  TfLiteStatus WaitForRead() override;
+
+ private:
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_WEIGHT_PROVIDER_H_
@@ -0,0 +1,111 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/micro_weight_streamer.h"
+
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_time.h"
+
+namespace tflite {
+
+MicroWeightStreamer::MicroWeightStreamer(MicroWeightProvider* provider,
+                                         const Step* steps,
+                                         const int* subgraph_first_step,
+                                         uint8_t* staging, size_t slot_bytes)
+    : provider_(provider),
+      steps_(steps),
+      subgraph_first_step_(subgraph_first_step),
+      slots_{staging, staging + slot_bytes},
+      slot_bytes_(slot_bytes) {}
+
+TfLiteStatus MicroWeightStreamer::StageNodeInputs(int subgraph_idx,
+                                                  int node_idx,
+                                                  TfLiteEvalTensor* tensors) {
+  const int first = subgraph_first_step_[subgraph_idx];
+  const int end = subgraph_first_step_[subgraph_idx + 1];
+
+  // Binary search for the first step of the node.
+  int step = first;
+  int count = end - first;
+  while (count > 0) {
+    const int half = count / 2;
+    if (steps_[step + half].node_index < node_idx) {
+      step += half + 1;
+      count -= half + 1;
+    } else {
+      count = half;
+    }
+  }
+  if (step == end || steps_[step].node_index != node_idx) {
+    return kTfLiteOk;
+  }
+
+  // Step i always uses slot i % 2, so a node with two streamed inputs has
+  // both slots and consecutive nodes alternate between them.
+  int busy_slots = 0;
+  for (; step < end && steps_[step].node_index == node_idx; ++step) {
+    const int slot = step & 1;
+    TF_LITE_ENSURE_STATUS(StartLoad(step, slot));
+    if (pending_slot_ == slot) {
+      TF_LITE_ENSURE_STATUS(WaitForPendingLoad());
+    }
+    tensors[steps_[step].tensor_index].data.data = slots_[slot];
+    busy_slots |= 1 << slot;
+  }
+
+  const int next = step < end ? step : first;
+  if ((busy_slots & (1 << (next & 1))) == 0) {
+    TF_LITE_ENSURE_STATUS(StartLoad(next, next & 1));
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroWeightStreamer::StartLoad(int step, int slot) {
+  if (slot_step_[slot] == step) {
+    return kTfLiteOk;
+  }
+  TF_LITE_ENSURE_STATUS(WaitForPendingLoad());
+
+  slot_step_[slot] = -1;
+  const Step& load = steps_[step];
+  if (provider_->StartRead(load.source, load.bytes, slots_[slot]) !=
+      kTfLiteOk) {
+    MicroPrintf("Failed to start reading streamed tensor %d",
+                load.tensor_index);
+    return kTfLiteError;
+  }
+  slot_step_[slot] = step;
+  pending_slot_ = slot;
+  ++reads_;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroWeightStreamer::WaitForPendingLoad() {
+  if (pending_slot_ < 0) {
+    return kTfLiteOk;
+  }
+  const uint32_t start_ticks = GetCurrentTimeTicks();
+  const TfLiteStatus status = provider_->WaitForRead();
+  stall_ticks_ += GetCurrentTimeTicks() - start_ticks;
+  if (status != kTfLiteOk) {
+    MicroPrintf("Failed to read streamed tensor %d",
+                steps_[slot_step_[pending_slot_]].tensor_index);
+    slot_step_[pending_slot_] = -1;
+  }
+  pending_slot_ = -1;
+  return status;
+}
+
+}  // namespace tflite
@@ -0,0 +1,99 @@
+/* Copyright 2023 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_WEIGHT_STREAMER_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_WEIGHT_STREAMER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/micro_weight_provider.h"
+
+namespace tflite {
+
+// Streams constant tensors that live in slow storage through a small SRAM
+// staging area while a subgraph is invoked.
+//
+// MicroAllocator decides which tensors are streamed (see
+// MicroAllocator::SetWeightStreaming) and creates the streamer. Before a node
+// is invoked, MicroGraph calls StageNodeInputs, which waits until the node's
+// streamed inputs are in the staging area and points their TfLiteEvalTensors
+// at the copies, so kernels need no changes. The staging area has two slots:
+// while a node computes with its weights in one slot, the weights of the next
+// node that has streamed inputs are read into the other one. After the last
+// such node of a subgraph, the first one's weights are read for the next
+// invocation.
+//
+// Kernels that read constant tensors in Prepare still read them in place, so
+// the model flatbuffer must stay addressable, e.g. in XIP flash.
+class MicroWeightStreamer {
+ public:
+  // A streamed input of a node.
+  struct Step {
+    int node_index;
+    int tensor_index;
+    const void* source;
+    size_t bytes;
+  };
+
+  // steps holds the steps of all subgraphs sorted by subgraph and node, with
+  // at most two steps per node. The steps of subgraph i are
+  // [subgraph_first_step[i], subgraph_first_step[i + 1]). staging holds two
+  // slots of slot_bytes bytes each.
+  MicroWeightStreamer(MicroWeightProvider* provider, const Step* steps,
+                      const int* subgraph_first_step, uint8_t* staging,
+                      size_t slot_bytes);
+
+  // Makes the streamed inputs of node_idx resident and points their entries
+  // in tensors at the staging area, then starts reading the next streamed
+  // inputs.
+  TfLiteStatus StageNodeInputs(int subgraph_idx, int node_idx,
+                               TfLiteEvalTensor* tensors);
+
+  // Number of ticks spent waiting for reads that had not completed yet, i.e.
+  // the part of the storage latency that prefetching could not hide.
+  uint32_t stall_ticks() const { return stall_ticks_; }
+
+  // Number of reads started so far.
+  uint32_t reads() const { return reads_; }
+
+  size_t staging_bytes() const { return 2 * slot_bytes_; }
+
+ private:
+  // Starts reading step into slot unless the slot already holds it.
+  TfLiteStatus StartLoad(int step, int slot);
+
+  // Waits for the read in flight, if any.
+  TfLiteStatus WaitForPendingLoad();
+
+  MicroWeightProvider* provider_;
+  const Step* steps_;
+  const int* subgraph_first_step_;
+  uint8_t* slots_[2];
+  size_t slot_bytes_;
+
+  // Step held by or being read into each slot, or -1.
+  int slot_step_[2] = {-1, -1};
+  // Slot with a read in flight, or -1.
+  int pending_slot_ = -1;
+
+  uint32_t stall_ticks_ = 0;
+  uint32_t reads_ = 0;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_WEIGHT_STREAMER_H_
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
 #include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_arena_constants.h"
 #include "tensorflow/lite/micro/micro_log.h"
 
 namespace tflite {
@@ -61,6 +62,21 @@ RecordingMicroAllocator* RecordingMicroAllocator::Create(uint8_t* tensor_arena,
   return allocator;
 }
 
+RecordingMicroAllocator* RecordingMicroAllocator::Create(
+    uint8_t* tensor_arena, size_t arena_size,
+    MicroMemoryPlanner* memory_planner) {
+  TFLITE_DCHECK(memory_planner != nullptr);
+  RecordingSingleArenaBufferAllocator* simple_memory_allocator =
+      RecordingSingleArenaBufferAllocator::Create(tensor_arena, arena_size);
+  TFLITE_DCHECK(simple_memory_allocator != nullptr);
+
+  uint8_t* allocator_buffer = simple_memory_allocator->AllocatePersistentBuffer(
+      sizeof(RecordingMicroAllocator), alignof(RecordingMicroAllocator));
+  RecordingMicroAllocator* allocator = new (allocator_buffer)
+      RecordingMicroAllocator(simple_memory_allocator, memory_planner);
+  return allocator;
+}
+
 RecordedAllocation RecordingMicroAllocator::GetRecordedAllocation(
     RecordedAllocationType allocation_type) const {
   switch (allocation_type) {
@@ -78,6 +94,10 @@ RecordedAllocation RecordingMicroAllocator::GetRecordedAllocation(
       return recorded_node_and_registration_array_data_;
     case RecordedAllocationType::kOpData:
       return recorded_op_data_;
+    case RecordedAllocationType::kScratchBufferData:
+      return recorded_scratch_buffer_data_;
+    case RecordedAllocationType::kActivationTensorData:
+      return recorded_activation_tensor_data_;
   }
   MicroPrintf("Invalid allocation type supplied: %d", allocation_type);
   return RecordedAllocation();
@@ -112,16 +132,84 @@ void RecordingMicroAllocator::PrintAllocations() const {
                           "NodeAndRegistration structs");
   PrintRecordedAllocation(RecordedAllocationType::kOpData,
                           "Operator runtime data", "OpData structs");
+  PrintRecordedAllocation(RecordedAllocationType::kScratchBufferData,
+                          "Scratch buffer data", "scratch buffers");
+  PrintRecordedAllocation(RecordedAllocationType::kActivationTensorData,
+                          "Activation tensor data", "tensors");
+  const MicroAlignmentPolicy& policy = alignment_policy();
+  MicroPrintf(
+      "[RecordingMicroAllocator] Alignment padding: tail %d bytes, head %d "
+      "bytes (alignment of tensors %d, scratch buffers %d, persistent buffers "
+      "%d)",
+      static_cast<int>(GetPersistentPaddingBytes()),
+      static_cast<int>(GetNonPersistentPaddingBytes()),
+      static_cast<int>(policy.tensor_alignment),
+      static_cast<int>(policy.scratch_alignment),
+      static_cast<int>(policy.persistent_alignment));
+  if (overridden_scratch_bytes() > 0) {
+    MicroPrintf(
+        "[RecordingMicroAllocator] Scratch buffer overrides removed %d bytes "
+        "from the requests",
+        static_cast<int>(overridden_scratch_bytes()));
+  }
+}
+
+size_t RecordingMicroAllocator::GetPersistentPaddingBytes() const {
+  const RecordedAllocation* tail_allocations[] = {
+      &recorded_tflite_eval_tensor_data_,
+      &recorded_persistent_tflite_tensor_data_,
+      &recorded_persistent_tflite_tensor_quantization_data_,
+      &recorded_persistent_buffer_data_,
+      &recorded_tflite_tensor_variable_buffer_data_,
+      &recorded_node_and_registration_array_data_,
+      &recorded_op_data_};
+  size_t padding_bytes = 0;
+  for (const RecordedAllocation* allocation : tail_allocations) {
+    padding_bytes += allocation->used_bytes - allocation->requested_bytes;
+  }
+  return padding_bytes;
+}
+
+size_t RecordingMicroAllocator::GetNonPersistentPaddingBytes() const {
+  return recorded_scratch_buffer_data_.used_bytes -
+         recorded_scratch_buffer_data_.requested_bytes +
+         recorded_activation_tensor_data_.used_bytes -
+         recorded_activation_tensor_data_.requested_bytes;
 }
 
-void* RecordingMicroAllocator::AllocatePersistentBuffer(size_t bytes) {
+void* RecordingMicroAllocator::AllocateAlignedPersistentBuffer(
+    size_t bytes, size_t alignment) {
   RecordedAllocation allocations = SnapshotAllocationUsage();
-  void* buffer = MicroAllocator::AllocatePersistentBuffer(bytes);
+  void* buffer =
+      MicroAllocator::AllocateAlignedPersistentBuffer(bytes, alignment);
   RecordAllocationUsage(allocations, recorded_persistent_buffer_data_);
 
   return buffer;
 }
 
+TfLiteStatus RecordingMicroAllocator::RequestAlignedScratchBufferInArena(
+    size_t bytes, size_t alignment, int subgraph_idx, int* buffer_idx) {
+  TF_LITE_ENSURE_STATUS(MicroAllocator::RequestAlignedScratchBufferInArena(
+      bytes, alignment, subgraph_idx, buffer_idx));
+
+  // Scratch buffers only get an address when the memory plan is committed,
+  // so record the size they take up in the plan.
+  if (alignment < alignment_policy().scratch_alignment) {
+    alignment = alignment_policy().scratch_alignment;
+  }
+  recorded_scratch_buffer_data_.requested_bytes += bytes;
+  recorded_scratch_buffer_data_.used_bytes += AlignSizeUp(bytes, alignment);
+  recorded_scratch_buffer_data_.count++;
+  return kTfLiteOk;
+}
+
+void RecordingMicroAllocator::RecordPlannedTensor(size_t bytes,
+                                                  size_t planned_bytes) {
+  recorded_activation_tensor_data_.requested_bytes += bytes;
+  recorded_activation_tensor_data_.used_bytes += planned_bytes;
+  recorded_activation_tensor_data_.count++;
+}
+
 void RecordingMicroAllocator::PrintRecordedAllocation(
     RecordedAllocationType allocation_type, const char* allocation_name,
     const char* allocation_description) const {
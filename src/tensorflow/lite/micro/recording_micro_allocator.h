@@ -24,7 +24,6 @@ namespace tflite {
 
 // List of buckets currently recorded by this class. Each type keeps a list of
 // allocated information during model initialization.
-// TODO(b/169834511): Add tracking for scratch buffer allocations.
 enum class RecordedAllocationType {
   kTfLiteEvalTensorData,
   kPersistentTfLiteTensorData,
@@ -33,6 +32,12 @@ enum class RecordedAllocationType {
   kTfLiteTensorVariableBufferData,
   kNodeAndRegistrationArray,
   kOpData,
+  // Scratch buffers are planned in the head together with the activations, so
+  // used_bytes is their planned size, not additional arena usage.
+  kScratchBufferData,
+  // Same for the activation tensors: used_bytes is the sum of their sizes
+  // padded to their alignment, not the size of the head.
+  kActivationTensorData,
 };
 
 // Container for holding information about allocation recordings by a given
@@ -57,6 +62,12 @@ class RecordingMicroAllocator : public MicroAllocator {
   static RecordingMicroAllocator* Create(uint8_t* tensor_arena,
                                          size_t arena_size);
 
+  // Creates a RecordingMicroAllocator that plans the head with the given
+  // memory planner instead of a GreedyMemoryPlanner in the arena.
+  static RecordingMicroAllocator* Create(uint8_t* tensor_arena,
+                                         size_t arena_size,
+                                         MicroMemoryPlanner* memory_planner);
+
   // Returns the fixed amount of memory overhead of RecordingMicroAllocator.
   static size_t GetDefaultTailUsage();
 
@@ -67,10 +78,22 @@ class RecordingMicroAllocator : public MicroAllocator {
   const RecordingSingleArenaBufferAllocator* GetSimpleMemoryAllocator() const;
 
   // Logs out through the ErrorReporter all allocation recordings by type
-  // defined in RecordedAllocationType.
+  // defined in RecordedAllocationType, followed by the bytes lost to padding
+  // buffers to their alignment in the tail and in the head.
   void PrintAllocations() const;
 
-  void* AllocatePersistentBuffer(size_t bytes) override;
+  // Returns the bytes lost to alignment padding in the tail or in the head,
+  // i.e. used minus requested bytes of the recorded allocations there.
+  size_t GetPersistentPaddingBytes() const;
+  size_t GetNonPersistentPaddingBytes() const;
+
+  void* AllocateAlignedPersistentBuffer(size_t bytes,
+                                        size_t alignment) override;
+
+  TfLiteStatus RequestAlignedScratchBufferInArena(size_t bytes,
+                                                  size_t alignment,
+                                                  int subgraph_idx,
+                                                  int* buffer_idx) override;
 
  protected:
   TfLiteStatus AllocateNodeAndRegistrations(
@@ -93,6 +116,8 @@ class RecordingMicroAllocator : public MicroAllocator {
                                                   int subgraph_index,
                                                   bool allocate_temp) override;
 
+  void RecordPlannedTensor(size_t bytes, size_t planned_bytes) override;
+
  private:
   RecordingMicroAllocator(RecordingSingleArenaBufferAllocator* memory_allocator,
                           MicroMemoryPlanner* memory_planner);
@@ -116,6 +141,8 @@ class RecordingMicroAllocator : public MicroAllocator {
 
   // TODO(b/187993291): Re-enable OpData allocating tracking.
   RecordedAllocation recorded_op_data_ = {};
+  RecordedAllocation recorded_scratch_buffer_data_ = {};
+  RecordedAllocation recorded_activation_tensor_data_ = {};
 
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
@@ -103,6 +103,11 @@ typedef int64_t q63_t;
 #endif
 #endif
 
+/* Host builds can emulate the DSP extension to run the ARM_MATH_DSP paths */
+#if defined(TF_LITE_MICRO_CMSIS_NN_EMULATE_DSP) && !defined(__ARM_FEATURE_DSP)
+#include "tensorflow/lite/micro/kernels/cmsis_nn/dsp_emulation.h"
+#endif
+
 #if __ARM_FEATURE_MVE
 #ifndef ARM_MATH_MVEI
 #define ARM_MATH_MVEI
@@ -537,7 +537,6 @@ int32_t arm_convolve_1_x_n_s8_get_buffer_size(const cmsis_nn_dims *input_dims, c
  *                                 size if required.
  *                                 The caller is expected to clear the buffer ,if applicable, for security reasons.
  * @param[in]      dw_conv_params  Depthwise convolution parameters (e.g. strides, dilations, pads,...)
- *                                 dw_conv_params->dilation is not used.
  *                                 Range of dw_conv_params->input_offset : [-127, 128]
  *                                 Range of dw_conv_params->output_offset : [-128, 127]
  * @param[in]      quant_params    Per-channel quantization info.
@@ -758,9 +757,11 @@ int32_t arm_depthwise_conv_wrapper_s16_get_buffer_size(const cmsis_nn_dw_conv_pa
  * @details
  *    - Supported framework: TensorFlow Lite
  *    - The following constrains on the arguments apply
- *        -# Number of input channel equals number of output channels or ch_mult equals 1
+ *        -# Number of output channels equals number of input channels times ch_mult
  *    - q7 is used as data type eventhough it is s8 data. It is done so to be consistent with existing APIs.
  *    - Reccomended when number of channels is 4 or greater.
+ *    - With ch_mult > 1 every input channel is replicated ch_mult times into the im2col buffer, so the
+ *      buffer size depends on the number of output channels.
  *
  */
 arm_cmsis_nn_status arm_depthwise_conv_fast_s16(const cmsis_nn_context *ctx,
@@ -817,12 +818,11 @@ arm_cmsis_nn_status arm_depthwise_conv_3x3_s8(const cmsis_nn_context *ctx,
                                               q7_t *output_data);
 
 /**
- * @brief Optimized s8 depthwise convolution function with constraint that in_channel equals out_channel.
+ * @brief Optimized s8 depthwise convolution function with any channel multiplier and dilation.
  *        Refer arm_depthwise_conv_s8() for function argument details.
  *
  * @return     The function returns one of the following
- *                <code>ARM_CMSIS_NN_ARG_ERROR</code> - input channel != output channel or
- *                                                      ch_mult != 1
+ *                <code>ARM_CMSIS_NN_ARG_ERROR</code> - input channel * ch_mult != output channel
  *                <code>ARM_CMSIS_NN_SUCCESS</code> - Successful operation
  *
  * @note       If number of channels is not a multiple of 4, upto 3 elements outside the boundary will be read out
@@ -834,9 +834,11 @@ arm_cmsis_nn_status arm_depthwise_conv_3x3_s8(const cmsis_nn_context *ctx,
  * @details
  *    - Supported framework: TensorFlow Lite
  *    - The following constrains on the arguments apply
- *        -# Number of input channel equals number of output channels or ch_mult equals 1
+ *        -# Number of output channels equals number of input channels times ch_mult
  *    - q7 is used as data type eventhough it is s8 data. It is done so to be consistent with existing APIs.
  *    - Reccomended when number of channels is 4 or greater.
+ *    - With ch_mult > 1 every input channel is replicated ch_mult times into the im2col buffer, so the
+ *      buffer size depends on the number of output channels.
  *
  */
 arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
@@ -853,9 +855,9 @@ arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
 
 /**
  * @brief Get the required buffer size for optimized s8 depthwise convolution
- * function with constraint that in_channel equals out_channel.
+ * function.
  * @param[in]       input_dims   Input (activation) tensor dimensions. Format: [1, H, W, C_IN]
- *                               Batch argument N is not used.
+ *                               Not used.
  * @param[in]       filter_dims  Filter tensor dimensions. Format: [1, H, W, C_OUT]
  * @return          The function returns  required buffer size in bytes
  *
@@ -42,7 +42,8 @@
  */
 
 /*
- * Optimized s8 depthwise convolution function with constraint that in_channel equals out_channel
+ * Optimized s8 depthwise convolution function. Any channel multiplier and dilation is supported; input
+ * channels are replicated ch_mult times while building the im2col buffer.
  *
  *  Refer prototype header file for details.
  *
@@ -64,8 +65,9 @@ arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
     const int32_t input_ch = input_dims->c;
     const int32_t output_ch = output_dims->c;
 
-    /* Check depth multiplier is 1 */
-    if (input_ch != output_ch)
+    const int32_t ch_mult = dw_conv_params->ch_mult;
+
+    if (input_ch * ch_mult != output_ch)
     {
         return ARM_CMSIS_NN_ARG_ERROR;
     }
@@ -84,6 +86,8 @@ arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
     const int32_t pad_y = dw_conv_params->padding.h;
     const int32_t stride_x = dw_conv_params->stride.w;
     const int32_t stride_y = dw_conv_params->stride.h;
+    const int32_t dilation_x = dw_conv_params->dilation.w;
+    const int32_t dilation_y = dw_conv_params->dilation.h;
     const int32_t *output_shift = quant_params->shift;
     const int32_t *output_mult = quant_params->multiplier;
     const int32_t output_x = output_dims->w;
@@ -102,7 +106,7 @@ arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
     int buffer_count = 0;
     const int32_t kernel_size = kernel_x * kernel_y;
 
-    const int32_t ch_loop = (input_ch + (CH_IN_BLOCK_MVE - 1)) / CH_IN_BLOCK_MVE;
+    const int32_t ch_loop = (output_ch + (CH_IN_BLOCK_MVE - 1)) / CH_IN_BLOCK_MVE;
     int32_t remaining_ch = output_ch;
     int32_t active_ch = MIN(CH_IN_BLOCK_MVE, remaining_ch);
     remaining_ch -= CH_IN_BLOCK_MVE;
@@ -111,26 +115,37 @@ arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
     {
         out = output + i_ch * CH_IN_BLOCK_MVE;
         const int8_t *input_slice = input + (i_ch * CH_IN_BLOCK_MVE);
+        const int32_t first_out_ch = i_ch * CH_IN_BLOCK_MVE;
 
         for (int i_out_y = 0, base_idx_y = -pad_y; i_out_y < output_y; base_idx_y += stride_y, i_out_y++)
         {
             for (int i_out_x = 0, base_idx_x = -pad_x; i_out_x < output_x; base_idx_x += stride_x, i_out_x++)
             {
-                for (int i_ker_y = base_idx_y; i_ker_y < base_idx_y + kernel_y; i_ker_y++)
+                for (int i_ker_y = 0; i_ker_y < kernel_y; i_ker_y++)
                 {
-                    for (int i_ker_x = base_idx_x; i_ker_x < base_idx_x + kernel_x; i_ker_x++)
+                    const int32_t idx_y = base_idx_y + i_ker_y * dilation_y;
+                    for (int i_ker_x = 0; i_ker_x < kernel_x; i_ker_x++)
                     {
-                        if (i_ker_y < 0 || i_ker_y >= input_y || i_ker_x < 0 || i_ker_x >= input_x)
+                        const int32_t idx_x = base_idx_x + i_ker_x * dilation_x;
+                        if (idx_y < 0 || idx_y >= input_y || idx_x < 0 || idx_x >= input_x)
                         {
                             arm_memset_q7(lhs_buffer, (int8_t)-input_offset, (uint32_t)active_ch);
                             padded = 1;
                         }
-                        else
+                        else if (ch_mult == 1)
                         {
                             arm_memcpy_q7(lhs_buffer,
-                                          input_slice + (i_ker_y * input_x + i_ker_x) * input_ch,
+                                          input_slice + (idx_y * input_x + idx_x) * input_ch,
                                           (uint32_t)active_ch);
                         }
+                        else
+                        {
+                            const q7_t *pixel = input + (idx_y * input_x + idx_x) * input_ch;
+                            for (int i_out_ch = 0; i_out_ch < active_ch; i_out_ch++)
+                            {
+                                lhs_buffer[i_out_ch] = pixel[(first_out_ch + i_out_ch) / ch_mult];
+                            }
+                        }
                         lhs_buffer += CH_IN_BLOCK_MVE;
                     }
                 }
@@ -146,7 +161,7 @@ arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
                                                       kernel + block_offset,
                                                       input_offset,
                                                       active_ch,
-                                                      input_ch,
+                                                      output_ch,
                                                       output_shift + block_offset,
                                                       output_mult + block_offset,
                                                       output_offset,
@@ -162,7 +177,7 @@ arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
                                                              kernel + block_offset,
                                                              input_offset,
                                                              active_ch,
-                                                             input_ch,
+                                                             output_ch,
                                                              output_shift + block_offset,
                                                              output_mult + block_offset,
                                                              output_offset,
@@ -173,7 +188,7 @@ arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
                                                              out);
                         padded = 0;
                     }
-                    out += (4 * input_ch);
+                    out += (4 * output_ch);
                     buffer_count = 0;
                 }
             }
@@ -186,7 +201,7 @@ arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
         {
             int32_t loop_count = (active_ch + 3) / 4;
             int32_t num_ch_to_process = active_ch;
-            out = out_base + (i_buf * input_ch);
+            out = out_base + (i_buf * output_ch);
             for (int i_loop_cnt = 0, offset = i_ch * CH_IN_BLOCK_MVE; i_loop_cnt < loop_count;
                  num_ch_to_process -= 4, offset += 4, i_loop_cnt++)
             {
@@ -206,7 +221,7 @@ arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
                     out_0 += vmulq_s32(ip_0, ker_0);
 
                     col_0 += CH_IN_BLOCK_MVE;
-                    row_0 += input_ch;
+                    row_0 += output_ch;
                 }
 
                 const int32x4_t mult = vldrwq_s32(&output_mult[offset]);
@@ -246,44 +261,57 @@ arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
             const int16_t base_idx_x = (i_out_x * stride_x) - pad_x;
 
             /* Out of bounds is only considered for the y axis as it provides a contiguous zero'ing opportunity than
-               along the x axis */
-            const int ker_y_start = MAX(0, -base_idx_y);
-            /* Condition for kernel end dimension: (base_idx_y + ker_y_end) < input_y */
-            const int ker_y_end = MIN(kernel_y, input_y - base_idx_y);
+               along the x axis. Kernel rows [ker_y_start, ker_y_end) are inside the input. */
+            const int ker_y_start = base_idx_y < 0 ? MIN(kernel_y, (-base_idx_y + dilation_y - 1) / dilation_y) : 0;
+            const int ker_y_end =
+                MAX(ker_y_start, MIN(kernel_y, (input_y - base_idx_y + dilation_y - 1) / dilation_y));
 
             int32_t index = 0;
             if (ker_y_start != 0)
             {
-                memset(&col_buffer[index], 0, (kernel_x * input_ch) * ker_y_start * sizeof(q15_t));
-                index += (kernel_x * input_ch) * ker_y_start;
+                memset(&col_buffer[index], 0, (kernel_x * output_ch) * ker_y_start * sizeof(q15_t));
+                index += (kernel_x * output_ch) * ker_y_start;
             }
 
             for (int i_ker_y = ker_y_start; i_ker_y < ker_y_end; i_ker_y++)
             {
-                const int32_t idx_y = base_idx_y + i_ker_y;
+                const int32_t idx_y = base_idx_y + i_ker_y * dilation_y;
 
                 for (int i_ker_x = 0; i_ker_x < kernel_x; i_ker_x++)
                 {
-                    const int32_t idx_x = base_idx_x + i_ker_x;
+                    const int32_t idx_x = base_idx_x + i_ker_x * dilation_x;
                     if (idx_x < 0 || idx_x >= input_x)
                     {
-                        memset(&col_buffer[index], 0, input_ch * sizeof(q15_t));
+                        memset(&col_buffer[index], 0, output_ch * sizeof(q15_t));
                     }
-                    else
+                    else if (ch_mult == 1)
                     {
                         arm_q7_to_q15_with_offset((q7_t *)input + (idx_y * input_x + idx_x) * input_ch,
                                                   &col_buffer[index],
                                                   input_ch,
                                                   input_offset);
                     }
-                    index += input_ch;
+                    else
+                    {
+                        const q7_t *pixel = input + (idx_y * input_x + idx_x) * input_ch;
+                        q15_t *dst = &col_buffer[index];
+                        for (int i_in_ch = 0; i_in_ch < input_ch; i_in_ch++)
+                        {
+                            const q15_t value = (q15_t)(pixel[i_in_ch] + input_offset);
+                            for (int i_mult = 0; i_mult < ch_mult; i_mult++)
+                            {
+                                *dst++ = value;
+                            }
+                        }
+                    }
+                    index += output_ch;
                 }
             }
 
             const int diff = kernel_y - ker_y_end;
             if (diff != 0)
             {
-                memset(&col_buffer[index], 0, (kernel_x * input_ch) * diff * sizeof(q15_t));
+                memset(&col_buffer[index], 0, (kernel_x * output_ch) * diff * sizeof(q15_t));
             }
 
             row_count = output_ch / 4;
@@ -319,9 +347,9 @@ arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
                     q31_t ip_a1, ip_a2, ip_b1, ip_b2, op_a, op_b, op_c;
                     /* Read 4 weights */
                     ip_b1 = arm_nn_read_q7x4(row_pos);
-                    ip_a1 = arm_nn_read_q7x4(row_pos + input_ch);
+                    ip_a1 = arm_nn_read_q7x4(row_pos + output_ch);
                     op_a = arm_nn_read_q15x2(col_pos);
-                    op_b = arm_nn_read_q15x2(col_pos + input_ch);
+                    op_b = arm_nn_read_q15x2(col_pos + output_ch);
 
                     ip_a2 = __SXTB16(ip_b1);
                     ip_b1 = __SXTB16(__ROR(ip_b1, 8));
@@ -338,7 +366,7 @@ arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
                     sum_2 = __SMLAD(op_a, op_b, sum_2);
 
                     op_a = arm_nn_read_q15x2(col_pos + 2);
-                    op_b = arm_nn_read_q15x2(col_pos + input_ch + 2);
+                    op_b = arm_nn_read_q15x2(col_pos + output_ch + 2);
 
                     op_c = __PKHBT(op_b, op_a, 16);
                     op_a = __PKHTB(op_b, op_a, 16);
@@ -348,8 +376,8 @@ arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
                     op_b = __PKHTB(ip_a1, ip_b1, 16);
                     sum_4 = __SMLAD(op_a, op_b, sum_4);
 
-                    row_pos += input_ch << 1;
-                    col_pos += input_ch << 1;
+                    row_pos += output_ch << 1;
+                    col_pos += output_ch << 1;
                     col_count--;
                 }
 
@@ -361,8 +389,8 @@ arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
                     sum_3 += row_pos[2] * col_pos[2];
                     sum_4 += row_pos[3] * col_pos[3];
 
-                    row_pos += input_ch;
-                    col_pos += input_ch;
+                    row_pos += output_ch;
+                    col_pos += output_ch;
 
                     col_count--;
                 }
@@ -407,7 +435,7 @@ arm_cmsis_nn_status arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
 
                 for (int i = 0; i < col_count; i++)
                 {
-                    sum += row_pos[i * input_ch] * col_pos[i * input_ch];
+                    sum += row_pos[i * output_ch] * col_pos[i * output_ch];
                 }
                 sum = arm_nn_requantize(sum, *output_mult++, *output_shift++);
                 sum += output_offset;
@@ -448,7 +476,8 @@ int32_t arm_depthwise_conv_s8_opt_get_buffer_size(const cmsis_nn_dims *input_dim
     (void)input_dims;
     return (4 * CH_IN_BLOCK_MVE * filter_dims->w * filter_dims->h) * (int32_t)sizeof(int8_t);
 #elif defined(ARM_MATH_DSP)
-    return (input_dims->c * filter_dims->w * filter_dims->h) * sizeof(int16_t);
+    (void)input_dims;
+    return (filter_dims->c * filter_dims->w * filter_dims->h) * sizeof(int16_t);
 #else
     (void)input_dims;
     (void)filter_dims;
@@ -46,6 +46,16 @@
  *  Refer header file for details.
  *
  */
+/*
+ * arm_depthwise_conv_s8() has its own fast path for a channel multiplier that is a multiple of four without
+ * dilation. Every other single-batch case goes to arm_depthwise_conv_s8_opt().
+ */
+static int use_opt_kernel(const cmsis_nn_dw_conv_params *dw_conv_params, const cmsis_nn_dims *input_dims)
+{
+    const int undilated = dw_conv_params->dilation.w == 1 && dw_conv_params->dilation.h == 1;
+    return input_dims->n == 1 && !(dw_conv_params->ch_mult % 4 == 0 && undilated);
+}
+
 arm_cmsis_nn_status arm_depthwise_conv_wrapper_s8(const cmsis_nn_context *ctx,
                                                   const cmsis_nn_dw_conv_params *dw_conv_params,
                                                   const cmsis_nn_per_channel_quant_params *quant_params,
@@ -59,12 +69,12 @@ arm_cmsis_nn_status arm_depthwise_conv_wrapper_s8(const cmsis_nn_context *ctx,
                                                   q7_t *output)
 {
     arm_cmsis_nn_status status = ARM_CMSIS_NN_SUCCESS;
-    if (1 == dw_conv_params->ch_mult && input_dims->n == 1 && dw_conv_params->dilation.w == 1 &&
-        dw_conv_params->dilation.h == 1)
+    if (use_opt_kernel(dw_conv_params, input_dims))
     {
 #if !defined(ARM_MATH_MVEI)
         if ((filter_dims->w == 3) && (filter_dims->h == 3) && (dw_conv_params->padding.h <= 1) &&
-            (dw_conv_params->padding.w <= 1))
+            (dw_conv_params->padding.w <= 1) && 1 == dw_conv_params->ch_mult && dw_conv_params->dilation.w == 1 &&
+            dw_conv_params->dilation.h == 1)
         {
             status = arm_depthwise_conv_3x3_s8(ctx,
                                                dw_conv_params,
@@ -118,11 +128,10 @@ int32_t arm_depthwise_conv_wrapper_s8_get_buffer_size(const cmsis_nn_dw_conv_par
                                                       const cmsis_nn_dims *filter_dims,
                                                       const cmsis_nn_dims *output_dims)
 {
-    (void)dw_conv_params;
+    (void)output_dims;
     int32_t size = 0;
 
-    if (input_dims->c == output_dims->c && input_dims->n == 1 && dw_conv_params->dilation.w == 1 &&
-        dw_conv_params->dilation.h == 1)
+    if (use_opt_kernel(dw_conv_params, input_dims))
     {
         size = arm_depthwise_conv_s8_opt_get_buffer_size(input_dims, filter_dims);
     }
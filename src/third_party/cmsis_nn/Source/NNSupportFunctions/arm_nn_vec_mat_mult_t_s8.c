@@ -91,29 +91,57 @@ arm_cmsis_nn_status arm_nn_vec_mat_mult_t_s8(const q7_t *lhs,
 
         uint32_t col_cnt = (uint32_t)rhs_cols;
 
-        for (int i = 0; i < col_loop_cnt; i++)
+        if (lhs_offset == 0)
         {
-            mve_pred16_t p = vctp8q(col_cnt);
-            col_cnt -= 16;
+            // The caller has folded the lhs offset into the bias, so the rhs sums are not needed.
+            for (int i = 0; i < col_loop_cnt; i++)
+            {
+                mve_pred16_t p = vctp8q(col_cnt);
+                col_cnt -= 16;
 
-            const int8x16_t input = vldrbq_z_s8(lhs_vec, p);
+                const int8x16_t input = vldrbq_z_s8(lhs_vec, p);
 
-            const int8x16_t ker_0 = vldrbq_z_s8(rhs_0, p);
-            rhs_sum_0 = vaddvaq_p_s8(rhs_sum_0, ker_0, p);
-            acc_0 = vmladavaq_p_s8(acc_0, ker_0, input, p);
+                const int8x16_t ker_0 = vldrbq_z_s8(rhs_0, p);
+                acc_0 = vmladavaq_p_s8(acc_0, ker_0, input, p);
 
-            const int8x16_t ker_1 = vldrbq_z_s8(rhs_1, p);
-            rhs_sum_1 = vaddvaq_p_s8(rhs_sum_1, ker_1, p);
-            acc_1 = vmladavaq_p_s8(acc_1, ker_1, input, p);
+                const int8x16_t ker_1 = vldrbq_z_s8(rhs_1, p);
+                acc_1 = vmladavaq_p_s8(acc_1, ker_1, input, p);
 
-            const int8x16_t ker_2 = vldrbq_z_s8(rhs_2, p);
-            rhs_sum_2 = vaddvaq_p_s8(rhs_sum_2, ker_2, p);
-            acc_2 = vmladavaq_p_s8(acc_2, ker_2, input, p);
+                const int8x16_t ker_2 = vldrbq_z_s8(rhs_2, p);
+                acc_2 = vmladavaq_p_s8(acc_2, ker_2, input, p);
 
-            lhs_vec += 16;
-            rhs_0 += 16;
-            rhs_1 += 16;
-            rhs_2 += 16;
+                lhs_vec += 16;
+                rhs_0 += 16;
+                rhs_1 += 16;
+                rhs_2 += 16;
+            }
+        }
+        else
+        {
+            for (int i = 0; i < col_loop_cnt; i++)
+            {
+                mve_pred16_t p = vctp8q(col_cnt);
+                col_cnt -= 16;
+
+                const int8x16_t input = vldrbq_z_s8(lhs_vec, p);
+
+                const int8x16_t ker_0 = vldrbq_z_s8(rhs_0, p);
+                rhs_sum_0 = vaddvaq_p_s8(rhs_sum_0, ker_0, p);
+                acc_0 = vmladavaq_p_s8(acc_0, ker_0, input, p);
+
+                const int8x16_t ker_1 = vldrbq_z_s8(rhs_1, p);
+                rhs_sum_1 = vaddvaq_p_s8(rhs_sum_1, ker_1, p);
+                acc_1 = vmladavaq_p_s8(acc_1, ker_1, input, p);
+
+                const int8x16_t ker_2 = vldrbq_z_s8(rhs_2, p);
+                rhs_sum_2 = vaddvaq_p_s8(rhs_sum_2, ker_2, p);
+                acc_2 = vmladavaq_p_s8(acc_2, ker_2, input, p);
+
+                lhs_vec += 16;
+                rhs_0 += 16;
+                rhs_1 += 16;
+                rhs_2 += 16;
+            }
         }
         rhs += 3 * rhs_cols;
 
@@ -161,7 +189,10 @@ arm_cmsis_nn_status arm_nn_vec_mat_mult_t_s8(const q7_t *lhs,
             const int8x16_t input = vldrbq_z_s8(lhs_vec, p);
 
             const int8x16_t ker_0 = vldrbq_z_s8(rhs_0, p);
-            rhs_sum_0 = vaddvaq_p_s8(rhs_sum_0, ker_0, p);
+            if (lhs_offset != 0)
+            {
+                rhs_sum_0 = vaddvaq_p_s8(rhs_sum_0, ker_0, p);
+            }
             acc_0 = vmladavaq_p_s8(acc_0, ker_0, input, p);
 
             lhs_vec += 16;